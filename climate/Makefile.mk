@@ -23,3 +23,5 @@ climate_climate_la_SOURCES += climate/weather.cpp
 climate_climate_la_SOURCES += climate/weather.h
 climate_climate_la_SOURCES += climate/weather_reader.cpp
 climate_climate_la_SOURCES += climate/weather_reader.h
+climate_climate_la_SOURCES += climate/weather_store.cpp
+climate_climate_la_SOURCES += climate/weather_store.h
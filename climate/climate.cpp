@@ -23,6 +23,7 @@
 #undef min
 #endif
 #include "climate.h"
+#include "weather_store.h"
 #include "timestamp.h"
 EXPORT_CREATE(climate)
 EXPORT_INIT(climate)
@@ -523,6 +524,14 @@ void tmy2_reader::close(){
 CLASS *climate::oclass = NULL;
 climate *climate::defaults = NULL;
 
+/* weather values published with PF_NOTIFYCHANGE; presync reports them to subscribers when they change */
+static struct s_notify_property {
+	const char *name;
+	PROPERTY *prop;
+} notify_property[] = {
+	{"temperature"},{"humidity"},{"solar_direct"},{"solar_diffuse"},{"solar_global"},{"pressure"},{"wind_speed"},{"rainfall"},
+};
+
 climate::climate(MODULE *module)
 {
 	memset(this, 0, sizeof(climate));
@@ -535,16 +544,16 @@ climate::climate(MODULE *module)
       PT_double,"solar_zenith",PADDR(solar_zenith),
 			PT_char32, "city", PADDR(city),
 			PT_char1024,"tmyfile",PADDR(tmyfile),
-			PT_double,"temperature[degF]",PADDR(temperature),
-			PT_double,"humidity[pu]",PADDR(humidity),
+			PT_double,"temperature[degF]",PADDR(temperature),PT_FLAGS,PF_NOTIFYCHANGE,
+			PT_double,"humidity[pu]",PADDR(humidity),PT_FLAGS,PF_NOTIFYCHANGE,
 			PT_double,"solar_flux[W/sf]",PADDR(solar_flux),	PT_SIZE, 9,
-			PT_double,"solar_direct[W/sf]",PADDR(solar_direct),
-			PT_double,"solar_diffuse[W/sf]",PADDR(solar_diffuse),
-			PT_double,"solar_global[W/sf]",PADDR(solar_global),
+			PT_double,"solar_direct[W/sf]",PADDR(solar_direct),PT_FLAGS,PF_NOTIFYCHANGE,
+			PT_double,"solar_diffuse[W/sf]",PADDR(solar_diffuse),PT_FLAGS,PF_NOTIFYCHANGE,
+			PT_double,"solar_global[W/sf]",PADDR(solar_global),PT_FLAGS,PF_NOTIFYCHANGE,
 			PT_double,"extraterrestrial_global_horizontal[W/sf]",PADDR(global_horizontal_extra),
 			PT_double,"extraterrestrial_direct_normal[W/sf]",PADDR(direct_normal_extra),
-			PT_double,"pressure[mbar]",PADDR(pressure),
-			PT_double,"wind_speed[m/s]", PADDR(wind_speed),
+			PT_double,"pressure[mbar]",PADDR(pressure),PT_FLAGS,PF_NOTIFYCHANGE,
+			PT_double,"wind_speed[m/s]", PADDR(wind_speed),PT_FLAGS,PF_NOTIFYCHANGE,
 			PT_double,"wind_dir[deg]", PADDR(wind_dir),
 			PT_double,"wind_gust[mph]", PADDR(wind_gust),
 			PT_double,"record.low[degF]", PADDR(record.low),
@@ -552,7 +561,7 @@ climate::climate(MODULE *module)
 			PT_double,"record.high[degF]", PADDR(record.high),
 			PT_int32,"record.high_day",PADDR(record.high_day),
 			PT_double,"record.solar[W/sf]", PADDR(record.solar),
-			PT_double,"rainfall[in/h]",PADDR(rainfall),
+			PT_double,"rainfall[in/h]",PADDR(rainfall),PT_FLAGS,PF_NOTIFYCHANGE,
 			PT_double,"snowdepth[in]",PADDR(snowdepth),
 			PT_enumeration,"interpolate",PADDR(interpolate),PT_DESCRIPTION,"the interpolation mode used on the climate data",
 				PT_KEYWORD,"NONE",(enumeration)CI_NONE,
@@ -586,6 +595,8 @@ climate::climate(MODULE *module)
 			PT_double,"cloud_aerosol_transmissivity[pu]",PADDR(cloud_aerosol_transmissivity),
 			NULL)<1) GL_THROW("unable to publish properties in %s",__FILE__);
 		memset(this,0,sizeof(climate));
+		for ( size_t n=0 ; n<sizeof(notify_property)/sizeof(notify_property[0]) ; n++ )
+			notify_property[n].prop = gl_find_property(oclass,(char*)notify_property[n].name);
 		sa = new SolarAngles();
 		defaults = this;
 		gl_publish_function(oclass,	"calculate_solar_radiation_degrees", (FUNCTIONADDR)calculate_solar_radiation_degrees);
@@ -639,7 +650,6 @@ int climate::init(OBJECT *parent)
 	char *dot = 0;
 	OBJECT *obj=OBJECTHDR(this);
 	TIMESTAMP t0 = obj->clock;
-	double meter_to_feet = 1.0;
 	double tz_num_offset;
 
 	reader_type = RT_NONE;
@@ -730,7 +740,9 @@ int climate::init(OBJECT *parent)
 			}
 			csv_reader *my = OBJECTDATA(reader,csv_reader);
 			reader_hndl = my;
+			WRITELOCK_OBJECT(reader);
 			rv = my->open(my->filename);
+			WRITEUNLOCK_OBJECT(reader);
 //			my->get_data(t0, &temperature, &humidity, &solar_direct, &solar_diffuse, &wind_speed, &rainfall, &snowdepth);
 			//Pull timezone information
 			tz_num_offset = my->tz_numval;
@@ -777,39 +789,23 @@ int climate::init(OBJECT *parent)
 	}
 
 	// implicit if(reader_type == RT_TMY2) ~ do the following
-	if( file.open(found_file) < 3 ){
-		gl_error("climate::init() -- weather file header improperly formed");
-		return 0;
-	}
-	
-	// begin parsing the TMY file
-	int line=0;
-	tmy = (TMYDATA*)malloc(sizeof(TMYDATA)*8760);
-	if (tmy==NULL)
-	{
-		gl_error("TMY buffer allocation failed");
+	// the hourly table is shared by all the climate objects using the same file
+	WEATHERTABLE *table = weather_store_get(found_file,ground_reflectivity);
+	if (table==NULL)
 		return 0;
-	}
-
-	int month, day, hour;//, year;
-	double dnr,dhr,ghr,wspeed,wdir,precip,snowdepth,pressure,extra_dni,extra_ghi,tot_sky_cov,opq_sky_cov;
-	//char cty[50];
-	//char st[3];
-	int lat_deg,lat_min,long_deg,long_min;
-	/* The city/state data isn't used anywhere.  -mhauer */
-	//file.header_info(cty,st,&lat_deg,&lat_min,&long_deg,&long_min);
-	file.header_info(NULL,NULL,&lat_deg,&lat_min,&long_deg,&long_min);
+	tmy = table->tmy;
+	is_TMY2 = (table->is_tmy2!=0);
 
 	//Handle hemispheres
-	if (lat_deg<0)
-		set_latitude((double)lat_deg - (((double)lat_min) / 60));
+	if (table->lat_deg<0)
+		set_latitude((double)table->lat_deg - (((double)table->lat_min) / 60));
 	else
-		set_latitude((double)lat_deg + (((double)lat_min) / 60));
+		set_latitude((double)table->lat_deg + (((double)table->lat_min) / 60));
 
-	if (long_deg<0)
-		set_longitude((double)long_deg - (((double)long_min) / 60));
+	if (table->long_deg<0)
+		set_longitude((double)table->long_deg - (((double)table->long_min) / 60));
 	else
-		set_longitude((double)long_deg + (((double)long_min) / 60));
+		set_longitude((double)table->long_deg + (((double)table->long_min) / 60));
 
 	//Generic check for TMY files
 	if (fabs(obj->latitude) > 90)
@@ -843,108 +839,21 @@ int climate::init(OBJECT *parent)
 		//Defined above
 	}
 
-	if(0 == gl_convert("m", "ft", &meter_to_feet)){
-		gl_error("climate::init unable to gl_convert() 'm' to 'ft'!");
-		return 0;
+	tz_meridian =  15 * table->tz_offset;//std_meridians[-file.tz_offset-5];
+	tz_offset_val = table->tz_offset;
+
+	/* track records */
+	if (table->record.solar>record.solar || record.solar==0) record.solar = table->record.solar;
+	if (table->record.high>record.high || record.high==0)
+	{
+		record.high = table->record.high;
+		record.high_day = table->record.high_day;
 	}
-	file.elevation = (int)(file.elevation * meter_to_feet);
-	tz_meridian =  15 * file.tz_offset;//std_meridians[-file.tz_offset-5];
-	tz_offset_val = file.tz_offset;
-	while (line<8760 && file.next())
+	if (table->record.low<record.low || record.low==0)
 	{
-		while (isdigit(file.buf[1]) == 0) {
-			file.next();
-		}
-		file.read_data(&dnr,&dhr,&ghr,&temperature,&humidity,&month,&day,&hour,&wspeed,&wdir,&precip,&snowdepth,&pressure,&extra_dni,&extra_ghi,&tot_sky_cov,&opq_sky_cov);
-
-		int doy = sa->day_of_yr(month,day);
-		int hoy = (doy - 1) * 24 + (hour-1);
-		if (hoy>=0 && hoy<8760){
-			// pre-conversion of solar data from W/m^2 to W/sf
-			if(0 == gl_convert("W/m^2", "W/sf", &(dnr))){
-				gl_error("climate::init unable to gl_convert() 'W/m^2' to 'W/sf'!");
-				return 0;
-			}
-			if(0 == gl_convert("W/m^2", "W/sf", &(dhr))){
-				gl_error("climate::init unable to gl_convert() 'W/m^2' to 'W/sf'!");
-				return 0;
-			}
-			if(0 == gl_convert("W/m^2", "W/sf", &(ghr))){
-				gl_error("climate::init unable to gl_convert() 'W/m^2' to 'W/sf'!");
-				return 0;
-			}
-			if(0 == gl_convert("W/m^2", "W/sf", &(extra_dni))){
-				gl_error("climate::init unable to gl_convert() 'W/m^2' to 'W/sf'!");
-				return 0;
-			}
-			if(0 == gl_convert("W/m^2", "W/sf", &(extra_ghi))){
-				gl_error("climate::init unable to gl_convert() 'W/m^2' to 'W/sf'!");
-				return 0;
-			}
-			if(0 == gl_convert("mps", "mph", &(wspeed))){
-				gl_error("climate::init unable to gl_convert() 'm/s' to 'miles/h'!");
-				return 0;
-			}
-			tmy[hoy].temp_raw = temperature;
-			tmy[hoy].temp = temperature;
-			// post-conversion of copy of temperature from C to F
-			if(0 == gl_convert("degC", "degF", &(tmy[hoy].temp))){
-				gl_error("climate::init unable to gl_convert() 'degC' to 'degF'!");
-				return 0;
-			}
-			tmy[hoy].windspeed=wspeed;
-			tmy[hoy].rh = humidity;
-			tmy[hoy].dnr = dnr;
-			tmy[hoy].dhr = dhr;
-			tmy[hoy].ghr = ghr;
-			tmy[hoy].rainfall = precip;
-			tmy[hoy].snowdepth = snowdepth;
-			tmy[hoy].solar_raw = dnr;
-
-			tmy[hoy].direct_normal_extra = extra_dni;
-			tmy[hoy].pressure = pressure;
-			
-			tmy[hoy].global_horizontal_extra = extra_ghi;
-			tmy[hoy].wind_dir = wdir;
-			tmy[hoy].tot_sky_cov = tot_sky_cov;
-			tmy[hoy].opq_sky_cov = opq_sky_cov;
-
-			double sol_time = sa->solar_time((double)hour,doy,RAD(tz_meridian),RAD(get_longitude()));
-			double sol_rad = 0.0;
-
-			tmy[hoy].solar_elevation = sa->altitude(doy, RAD(obj->latitude), sol_time);
-			tmy[hoy].solar_azimuth = sa->azimuth(doy, RAD(obj->latitude), sol_time);
-			tmy[hoy].solar_zenith = (90. * PI_OVER_180)-tmy[hoy].solar_elevation;
-
-			for(COMPASS_PTS c_point = CP_H; c_point < CP_LAST;c_point=COMPASS_PTS(c_point+1)){
-				if(c_point == CP_H)
-					sol_rad = file.calc_solar(CP_E,doy,RAD(get_latitude()),sol_time,dnr,dhr,ghr,ground_reflectivity,0.0);//(double)dnr * cos_incident + dhr;
-				else
-					sol_rad = file.calc_solar(c_point,doy,RAD(get_latitude()),sol_time,dnr,dhr,ghr,ground_reflectivity);//(double)dnr * cos_incident + dhr;
-				/* TMY2 solar radiation data is in Watt-hours per square meter. */
-				tmy[hoy].solar[c_point] = sol_rad;
-
-				/* track records */
-				if (sol_rad>record.solar || record.solar==0) record.solar = sol_rad;
-				if (tmy[hoy].temp>record.high || record.high==0)
-				{
-					record.high = tmy[hoy].temp;
-					record.high_day = doy;
-				}
-				if (tmy[hoy].temp<record.low || record.low==0)
-				{
-					record.low = tmy[hoy].temp;
-					record.low_day = doy;
-				}
-			}
-
-		}
-		else
-			gl_error("%s(%d): day %d, hour %d is out of allowed range 0-8759 hours", tmyfile.get_string(),line,day,hour);
-
-		line++;
+		record.low = table->record.low;
+		record.low_day = table->record.low_day;
 	}
-	file.close();
 
 	/* initialize climate to starttime */
 	presync(gl_globalclock);
@@ -1991,6 +1900,10 @@ TIMESTAMP climate::presync(TIMESTAMP t0) /* called in presync */
 	TIMESTAMP tmy_rv = 0;
 	TIMESTAMP cloud_rv = 0;
 	DATETIME dt;
+	double last_value[sizeof(notify_property)/sizeof(notify_property[0])];
+	size_t n;
+	for ( n=0 ; n<sizeof(notify_property)/sizeof(notify_property[0]) ; n++ )
+		last_value[n] = *(double*)GETADDR(my(),notify_property[n].prop);
 
 	// TODO: need to read the cloud stuff from the csv file
 	// changes appear to be limited to weather.h, weather.cpp, csv_reader.h, csv_reader.cpp
@@ -2071,28 +1984,28 @@ TIMESTAMP climate::presync(TIMESTAMP t0) /* called in presync */
 				now = hoy+ts.minute/60.0;
 				hoy0 = hoy;
 				hoy1 = hoy+1.0;
-				temperature = (gl_lerp(now, hoy0, tmy[hoy].temp, hoy1, tmy[hoy+1%8760].temp));
-				humidity = (gl_lerp(now, hoy0, tmy[hoy].rh, hoy1, tmy[hoy+1%8760].rh));
-				solar_direct = (gl_lerp(now, hoy0, tmy[hoy].dnr, hoy1, tmy[hoy+1%8760].dnr));
-				solar_diffuse = (gl_lerp(now, hoy0, tmy[hoy].dhr, hoy1, tmy[hoy+1%8760].dhr));
-				solar_global = (gl_lerp(now, hoy0, tmy[hoy].ghr, hoy1, tmy[hoy+1%8760].ghr));
-				wind_speed = (gl_lerp(now, hoy0, tmy[hoy].windspeed, hoy1, tmy[hoy+1%8760].windspeed));
-				rainfall = (gl_lerp(now, hoy0, tmy[hoy].rainfall, hoy1, tmy[hoy+1%8760].rainfall));
-				snowdepth = (gl_lerp(now, hoy0, tmy[hoy].snowdepth, hoy1, tmy[hoy+1%8760].snowdepth));
-				solar_azimuth = (gl_lerp(now, hoy0, tmy[hoy].solar_azimuth, hoy1, tmy[hoy+1%8760].solar_azimuth));
-				solar_elevation = (gl_lerp(now, hoy0, tmy[hoy].solar_elevation, hoy1, tmy[hoy+1%8760].solar_elevation));
-				solar_zenith = (gl_lerp(now, hoy0, tmy[hoy].solar_zenith, hoy1, tmy[hoy+1%8760].solar_zenith));
-				temperature_raw = (gl_lerp(now, hoy0, tmy[hoy].temp_raw, hoy1, tmy[hoy+1%8760].temp_raw));
-				solar_raw = (gl_lerp(now, hoy0, tmy[hoy].solar_raw, hoy1, tmy[hoy+1%8760].solar_raw));
-				pressure = gl_lerp(now, hoy0, tmy[hoy].pressure, hoy1, tmy[hoy+1%8760].pressure);
-				direct_normal_extra = gl_lerp(now, hoy0, tmy[hoy].direct_normal_extra, hoy1, tmy[hoy+1%8760].direct_normal_extra);
-				global_horizontal_extra = gl_lerp(now, hoy0, tmy[hoy].global_horizontal_extra, hoy1, tmy[hoy+1%8760].global_horizontal_extra);
-				wind_dir = gl_lerp(now, hoy0, tmy[hoy].wind_dir, hoy1, tmy[hoy+1%8760].wind_dir);
-				tot_sky_cov = gl_lerp(now, hoy0, tmy[hoy].tot_sky_cov, hoy1, tmy[hoy+1%8760].tot_sky_cov);
-				opq_sky_cov = gl_lerp(now, hoy0, tmy[hoy].opq_sky_cov, hoy1, tmy[hoy+1%8760].opq_sky_cov);
+				temperature = (gl_lerp(now, hoy0, tmy[hoy].temp, hoy1, tmy[(hoy+1)%8760].temp));
+				humidity = (gl_lerp(now, hoy0, tmy[hoy].rh, hoy1, tmy[(hoy+1)%8760].rh));
+				solar_direct = (gl_lerp(now, hoy0, tmy[hoy].dnr, hoy1, tmy[(hoy+1)%8760].dnr));
+				solar_diffuse = (gl_lerp(now, hoy0, tmy[hoy].dhr, hoy1, tmy[(hoy+1)%8760].dhr));
+				solar_global = (gl_lerp(now, hoy0, tmy[hoy].ghr, hoy1, tmy[(hoy+1)%8760].ghr));
+				wind_speed = (gl_lerp(now, hoy0, tmy[hoy].windspeed, hoy1, tmy[(hoy+1)%8760].windspeed));
+				rainfall = (gl_lerp(now, hoy0, tmy[hoy].rainfall, hoy1, tmy[(hoy+1)%8760].rainfall));
+				snowdepth = (gl_lerp(now, hoy0, tmy[hoy].snowdepth, hoy1, tmy[(hoy+1)%8760].snowdepth));
+				solar_azimuth = (gl_lerp(now, hoy0, tmy[hoy].solar_azimuth, hoy1, tmy[(hoy+1)%8760].solar_azimuth));
+				solar_elevation = (gl_lerp(now, hoy0, tmy[hoy].solar_elevation, hoy1, tmy[(hoy+1)%8760].solar_elevation));
+				solar_zenith = (gl_lerp(now, hoy0, tmy[hoy].solar_zenith, hoy1, tmy[(hoy+1)%8760].solar_zenith));
+				temperature_raw = (gl_lerp(now, hoy0, tmy[hoy].temp_raw, hoy1, tmy[(hoy+1)%8760].temp_raw));
+				solar_raw = (gl_lerp(now, hoy0, tmy[hoy].solar_raw, hoy1, tmy[(hoy+1)%8760].solar_raw));
+				pressure = gl_lerp(now, hoy0, tmy[hoy].pressure, hoy1, tmy[(hoy+1)%8760].pressure);
+				direct_normal_extra = gl_lerp(now, hoy0, tmy[hoy].direct_normal_extra, hoy1, tmy[(hoy+1)%8760].direct_normal_extra);
+				global_horizontal_extra = gl_lerp(now, hoy0, tmy[hoy].global_horizontal_extra, hoy1, tmy[(hoy+1)%8760].global_horizontal_extra);
+				wind_dir = gl_lerp(now, hoy0, tmy[hoy].wind_dir, hoy1, tmy[(hoy+1)%8760].wind_dir);
+				tot_sky_cov = gl_lerp(now, hoy0, tmy[hoy].tot_sky_cov, hoy1, tmy[(hoy+1)%8760].tot_sky_cov);
+				opq_sky_cov = gl_lerp(now, hoy0, tmy[hoy].opq_sky_cov, hoy1, tmy[(hoy+1)%8760].opq_sky_cov);
 				for ( int pt = 0 ; pt < CP_LAST ; ++pt )
 				{
-					solar_flux[pt] = gl_lerp(now, hoy0, tmy[hoy].solar[pt], hoy1, tmy[hoy+1%8760].solar[pt]);
+					solar_flux[pt] = gl_lerp(now, hoy0, tmy[hoy].solar[pt], hoy1, tmy[(hoy+1)%8760].solar[pt]);
 				}
 				break;
 			case CI_QUADRATIC:
@@ -2100,67 +2013,67 @@ TIMESTAMP climate::presync(TIMESTAMP t0) /* called in presync */
 				hoy0 = hoy;
 				hoy1 = hoy+1.0;
 				hoy2 = hoy+2.0;
-				temperature = (gl_qerp(now, hoy0, tmy[hoy].temp, hoy1, tmy[hoy+1%8760].temp, hoy2, tmy[hoy+2%8760].temp));
-				humidity = (gl_qerp(now, hoy0, tmy[hoy].rh, hoy1, tmy[hoy+1%8760].rh, hoy2, tmy[hoy+2%8760].rh));
+				temperature = (gl_qerp(now, hoy0, tmy[hoy].temp, hoy1, tmy[(hoy+1)%8760].temp, hoy2, tmy[(hoy+2)%8760].temp));
+				humidity = (gl_qerp(now, hoy0, tmy[hoy].rh, hoy1, tmy[(hoy+1)%8760].rh, hoy2, tmy[(hoy+2)%8760].rh));
 				if(humidity < 0.0){
 					humidity = 0.0;
 					gl_verbose("Setting humidity to zero. Quadratic interpolation caused the humidity to drop below zero.");
 				}
-				solar_direct = (gl_qerp(now, hoy0, tmy[hoy].dnr, hoy1, tmy[hoy+1%8760].dnr, hoy2, tmy[hoy+2%8760].dnr));
+				solar_direct = (gl_qerp(now, hoy0, tmy[hoy].dnr, hoy1, tmy[(hoy+1)%8760].dnr, hoy2, tmy[(hoy+2)%8760].dnr));
 				if(solar_direct < 0.0){
 					solar_direct = 0.0;
 					gl_verbose("Setting solar_direct to zero. Quadratic interpolation caused the solar_direct to drop below zero.");
 				}
-				solar_diffuse = (gl_qerp(now, hoy0, tmy[hoy].dhr, hoy1, tmy[hoy+1%8760].dhr, hoy2, tmy[hoy+2%8760].dhr));
+				solar_diffuse = (gl_qerp(now, hoy0, tmy[hoy].dhr, hoy1, tmy[(hoy+1)%8760].dhr, hoy2, tmy[(hoy+2)%8760].dhr));
 				if(solar_diffuse < 0.0){
 					solar_diffuse = 0.0;
 					gl_verbose("Setting solar_diffuse to zero. Quadratic interpolation caused the solar_diffuse to drop below zero.");
 				}
-				solar_global = (gl_qerp(now, hoy0, tmy[hoy].ghr, hoy1, tmy[hoy+1%8760].ghr, hoy2, tmy[hoy+2%8760].ghr));
+				solar_global = (gl_qerp(now, hoy0, tmy[hoy].ghr, hoy1, tmy[(hoy+1)%8760].ghr, hoy2, tmy[(hoy+2)%8760].ghr));
 				if(solar_global < 0.0){
 					solar_global = 0.0;
 					gl_verbose("Setting solar_global to zero. Quadratic interpolation caused the solar_global to drop below zero.");
 				}
-				wind_speed = (gl_qerp(now, hoy0, tmy[hoy].windspeed, hoy1, tmy[hoy+1%8760].windspeed, hoy2, tmy[hoy+2%8760].windspeed));
+				wind_speed = (gl_qerp(now, hoy0, tmy[hoy].windspeed, hoy1, tmy[(hoy+1)%8760].windspeed, hoy2, tmy[(hoy+2)%8760].windspeed));
 				if(wind_speed < 0.0){
 					wind_speed = 0.0;
 					gl_verbose("Setting wind_speed to zero. Quadratic interpolation caused the wind_speed to drop below zero.");
 				}
-				rainfall = (gl_qerp(now, hoy0, tmy[hoy].rainfall, hoy1, tmy[hoy+1%8760].rainfall, hoy2, tmy[hoy+2%8760].rainfall));
+				rainfall = (gl_qerp(now, hoy0, tmy[hoy].rainfall, hoy1, tmy[(hoy+1)%8760].rainfall, hoy2, tmy[(hoy+2)%8760].rainfall));
 				if(rainfall < 0.0){
 					rainfall = 0.0;
 					gl_verbose("Setting rainfall to zero. Quadratic interpolation caused the rainfall to drop below zero.");
 				}
-				snowdepth = (gl_qerp(now, hoy0, tmy[hoy].snowdepth, hoy1, tmy[hoy+1%8760].snowdepth, hoy2, tmy[hoy+2%8760].snowdepth));
+				snowdepth = (gl_qerp(now, hoy0, tmy[hoy].snowdepth, hoy1, tmy[(hoy+1)%8760].snowdepth, hoy2, tmy[(hoy+2)%8760].snowdepth));
 				if(snowdepth < 0.0){
 					snowdepth = 0.0;
 					gl_verbose("Setting snowdepth to zero. Quadratic interpolation caused the snowdepth to drop below zero.");
 				}
-				solar_azimuth = (gl_qerp(now, hoy0, tmy[hoy].solar_azimuth, hoy1, tmy[hoy+1%8760].solar_azimuth, hoy2, tmy[hoy+2%8760].solar_azimuth));
-				solar_elevation = (gl_qerp(now, hoy0, tmy[hoy].solar_elevation, hoy1, tmy[hoy+1%8760].solar_elevation, hoy2, tmy[hoy+2%8760].solar_elevation));
-				solar_zenith = (gl_qerp(now, hoy0, tmy[hoy].solar_zenith, hoy1, tmy[hoy+1%8760].solar_zenith, hoy2, tmy[hoy+2%8760].solar_zenith));
-				temperature_raw = (gl_qerp(now, hoy0, tmy[hoy].temp_raw, hoy1, tmy[hoy+1%8760].temp_raw, hoy2, tmy[hoy+2%8760].temp_raw));
-				solar_raw = (gl_qerp(now, hoy0, tmy[hoy].solar_raw, hoy1, tmy[hoy+1%8760].solar_raw, hoy2, tmy[hoy+2%8760].solar_raw));
+				solar_azimuth = (gl_qerp(now, hoy0, tmy[hoy].solar_azimuth, hoy1, tmy[(hoy+1)%8760].solar_azimuth, hoy2, tmy[(hoy+2)%8760].solar_azimuth));
+				solar_elevation = (gl_qerp(now, hoy0, tmy[hoy].solar_elevation, hoy1, tmy[(hoy+1)%8760].solar_elevation, hoy2, tmy[(hoy+2)%8760].solar_elevation));
+				solar_zenith = (gl_qerp(now, hoy0, tmy[hoy].solar_zenith, hoy1, tmy[(hoy+1)%8760].solar_zenith, hoy2, tmy[(hoy+2)%8760].solar_zenith));
+				temperature_raw = (gl_qerp(now, hoy0, tmy[hoy].temp_raw, hoy1, tmy[(hoy+1)%8760].temp_raw, hoy2, tmy[(hoy+2)%8760].temp_raw));
+				solar_raw = (gl_qerp(now, hoy0, tmy[hoy].solar_raw, hoy1, tmy[(hoy+1)%8760].solar_raw, hoy2, tmy[(hoy+2)%8760].solar_raw));
 				if(solar_raw < 0.0){
 					solar_raw = 0.0;
 					gl_verbose("Setting solar_raw to zero. Quadratic interpolation caused the solar_raw to drop below zero.");
 				}
-				pressure = gl_qerp(now, hoy0, tmy[hoy].pressure, hoy1, tmy[hoy+1%8760].pressure, hoy2, tmy[hoy+2%8760].pressure);
+				pressure = gl_qerp(now, hoy0, tmy[hoy].pressure, hoy1, tmy[(hoy+1)%8760].pressure, hoy2, tmy[(hoy+2)%8760].pressure);
 				if(pressure < 0.0){
 					pressure = 0.0;
 					gl_verbose("Setting pressure to zero. Quadratic interpolation caused the pressure to drop below zero.");
 				}
-				direct_normal_extra = gl_qerp(now, hoy0, tmy[hoy].direct_normal_extra, hoy1, tmy[hoy+1%8760].direct_normal_extra, hoy2, tmy[hoy+2%8760].direct_normal_extra);
+				direct_normal_extra = gl_qerp(now, hoy0, tmy[hoy].direct_normal_extra, hoy1, tmy[(hoy+1)%8760].direct_normal_extra, hoy2, tmy[(hoy+2)%8760].direct_normal_extra);
 				if(direct_normal_extra < 0.0){
 					direct_normal_extra = 0.0;
 					gl_verbose("Setting extraterrestrial_direct_normal to zero. Quadratic interpolation caused the extraterrestrial_direct_normal to drop below zero.");
 				}
-				global_horizontal_extra = gl_qerp(now, hoy0, tmy[hoy].global_horizontal_extra, hoy1, tmy[hoy+1%8760].global_horizontal_extra, hoy2, tmy[hoy+2%8760].global_horizontal_extra);
+				global_horizontal_extra = gl_qerp(now, hoy0, tmy[hoy].global_horizontal_extra, hoy1, tmy[(hoy+1)%8760].global_horizontal_extra, hoy2, tmy[(hoy+2)%8760].global_horizontal_extra);
 				if(global_horizontal_extra < 0.0){
 					global_horizontal_extra = 0.0;
 					gl_verbose("Setting global_horizontal_extra to zero. Quadratic interpolation caused the global_horizontal_extra to drop below zero.");
 				}
-				wind_dir = gl_qerp(now, hoy0, tmy[hoy].wind_dir, hoy1, tmy[hoy+1%8760].wind_dir, hoy2, tmy[hoy+2%8760].wind_dir);
+				wind_dir = gl_qerp(now, hoy0, tmy[hoy].wind_dir, hoy1, tmy[(hoy+1)%8760].wind_dir, hoy2, tmy[(hoy+2)%8760].wind_dir);
 				if(wind_dir < 0.0){
 					wind_dir = 360.0+wind_dir;
 					gl_verbose("Setting wind_dir to 360+wind_dir. Quadratic interpolation caused the wind_dir to drop below zero.");
@@ -2169,12 +2082,12 @@ TIMESTAMP climate::presync(TIMESTAMP t0) /* called in presync */
 					wind_dir = wind_dir-360.0;
 					gl_verbose("Setting wind_dir to wind_dir-360. Quadratic interpolation caused the wind_dir to rise above 360.");
 				}
-				tot_sky_cov = gl_qerp(now, hoy0, tmy[hoy].tot_sky_cov, hoy1, tmy[hoy+1%8760].tot_sky_cov, hoy2, tmy[hoy+2%8760].tot_sky_cov);
+				tot_sky_cov = gl_qerp(now, hoy0, tmy[hoy].tot_sky_cov, hoy1, tmy[(hoy+1)%8760].tot_sky_cov, hoy2, tmy[(hoy+2)%8760].tot_sky_cov);
 				if(tot_sky_cov < 0.0){
 					tot_sky_cov = 0.0;
 					gl_verbose("Setting tot_sky_cov to zero. Quadratic interpolation caused the tot_sky_cov to drop below zero.");
 				}
-				opq_sky_cov = gl_qerp(now, hoy0, tmy[hoy].opq_sky_cov, hoy1, tmy[hoy+1%8760].opq_sky_cov, hoy2, tmy[hoy+2%8760].opq_sky_cov);
+				opq_sky_cov = gl_qerp(now, hoy0, tmy[hoy].opq_sky_cov, hoy1, tmy[(hoy+1)%8760].opq_sky_cov, hoy2, tmy[(hoy+2)%8760].opq_sky_cov);
 				if(opq_sky_cov < 0.0){
 					opq_sky_cov = 0.0;
 					gl_verbose("Setting opq_sky_cov to zero. Quadratic interpolation caused the opq_sky_cov to drop below zero.");
@@ -2186,7 +2099,7 @@ TIMESTAMP climate::presync(TIMESTAMP t0) /* called in presync */
 					{
 						solar_flux[pt] = tmy[hoy].solar[pt];
 					} else {
-						solar_flux[pt] = gl_qerp(now, hoy0, tmy[hoy].solar[pt], hoy1, tmy[hoy+1%8760].solar[pt], hoy2, tmy[hoy+2%8760].solar[pt]);
+						solar_flux[pt] = gl_qerp(now, hoy0, tmy[hoy].solar[pt], hoy1, tmy[(hoy+1)%8760].solar[pt], hoy2, tmy[(hoy+2)%8760].solar[pt]);
 						if(solar_flux[pt] < 0.0)
 							solar_flux[pt] = 0.0; /* quadratic isn't always cooperative... */
 					}
@@ -2216,6 +2129,12 @@ TIMESTAMP climate::presync(TIMESTAMP t0) /* called in presync */
 		cloud_rv = t0 + 60;
 	}
 
+	for ( n=0 ; n<sizeof(notify_property)/sizeof(notify_property[0]) ; n++ )
+	{
+		if ( *(double*)GETADDR(my(),notify_property[n].prop)!=last_value[n] )
+			gl_notify_change(my(),notify_property[n].prop);
+	}
+
 	//Extra logic to return the correct timestamp based on the weather data source and the use of the cloud model.
 	if (t0 <= TS_ZERO)
 		return TS_NEVER;
@@ -76,6 +76,11 @@ int csv_reader::open(const char *file){
 	OBJECT *obj = OBJECTHDR(this);
 	weather *wtr = 0;
 
+	// climate objects that share a reader only load it once
+	if(status == CR_OPEN){
+		return 1;
+	}
+
 	if(file == 0){
 		gl_error("csv_reader has no input file name!");
 		/* TROUBLESHOOT
@@ -158,6 +163,7 @@ int csv_reader::open(const char *file){
 	obj->latitude = lat_deg + (lat_deg > 0 ? lat_min : -lat_min) / 60;
 	obj->longitude = long_deg + (long_deg > 0 ? long_min : -long_min) / 60;
 
+	status = CR_OPEN;
 	return 1;
 }
 
@@ -11,6 +11,7 @@
 #include "climate.h"
 #include "weather.h"
 #include "csv_reader.h"
+#include "weather_store.h"
 
 EXPORT CLASS *init(CALLBACKS *fntable, MODULE *module, int argc, char *argv[])
 {
@@ -20,6 +21,8 @@ EXPORT CLASS *init(CALLBACKS *fntable, MODULE *module, int argc, char *argv[])
 		return NULL;
 	}
 
+	gl_global_create("climate::weather_cache",PT_bool,&weather_cache,PT_DESCRIPTION,"Save the parsed TMY2 weather files in binary caches next to them and reuse them (default is false)",NULL);
+
 	new climate(module);
 	new weather(module);
 	new csv_reader(module);
@@ -0,0 +1,430 @@
+/** $Id$
+	Copyright (C) 2012 Battelle Memorial Institute
+	@file weather_store.cpp
+	@addtogroup climate
+	@ingroup modules
+
+	Shared weather tables for climate objects.  See weather_store.h.
+
+	The cache file holds a WEATHERCACHEHEADER followed by the table of
+	WEATHER_HOURS TMYDATA records in the layout climate uses, so it can be
+	mapped and used in place.  The header holds the size and checksum of the
+	weather file it was built from; a cache that does not match the weather
+	file, the reflectivity, or the TMYDATA layout is rebuilt.
+ @{
+ **/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "gridlabd.h"
+#include "weather_store.h"
+
+#ifdef WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define RAD(x) (x*PI)/180
+
+extern bool is_TMY2;
+
+#define WEATHERCACHE_MAGIC 0x43574447 /* "GDWC" */
+#define WEATHERCACHE_VERSION 1 /* increment when the cache layout changes */
+
+typedef struct s_weather_cache_header {
+	unsigned int magic; ///< WEATHERCACHE_MAGIC
+	unsigned int version; ///< WEATHERCACHE_VERSION
+	unsigned int header_size; ///< size of this header, which is also the offset of the table
+	unsigned int record_size; ///< size of each TMYDATA record
+	unsigned int n_records; ///< number of records in the table
+	unsigned int is_tmy2; ///< non-zero if the weather file is TMY2 rather than TMY3
+	uint64 source_size; ///< size of the weather file
+	uint64 source_checksum; ///< checksum of the weather file
+	double ground_reflectivity; ///< ground reflectivity used for the solar values
+	int lat_deg, lat_min, long_deg, long_min, tz_offset, elevation; ///< weather file header values
+	CLIMATERECORD record; ///< record values over the whole table
+} WEATHERCACHEHEADER;
+
+bool weather_cache = false; ///< save and reuse weather caches next to the weather files
+
+static WEATHERTABLE *weather_tables = NULL;
+static unsigned int weather_tables_lock = 0;
+
+/* FNV-1a checksum of a weather file */
+static bool weather_checksum(const char *filename, uint64 *size, uint64 *checksum)
+{
+	unsigned char buffer[65536];
+	size_t len, n;
+	uint64 hash = 14695981039346656037ULL;
+	FILE *fp = fopen(filename,"rb");
+	if ( fp==NULL )
+		return false;
+	*size = 0;
+	while ( (len=fread(buffer,1,sizeof(buffer),fp))>0 )
+	{
+		for ( n=0 ; n<len ; n++ )
+		{
+			hash ^= buffer[n];
+			hash *= 1099511628211ULL;
+		}
+		*size += len;
+	}
+	fclose(fp);
+	*checksum = hash;
+	return true;
+}
+
+/* check that a cache header matches the weather file */
+static bool weather_cache_valid(WEATHERCACHEHEADER *header, uint64 file_size, uint64 source_size, uint64 source_checksum, double ground_reflectivity)
+{
+	return header->magic==WEATHERCACHE_MAGIC
+		&& header->version==WEATHERCACHE_VERSION
+		&& header->header_size==sizeof(WEATHERCACHEHEADER)
+		&& header->record_size==sizeof(TMYDATA)
+		&& header->n_records==WEATHER_HOURS
+		&& file_size==sizeof(WEATHERCACHEHEADER)+(uint64)WEATHER_HOURS*sizeof(TMYDATA)
+		&& header->source_size==source_size
+		&& header->source_checksum==source_checksum
+		&& header->ground_reflectivity==ground_reflectivity;
+}
+
+/* copy the cache header values into a table */
+static void weather_cache_copy(WEATHERTABLE *table, WEATHERCACHEHEADER *header)
+{
+	table->lat_deg = header->lat_deg;
+	table->lat_min = header->lat_min;
+	table->long_deg = header->long_deg;
+	table->long_min = header->long_min;
+	table->tz_offset = header->tz_offset;
+	table->elevation = header->elevation;
+	table->record = header->record;
+	table->is_tmy2 = header->is_tmy2;
+	if ( table->is_tmy2 )
+		gl_warning("Daylight saving time (DST) is not handled correctly when using TMY2 datasets; please use TMY3 for DST-corrected weather data.");
+}
+
+/* load a table from its cache
+	@returns true if the cache was valid and loaded
+ */
+static bool weather_cache_load(WEATHERTABLE *table, const char *cachename, uint64 source_size, uint64 source_checksum)
+{
+#ifdef WIN32
+	WEATHERCACHEHEADER header;
+	size_t table_size = (size_t)WEATHER_HOURS*sizeof(TMYDATA);
+	uint64 file_size;
+	FILE *fp = fopen(cachename,"rb");
+	if ( fp==NULL )
+		return false;
+	fseek(fp,0,SEEK_END);
+	file_size = ftell(fp);
+	fseek(fp,0,SEEK_SET);
+	if ( fread(&header,sizeof(header),1,fp)!=1
+		|| !weather_cache_valid(&header,file_size,source_size,source_checksum,table->ground_reflectivity) )
+	{
+		fclose(fp);
+		return false;
+	}
+	table->tmy = (TMYDATA*)malloc(table_size);
+	if ( table->tmy==NULL || fread(table->tmy,table_size,1,fp)!=1 )
+	{
+		free(table->tmy);
+		table->tmy = NULL;
+		fclose(fp);
+		return false;
+	}
+	fclose(fp);
+	weather_cache_copy(table,&header);
+	return true;
+#else
+	struct stat info;
+	WEATHERCACHEHEADER *header;
+	int fd = open(cachename,O_RDONLY);
+	if ( fd<0 )
+		return false;
+	if ( fstat(fd,&info)<0 || info.st_size<(off_t)sizeof(WEATHERCACHEHEADER) )
+	{
+		close(fd);
+		return false;
+	}
+	header = (WEATHERCACHEHEADER*)mmap(NULL,info.st_size,PROT_READ,MAP_SHARED,fd,0);
+	close(fd);
+	if ( header==(WEATHERCACHEHEADER*)MAP_FAILED )
+		return false;
+	if ( !weather_cache_valid(header,info.st_size,source_size,source_checksum,table->ground_reflectivity) )
+	{
+		munmap(header,info.st_size);
+		return false;
+	}
+	table->map = header;
+	table->map_size = info.st_size;
+	table->tmy = (TMYDATA*)((char*)header+header->header_size);
+	weather_cache_copy(table,header);
+	return true;
+#endif
+}
+
+/* save a table in its cache
+	The cache is written to a temporary file first so that other simulations
+	never see a partial cache.
+ */
+static void weather_cache_save(WEATHERTABLE *table, const char *cachename, uint64 source_size, uint64 source_checksum)
+{
+	char tempname[1100];
+	WEATHERCACHEHEADER header;
+	FILE *fp;
+	bool ok;
+
+	memset(&header,0,sizeof(header));
+	header.magic = WEATHERCACHE_MAGIC;
+	header.version = WEATHERCACHE_VERSION;
+	header.header_size = sizeof(WEATHERCACHEHEADER);
+	header.record_size = sizeof(TMYDATA);
+	header.n_records = WEATHER_HOURS;
+	header.source_size = source_size;
+	header.source_checksum = source_checksum;
+	header.ground_reflectivity = table->ground_reflectivity;
+	header.lat_deg = table->lat_deg;
+	header.lat_min = table->lat_min;
+	header.long_deg = table->long_deg;
+	header.long_min = table->long_min;
+	header.tz_offset = table->tz_offset;
+	header.elevation = table->elevation;
+	header.record = table->record;
+	header.is_tmy2 = table->is_tmy2;
+
+	sprintf(tempname,"%s.%d",cachename,(int)getpid());
+	fp = fopen(tempname,"wb");
+	if ( fp==NULL )
+	{
+		gl_verbose("weather cache '%s' could not be written", cachename);
+		return;
+	}
+	ok = fwrite(&header,sizeof(header),1,fp)==1
+		&& fwrite(table->tmy,sizeof(TMYDATA),WEATHER_HOURS,fp)==WEATHER_HOURS;
+	ok = (fclose(fp)==0) && ok;
+#ifdef WIN32
+	if ( ok )
+		remove(cachename);
+#endif
+	if ( !ok || rename(tempname,cachename)!=0 )
+	{
+		remove(tempname);
+		gl_verbose("weather cache '%s' could not be written", cachename);
+		return;
+	}
+	gl_verbose("weather cache '%s' saved", cachename);
+}
+
+/* parse a TMY2 weather file into a table */
+static bool weather_parse(WEATHERTABLE *table)
+{
+	tmy2_reader file;
+	SolarAngles sa;
+	TMYDATA *tmy;
+	double meter_to_feet = 1.0;
+	double latitude, longitude, tz_meridian;
+	double temperature, humidity;
+	double dnr,dhr,ghr,wspeed,wdir,precip,snowdepth,pressure,extra_dni,extra_ghi,tot_sky_cov,opq_sky_cov;
+	int month, day, hour;
+	int line = 0;
+
+	if ( file.open(table->filename) < 3 ){
+		gl_error("climate::init() -- weather file header improperly formed");
+		return false;
+	}
+
+	tmy = table->tmy = (TMYDATA*)calloc(WEATHER_HOURS,sizeof(TMYDATA));
+	if (tmy==NULL)
+	{
+		gl_error("TMY buffer allocation failed");
+		file.close();
+		return false;
+	}
+
+	/* The city/state data isn't used anywhere.  -mhauer */
+	file.header_info(NULL,NULL,&table->lat_deg,&table->lat_min,&table->long_deg,&table->long_min);
+
+	//Handle hemispheres
+	if (table->lat_deg<0)
+		latitude = (double)table->lat_deg - (((double)table->lat_min) / 60);
+	else
+		latitude = (double)table->lat_deg + (((double)table->lat_min) / 60);
+
+	if (table->long_deg<0)
+		longitude = (double)table->long_deg - (((double)table->long_min) / 60);
+	else
+		longitude = (double)table->long_deg + (((double)table->long_min) / 60);
+
+	if(0 == gl_convert("m", "ft", &meter_to_feet)){
+		gl_error("climate::init unable to gl_convert() 'm' to 'ft'!");
+		file.close();
+		return false;
+	}
+	table->elevation = (int)(file.elevation * meter_to_feet);
+	table->is_tmy2 = is_TMY2;
+	table->tz_offset = file.tz_offset;
+	tz_meridian =  15 * file.tz_offset;//std_meridians[-file.tz_offset-5];
+
+	while (line<WEATHER_HOURS && file.next())
+	{
+		while (isdigit(file.buf[1]) == 0) {
+			file.next();
+		}
+		file.read_data(&dnr,&dhr,&ghr,&temperature,&humidity,&month,&day,&hour,&wspeed,&wdir,&precip,&snowdepth,&pressure,&extra_dni,&extra_ghi,&tot_sky_cov,&opq_sky_cov);
+
+		int doy = sa.day_of_yr(month,day);
+		int hoy = (doy - 1) * 24 + (hour-1);
+		if (hoy>=0 && hoy<WEATHER_HOURS){
+			// pre-conversion of solar data from W/m^2 to W/sf
+			if(0 == gl_convert("W/m^2", "W/sf", &(dnr))
+				|| 0 == gl_convert("W/m^2", "W/sf", &(dhr))
+				|| 0 == gl_convert("W/m^2", "W/sf", &(ghr))
+				|| 0 == gl_convert("W/m^2", "W/sf", &(extra_dni))
+				|| 0 == gl_convert("W/m^2", "W/sf", &(extra_ghi))){
+				gl_error("climate::init unable to gl_convert() 'W/m^2' to 'W/sf'!");
+				file.close();
+				return false;
+			}
+			if(0 == gl_convert("mps", "mph", &(wspeed))){
+				gl_error("climate::init unable to gl_convert() 'm/s' to 'miles/h'!");
+				file.close();
+				return false;
+			}
+			tmy[hoy].temp_raw = temperature;
+			tmy[hoy].temp = temperature;
+			// post-conversion of copy of temperature from C to F
+			if(0 == gl_convert("degC", "degF", &(tmy[hoy].temp))){
+				gl_error("climate::init unable to gl_convert() 'degC' to 'degF'!");
+				file.close();
+				return false;
+			}
+			tmy[hoy].windspeed=wspeed;
+			tmy[hoy].rh = humidity;
+			tmy[hoy].dnr = dnr;
+			tmy[hoy].dhr = dhr;
+			tmy[hoy].ghr = ghr;
+			tmy[hoy].rainfall = precip;
+			tmy[hoy].snowdepth = snowdepth;
+			tmy[hoy].solar_raw = dnr;
+
+			tmy[hoy].direct_normal_extra = extra_dni;
+			tmy[hoy].pressure = pressure;
+
+			tmy[hoy].global_horizontal_extra = extra_ghi;
+			tmy[hoy].wind_dir = wdir;
+			tmy[hoy].tot_sky_cov = tot_sky_cov;
+			tmy[hoy].opq_sky_cov = opq_sky_cov;
+
+			double sol_time = sa.solar_time((double)hour,doy,RAD(tz_meridian),RAD(longitude));
+			double sol_rad = 0.0;
+
+			tmy[hoy].solar_elevation = sa.altitude(doy, RAD(latitude), sol_time);
+			tmy[hoy].solar_azimuth = sa.azimuth(doy, RAD(latitude), sol_time);
+			tmy[hoy].solar_zenith = (90. * PI_OVER_180)-tmy[hoy].solar_elevation;
+
+			for(COMPASS_PTS c_point = CP_H; c_point < CP_LAST;c_point=COMPASS_PTS(c_point+1)){
+				if(c_point == CP_H)
+					sol_rad = file.calc_solar(CP_E,doy,RAD(latitude),sol_time,dnr,dhr,ghr,table->ground_reflectivity,0.0);//(double)dnr * cos_incident + dhr;
+				else
+					sol_rad = file.calc_solar(c_point,doy,RAD(latitude),sol_time,dnr,dhr,ghr,table->ground_reflectivity,90);//(double)dnr * cos_incident + dhr;
+				/* TMY2 solar radiation data is in Watt-hours per square meter. */
+				tmy[hoy].solar[c_point] = sol_rad;
+
+				/* track records */
+				if (sol_rad>table->record.solar || table->record.solar==0) table->record.solar = sol_rad;
+				if (tmy[hoy].temp>table->record.high || table->record.high==0)
+				{
+					table->record.high = tmy[hoy].temp;
+					table->record.high_day = doy;
+				}
+				if (tmy[hoy].temp<table->record.low || table->record.low==0)
+				{
+					table->record.low = tmy[hoy].temp;
+					table->record.low_day = doy;
+				}
+			}
+
+		}
+		else
+			gl_error("%s(%d): day %d, hour %d is out of allowed range 0-8759 hours", table->filename,line,day,hour);
+
+		line++;
+	}
+	file.close();
+	return true;
+}
+
+/** Get the shared table of a TMY2 weather file
+	The table is parsed, or loaded from its cache, the first time it is
+	requested and shared by all later requests for the same file.  Climate
+	objects may initialize concurrently, so the store is locked while a table
+	is located or built.
+	@returns the table, or NULL if the weather file could not be read
+ **/
+WEATHERTABLE *weather_store_get(const char *filename, double ground_reflectivity)
+{
+	WEATHERTABLE *table;
+	char cachename[1100];
+	uint64 source_size, source_checksum;
+
+	WRITELOCK(&weather_tables_lock);
+	for ( table=weather_tables ; table!=NULL ; table=table->next )
+	{
+		if ( strcmp(table->filename,filename)==0 && table->ground_reflectivity==ground_reflectivity )
+		{
+			WRITEUNLOCK(&weather_tables_lock);
+			gl_verbose("weather file '%s' shares the table already loaded", filename);
+			return table;
+		}
+	}
+
+	table = (WEATHERTABLE*)calloc(1,sizeof(WEATHERTABLE));
+	if ( table==NULL )
+	{
+		WRITEUNLOCK(&weather_tables_lock);
+		gl_error("TMY buffer allocation failed");
+		return NULL;
+	}
+	strncpy(table->filename,filename,sizeof(table->filename)-1);
+	table->ground_reflectivity = ground_reflectivity;
+	sprintf(cachename,"%s.cache",table->filename);
+
+	if ( !weather_checksum(filename,&source_size,&source_checksum) )
+	{
+		WRITEUNLOCK(&weather_tables_lock);
+		free(table);
+		gl_error("weather file '%s' access failed", filename);
+		return NULL;
+	}
+
+	if ( weather_cache && weather_cache_load(table,cachename,source_size,source_checksum) )
+		gl_verbose("weather file '%s' loaded from cache '%s'", filename, cachename);
+	else
+	{
+		if ( !weather_parse(table) )
+		{
+			WRITEUNLOCK(&weather_tables_lock);
+			free(table->tmy);
+			free(table);
+			return NULL;
+		}
+		gl_verbose("weather file '%s' parsed", filename);
+		if ( weather_cache )
+			weather_cache_save(table,cachename,source_size,source_checksum);
+	}
+
+	table->next = weather_tables;
+	weather_tables = table;
+	WRITEUNLOCK(&weather_tables_lock);
+	return table;
+}
+
+/**@}*/
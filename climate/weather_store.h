@@ -0,0 +1,44 @@
+/** $Id$
+	Copyright (C) 2012 Battelle Memorial Institute
+	@file weather_store.h
+	@addtogroup climate
+	@ingroup modules
+
+	The weather store parses each TMY2 file once and shares the resulting
+	hourly table read-only with every climate object that uses the file.
+	When \p climate::weather_cache is set (it is off by default) the table is also saved in a binary
+	cache next to the weather file (the weather file name with \p .cache added)
+	along with a checksum of the weather file, and later runs map the cache
+	instead of parsing the weather file again.
+ @{
+ **/
+
+#ifndef _WEATHER_STORE_H
+#define _WEATHER_STORE_H
+
+#include "climate.h"
+
+#define WEATHER_HOURS 8760 /* number of hourly records in a table */
+
+typedef struct s_weather_table {
+	char filename[1024]; ///< the weather file
+	double ground_reflectivity; ///< ground reflectivity used for the solar values
+	int lat_deg, lat_min; ///< latitude from the weather file header
+	int long_deg, long_min; ///< longitude from the weather file header
+	int tz_offset; ///< timezone offset from the weather file header
+	int elevation; ///< elevation from the weather file header (ft)
+	int is_tmy2; ///< non-zero if the weather file is TMY2 rather than TMY3
+	CLIMATERECORD record; ///< record values over the whole table
+	TMYDATA *tmy; ///< the hourly values, WEATHER_HOURS of them (read-only)
+	void *map; ///< the mapped cache, if any
+	size_t map_size; ///< the size of the mapped cache
+	struct s_weather_table *next;
+} WEATHERTABLE;
+
+extern bool weather_cache;
+
+WEATHERTABLE *weather_store_get(const char *filename, double ground_reflectivity);
+
+#endif
+
+/**@}*/
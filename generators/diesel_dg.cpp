@@ -535,6 +535,8 @@ int diesel_dg::create(void)
 	YS2 = 0.0;
 	Rr = 0.0;
 
+	batch_pass = 0;
+
 	torque_delay = NULL;
 	x5a_delayed = NULL;
 	torque_delay_len = 0;
@@ -2442,6 +2444,345 @@ STATUS diesel_dg::post_deltaupdate(complex *useful_value, unsigned int mode_pass
 //	return SUCCESS;	//Just indicate success right now
 //}
 
+//Batched machine dynamics
+//The machine equations of apply_dynamics are the same for every generator, whatever its
+//governor or exciter.  When enable_batch_dynamics is set, the module interupdate gathers
+//the states of all deltamode generators into structure-of-arrays blocks at the start of
+//each pass, evaluates the machine equations over the blocks, and scatters the derivatives
+//back, so apply_dynamics only does the governor and exciter for those generators.  Each
+//block holds MAC_BLOCK_WIDTH generators in fixed-size arrays, so the loops over a block
+//have no aliasing or branches and the compiler can vectorize them.  The trigonometry and
+//square roots are done in a separate scalar loop.
+#define MAC_BLOCK_WIDTH 4
+
+typedef struct s_mac_states_block {
+	//Parameters - gathered at the start of each deltamode run
+	double current_base[MAC_BLOCK_WIDTH], Rated_VA[MAC_BLOCK_WIDTH], omega_ref[MAC_BLOCK_WIDTH];
+	double torque_base[MAC_BLOCK_WIDTH], inertia_gain[MAC_BLOCK_WIDTH], damping[MAC_BLOCK_WIDTH], Rr_half[MAC_BLOCK_WIDTH];
+	double kEq[MAC_BLOCK_WIDTH], kEd[MAC_BLOCK_WIDTH], kFd[MAC_BLOCK_WIDTH], kFq[MAC_BLOCK_WIDTH], Xqpp_Xdpp[MAC_BLOCK_WIDTH];
+	double Xdp_Xl[MAC_BLOCK_WIDTH], Xqp_Xl[MAC_BLOCK_WIDTH], Xdp_Xdpp[MAC_BLOCK_WIDTH], Xqp_Xqpp[MAC_BLOCK_WIDTH], Xd_Xdp[MAC_BLOCK_WIDTH], Xq_Xqp[MAC_BLOCK_WIDTH];
+	double Tdop[MAC_BLOCK_WIDTH], Tdopp[MAC_BLOCK_WIDTH], Tqop[MAC_BLOCK_WIDTH], Tqopp[MAC_BLOCK_WIDTH];
+	double Y_re[9][MAC_BLOCK_WIDTH], Y_im[9][MAC_BLOCK_WIDTH];	//Generator admittance matrix, row major
+	//Inputs - gathered each pass
+	double IG_re[3][MAC_BLOCK_WIDTH], IG_im[3][MAC_BLOCK_WIDTH];	//Generator current injections
+	double V_re[3][MAC_BLOCK_WIDTH], V_im[3][MAC_BLOCK_WIDTH];		//Bus voltages
+	double rotor_angle[MAC_BLOCK_WIDTH], omega[MAC_BLOCK_WIDTH], Flux1d[MAC_BLOCK_WIDTH], Flux2q[MAC_BLOCK_WIDTH];
+	double Ep_re[MAC_BLOCK_WIDTH], Ep_im[MAC_BLOCK_WIDTH], Vfd[MAC_BLOCK_WIDTH], torque_mech[MAC_BLOCK_WIDTH];
+	//Intermediate values
+	double I_re[3][MAC_BLOCK_WIDTH], I_im[3][MAC_BLOCK_WIDTH];	//Generator currents (p.u.)
+	double Ip_re[MAC_BLOCK_WIDTH], Ip_im[MAC_BLOCK_WIDTH];		//Positive sequence current
+	double In_sq[MAC_BLOCK_WIDTH], In_mag[MAC_BLOCK_WIDTH];		//Negative sequence current magnitude, squared and not
+	double cos_angle[MAC_BLOCK_WIDTH], sin_angle[MAC_BLOCK_WIDTH];	//Rotation of the rotor angle
+	//Outputs
+	double Ir_re[MAC_BLOCK_WIDTH], Ir_im[MAC_BLOCK_WIDTH];		//Rotated current
+	double torque_elec[MAC_BLOCK_WIDTH], pwr_mech[MAC_BLOCK_WIDTH];
+	double d_omega[MAC_BLOCK_WIDTH], d_rotor_angle[MAC_BLOCK_WIDTH], d_Flux1d[MAC_BLOCK_WIDTH], d_Flux2q[MAC_BLOCK_WIDTH];
+	double d_Ep_re[MAC_BLOCK_WIDTH], d_Ep_im[MAC_BLOCK_WIDTH];
+} MAC_STATES_BLOCK;
+
+static MAC_STATES_BLOCK *batch_blocks = NULL;	//Blocks of generator states
+static diesel_dg **batch_gens = NULL;			//Generator of each block entry, in delta_objects order
+static int batch_gen_count = 0;					//Number of generators in the blocks
+static int batch_gen_size = 0;					//Allocated number of generators
+static unsigned int64 batch_pass_count = 0;		//Number of batched passes so far
+
+//Update the machine equations of the deltamode generators for this pass
+//The first pass of a deltamode run initializes the states inside each generator, so it is
+//left to apply_dynamics and used to collect the block membership and parameters instead.
+void diesel_dg::batch_dynamics(unsigned int64 delta_time, unsigned int iteration_count_val)
+{
+	MAC_STATES_BLOCK *b;
+	diesel_dg *gen;
+	MAC_STATES *state;
+	MAC_STATES *delta;
+	OBJECT *obj;
+	complex aval, aval_sq;
+	double x0r, x0i, x1r, x1i, x2r, x2i, tr, ti;
+	double temp_double_1, temp_double_2, temp_double_3, omega_pu;
+	int curr_object_number, other, n_blocks, blk, n, l, k, j;
+	bool shared;
+
+	//Results of the previous pass are never used again
+	batch_pass_count++;
+
+	//Build the blocks
+	if ((delta_time == 0) && (iteration_count_val == 0))
+	{
+		if (batch_gen_size < gen_object_count)
+		{
+			if (batch_blocks != NULL)
+				gl_free(batch_blocks);
+			if (batch_gens != NULL)
+				gl_free(batch_gens);
+
+			n_blocks = (gen_object_count + MAC_BLOCK_WIDTH - 1) / MAC_BLOCK_WIDTH;
+			batch_blocks = (MAC_STATES_BLOCK*)gl_malloc(n_blocks*sizeof(MAC_STATES_BLOCK));
+			batch_gens = (diesel_dg**)gl_malloc(gen_object_count*sizeof(diesel_dg*));
+
+			if ((batch_blocks == NULL) || (batch_gens == NULL))
+			{
+				gl_warning("diesel_dg: unable to allocate the batched dynamics, updating each generator separately");
+				/*  TROUBLESHOOT
+				The memory for the batched machine dynamics of the diesel_dg objects could not be allocated.  The
+				generators are updated one at a time instead, which gives the same results.  Free up some memory
+				or set generators::enable_batch_dynamics to false.
+				*/
+				batch_gen_size = 0;
+				batch_gen_count = 0;
+				enable_batch_dynamics = false;
+				return;
+			}
+
+			memset(batch_blocks,0,n_blocks*sizeof(MAC_STATES_BLOCK));
+			batch_gen_size = gen_object_count;
+		}
+
+		batch_gen_count = 0;
+		for (curr_object_number=0; curr_object_number<gen_object_count; curr_object_number++)
+		{
+			obj = delta_objects[curr_object_number];
+			if ((obj == NULL) || (obj->oclass != oclass))
+				continue;
+
+			gen = OBJECTDATA(obj,diesel_dg);
+			if ((gen->IGenerated == NULL) || (gen->pCircuit_V == NULL))
+				continue;
+
+			//Generators out of service get no interupdate, so they are left out of the blocks
+			if ((obj->in_svc_double > gl_globaldeltaclock) || (obj->out_svc_double < gl_globaldeltaclock))
+				continue;
+
+			//Generators that share a bus read each other's injections during the pass, so they keep the sequential update
+			shared = false;
+			for (other=0; other<gen_object_count; other++)
+			{
+				if ((other != curr_object_number) && (delta_objects[other] != NULL) && (delta_objects[other]->oclass == oclass)
+					&& (OBJECTDATA(delta_objects[other],diesel_dg)->IGenerated == gen->IGenerated))
+				{
+					shared = true;
+					break;
+				}
+			}
+			if (shared == true)
+				continue;
+
+			batch_gens[batch_gen_count++] = gen;
+		}
+
+		//Parameters, combined exactly as apply_dynamics does - unused entries of the last block copy the last generator
+		n_blocks = (batch_gen_count + MAC_BLOCK_WIDTH - 1) / MAC_BLOCK_WIDTH;
+		for (n=0; n<n_blocks*MAC_BLOCK_WIDTH; n++)
+		{
+			gen = batch_gens[(n < batch_gen_count) ? n : (batch_gen_count - 1)];
+			b = &batch_blocks[n / MAC_BLOCK_WIDTH];
+			l = n % MAC_BLOCK_WIDTH;
+
+			b->current_base[l] = gen->current_base;
+			b->Rated_VA[l] = gen->Rated_VA;
+			b->omega_ref[l] = gen->omega_ref;
+			b->torque_base[l] = gen->Rated_VA/gen->omega_ref;
+			b->inertia_gain[l] = gen->omega_ref/(2.0*gen->inertia);
+			b->damping[l] = gen->damping;
+			b->Rr_half[l] = 0.5*gen->Rr;
+			b->kEq[l] = -(gen->Xqpp-gen->Xl)/(gen->Xqp-gen->Xl);
+			b->kEd[l] = (gen->Xdpp-gen->Xl)/(gen->Xdp-gen->Xl);
+			b->kFd[l] = (gen->Xdp-gen->Xdpp)/(gen->Xdp-gen->Xl);
+			b->kFq[l] = (gen->Xqp-gen->Xqpp)/(gen->Xqp-gen->Xl);
+			b->Xqpp_Xdpp[l] = gen->Xqpp-gen->Xdpp;
+			b->Xdp_Xl[l] = gen->Xdp-gen->Xl;
+			b->Xqp_Xl[l] = gen->Xqp-gen->Xl;
+			b->Xdp_Xdpp[l] = gen->Xdp-gen->Xdpp;
+			b->Xqp_Xqpp[l] = gen->Xqp-gen->Xqpp;
+			b->Xd_Xdp[l] = gen->Xd-gen->Xdp;
+			b->Xq_Xqp[l] = gen->Xq-gen->Xqp;
+			b->Tdop[l] = gen->Tdop;
+			b->Tdopp[l] = gen->Tdopp;
+			b->Tqop[l] = gen->Tqop;
+			b->Tqopp[l] = gen->Tqopp;
+			for (k=0; k<3; k++)
+			{
+				for (j=0; j<3; j++)
+				{
+					b->Y_re[3*k+j][l] = gen->generator_admittance[k][j].Re();
+					b->Y_im[3*k+j][l] = gen->generator_admittance[k][j].Im();
+				}
+			}
+		}
+
+		gl_verbose("diesel_dg: %d of %d deltamode generator objects use the batched dynamics", batch_gen_count, gen_object_count);
+		return;
+	}
+
+	if (batch_gen_count == 0)
+		return;
+
+	n_blocks = (batch_gen_count + MAC_BLOCK_WIDTH - 1) / MAC_BLOCK_WIDTH;
+
+	//Sequence transformation term (1@120deg), as in convert_abc_to_pn0
+	aval = complex(cos(2.0*PI/3.0),sin(2.0*PI/3.0));
+	aval_sq = aval*aval;
+
+	for (blk=0; blk<n_blocks; blk++)
+	{
+		b = &batch_blocks[blk];
+
+		//Gather the inputs - the predictor pass works from the current state, the corrector from the predicted one
+		for (l=0; l<MAC_BLOCK_WIDTH; l++)
+		{
+			n = blk*MAC_BLOCK_WIDTH + l;
+			gen = batch_gens[(n < batch_gen_count) ? n : (batch_gen_count - 1)];
+			state = ((iteration_count_val & 1) == 0) ? &gen->curr_state : &gen->next_state;
+
+			for (k=0; k<3; k++)
+			{
+				b->IG_re[k][l] = gen->IGenerated[k].Re();
+				b->IG_im[k][l] = gen->IGenerated[k].Im();
+				b->V_re[k][l] = gen->pCircuit_V[k].Re();
+				b->V_im[k][l] = gen->pCircuit_V[k].Im();
+			}
+			b->rotor_angle[l] = state->rotor_angle;
+			b->omega[l] = state->omega;
+			b->Flux1d[l] = state->Flux1d;
+			b->Flux2q[l] = state->Flux2q;
+			b->Ep_re[l] = state->EpRotated.Re();
+			b->Ep_im[l] = state->EpRotated.Im();
+			b->Vfd[l] = state->Vfd;
+			b->torque_mech[l] = state->torque_mech;
+		}
+
+		//Generator currents and their sequence components
+		for (l=0; l<MAC_BLOCK_WIDTH; l++)
+		{
+			for (k=0; k<3; k++)
+			{
+				tr = b->IG_re[k][l];
+				ti = b->IG_im[k][l];
+				for (j=0; j<3; j++)
+				{
+					tr -= b->Y_re[3*k+j][l]*b->V_re[j][l] - b->Y_im[3*k+j][l]*b->V_im[j][l];
+					ti -= b->Y_re[3*k+j][l]*b->V_im[j][l] + b->Y_im[3*k+j][l]*b->V_re[j][l];
+				}
+				b->I_re[k][l] = tr/b->current_base[l];
+				b->I_im[k][l] = ti/b->current_base[l];
+			}
+
+			x0r = b->I_re[0][l]; x0i = b->I_im[0][l];
+			x1r = b->I_re[1][l]; x1i = b->I_im[1][l];
+			x2r = b->I_re[2][l]; x2i = b->I_im[2][l];
+
+			//Positive sequence
+			tr = x0r + (aval.Re()*x1r - aval.Im()*x1i);
+			ti = x0i + (aval.Re()*x1i + aval.Im()*x1r);
+			tr += aval_sq.Re()*x2r - aval_sq.Im()*x2i;
+			ti += aval_sq.Re()*x2i + aval_sq.Im()*x2r;
+			b->Ip_re[l] = tr/3.0;
+			b->Ip_im[l] = ti/3.0;
+
+			//Negative sequence - only its magnitude is needed
+			tr = x0r + (aval_sq.Re()*x1r - aval_sq.Im()*x1i);
+			ti = x0i + (aval_sq.Re()*x1i + aval_sq.Im()*x1r);
+			tr += aval.Re()*x2r - aval.Im()*x2i;
+			ti += aval.Re()*x2i + aval.Im()*x2r;
+			tr /= 3.0;
+			ti /= 3.0;
+			b->In_sq[l] = tr*tr+ti*ti;
+		}
+
+		//Library functions
+		for (l=0; l<MAC_BLOCK_WIDTH; l++)
+		{
+			b->cos_angle[l] = cos(-1.0*b->rotor_angle[l]);
+			b->sin_angle[l] = sin(-1.0*b->rotor_angle[l]);
+			b->In_mag[l] = sqrt(b->In_sq[l]);
+		}
+
+		//Machine equations
+		for (l=0; l<MAC_BLOCK_WIDTH; l++)
+		{
+			//Rotate current for current angle
+			tr = b->cos_angle[l]*0.0 - b->sin_angle[l]*1.0;
+			ti = b->cos_angle[l]*1.0 + b->sin_angle[l]*0.0;
+			b->Ir_re[l] = tr*b->Ip_re[l] - ti*b->Ip_im[l];
+			b->Ir_im[l] = tr*b->Ip_im[l] + ti*b->Ip_re[l];
+
+			//Speed update
+			temp_double_1  = b->kEq[l]*b->Ep_re[l]*b->Ir_re[l];
+			temp_double_1 -= b->kEd[l]*b->Ep_im[l]*b->Ir_im[l];
+			temp_double_1 -= b->kFd[l]*b->Flux1d[l]*b->Ir_im[l];
+			temp_double_1 += b->kFq[l]*b->Flux2q[l]*b->Ir_re[l];
+			temp_double_1 -= b->Xqpp_Xdpp[l]*b->Ir_re[l]*b->Ir_im[l];
+			temp_double_1 -= b->Rr_half[l]*b->In_mag[l]*b->In_mag[l];
+			b->torque_elec[l] = -temp_double_1*b->Rated_VA[l]/b->omega_ref[l];
+			temp_double_1 = (b->torque_mech[l]/b->torque_base[l] - b->torque_elec[l]/b->torque_base[l]);
+			temp_double_1 -= b->damping[l]*(b->omega[l]-b->omega_ref[l])/b->omega_ref[l];
+			b->pwr_mech[l] = b->torque_mech[l]*b->omega[l];
+			b->d_omega[l] = temp_double_1*b->inertia_gain[l];
+
+			//Rotor angle update
+			omega_pu = b->omega[l]/b->omega_ref[l];
+			b->d_rotor_angle[l] = (omega_pu-1.0)*b->omega_ref[l];
+
+			//Flux updates
+			b->d_Flux1d[l] = (-b->Flux1d[l] + b->Ep_im[l] - (b->Xdp_Xl[l]*b->Ir_re[l]))/b->Tdopp[l];
+			b->d_Flux2q[l] = (-b->Flux2q[l] - b->Ep_re[l] - (b->Xqp_Xl[l]*b->Ir_im[l]))/b->Tqopp[l];
+
+			//Internal voltage updates - EqInt
+			temp_double_1  = b->Vfd[l] - b->Ep_im[l];
+			temp_double_2  = b->Flux1d[l] + b->Xdp_Xl[l]*b->Ir_re[l] - b->Ep_im[l];
+			temp_double_2 /= b->Xdp_Xl[l];
+			temp_double_2 /= b->Xdp_Xl[l];
+			temp_double_3  = b->Ir_re[l] - b->Xdp_Xdpp[l]*temp_double_2;
+			temp_double_1 -= b->Xd_Xdp[l]*temp_double_3;
+			b->d_Ep_im[l] = temp_double_1/b->Tdop[l];
+
+			//Internal voltage updates - EdInt
+			temp_double_1  = -b->Ep_re[l];
+			temp_double_2  = b->Flux2q[l] + b->Xqp_Xl[l]*b->Ir_im[l] + b->Ep_re[l];
+			temp_double_2 /= b->Xqp_Xl[l];
+			temp_double_2 /= b->Xqp_Xl[l];
+			temp_double_3  = b->Ir_im[l] - b->Xqp_Xqpp[l]*temp_double_2;
+			temp_double_1 += b->Xq_Xqp[l]*temp_double_3;
+			b->d_Ep_re[l] = temp_double_1/b->Tqop[l];
+		}
+
+		//Scatter the results - apply_dynamics skips the machine equations of these generators this pass
+		for (l=0; (l<MAC_BLOCK_WIDTH) && (blk*MAC_BLOCK_WIDTH + l < batch_gen_count); l++)
+		{
+			gen = batch_gens[blk*MAC_BLOCK_WIDTH + l];
+
+			//A generator that went out of service since the blocks were built keeps its states as they are
+			obj = OBJECTHDR(gen);
+			if ((obj->in_svc_double > gl_globaldeltaclock) || (obj->out_svc_double < gl_globaldeltaclock))
+				continue;
+
+			if ((iteration_count_val & 1) == 0)
+			{
+				state = &gen->curr_state;
+				delta = &gen->predictor_vals;
+			}
+			else
+			{
+				state = &gen->next_state;
+				delta = &gen->corrector_vals;
+			}
+
+			gen->current_A = complex(b->I_re[0][l],b->I_im[0][l])*b->current_base[l];
+			gen->current_B = complex(b->I_re[1][l],b->I_im[1][l])*b->current_base[l];
+			gen->current_C = complex(b->I_re[2][l],b->I_im[2][l])*b->current_base[l];
+			state->Irotated = complex(b->Ir_re[l],b->Ir_im[l]);
+			state->torque_elec = b->torque_elec[l];
+			state->pwr_mech = b->pwr_mech[l];
+			delta->omega = b->d_omega[l];
+			delta->rotor_angle = b->d_rotor_angle[l];
+			delta->Flux1d = b->d_Flux1d[l];
+			delta->Flux2q = b->d_Flux2q[l];
+			delta->EpRotated = complex(b->d_Ep_re[l],b->d_Ep_im[l]);
+			gen->batch_pass = batch_pass_count;
+		}
+	}
+}
+
+
 //Applies dynamic equations for predictor/corrector sets
 //Functionalized since they are identical
 //Returns a SUCCESS/FAIL
@@ -2456,74 +2797,78 @@ STATUS diesel_dg::apply_dynamics(MAC_STATES *curr_time, MAC_STATES *curr_delta,
 	double temp_double_1, temp_double_2, temp_double_3, delomega, x0; 
 	double torquenow, x5a_now;
 
-	//Convert current as well
-	current_pu[0] = (IGenerated[0] - generator_admittance[0][0]*pCircuit_V[0] - generator_admittance[0][1]*pCircuit_V[1] - generator_admittance[0][2]*pCircuit_V[2])/current_base;
-	current_pu[1] = (IGenerated[1] - generator_admittance[1][0]*pCircuit_V[0] - generator_admittance[1][1]*pCircuit_V[1] - generator_admittance[1][2]*pCircuit_V[2])/current_base;
-	current_pu[2] = (IGenerated[2] - generator_admittance[2][0]*pCircuit_V[0] - generator_admittance[2][1]*pCircuit_V[1] - generator_admittance[2][2]*pCircuit_V[2])/current_base;
-
-	// post currents
-	current_A=current_pu[0]*current_base;
-	current_B=current_pu[1]*current_base;
-	current_C=current_pu[2]*current_base;
-
+	//Machine equations - skipped if the batched update already did them this pass
+	if ((batch_pass == 0) || (batch_pass != batch_pass_count))
+	{
+		//Convert current as well
+		current_pu[0] = (IGenerated[0] - generator_admittance[0][0]*pCircuit_V[0] - generator_admittance[0][1]*pCircuit_V[1] - generator_admittance[0][2]*pCircuit_V[2])/current_base;
+		current_pu[1] = (IGenerated[1] - generator_admittance[1][0]*pCircuit_V[0] - generator_admittance[1][1]*pCircuit_V[1] - generator_admittance[1][2]*pCircuit_V[2])/current_base;
+		current_pu[2] = (IGenerated[2] - generator_admittance[2][0]*pCircuit_V[0] - generator_admittance[2][1]*pCircuit_V[1] - generator_admittance[2][2]*pCircuit_V[2])/current_base;
 
-	//Nab per-unit omega, while we're at it
-	omega_pu = curr_time->omega/omega_ref;
+		// post currents
+		current_A=current_pu[0]*current_base;
+		current_B=current_pu[1]*current_base;
+		current_C=current_pu[2]*current_base;
 
-	//Sequence them
-	convert_abc_to_pn0(&current_pu[0],&Ipn0[0]);
 
-	//Rotate current for current angle
-	temp_complex = complex_exp(-1.0*curr_time->rotor_angle);
-	curr_time->Irotated = temp_complex*complex(0.0,1.0)*Ipn0[0];
-
-	//Get speed update - split for readability
-	temp_double_1 =  -(Xqpp-Xl)/(Xqp-Xl)*curr_time->EpRotated.Re()*curr_time->Irotated.Re();
-	temp_double_1 -=(Xdpp-Xl)/(Xdp-Xl)*curr_time->EpRotated.Im()*curr_time->Irotated.Im();
-	temp_double_1 -=(Xdp-Xdpp)/(Xdp-Xl)*curr_time->Flux1d*curr_time->Irotated.Im();
-	temp_double_1 +=(Xqp-Xqpp)/(Xqp-Xl)*curr_time->Flux2q*curr_time->Irotated.Re();
-	temp_double_1 -=(Xqpp-Xdpp)*curr_time->Irotated.Re()*curr_time->Irotated.Im();
-	temp_double_3 = Ipn0[1].Mag();
-	temp_double_1 -=0.5*Rr*temp_double_3*temp_double_3;
-	curr_time->torque_elec=-temp_double_1*Rated_VA/omega_ref; 
-	temp_double_1 =(curr_time->torque_mech/(Rated_VA/omega_ref)-curr_time->torque_elec/(Rated_VA/omega_ref));
-	temp_double_1 -=damping*(curr_time->omega-omega_ref)/omega_ref;
+		//Nab per-unit omega, while we're at it
+		omega_pu = curr_time->omega/omega_ref;
+
+		//Sequence them
+		convert_abc_to_pn0(&current_pu[0],&Ipn0[0]);
+
+		//Rotate current for current angle
+		temp_complex = complex_exp(-1.0*curr_time->rotor_angle);
+		curr_time->Irotated = temp_complex*complex(0.0,1.0)*Ipn0[0];
+
+		//Get speed update - split for readability
+		temp_double_1 =  -(Xqpp-Xl)/(Xqp-Xl)*curr_time->EpRotated.Re()*curr_time->Irotated.Re();
+		temp_double_1 -=(Xdpp-Xl)/(Xdp-Xl)*curr_time->EpRotated.Im()*curr_time->Irotated.Im();
+		temp_double_1 -=(Xdp-Xdpp)/(Xdp-Xl)*curr_time->Flux1d*curr_time->Irotated.Im();
+		temp_double_1 +=(Xqp-Xqpp)/(Xqp-Xl)*curr_time->Flux2q*curr_time->Irotated.Re();
+		temp_double_1 -=(Xqpp-Xdpp)*curr_time->Irotated.Re()*curr_time->Irotated.Im();
+		temp_double_3 = Ipn0[1].Mag();
+		temp_double_1 -=0.5*Rr*temp_double_3*temp_double_3;
+		curr_time->torque_elec=-temp_double_1*Rated_VA/omega_ref; 
+		temp_double_1 =(curr_time->torque_mech/(Rated_VA/omega_ref)-curr_time->torque_elec/(Rated_VA/omega_ref));
+		temp_double_1 -=damping*(curr_time->omega-omega_ref)/omega_ref;
 
-	curr_time->pwr_mech = curr_time->torque_mech*curr_time->omega;
+		curr_time->pwr_mech = curr_time->torque_mech*curr_time->omega;
 
-	temp_double_2 = omega_ref/(2.0*inertia);
+		temp_double_2 = omega_ref/(2.0*inertia);
 
-	//Post the delta value
-	curr_delta->omega = temp_double_1*temp_double_2;
+		//Post the delta value
+		curr_delta->omega = temp_double_1*temp_double_2;
 
-	//Calculate rotor angle update
-	curr_delta->rotor_angle = (omega_pu-1.0)*omega_ref;
+		//Calculate rotor angle update
+		curr_delta->rotor_angle = (omega_pu-1.0)*omega_ref;
 
-	//Update flux values
-	curr_delta->Flux1d = (-curr_time->Flux1d + curr_time->EpRotated.Im() - ((Xdp-Xl)*curr_time->Irotated.Re()))/Tdopp;
-	curr_delta->Flux2q = (-curr_time->Flux2q - curr_time->EpRotated.Re() - ((Xqp-Xl)*curr_time->Irotated.Im()))/Tqopp;
+		//Update flux values
+		curr_delta->Flux1d = (-curr_time->Flux1d + curr_time->EpRotated.Im() - ((Xdp-Xl)*curr_time->Irotated.Re()))/Tdopp;
+		curr_delta->Flux2q = (-curr_time->Flux2q - curr_time->EpRotated.Re() - ((Xqp-Xl)*curr_time->Irotated.Im()))/Tqopp;
 
-	//Internal voltage updates - EqInt - again split for readability
-	temp_double_1  = curr_time->Vfd - curr_time->EpRotated.Im();
-	temp_double_2  = curr_time->Flux1d + (Xdp-Xl)*curr_time->Irotated.Re() - curr_time->EpRotated.Im();
-	temp_double_2 /= (Xdp-Xl);
-	temp_double_2 /= (Xdp-Xl);
-	temp_double_3  = curr_time->Irotated.Re() - (Xdp-Xdpp)*temp_double_2;
-	temp_double_1 -= (Xd-Xdp)*temp_double_3;
+		//Internal voltage updates - EqInt - again split for readability
+		temp_double_1  = curr_time->Vfd - curr_time->EpRotated.Im();
+		temp_double_2  = curr_time->Flux1d + (Xdp-Xl)*curr_time->Irotated.Re() - curr_time->EpRotated.Im();
+		temp_double_2 /= (Xdp-Xl);
+		temp_double_2 /= (Xdp-Xl);
+		temp_double_3  = curr_time->Irotated.Re() - (Xdp-Xdpp)*temp_double_2;
+		temp_double_1 -= (Xd-Xdp)*temp_double_3;
 
-	//Post the update value
-	curr_delta->EpRotated.SetImag(temp_double_1/Tdop);
+		//Post the update value
+		curr_delta->EpRotated.SetImag(temp_double_1/Tdop);
 
-	//Internal voltage updates - EdInt - again split for readability
-	temp_double_1  = -curr_time->EpRotated.Re();
-	temp_double_2  = curr_time->Flux2q + (Xqp-Xl)*curr_time->Irotated.Im() + curr_time->EpRotated.Re();
-	temp_double_2 /= (Xqp-Xl);
-	temp_double_2 /= (Xqp-Xl);
-	temp_double_3  = curr_time->Irotated.Im() - (Xqp-Xqpp)*temp_double_2;
-	temp_double_1 += (Xq-Xqp)*temp_double_3;
+		//Internal voltage updates - EdInt - again split for readability
+		temp_double_1  = -curr_time->EpRotated.Re();
+		temp_double_2  = curr_time->Flux2q + (Xqp-Xl)*curr_time->Irotated.Im() + curr_time->EpRotated.Re();
+		temp_double_2 /= (Xqp-Xl);
+		temp_double_2 /= (Xqp-Xl);
+		temp_double_3  = curr_time->Irotated.Im() - (Xqp-Xqpp)*temp_double_2;
+		temp_double_1 += (Xq-Xqp)*temp_double_3;
 
-	//Post the update value
-	curr_delta->EpRotated.SetReal(temp_double_1/Tqop);
+		//Post the update value
+		curr_delta->EpRotated.SetReal(temp_double_1/Tqop);
+	}
 
 	//Governor updates, if relevant
 	if (Governor_type == DEGOV1)	//Woodward Governor
@@ -153,6 +153,7 @@ private:
 	MAC_STATES next_state;
 	MAC_STATES predictor_vals;	//Predictor pass values of variables
 	MAC_STATES corrector_vals;	//Corrector pass values of variables
+	unsigned int64 batch_pass;	//Pass of the batched machine dynamics that last updated this generator (0 if never)
 
 	bool deltamode_inclusive;	//Boolean for deltamode calls - pulled from object flags
 	double *mapped_freq_variable;	//Mapping to frequency variable in powerflow module - deltamode updates
@@ -361,6 +362,7 @@ public:
 	//STATUS deltaupdate(unsigned int64 dt, unsigned int iteration_count_val);
 	SIMULATIONMODE inter_deltaupdate(unsigned int64 delta_time, unsigned long dt, unsigned int iteration_count_val);
 	STATUS post_deltaupdate(complex *useful_value, unsigned int mode_pass);
+	static void batch_dynamics(unsigned int64 delta_time, unsigned int iteration_count_val);
 public:
 	static CLASS *oclass;
 	static diesel_dg *defaults;
@@ -40,6 +40,7 @@ GLOBAL OBJECT **delta_objects INIT(NULL);				/* Array pointer objects that need
 GLOBAL FUNCTIONADDR *delta_preupdate_functions INIT(NULL);	/* Array pointer functions for objects that need deltamode preupdate calls */
 GLOBAL FUNCTIONADDR *delta_functions INIT(NULL);			/* Array pointer functions for objects that need deltamode interupdate calls */
 GLOBAL FUNCTIONADDR *post_delta_functions INIT(NULL);		/* Array pointer functions for objects that need deltamode postupdate calls */
+GLOBAL bool enable_batch_dynamics INIT(false);			/* Update the machine dynamics of all diesel_dg objects in one batch */
 GLOBAL int gen_object_count INIT(0);		/* deltamode object count */
 GLOBAL int gen_object_current INIT(-1);		/* Index of current deltamode object */
 GLOBAL TIMESTAMP deltamode_starttime INIT(TS_NEVER);	/* Tracking variable for next desired instance of deltamode */
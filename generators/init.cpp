@@ -6,6 +6,7 @@
 #include <errno.h>
 #include <math.h>
 #include "gridlabd.h"
+#include "threadpool.h"
 
 #define _GENERATORS_GLOBALS
 #include "generators.h"
@@ -30,6 +31,7 @@ EXPORT CLASS *init(CALLBACKS *fntable, MODULE *module, int argc, char *argv[])
 	/* Publish external global variables */
 	gl_global_create("generators::enable_subsecond_models", PT_bool, &enable_subsecond_models,PT_DESCRIPTION,"Enable deltamode capabilities within the powerflow module",NULL);
 	gl_global_create("generators::deltamode_timestep", PT_double, &deltamode_timestep_publish,PT_UNITS,"ns",PT_DESCRIPTION,"Desired minimum timestep for deltamode-related simulations",NULL);
+	gl_global_create("generators::enable_batch_dynamics", PT_bool, &enable_batch_dynamics,PT_DESCRIPTION,"Update the machine dynamics of all deltamode diesel_dg objects together in one batch",NULL);
 
 	CLASS *first =
 	/*** DO NOT EDIT NEXT LINE ***/
@@ -259,6 +261,198 @@ EXPORT unsigned long preupdate(MODULE *module, TIMESTAMP t0, unsigned int64 dt)
 	}
 }
 
+//Interupdate dispatch over the core thread pool
+//Generators post their currents and powers into their parent node during the update,
+//so objects are grouped by the first ancestor outside this module and each group is
+//updated in list order by one thread.  Separate groups share no data and run concurrently.
+typedef struct s_interupdate_group {
+	int n_objects;		//Number of objects in the group
+	int *object_index;	//Indices into delta_objects, in list order
+} INTERUPDATE_GROUP;
+
+//Iterator input and result - the pass number starts each pass of the threads
+typedef struct s_interupdate_data {
+	unsigned int64 pass;
+	unsigned int64 delta_time;
+	unsigned long dt;
+	unsigned int iteration_count_val;
+	SIMULATIONMODE status;	//Combined result of the updates (highest of SM_EVENT, SM_DELTA, SM_DELTA_ITER, SM_ERROR)
+} INTERUPDATE_DATA;
+
+typedef struct s_interupdate_root {
+	OBJECT *root;
+	int index;
+} INTERUPDATE_ROOT;
+
+static INTERUPDATE_GROUP *interupdate_groups = NULL;
+static int interupdate_group_count = 0;
+static MTI *interupdate_mti = NULL;
+static bool interupdate_mti_checked = false;
+static unsigned int64 interupdate_pass = 0;
+
+//Update one object - returns its simulation mode
+static SIMULATIONMODE interupdate_object(int curr_object_number, unsigned int64 delta_time, unsigned long dt, unsigned int iteration_count_val)
+{
+	SIMULATIONMODE function_status;
+
+	//See if we're in service or not
+	if ((delta_objects[curr_object_number]->in_svc_double <= gl_globaldeltaclock) && (delta_objects[curr_object_number]->out_svc_double >= gl_globaldeltaclock))
+	{
+		//Call the actual function
+		function_status = ((SIMULATIONMODE (*)(OBJECT *, unsigned int64, unsigned long, unsigned int))(*delta_functions[curr_object_number]))(delta_objects[curr_object_number],delta_time,dt,iteration_count_val);
+	}
+	else //Not in service - off to event mode
+		function_status = SM_EVENT;
+
+	if (function_status == SM_ERROR)
+	{
+		gl_error("Generator object:%s - deltamode function returned an error!",delta_objects[curr_object_number]->name);
+		/*  TROUBLESHOOT
+		While performing a deltamode update, one object returned an error code.  Check to see if the object itself provided
+		more details and try again.  If the error persists, please submit your code and a bug report via the trac website.
+		*/
+	}
+
+	return function_status;
+}
+
+static MTIITEM interupdate_get(MTIITEM item)
+{
+	INTERUPDATE_GROUP *group = (INTERUPDATE_GROUP*)item;
+
+	if (group == NULL)
+		return interupdate_group_count>0 ? (MTIITEM)interupdate_groups : NULL;
+	else if (group+1 < interupdate_groups+interupdate_group_count)
+		return (MTIITEM)(group+1);
+	else
+		return NULL;
+}
+
+static void interupdate_call(MTIDATA output, MTIITEM item, MTIDATA input)
+{
+	INTERUPDATE_GROUP *group = (INTERUPDATE_GROUP*)item;
+	INTERUPDATE_DATA *result = (INTERUPDATE_DATA*)output;
+	INTERUPDATE_DATA *data = (INTERUPDATE_DATA*)input;
+	SIMULATIONMODE function_status;
+	int n;
+
+	for (n=0; n<group->n_objects; n++)
+	{
+		function_status = interupdate_object(group->object_index[n],data->delta_time,data->dt,data->iteration_count_val);
+
+		if (function_status > result->status)
+			result->status = function_status;
+
+		//Stop this group on an error, as the serial loop does
+		if (function_status == SM_ERROR)
+			break;
+	}
+}
+
+static MTIDATA interupdate_set(MTIDATA to, MTIDATA from)
+{
+	if (to == NULL)
+		to = (MTIDATA)malloc(sizeof(INTERUPDATE_DATA));
+	if (to != NULL)
+	{
+		if (from == NULL)
+			memset(to,0,sizeof(INTERUPDATE_DATA));
+		else
+			memcpy(to,from,sizeof(INTERUPDATE_DATA));
+	}
+	return to;
+}
+
+static int interupdate_compare(MTIDATA a, MTIDATA b)
+{
+	//The threads wait while their last pass matches the current one
+	return ((INTERUPDATE_DATA*)a)->pass == ((INTERUPDATE_DATA*)b)->pass ? 0 : 2;
+}
+
+static void interupdate_gather(MTIDATA a, MTIDATA b)
+{
+	INTERUPDATE_DATA *to = (INTERUPDATE_DATA*)a;
+	INTERUPDATE_DATA *from = (INTERUPDATE_DATA*)b;
+
+	if (from->status > to->status)
+		to->status = from->status;
+}
+
+static int interupdate_reject(MTI *mti, MTIDATA data)
+{
+	return 0;	//Every pass is needed
+}
+
+static int interupdate_root_compare(const void *a, const void *b)
+{
+	const INTERUPDATE_ROOT *x = (const INTERUPDATE_ROOT*)a;
+	const INTERUPDATE_ROOT *y = (const INTERUPDATE_ROOT*)b;
+
+	if (x->root != y->root)
+		return x->root->id < y->root->id ? -1 : 1;
+	else
+		return x->index - y->index;
+}
+
+//Group the deltamode objects and create the iterator - leaves it NULL if the updates must run serially
+static void interupdate_setup(MODULE *module)
+{
+	static MTIFUNCTIONS fns = {interupdate_get, interupdate_call, interupdate_set, interupdate_compare, interupdate_gather, interupdate_reject};
+	INTERUPDATE_ROOT *roots;
+	int *indices;
+	int curr_object_number, n_roots, n;
+
+	roots = (INTERUPDATE_ROOT*)gl_malloc(gen_object_count*sizeof(INTERUPDATE_ROOT));
+	indices = (int*)gl_malloc(gen_object_count*sizeof(int));
+	interupdate_groups = (INTERUPDATE_GROUP*)gl_malloc(gen_object_count*sizeof(INTERUPDATE_GROUP));
+	if ((roots == NULL) || (indices == NULL) || (interupdate_groups == NULL))
+	{
+		gl_warning("generators: unable to allocate the deltamode update groups, updates will run single threaded");
+		/*  TROUBLESHOOT
+		The memory needed to run the deltamode object updates in parallel could not be allocated.  The updates
+		are run in a single thread instead, which gives the same results more slowly.
+		*/
+		interupdate_group_count = 0;
+		return;
+	}
+
+	//Find the object each one posts to
+	n_roots = 0;
+	for (curr_object_number=0; curr_object_number<gen_object_count; curr_object_number++)
+	{
+		OBJECT *root = delta_objects[curr_object_number];
+
+		if ((root == NULL) || (delta_functions[curr_object_number] == NULL))
+			continue;
+
+		while ((root->parent != NULL) && (root->oclass->module == module))
+			root = root->parent;
+
+		roots[n_roots].root = root;
+		roots[n_roots].index = curr_object_number;
+		n_roots++;
+	}
+
+	//Collect the objects posting to the same object, keeping their list order
+	qsort(roots,n_roots,sizeof(INTERUPDATE_ROOT),interupdate_root_compare);
+	interupdate_group_count = 0;
+	for (n=0; n<n_roots; n++)
+	{
+		if ((n == 0) || (roots[n].root != roots[n-1].root))
+		{
+			interupdate_groups[interupdate_group_count].n_objects = 0;
+			interupdate_groups[interupdate_group_count].object_index = indices+n;
+			interupdate_group_count++;
+		}
+		indices[n] = roots[n].index;
+		interupdate_groups[interupdate_group_count-1].n_objects++;
+	}
+	gl_free(roots);
+
+	interupdate_mti = gl_mti_init("generators::interupdate",&fns,8);
+	gl_verbose("generators: %d deltamode objects in %d update groups, updated %s", n_roots, interupdate_group_count, interupdate_mti!=NULL ? "in parallel" : "single threaded");
+}
+
 //interupdate function of deltamode
 //Module-level call for each timestep of deltamode
 //Ideally, all deltamode objects coordinate through their module call, not their individual "update" call
@@ -272,17 +466,42 @@ EXPORT SIMULATIONMODE interupdate(MODULE *module, TIMESTAMP t0, unsigned int64 d
 	
 	if (enable_subsecond_models == true)
 	{
-		//Loop through the object list and call the updates
-		for (curr_object_number=0; curr_object_number<gen_object_count; curr_object_number++)
+		//Group the objects on the first update
+		if (interupdate_mti_checked == false)
 		{
-			//See if we're in service or not
-			if ((delta_objects[curr_object_number]->in_svc_double <= gl_globaldeltaclock) && (delta_objects[curr_object_number]->out_svc_double >= gl_globaldeltaclock))
+			interupdate_setup(module);
+			interupdate_mti_checked = true;
+		}
+
+		//Update the machine dynamics of the diesel generators together, if desired
+		if (enable_batch_dynamics == true)
+			diesel_dg::batch_dynamics(delta_time,iteration_count_val);
+
+		//Update the groups in parallel, if possible
+		if (interupdate_mti != NULL)
+		{
+			INTERUPDATE_DATA input, result;
+
+			memset(&input,0,sizeof(input));
+			input.pass = ++interupdate_pass;
+			input.delta_time = delta_time;
+			input.dt = dt;
+			input.iteration_count_val = iteration_count_val;
+
+			if (gl_mti_run(&result,interupdate_mti,&input))
 			{
-				//Call the actual function
-				function_status = ((SIMULATIONMODE (*)(OBJECT *, unsigned int64, unsigned long, unsigned int))(*delta_functions[curr_object_number]))(delta_objects[curr_object_number],delta_time,dt,iteration_count_val);
+				if ((result.status == SM_DELTA) || (result.status == SM_DELTA_ITER) || (result.status == SM_ERROR))
+					return result.status;
+				else
+					return SM_EVENT;
 			}
-			else //Not in service - off to event mode
-				function_status = SM_EVENT;
+			//Default else - run single threaded
+		}
+
+		//Loop through the object list and call the updates
+		for (curr_object_number=0; curr_object_number<gen_object_count; curr_object_number++)
+		{
+			function_status = interupdate_object(curr_object_number,delta_time,dt,iteration_count_val);
 
 			//Determine what our return is
 			if (function_status == SM_DELTA)
@@ -293,14 +512,7 @@ EXPORT SIMULATIONMODE interupdate(MODULE *module, TIMESTAMP t0, unsigned int64 d
 				delta_iter = true;
 			}
 			else if (function_status == SM_ERROR)
-			{
-				gl_error("Generator object:%s - deltamode function returned an error!",delta_objects[curr_object_number]->name);
-				/*  TROUBLESHOOT
-				While performing a deltamode update, one object returned an error code.  Check to see if the object itself provided
-				more details and try again.  If the error persists, please submit your code and a bug report via the trac website.
-				*/
-				return SM_ERROR;
-			}
+				return SM_ERROR;	//Error message given by interupdate_object
 			//Default else, we're in SM_EVENT, so no flag change needed
 		}
 				
@@ -321,6 +533,18 @@ EXPORT SIMULATIONMODE interupdate(MODULE *module, TIMESTAMP t0, unsigned int64 d
 	}
 }
 
+//nextstep function of deltamode
+//Module-level call after each deltamode timestep when the timestep may vary
+//The machine and inverter controls are integrated with the step they were set up with
+//and a step cannot be rejected and retried, so deltamode objects hold the timestep
+EXPORT unsigned long deltamode_nextstep(MODULE *module, TIMESTAMP t0, unsigned int64 delta_time, unsigned long dt)
+{
+	if ((enable_subsecond_models == true) && (gen_object_count > 0))
+		return dt;
+	else
+		return DT_INFINITY;
+}
+
 //postupdate function of deltamode
 //Executes after all objects in the simulation agree to go back to event-driven mode
 //Return value is a SUCCESS/FAILURE
@@ -1,9 +1,14 @@
+dist_pkgdata_DATA += gldcore/benchmark.txt
 dist_pkgdata_DATA += gldcore/tzinfo.txt
 dist_pkgdata_DATA += gldcore/unitfile.txt
 
 GLD_SOURCES_PLACE_HOLDER = 
+GLD_SOURCES_PLACE_HOLDER += gldcore/accumulator.c
+GLD_SOURCES_PLACE_HOLDER += gldcore/accumulator.h
 GLD_SOURCES_PLACE_HOLDER += gldcore/aggregate.c
 GLD_SOURCES_PLACE_HOLDER += gldcore/aggregate.h
+GLD_SOURCES_PLACE_HOLDER += gldcore/benchmark.cpp
+GLD_SOURCES_PLACE_HOLDER += gldcore/benchmark.h
 GLD_SOURCES_PLACE_HOLDER += gldcore/build.h
 GLD_SOURCES_PLACE_HOLDER += gldcore/class.c
 GLD_SOURCES_PLACE_HOLDER += gldcore/class.h
@@ -101,9 +106,14 @@ GLD_SOURCES_PLACE_HOLDER += gldcore/server.c
 GLD_SOURCES_PLACE_HOLDER += gldcore/server.h
 GLD_SOURCES_PLACE_HOLDER += gldcore/setup.cpp
 GLD_SOURCES_PLACE_HOLDER += gldcore/setup.h
+GLD_SOURCES_PLACE_HOLDER += gldcore/statistics.c
+GLD_SOURCES_PLACE_HOLDER += gldcore/statistics.h
 GLD_SOURCES_PLACE_HOLDER += gldcore/stream.cpp
 GLD_SOURCES_PLACE_HOLDER += gldcore/stream.h
 GLD_SOURCES_PLACE_HOLDER += gldcore/stream_type.h
+GLD_SOURCES_PLACE_HOLDER += gldcore/telemetry.c
+GLD_SOURCES_PLACE_HOLDER += gldcore/telemetry.h
+GLD_SOURCES_PLACE_HOLDER += gldcore/telemetry_reader.c
 GLD_SOURCES_PLACE_HOLDER += gldcore/test.c
 GLD_SOURCES_PLACE_HOLDER += gldcore/test_callbacks.h
 GLD_SOURCES_PLACE_HOLDER += gldcore/test_framework.cpp
@@ -197,6 +207,7 @@ pkginclude_HEADERS += gldcore/module.h
 pkginclude_HEADERS += gldcore/object.h
 pkginclude_HEADERS += gldcore/property.h
 pkginclude_HEADERS += gldcore/schedule.h
+pkginclude_HEADERS += gldcore/telemetry.h
 pkginclude_HEADERS += gldcore/test.h
 pkginclude_HEADERS += gldcore/version.h
 
@@ -0,0 +1,198 @@
+/** $Id$
+	Copyright (C) 2008 Battelle Memorial Institute
+	@file accumulator.c
+	@addtogroup accumulator
+	@ingroup core
+
+	Lock-free accumulation of values into an object.
+
+	Each accumulator has one partial buffer per thread, padded to a cache
+	line so threads adding into the same accumulator do not share lines.
+	The first time a thread adds into an accumulator after a combine, the
+	accumulator is put on the list of that thread, so the combine only
+	visits the accumulators that were used.  The combine runs on the main
+	thread while the object threads are waiting, and adds the partial sums
+	in the order of the threads, so the result does not depend on which
+	thread finished first.
+ @{
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "platform.h"
+#include "output.h"
+#include "globals.h"
+#include "lock.h"
+#include "accumulator.h"
+
+#define CACHELINE 64
+
+static ACCUMULATOR *accumulator_list = NULL;
+static unsigned int accumulator_lock = 0;
+static ACCUMULATOR **used_list = NULL; /* accumulators with partial sums, by slot */
+static unsigned int n_slots = 0;
+static pthread_key_t slot_key;
+
+int64 accumulator_combines = 0;
+
+#define SLOT(A,S) ((ACCUMULATORSLOT*)((A)->buffer + (S)*(A)->stride))
+#define SUMS(P) ((double*)((P)+1))
+
+/** Get the accumulator of the values, creating it if none exists yet
+	@return the accumulator, or NULL if memory could not be allocated
+ **/
+ACCUMULATOR *accumulator_create(complex *value, /**< the values to accumulate into */
+								unsigned int n) /**< the number of values */
+{
+	ACCUMULATOR *acc;
+	char *block;
+
+	/* objects may be initialized in parallel */
+	wlock(&accumulator_lock);
+	for ( acc=accumulator_list ; acc!=NULL ; acc=acc->next )
+	{
+		if ( acc->value==value && acc->n==n )
+			goto Done;
+	}
+
+	if ( n_slots==0 )
+	{
+		n_slots = global_threadcount>1 ? global_threadcount : 1;
+		used_list = (ACCUMULATOR**)malloc(sizeof(ACCUMULATOR*)*n_slots);
+		if ( used_list==NULL || pthread_key_create(&slot_key,NULL)!=0 )
+		{
+			output_error("accumulator_create(): unable to allocate the accumulator slots");
+			/* TROUBLESHOOT
+				The system could not allocate the per-thread lists of the accumulators.
+				Try freeing up system memory, or reducing the thread count, and try again.
+			 */
+			n_slots = 0;
+			goto Done;
+		}
+		memset(used_list,0,sizeof(ACCUMULATOR*)*n_slots);
+	}
+
+	acc = (ACCUMULATOR*)malloc(sizeof(ACCUMULATOR));
+	if ( acc==NULL )
+		goto Failed;
+	acc->value = value;
+	acc->n = n;
+	acc->slots = global_accumulators ? n_slots : 1;
+	acc->lock = 0;
+	acc->stride = (sizeof(ACCUMULATORSLOT) + sizeof(double)*2*n + CACHELINE-1)/CACHELINE*CACHELINE;
+	block = (char*)malloc(acc->stride*acc->slots + CACHELINE);
+	if ( block==NULL )
+	{
+		free(acc);
+		acc = NULL;
+		goto Failed;
+	}
+	memset(block,0,acc->stride*acc->slots + CACHELINE);
+	acc->buffer = block + (CACHELINE - (size_t)block%CACHELINE);
+	acc->next = accumulator_list;
+	accumulator_list = acc;
+	goto Done;
+
+Failed:
+	output_error("accumulator_create(): unable to allocate an accumulator of %d values", n);
+	/* TROUBLESHOOT
+		The system could not allocate the partial buffers of an accumulator.
+		Try freeing up system memory, or reducing the thread count, and try again.
+	 */
+Done:
+	wunlock(&accumulator_lock);
+	return acc;
+}
+
+/* add the values into the partial buffer of the calling thread */
+static void accumulate(ACCUMULATOR *acc, complex *values, double sign)
+{
+	unsigned int i;
+	ACCUMULATORSLOT *slot;
+	double *sum;
+	size_t s;
+
+	/* on a single thread nothing else writes the values, otherwise they are locked */
+	if ( acc->slots==1 )
+	{
+		if ( n_slots>1 )
+			wlock(&acc->lock);
+		for ( i=0 ; i<acc->n ; i++ )
+		{
+			acc->value[i].r += sign*values[i].r;
+			acc->value[i].i += sign*values[i].i;
+		}
+		if ( n_slots>1 )
+			wunlock(&acc->lock);
+		return;
+	}
+
+	s = (size_t)pthread_getspecific(slot_key);
+	slot = SLOT(acc,s);
+	if ( !slot->used )
+	{
+		slot->used = 1;
+		slot->next = used_list[s];
+		used_list[s] = acc;
+	}
+	sum = SUMS(slot);
+	for ( i=0 ; i<acc->n ; i++ )
+	{
+		sum[2*i] += sign*values[i].r;
+		sum[2*i+1] += sign*values[i].i;
+	}
+}
+
+/** Add values to an accumulator **/
+void accumulator_add(ACCUMULATOR *acc, /**< the accumulator */
+					 complex *values) /**< the values to add */
+{
+	accumulate(acc,values,+1);
+}
+
+/** Subtract values from an accumulator **/
+void accumulator_sub(ACCUMULATOR *acc, /**< the accumulator */
+					 complex *values) /**< the values to subtract */
+{
+	accumulate(acc,values,-1);
+}
+
+/** Set the partial buffer used by the calling thread.
+	Threads that do not call this use the first buffer.
+ **/
+void accumulator_thread(unsigned int slot) /**< the slot of the thread (less than the thread count) */
+{
+	if ( n_slots>1 && slot<n_slots )
+		pthread_setspecific(slot_key,(void*)(size_t)slot);
+}
+
+/** Combine the partial buffers into the values.
+	This must only be called while no object is synchronizing.
+ **/
+void accumulator_syncall(void)
+{
+	unsigned int s, i;
+	for ( s=0 ; s<n_slots ; s++ )
+	{
+		ACCUMULATOR *acc = used_list[s];
+		while ( acc!=NULL )
+		{
+			ACCUMULATORSLOT *slot = SLOT(acc,s);
+			double *sum = SUMS(slot);
+			for ( i=0 ; i<acc->n ; i++ )
+			{
+				acc->value[i].r += sum[2*i];
+				acc->value[i].i += sum[2*i+1];
+				sum[2*i] = sum[2*i+1] = 0;
+			}
+			slot->used = 0;
+			acc = slot->next;
+			accumulator_combines++;
+		}
+		used_list[s] = NULL;
+	}
+}
+
+/**@}**/
@@ -0,0 +1,62 @@
+/** $Id$
+    Copyright (C) 2008 Battelle Memorial Institute
+
+@file accumulator.h
+@addtogroup accumulator Load accumulators
+@ingroup core
+
+Accumulators let many objects add values into the same object (usually
+their parent) without locking it.  Each thread that synchronizes objects
+adds into its own partial buffer, and the core combines the partial
+buffers into the values once all the objects of a rank have been
+synchronized, i.e., before the objects of the next rank, including the
+parent, see them.
+
+Objects that add into the same values share the same accumulator, which
+is found by the address of the values when it is created.  When the
+simulation runs on a single thread the values are added directly.  When
+the global \p accumulators is false the values are added directly under
+the lock of the accumulator, which is how the objects used to post into
+their parents.
+
+@{**/
+
+#ifndef _ACCUMULATOR_H
+#define _ACCUMULATOR_H
+
+#include "complex.h"
+
+/** Partial buffer of an accumulator **/
+typedef struct s_accumulatorslot {
+	struct s_accumulator *next;	/**< next accumulator with partial sums in the same slot */
+	unsigned int used;			/**< the slot holds partial sums to combine */
+} ACCUMULATORSLOT; /**< followed by the real and imaginary parts of the partial sums */
+
+/** Accumulator **/
+typedef struct s_accumulator {
+	complex *value;				/**< values accumulated into */
+	unsigned int n;				/**< number of values */
+	unsigned int slots;			/**< number of partial buffers (one per thread) */
+	size_t stride;				/**< size of a partial buffer, padded to a cache line */
+	char *buffer;				/**< partial buffers */
+	unsigned int lock;			/**< lock of the values when they are added directly */
+	struct s_accumulator *next;	/**< next accumulator */
+} ACCUMULATOR; /**< accumulator */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+ACCUMULATOR *accumulator_create(complex *value, unsigned int n);
+void accumulator_add(ACCUMULATOR *acc, complex *values);
+void accumulator_sub(ACCUMULATOR *acc, complex *values);
+void accumulator_thread(unsigned int slot);
+void accumulator_syncall(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/**@}**/
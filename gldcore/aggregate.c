@@ -34,6 +34,12 @@
 #include "aggregate.h"
 #include "output.h"
 #include "find.h"
+#include "globals.h"
+#include "lock.h"
+#include "threadpool.h"
+#include "exception.h"
+
+static AGGRGROUP *aggregate_group(char *group_expression, FINDPGM *pgm, FINDLIST *list);
 
 /** This function builds an collection of objects into an aggregation.  
 	The aggregation can be run using aggregate_value(AGGREGATION*)
@@ -313,6 +319,18 @@ AGGREGATION *aggregate_mkgroup(char *aggregator, /**< aggregator (min,max,avg,st
 			result->flags = flags;
 			result->punit = to_unit;
 			result->scale = scale;
+			result->members = aggregate_group(group_expression,pgm,list);
+			if ( result->members==NULL )
+			{
+				output_error("aggregate group expression '%s' membership could not be resolved", group_expression);
+				/* TROUBLESHOOT
+					The members of an aggregate group could not be stored.  
+					Free up memory and try again.
+				 */
+				free(result);
+				result = NULL;
+				errno=ENOMEM;
+			}
 		}
 		else
 		{
@@ -338,110 +356,276 @@ double arg(complex *x)
 	return (x->r==0) ? (x->i>0 ? PI/2 : (x->i==0 ? 0 : -PI/2)) : ((x->i>0) ? (x->r>0 ? atan(x->i/x->r) : PI-atan(x->i/x->r)) : (x->r>0 ? -atan(x->i/x->r) : PI+atan(x->i/x->r)));
 }
 
-/** This function performs an aggregate calculation given by the aggregation 
- **/
-double aggregate_value(AGGREGATION *aggr) /**< the aggregation to perform */
+/* Aggregations over the same group expression share one resolved membership list.
+   The find program is re-run on every evaluation when the group criteria are not
+   constant, otherwise only when objects are added, and the in-service subset
+   is only rebuilt when the clock crosses a member's service boundary.  All the
+   aggregations of a collector are reduced in one pass over the members, split over
+   the helper threads when the group is large enough.
+ */
+#define AGGR_SWEEPSIZE 32 /**< maximum number of aggregations reduced in one pass */
+#define AGGR_MTI_MINITEMS 4096 /**< minimum number of in-service members per helper thread */
+
+/** partial reduction of an aggregation */
+typedef struct s_aggracc {
+	double numerator, denominator, secondary;
+} AGGRACC;
+
+/** share of the in-service members reduced by a helper thread */
+typedef struct s_aggrchunk {
+	AGGRGROUP *group; /**< the group reduced */
+	unsigned int id; /**< the chunk number */
+	AGGRACC acc[AGGR_SWEEPSIZE]; /**< the partial reductions */
+} AGGRCHUNK;
+
+struct s_aggrgroup {
+	char *expression; /**< the group expression */
+	FINDPGM *pgm; /**< the find program of the group */
+	unsigned int lock; /**< group lock */
+	unsigned int n_objects; /**< object count when the members were resolved */
+	unsigned int n_changes; /**< service change count when the in-service list was built */
+	OBJECT **member; /**< the members of the group */
+	unsigned int n_members; /**< the number of members */
+	OBJECT **active; /**< the members in service */
+	unsigned int n_active; /**< the number of members in service */
+	TIMESTAMP active_from, active_to; /**< the clock interval over which the in-service list is valid */
+	MTI *mti; /**< the multithreaded iterator (NULL if none) */
+	int mti_tried; /**< flag indicating the iterator was attempted */
+	AGGRCHUNK *chunk; /**< the chunks reduced by the iterator */
+	unsigned int n_chunks; /**< the number of chunks */
+	int64 seq; /**< the iterator run count */
+	struct s_aggrgroup *next; /**< the next group */
+};
+
+/** aggregations reduced in one pass */
+typedef struct s_aggrsweep {
+	AGGRGROUP *group;
+	unsigned int n;
+	AGGREGATION *aggr[AGGR_SWEEPSIZE];
+} AGGRSWEEP;
+
+/** iterator data */
+typedef struct s_aggrrun {
+	int64 seq;
+	AGGRSWEEP *sweep;
+} AGGRRUN;
+
+static AGGRGROUP *group_list = NULL;
+static unsigned int group_lock = 0;
+
+/* resolve the members of a group from a find list */
+static int aggregate_members(AGGRGROUP *grp, FINDLIST *list)
 {
 	OBJECT *obj;
-	double numerator=0, denominator=0, secondary=0, third=0, fourth=0;
-	double scale = (aggr->punit ? aggr->scale : 1.0);
+	unsigned int n = 0;
+	OBJECT **member = (OBJECT**)realloc(grp->member,sizeof(OBJECT*)*(list->hit_count+1));
+	OBJECT **active = (OBJECT**)realloc(grp->active,sizeof(OBJECT*)*(list->hit_count+1));
+	if ( member!=NULL ) grp->member = member;
+	if ( active!=NULL ) grp->active = active;
+	if ( member==NULL || active==NULL )
+	{
+		errno = ENOMEM;
+		return 0;
+	}
+	for ( obj=find_first(list) ; obj!=NULL && n<list->hit_count ; obj=find_next(list,obj) )
+		grp->member[n++] = obj;
+	grp->n_members = n;
+	grp->n_active = 0;
+	grp->n_objects = object_get_count();
+	grp->active_from = TS_NEVER; /* force rebuild of the in-service list */
+	return 1;
+}
+
+/* get the shared membership of a group expression */
+static AGGRGROUP *aggregate_group(char *group_expression, FINDPGM *pgm, FINDLIST *list)
+{
+	AGGRGROUP *grp;
+	wlock(&group_lock);
+	for ( grp=group_list ; grp!=NULL ; grp=grp->next )
+	{
+		if ( strcmp(grp->expression,group_expression)==0 )
+			break;
+	}
+	if ( grp==NULL )
+	{
+		grp = (AGGRGROUP*)malloc(sizeof(AGGRGROUP));
+		if ( grp!=NULL )
+		{
+			memset(grp,0,sizeof(AGGRGROUP));
+			grp->expression = strdup(group_expression);
+			grp->pgm = pgm;
+			if ( grp->expression==NULL || !aggregate_members(grp,list) )
+			{
+				free(grp->expression);
+				free(grp->member);
+				free(grp->active);
+				free(grp);
+				grp = NULL;
+			}
+			else
+			{
+				grp->next = group_list;
+				group_list = grp;
+			}
+		}
+	}
+	wunlock(&group_lock);
+	return grp;
+}
+
+/* bring the member and in-service lists up to date */
+static void aggregate_update(AGGRGROUP *grp)
+{
+	unsigned int n;
+	TIMESTAMP next = TS_NEVER;
+
+	/* non-constant groups need search program rerun, others only when objects were added or removed */
+	if ( (grp->pgm->constflags&CF_CONSTANT)!=CF_CONSTANT || grp->n_objects!=object_get_count() )
+	{
+		FINDLIST *list = find_runpgm(NULL,grp->pgm);
+		if ( list!=NULL )
+		{
+			aggregate_members(grp,list);
+			free(list);
+		}
+	}
+
+	/* in-service list is still valid */
+	if ( grp->n_changes==object_get_service_changes() && global_clock>=grp->active_from && global_clock<grp->active_to )
+		return;
+
+	/* rebuild in-service list and find when it next changes */
+	grp->n_active = 0;
+	for ( n=0 ; n<grp->n_members ; n++ )
+	{
+		OBJECT *obj = grp->member[n];
+		if ( obj->in_svc>=global_clock )
+		{
+			if ( obj->in_svc<next ) next = obj->in_svc+1;
+		}
+		else if ( obj->out_svc>global_clock )
+		{
+			grp->active[grp->n_active++] = obj;
+			if ( obj->out_svc<next ) next = obj->out_svc;
+		}
+	}
+	grp->n_changes = object_get_service_changes();
+	grp->active_from = global_clock;
+	grp->active_to = next;
+}
+
+/* check whether an object has the value used by an aggregation */
+static int aggregate_valid(AGGREGATION *aggr, OBJECT *obj)
+{
+	PROPERTY *pinfo = aggr->pinfo;
+	if ( object_prop_in_class(obj,pinfo)==NULL || pinfo->access==PA_PRIVATE )
+		return 0;
+	if ( aggr->part==AP_NONE )
+		return pinfo->ptype==PT_double || pinfo->ptype==PT_random;
+	else
+		return pinfo->ptype==PT_complex;
+}
+
+/* reduce a list of objects for all aggregations in a sweep */
+static void aggregate_reduce(AGGRSWEEP *sweep, OBJECT **obj, unsigned int n_obj, AGGRACC *acc)
+{
+	CLASS *oclass[AGGR_SWEEPSIZE];
+	int valid[AGGR_SWEEPSIZE];
+	double ratio[AGGR_SWEEPSIZE];
+	unsigned int i, n;
 
-	/* non-constant groups need search program rerun */
-	if ((aggr->group->constflags & CF_CONSTANT) != CF_CONSTANT){
-		aggr->last = find_runpgm(NULL,aggr->group); /** @todo use constant part instead of NULL (ticket #3) */
+	for ( i=0 ; i<sweep->n ; i++ )
+	{
+		AGGREGATION *aggr = sweep->aggr[i];
+		memset(&acc[i],0,sizeof(AGGRACC));
+		oclass[i] = NULL;
+		valid[i] = 0;
+		ratio[i] = ( aggr->pinfo->unit!=NULL && aggr->punit!=NULL ) ? aggr->pinfo->unit->a/aggr->punit->a : 1.0;
 	}
 
-	for(obj = find_first(aggr->last); obj != NULL; obj = find_next(aggr->last, obj)){
-		double value=0;
-		double *pdouble = NULL;
-		complex *pcomplex = NULL;
+	for ( n=0 ; n<n_obj ; n++ )
+	{
+		char *data = (char*)(obj[n]+1);
+		for ( i=0 ; i<sweep->n ; i++ )
+		{
+			AGGREGATION *aggr = sweep->aggr[i];
+			AGGRACC *a = &acc[i];
+			double value;
 
-		/* add time-sensitivity to verify that we are only aggregating objects that are in-service and not out-service. */
-		if(obj->in_svc >= global_clock || obj->out_svc <= global_clock)
-			continue;
+			/* the property is checked once per class */
+			if ( obj[n]->oclass!=oclass[i] )
+			{
+				oclass[i] = obj[n]->oclass;
+				valid[i] = aggregate_valid(aggr,obj[n]);
+			}
+			if ( !valid[i] )
+				continue;
 
-		switch (aggr->pinfo->ptype) {
-		case PT_complex:
-		case PT_enduse:
-			pcomplex = object_get_complex(obj,aggr->pinfo);
-			if (pcomplex!=NULL)
+			if ( aggr->part==AP_NONE )
+			{
+				value = *(double*)(data+(int64)(aggr->pinfo->addr));
+				if ( aggr->pinfo->unit!=NULL && aggr->punit!=NULL )
+					value = (value - aggr->pinfo->unit->b) * ratio[i] + aggr->punit->b;
+			}
+			else
 			{
+				complex *pcomplex = (complex*)(data+(int64)(aggr->pinfo->addr));
 				switch (aggr->part) {
 				case AP_REAL: value=pcomplex->r; break;
 				case AP_IMAG: value=pcomplex->i; break;
 				case AP_MAG: value=mag(pcomplex); break;
 				case AP_ARG: value=arg(pcomplex); break;
 				case AP_ANG: value=arg(pcomplex)*180/PI;  break;
-				default: pcomplex = NULL; break; /* invalidate the result */
+				default: continue; /* invalid part */
 				}
 			}
-			break;
-		case PT_double:
-		case PT_loadshape:
-		case PT_random:
-			pdouble = object_get_double(obj,aggr->pinfo);
-			if (pdouble!=NULL){
-				value = *pdouble;
-				if(aggr->pinfo->unit != 0 && aggr->punit != 0){
-					int rv = unit_convert_ex(aggr->pinfo->unit, aggr->punit, &value);
-					if(rv == 0){ // error
-						;
-					}
-				} // else don't worry
-			}
-			break;
-		default:
-			break;
-		}
 
-		if (pdouble!=NULL || pcomplex!=NULL) /* valid value */
-		{
 			if ((aggr->flags&AF_ABS)==AF_ABS) value=fabs(value);
 			switch (aggr->op) {
 			case AGGR_MIN:
-				if (value<numerator || denominator==0) numerator=value;
-				denominator = 1;
+				if (value<a->numerator || a->denominator==0) a->numerator=value;
+				a->denominator = 1;
 				break;
 			case AGGR_MAX:
-				if (value>numerator || denominator==0) numerator=value;
-				denominator = 1;
+				if (value>a->numerator || a->denominator==0) a->numerator=value;
+				a->denominator = 1;
 				break;
 			case AGGR_COUNT:
-				numerator++;
-				denominator=1;
+				a->numerator++;
+				a->denominator=1;
 				break;
 			case AGGR_MBE:
-				denominator++;
-				numerator += value;
-				secondary += (value-secondary)/denominator;
+				a->denominator++;
+				a->numerator += value;
+				a->secondary += (value-a->secondary)/a->denominator;
 				break;
 			case AGGR_AVG:
 			case AGGR_MEAN:
-				numerator+=value;
-				denominator++;
+				a->numerator+=value;
+				a->denominator++;
 				break;
 			case AGGR_SUM:
-				numerator+=value;
-				denominator = 1;
+				a->numerator+=value;
+				a->denominator = 1;
 				break;
 			case AGGR_PROD:
-				numerator*=value;
-				denominator = 1;
+				a->numerator*=value;
+				a->denominator = 1;
 				break;
 			case AGGR_GAMMA:
-				denominator+=log(value);
-				if (numerator==0 || secondary>value)
-					secondary = value;
-				numerator++;
+				a->denominator+=log(value);
+				if (a->numerator==0 || a->secondary>value)
+					a->secondary = value;
+				a->numerator++;
 				break;
 			case AGGR_STD:
 			case AGGR_VAR:
-				denominator++;
+				a->denominator++;
 				// note this uses a compensated on-line algorithm (see Knuth 1998)
 				// it's better than the obvious method because it doesn't suffer from numerical instability when mean(x)-x is near zero
-				{	double delta = value-secondary;
-					secondary += delta/denominator;
-					numerator += delta*(value-secondary);
+				{	double delta = value-a->secondary;
+					a->secondary += delta/a->denominator;
+					a->numerator += delta*(value-a->secondary);
 				}
 				break;
 			case AGGR_SKEW:
@@ -451,8 +635,71 @@ double aggregate_value(AGGREGATION *aggr) /**< the aggregation to perform */
 			}
 		}
 	}
+}
+
+/* merge the partial reduction b into a */
+static void aggregate_merge(AGGREGATOR op, AGGRACC *a, AGGRACC *b)
+{
+	switch (op) {
+	case AGGR_MIN:
+		if (b->denominator!=0 && (b->numerator<a->numerator || a->denominator==0)) a->numerator=b->numerator;
+		if (b->denominator!=0) a->denominator = 1;
+		break;
+	case AGGR_MAX:
+		if (b->denominator!=0 && (b->numerator>a->numerator || a->denominator==0)) a->numerator=b->numerator;
+		if (b->denominator!=0) a->denominator = 1;
+		break;
+	case AGGR_COUNT:
+	case AGGR_SUM:
+		a->numerator+=b->numerator;
+		if (b->denominator!=0) a->denominator = 1;
+		break;
+	case AGGR_PROD:
+		a->numerator*=b->numerator;
+		if (b->denominator!=0) a->denominator = 1;
+		break;
+	case AGGR_AVG:
+	case AGGR_MEAN:
+		a->numerator+=b->numerator;
+		a->denominator+=b->denominator;
+		break;
+	case AGGR_MBE:
+		if (b->denominator!=0)
+		{
+			a->secondary += (b->secondary-a->secondary)*b->denominator/(a->denominator+b->denominator);
+			a->numerator+=b->numerator;
+			a->denominator+=b->denominator;
+		}
+		break;
+	case AGGR_GAMMA:
+		a->denominator+=b->denominator;
+		if (b->numerator!=0 && (a->numerator==0 || a->secondary>b->secondary))
+			a->secondary = b->secondary;
+		a->numerator+=b->numerator;
+		break;
+	case AGGR_STD:
+	case AGGR_VAR:
+		// pairwise combination of the on-line partial results (Chan et al. 1979)
+		if (b->denominator!=0)
+		{	double n = a->denominator+b->denominator;
+			double delta = b->secondary-a->secondary;
+			a->numerator += b->numerator + delta*delta*a->denominator*b->denominator/n;
+			a->secondary += delta*b->denominator/n;
+			a->denominator = n;
+		}
+		break;
+	case AGGR_SKEW:
+	case AGGR_KUR:
+	default:
+		break;
+	}
+}
+
+/* compute the aggregate from its reduction */
+static double aggregate_result(AGGREGATION *aggr, AGGRACC *a)
+{
+	double numerator=a->numerator, denominator=a->denominator, secondary=a->secondary;
 	switch (aggr->op) {
-		double v = 0.0, t = 0.0, m = 0.0;
 	case AGGR_GAMMA:
 		return 1 + numerator/(denominator-numerator*log(secondary));
 	case AGGR_STD:
@@ -478,4 +725,149 @@ double aggregate_value(AGGREGATION *aggr) /**< the aggregation to perform */
 	}
 }
 
+/* multithreaded reduction iterator */
+static AGGRGROUP *mti_group = NULL; /* group being indexed by mti_init */
+static MTIITEM aggregate_get(MTIITEM item)
+{
+	AGGRCHUNK *chunk = (AGGRCHUNK*)item;
+	if ( chunk==NULL )
+		return (MTIITEM)mti_group->chunk;
+	else if ( chunk->id+1<mti_group->n_chunks )
+		return (MTIITEM)(chunk+1);
+	else
+		return NULL;
+}
+static void aggregate_call(MTIDATA output, MTIITEM item, MTIDATA input)
+{
+	AGGRCHUNK *chunk = (AGGRCHUNK*)item;
+	AGGRGROUP *grp = chunk->group;
+	unsigned int begin = (unsigned int)((int64)grp->n_active*chunk->id/grp->n_chunks);
+	unsigned int end = (unsigned int)((int64)grp->n_active*(chunk->id+1)/grp->n_chunks);
+	aggregate_reduce(((AGGRRUN*)input)->sweep,grp->active+begin,end-begin,chunk->acc);
+}
+static MTIDATA aggregate_set(MTIDATA to, MTIDATA from)
+{
+	/* allocation request */
+	if ( to==NULL ) to = (MTIDATA)malloc(sizeof(AGGRRUN));
+
+	/* clear request (may follow allocation request) */
+	if ( from==NULL ) memset(to,0,sizeof(AGGRRUN));
+
+	/* copy request */
+	else memcpy(to,from,sizeof(AGGRRUN));
+
+	return to;
+}
+static int aggregate_compare(MTIDATA a, MTIDATA b)
+{
+	int64 s0 = (a?((AGGRRUN*)a)->seq:0);
+	int64 s1 = (b?((AGGRRUN*)b)->seq:0);
+	if ( s0>s1 ) return 1;
+	if ( s0<s1 ) return -1;
+	return 0;
+}
+static void aggregate_gather(MTIDATA a, MTIDATA b)
+{
+	/* partial reductions are kept in the chunks and merged in order by the caller */
+}
+static int aggregate_reject(MTI *mti, MTIDATA value)
+{
+	return 0;
+}
+
+/* create the multithreaded iterator of a group */
+static MTI *aggregate_mti(AGGRGROUP *grp)
+{
+	static MTIFUNCTIONS fns = {aggregate_get, aggregate_call, aggregate_set, aggregate_compare, aggregate_gather, aggregate_reject};
+	unsigned int n;
+	if ( grp->mti!=NULL || grp->mti_tried || global_threadcount<2 )
+		return grp->mti;
+	grp->mti_tried = TRUE;
+	grp->chunk = (AGGRCHUNK*)malloc(sizeof(AGGRCHUNK)*global_threadcount);
+	if ( grp->chunk==NULL )
+		return NULL;
+	grp->n_chunks = global_threadcount;
+	for ( n=0 ; n<grp->n_chunks ; n++ )
+	{
+		grp->chunk[n].group = grp;
+		grp->chunk[n].id = n;
+	}
+	wlock(&group_lock);
+	mti_group = grp;
+	grp->mti = mti_init("aggregate",&fns,1);
+	mti_group = NULL;
+	wunlock(&group_lock);
+	if ( grp->mti==NULL )
+		output_warning("aggregate group '%s' multi-threaded iterator initialization failed - using single-threaded iterator as fallback", grp->expression);
+	return grp->mti;
+}
+
+/* reduce the aggregations of a sweep over their group */
+static void aggregate_sweep(AGGRSWEEP *sweep, double *values)
+{
+	AGGRGROUP *grp = sweep->group;
+	AGGRACC acc[AGGR_SWEEPSIZE];
+	AGGRRUN run, result;
+	unsigned int i, n;
+
+	wlock(&grp->lock);
+	aggregate_update(grp);
+	run.seq = ++grp->seq;
+	run.sweep = sweep;
+	if ( grp->n_active>=2*AGGR_MTI_MINITEMS && aggregate_mti(grp)!=NULL && mti_run(&result,grp->mti,&run) )
+	{
+		/* merge partial reductions in member order */
+		for ( i=0 ; i<sweep->n ; i++ )
+		{
+			acc[i] = grp->chunk[0].acc[i];
+			for ( n=1 ; n<grp->n_chunks ; n++ )
+				aggregate_merge(sweep->aggr[i]->op,&acc[i],&grp->chunk[n].acc[i]);
+		}
+	}
+	else
+		aggregate_reduce(sweep,grp->active,grp->n_active,acc);
+	wunlock(&grp->lock);
+
+	for ( i=0 ; i<sweep->n ; i++ )
+		values[i] = aggregate_result(sweep->aggr[i],&acc[i]);
+}
+
+/** This function performs an aggregate calculation given by the aggregation 
+ **/
+double aggregate_value(AGGREGATION *aggr) /**< the aggregation to perform */
+{
+	double value;
+	AGGRSWEEP sweep;
+	sweep.group = aggr->members;
+	sweep.n = 1;
+	sweep.aggr[0] = aggr;
+	aggregate_sweep(&sweep,&value);
+	return value;
+}
+
+/** This function performs the aggregate calculations of a list of aggregations
+	linked by \p next, reducing those that share a group in a single pass
+	@returns the number of values computed
+ **/
+unsigned int aggregate_values(AGGREGATION *aggr, /**< the first aggregation to perform */
+							  double *values, /**< the values computed */
+							  unsigned int size) /**< the maximum number of values */
+{
+	unsigned int count = 0;
+	while ( aggr!=NULL && count<size )
+	{
+		AGGRSWEEP sweep;
+		sweep.group = aggr->members;
+		sweep.n = 0;
+		while ( aggr!=NULL && aggr->members==sweep.group && sweep.n<AGGR_SWEEPSIZE && count+sweep.n<size )
+		{
+			sweep.aggr[sweep.n++] = aggr;
+			aggr = aggr->next;
+		}
+		aggregate_sweep(&sweep,values+count);
+		count += sweep.n;
+	}
+	return count;
+}
+
 /**@}**/
@@ -16,6 +16,8 @@ typedef enum {AP_NONE, AP_REAL, AP_IMAG, AP_MAG, AP_ANG, AP_ARG} AGGRPART; /**<
 
 #define AF_ABS 0x01 /**< absolute value aggregation flag */
 
+typedef struct s_aggrgroup AGGRGROUP; /**< the membership shared by aggregations over the same group */
+
 typedef struct s_aggregate {
 	AGGREGATOR op; /**< the aggregation operator (min, max, etc.) */
 	struct s_findpgm *group; /**< the find program used to build the aggregation */
@@ -25,6 +27,7 @@ typedef struct s_aggregate {
 	AGGRPART part; /**< the property part (complex only) */
 	unsigned char flags; /**< aggregation flags (e.g., AF_ABS) */
 	struct s_findlist *last; /**< the result of the last run */
+	AGGRGROUP *members; /**< the resolved membership shared with other aggregations of the same group */
 	struct s_aggregate *next; /**< the next aggregation in the core's list of aggregators */
 } AGGREGATION; /**< the aggregation type */
 
@@ -34,6 +37,7 @@ extern "C" {
 
 AGGREGATION *aggregate_mkgroup(char *aggregator, char *group_expression);
 double aggregate_value(AGGREGATION *aggregate);
+unsigned int aggregate_values(AGGREGATION *aggregate, double *values, unsigned int size);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,110 @@
+# Local client for test_server_client.glm
+#
+# Usage: python3 server_client.py <port>
+#
+# Exits with a non-zero code naming the first check that failed.
+
+import os
+import shutil
+import socket
+import sys
+import time
+
+port = int(sys.argv[1])
+
+def connect():
+	s = socket.create_connection(("127.0.0.1",port),timeout=10)
+	return s
+
+def read_response(s, data=b""):
+	"""read one response from the socket, returns (status, body, rest of data)"""
+	while b"\r\n\r\n" not in data and b"\n\n" not in data:
+		chunk = s.recv(65536)
+		if not chunk:
+			return None, None, data
+		data += chunk
+	sep = b"\r\n\r\n" if b"\r\n\r\n" in data else b"\n\n"
+	header, data = data.split(sep,1)
+	lines = header.decode().splitlines()
+	status = int(lines[0].split()[1])
+	length = 0
+	for line in lines[1:]:
+		name, _, value = line.partition(":")
+		if name.strip().lower() == "content-length":
+			length = int(value)
+	while len(data) < length:
+		chunk = s.recv(65536)
+		if not chunk:
+			break
+		data += chunk
+	return status, data[:length], data[length:]
+
+def closed(s):
+	try:
+		return s.recv(1) == b""
+	except (ConnectionResetError, socket.timeout):
+		return True
+
+def check(name, condition):
+	if not condition:
+		print("server_client: %s failed" % name)
+		sys.exit(1)
+
+# pipelined keep-alive requests are answered in order on one connection
+s = connect()
+s.sendall(b"GET /json/clock HTTP/1.1\r\nHost: localhost\r\n\r\nGET /json/stoptime HTTP/1.1\r\nHost: localhost\r\n\r\n")
+status, body, rest = read_response(s)
+check("first pipelined request", status == 200 and b"clock" in body)
+status, body, rest = read_response(s,rest)
+check("second pipelined request", status == 200 and b"stoptime" in body)
+s.close()
+
+# batch query with a body
+s = connect()
+query = b"clock,nonexistent_global"
+s.sendall(b"POST /batch/ HTTP/1.1\r\nHost: localhost\r\nContent-Length: %d\r\n\r\n%s" % (len(query),query))
+status, body, rest = read_response(s)
+check("batch request", status == 200 and b"clock" in body and b"null" in body)
+s.close()
+
+# malformed or oversized requests are refused and the connection is closed
+for name, request, expect in [
+		("malformed content length", b"POST /batch/ HTTP/1.1\r\nContent-Length: 12abc\r\n\r\n", 400),
+		("negative content length", b"POST /batch/ HTTP/1.1\r\nContent-Length: -1\r\n\r\n", 400),
+		("overflowing content length", b"POST /batch/ HTTP/1.1\r\nContent-Length: 99999999999999999999999\r\n\r\n", 400),
+		("oversized content length", b"POST /batch/ HTTP/1.1\r\nContent-Length: 2000000\r\n\r\n", 413),
+		]:
+	s = connect()
+	s.sendall(request)
+	status, body, rest = read_response(s)
+	check(name, status == expect and closed(s))
+	s.close()
+
+# a header that never ends is not buffered without limit
+s = connect()
+try:
+	s.sendall(b"GET /json/clock HTTP/1.1\r\nX-Padding: " + b"x"*(2*1048576))
+except (BrokenPipeError, ConnectionResetError):
+	pass
+status, body, rest = read_response(s)
+check("oversized header", status in (None,413) and closed(s))
+s.close()
+
+# an external program does not hold up requests on other connections
+if shutil.which("perl"):
+	with open("slow.pl","w") as fh:
+		fh.write('sleep 2; open(my $fh,">","slow.txt"); print $fh "slow done\\n"; close($fh);\n')
+	slow = connect()
+	start = time.time()
+	slow.sendall(b"GET /perl/slow.pl?text/txt HTTP/1.1\r\nHost: localhost\r\n\r\n")
+	time.sleep(0.2)
+	s = connect()
+	s.sendall(b"GET /json/clock HTTP/1.1\r\nHost: localhost\r\n\r\n")
+	status, body, rest = read_response(s)
+	check("request during external program", status == 200 and time.time()-start < 1.5)
+	s.close()
+	status, body, rest = read_response(slow)
+	check("external program", status == 200 and body.strip() == b"slow done" and time.time()-start >= 2)
+	slow.close()
+
+print("server_client: all checks passed")
@@ -0,0 +1,59 @@
+# Reader check for test_telemetry.glm
+#
+# Usage: python3 telemetry_check.py <gridlabd> <telemetry file> <recorder file> <depth> <stoptime>
+#
+# Reads the finished ring back with "gridlabd --telemetry" and checks it
+# against the run.  Exits with a non-zero code naming the first check that failed.
+
+import calendar
+import subprocess
+import sys
+import time
+
+exename, tlmfile, csvfile, depth, stoptime = sys.argv[1:6]
+depth = int(depth)
+
+zones = {"UTC":0, "GMT":0, "PST":-8, "PDT":-7}
+
+def to_epoch(text):
+	"""convert a GridLAB-D timestamp string to seconds since the epoch"""
+	date, clock, zone = text.strip().split()
+	t = calendar.timegm(time.strptime(date+" "+clock,"%Y-%m-%d %H:%M:%S"))
+	return t - zones[zone]*3600
+
+def check(name, condition):
+	if not condition:
+		print("telemetry_check: %s failed" % name)
+		sys.exit(1)
+
+# the writer is done so the reader prints what is left in the ring and exits
+reader = subprocess.run([exename,"--telemetry",tlmfile],stdout=subprocess.PIPE,timeout=60)
+check("reader exit", reader.returncode == 0)
+lines = reader.stdout.decode().splitlines()
+names = lines[0].split(",")
+records = [line.split(",") for line in lines[1:]]
+
+check("name table", names[0] == "timestamp" and len(names) == 15
+	and names[1] == "house:0/air_temperature"
+	and "test_house/panel.power.real" in names
+	and "test_house/panel.power.imag" in names
+	and names[-1] == "clock")
+check("ring depth", len(records) == depth and all(len(record) == len(names) for record in records))
+
+# records are in order and the clock value is the record timestamp
+stamps = [to_epoch(record[0]) for record in records]
+check("record order", all(a < b for a, b in zip(stamps,stamps[1:])))
+check("clock value", all(float(record[-1]) == t for record, t in zip(records,stamps)))
+check("last record", stamps[-1] == to_epoch(stoptime))
+
+# the published temperature is the one the recorder saw
+recorded = {}
+for line in open(csvfile):
+	if not line.startswith("#"):
+		t, value = line.split(",")
+		recorded[to_epoch(t)] = float(value)
+column = names.index("test_house/air_temperature")
+common = [(float(record[column]), recorded[t]) for record, t in zip(records,stamps) if t in recorded]
+check("recorded values", len(common) >= depth-2 and all(abs(a-b) < 1e-3 for a, b in common))
+
+print("telemetry_check: all checks passed")
@@ -0,0 +1,433 @@
+// $Id$
+// Copyright (C) 2012 Battelle Memorial Institute
+//
+// Benchmark runs of a curated suite of models.  The suite file lists one model per line as
+//
+//	<name> <path-to-glm> [<command line options>...]
+//
+// where the path is relative to the working directory and the options are placed after the model
+// on the command line (so they can override the model's clock, e.g., --define stoptime=...).  Each
+// model is run benchmark_repeat times with a fixed random seed and the run statistics reported by
+// the child process are collected into a CSV report that can be compared between builds.
+//
+// Globals:
+//	benchmark_suite		suite file (default is benchmark.txt found on GLPATH)
+//	benchmark_report	report file (default is benchmark.csv)
+//	benchmark_repeat	number of runs of each model (default is 1)
+//	benchmark_seed		random seed given to each run (default is 1)
+//	benchmark_stats		set by --benchmark for each run to collect the run statistics
+//
+
+#ifdef WIN32
+#include <windows.h>
+#include <direct.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/resource.h>
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "globals.h"
+#include "output.h"
+#include "benchmark.h"
+#include "exec.h"
+#include "find.h"
+#include "object.h"
+extern "C" {
+#include "deltamode.h"
+}
+
+#ifdef WIN32
+#define WIFEXITED(X) (X>=0&&X<128)
+#define WEXITSTATUS(X) (X&127)
+#define WTERMSIG(X) (X&127)
+#else
+#include <sys/wait.h>
+#endif
+
+#define BENCHMARK_STATS "benchmark_stats.txt"
+
+/** run statistics written by benchmark_save() and collected by benchmark() */
+typedef enum {
+	BS_OBJECTS,		///< number of objects
+	BS_THREADS,		///< number of threads used
+	BS_SIMTIME,		///< simulated time (h)
+	BS_WALLTIME,	///< process wall time (s)
+	BS_LOADER,		///< model load time (s)
+	BS_INIT,		///< object initialization time (s)
+	BS_EXEC,		///< main loop time (s)
+	BS_SYNC,		///< main loop time not spent in core phases (s)
+	BS_INSTANCE,	///< instance sync time (s)
+	BS_RANDOMVAR,	///< random variable sync time (s)
+	BS_SCHEDULE,	///< schedule sync time (s)
+	BS_LOADSHAPE,	///< loadshape sync time (s)
+	BS_ENDUSE,		///< enduse sync time (s)
+	BS_TRANSFORM,	///< transform sync time (s)
+	BS_DELTAMODE,	///< deltamode update time (s)
+	BS_PASSES,		///< main loop passes
+	BS_TIMESTEPS,	///< main loop timesteps
+	BS_DELTASTEPS,	///< deltamode updates
+	BS_NRSOLVES,	///< Newton-Raphson solutions
+	BS_NRITERS,		///< Newton-Raphson iterations
+	BS_NRTIME,		///< Newton-Raphson solver time (s)
+	BS_PEAKRSS,		///< peak resident set size (kB)
+	_BS_LAST,
+} BENCHSTAT;
+static struct {
+	const char *name;
+	const char *format;
+} stat_info[_BS_LAST] = {
+	{"objects",		"%.0f"},
+	{"threads",		"%.0f"},
+	{"simtime_h",	"%.3f"},
+	{"wall_s",		"%.3f"},
+	{"loader_s",	"%.3f"},
+	{"init_s",		"%.3f"},
+	{"exec_s",		"%.3f"},
+	{"sync_s",		"%.3f"},
+	{"instance_s",	"%.3f"},
+	{"randomvar_s",	"%.3f"},
+	{"schedule_s",	"%.3f"},
+	{"loadshape_s",	"%.3f"},
+	{"enduse_s",	"%.3f"},
+	{"transform_s",	"%.3f"},
+	{"deltamode_s",	"%.3f"},
+	{"passes",		"%.0f"},
+	{"timesteps",	"%.0f"},
+	{"deltasteps",	"%.0f"},
+	{"nr_solves",	"%.0f"},
+	{"nr_iterations","%.0f"},
+	{"nr_s",		"%.3f"},
+	{"peak_rss_kB",	"%.0f"},
+};
+
+/** get a numeric global, if it exists */
+static bool get_stat(const char *name, double *value)
+{
+	char buffer[256];
+	if ( global_getvar((char*)name,buffer,sizeof(buffer))==NULL || buffer[0]=='\0' )
+		return false;
+	*value = atof(buffer);
+	return true;
+}
+
+/** peak resident set size of this process in kB */
+static double peak_rss(void)
+{
+#ifdef WIN32
+	return 0; // not available without psapi
+#else
+	struct rusage usage;
+	if ( getrusage(RUSAGE_SELF,&usage)!=0 )
+		return 0;
+#ifdef __APPLE__
+	return (double)usage.ru_maxrss/1024; // bytes on Mac OS X
+#else
+	return (double)usage.ru_maxrss;
+#endif
+#endif
+}
+
+/** save run statistics for the benchmark when benchmark_stats is set
+	Called by exec_start() when the simulation completes.
+ **/
+extern "C" void benchmark_save(int64 passes, int64 tsteps, int64 init_time, int64 exec_time)
+{
+	char file[1024];
+	if ( global_getvar("benchmark_stats",file,sizeof(file))==NULL || file[0]=='\0' )
+		return;
+
+	extern clock_t loader_time;
+	extern clock_t instance_synctime;
+	extern clock_t randomvar_synctime;
+	extern clock_t schedule_synctime;
+	extern clock_t loadshape_synctime;
+	extern clock_t enduse_synctime;
+	extern clock_t transform_synctime;
+	DELTAPROFILE *dp = delta_getprofile();
+
+	double stat[_BS_LAST];
+	bool valid[_BS_LAST];
+	size_t i;
+	for ( i=0 ; i<_BS_LAST ; i++ )
+	{
+		stat[i] = 0;
+		valid[i] = true;
+	}
+	stat[BS_OBJECTS] = object_get_count();
+	stat[BS_THREADS] = global_threadcount;
+	stat[BS_SIMTIME] = timestamp_to_hours(global_clock)-timestamp_to_hours(global_starttime);
+	stat[BS_WALLTIME] = (double)exec_clock()/CLOCKS_PER_SEC;
+	stat[BS_LOADER] = (double)loader_time/CLOCKS_PER_SEC;
+	stat[BS_INIT] = (double)init_time/CLOCKS_PER_SEC;
+	stat[BS_EXEC] = (double)exec_time/CLOCKS_PER_SEC;
+	stat[BS_INSTANCE] = (double)instance_synctime/CLOCKS_PER_SEC;
+	stat[BS_RANDOMVAR] = (double)randomvar_synctime/CLOCKS_PER_SEC;
+	stat[BS_SCHEDULE] = (double)schedule_synctime/CLOCKS_PER_SEC;
+	stat[BS_LOADSHAPE] = (double)loadshape_synctime/CLOCKS_PER_SEC;
+	stat[BS_ENDUSE] = (double)enduse_synctime/CLOCKS_PER_SEC;
+	stat[BS_TRANSFORM] = (double)transform_synctime/CLOCKS_PER_SEC;
+	stat[BS_DELTAMODE] = (double)(dp->t_preupdate+dp->t_update+dp->t_interupdate+dp->t_postupdate)/CLOCKS_PER_SEC;
+	stat[BS_SYNC] = stat[BS_EXEC];
+	for ( i=BS_INSTANCE ; i<=BS_DELTAMODE ; i++ )
+		stat[BS_SYNC] -= stat[i];
+	stat[BS_PASSES] = (double)passes;
+	stat[BS_TIMESTEPS] = (double)tsteps;
+	stat[BS_DELTASTEPS] = (double)dp->t_count;
+	valid[BS_NRSOLVES] = get_stat("powerflow::NR_solution_count",&stat[BS_NRSOLVES]);
+	valid[BS_NRITERS] = get_stat("powerflow::NR_iteration_count",&stat[BS_NRITERS]);
+	valid[BS_NRTIME] = get_stat("powerflow::NR_solver_time",&stat[BS_NRTIME]);
+	stat[BS_PEAKRSS] = peak_rss();
+
+	FILE *fp = fopen(file,"w");
+	if ( fp==NULL )
+	{
+		output_error("unable to write benchmark statistics to '%s': %s", file, strerror(errno));
+		return;
+	}
+	for ( i=0 ; i<_BS_LAST ; i++ )
+	{
+		if ( !valid[i] ) continue;
+		fprintf(fp,"%s=",stat_info[i].name);
+		fprintf(fp,stat_info[i].format,stat[i]);
+		fprintf(fp,"\n");
+	}
+	fclose(fp);
+	output_verbose("benchmark statistics saved to '%s'", file);
+}
+
+/** load the run statistics saved by a benchmark run */
+static bool load_stats(const char *file, char value[_BS_LAST][64])
+{
+	size_t i;
+	for ( i=0 ; i<_BS_LAST ; i++ )
+		value[i][0] = '\0';
+	FILE *fp = fopen(file,"r");
+	if ( fp==NULL )
+		return false;
+	char line[1024];
+	while ( fgets(line,sizeof(line),fp)!=NULL )
+	{
+		char name[64], data[64];
+		if ( sscanf(line,"%63[^=]=%63s",name,data)!=2 )
+			continue;
+		for ( i=0 ; i<_BS_LAST ; i++ )
+		{
+			if ( strcmp(name,stat_info[i].name)==0 )
+			{
+				strcpy(value[i],data);
+				break;
+			}
+		}
+	}
+	fclose(fp);
+	return true;
+}
+
+/** copyfile routine */
+static bool copyfile(const char *from, const char *to)
+{
+	FILE *in = fopen(from,"r");
+	if ( in==NULL )
+	{
+		output_error("copyfile(char *from='%s', char *to='%s'): unable to open '%s' for reading - %s", from,to,from,strerror(errno));
+		return false;
+	}
+	FILE *out = fopen(to,"w");
+	if ( out==NULL )
+	{
+		output_error("copyfile(char *from='%s', char *to='%s'): unable to open '%s' for writing - %s", from,to,to,strerror(errno));
+		fclose(in);
+		return false;
+	}
+	char buffer[65536];
+	size_t len;
+	bool ok = true;
+	while ( ok && (len=fread(buffer,1,sizeof(buffer),in))>0 )
+		ok = (fwrite(buffer,1,len,out)==len);
+	if ( !ok )
+		output_error("copyfile(char *from='%s', char *to='%s'): unable to write to '%s' - %s", from,to,to,strerror(errno));
+	fclose(in);
+	fclose(out);
+	return ok;
+}
+
+/** run one benchmark model
+	@returns the exit code of the run, or -1 if it could not be started
+ **/
+static int run_model(const char *name, const char *file, const char *options, const char *cmdargs, int seed, double *elapsed, char stats[_BS_LAST][64])
+{
+	// run in a folder next to the model so that relative references in the model still work
+	char dir[1024], model[1024];
+	strncpy(dir,file,sizeof(dir)-1);
+	dir[sizeof(dir)-1] = '\0';
+	const char *base = strrchr(file,'/');
+	base = base ? base+1 : file;
+	char *path = strrchr(dir,'/');
+	if ( path!=NULL )
+		sprintf(path+1,"%s",name);
+	else
+		strcpy(dir,name);
+#ifdef WIN32
+	mkdir(dir);
+#else
+	mkdir(dir,0750);
+#endif
+	sprintf(model,"%s/%s",dir,base);
+	if ( !copyfile(file,model) )
+		return -1;
+
+	char statfile[1024];
+	sprintf(statfile,"%s/" BENCHMARK_STATS,dir);
+	unlink(statfile);
+
+	char command[4096];
+	sprintf(command,"%s -W %s %s --define randomseed=%d --define benchmark_stats=" BENCHMARK_STATS " %s %s",
+#ifdef WIN32
+		_pgmptr,
+#else
+		"gridlabd",
+#endif
+		dir, cmdargs, seed, base, options);
+	output_debug("calling system('%s')",command);
+	int64 dt = exec_clock();
+	int code = system(command);
+	*elapsed = (double)(exec_clock()-dt)/CLOCKS_PER_SEC;
+	if ( WIFEXITED(code) )
+		code = WEXITSTATUS(code);
+	else
+		code = -WTERMSIG(code);
+	if ( !load_stats(statfile,stats) && code==XC_SUCCESS )
+		output_warning("benchmark %s did not save its run statistics", name);
+	return code;
+}
+
+/** main benchmark routine */
+extern "C" int benchmark(int argc, char *argv[])
+{
+	char cmdargs[1024] = "";
+	int i, redirect_found = 0;
+	for ( i=1 ; i<argc ; i++ )
+	{
+		if ( strcmp(argv[i],"--redirect")==0 ) redirect_found = 1;
+		if ( strlen(cmdargs)+strlen(argv[i])+2>=sizeof(cmdargs) )
+		{
+			output_fatal("--benchmark command line arguments are too long");
+			exit(XC_ARGERR);
+		}
+		strcat(cmdargs,argv[i]);
+		strcat(cmdargs," ");
+	}
+	if ( !redirect_found )
+		strcat(cmdargs,"--redirect all");
+
+	char suite[1024] = "benchmark.txt", suitefile[1024];
+	char report[1024] = "benchmark.csv";
+	char var[64];
+	int repeat = 1, seed = 1;
+	global_getvar("benchmark_suite",suite,sizeof(suite));
+	global_getvar("benchmark_report",report,sizeof(report));
+	if ( global_getvar("benchmark_repeat",var,sizeof(var))!=NULL && atoi(var)>0 ) repeat = atoi(var);
+	if ( global_getvar("benchmark_seed",var,sizeof(var))!=NULL ) seed = atoi(var);
+
+	if ( find_file(suite,NULL,R_OK,suitefile,sizeof(suitefile))==NULL )
+	{
+		output_fatal("benchmark suite '%s' not found", suite);
+		/* TROUBLESHOOT
+			The benchmark suite file could not be found in the working directory
+			or on the GLPATH.  Set <b>benchmark_suite</b> to the name of a valid
+			suite file, e.g., <code>gridlabd -D benchmark_suite=mysuite.txt --benchmark</code>.
+		 */
+		exit(XC_ARGERR);
+	}
+	FILE *in = fopen(suitefile,"r");
+	FILE *out = fopen(report,"w");
+	if ( in==NULL || out==NULL )
+	{
+		output_fatal("unable to open benchmark %s '%s': %s", in==NULL?"suite":"report", in==NULL?suitefile:report, strerror(errno));
+		exit(XC_IOERR);
+	}
+	output_message("Starting benchmark suite '%s' in directory '%s'", suitefile, global_workdir);
+
+	char tbuf[64];
+	time_t now = time(NULL);
+	fprintf(out,"# GridLAB-D %d.%d.%d-%d (%s) %d-bit %s %s\n", global_version_major, global_version_minor, global_version_patch, global_version_build, global_version_branch, (int)sizeof(void*)*8, global_platform,
+#ifdef _DEBUG
+		"DEBUG"
+#else
+		"RELEASE"
+#endif
+		);
+	fprintf(out,"# suite %s, %d run(s), seed %d, arguments '%s'\n", suitefile, repeat, seed, cmdargs);
+	fprintf(out,"# %s\n", strftime(tbuf,sizeof(tbuf),"%Y-%m-%d %H:%M:%S %z",localtime(&now))?tbuf:"???");
+	fprintf(out,"name,run,exitcode,elapsed_s");
+	for ( i=0 ; i<_BS_LAST ; i++ )
+		fprintf(out,",%s",stat_info[i].name);
+	fprintf(out,"\n");
+	fflush(out);
+
+	char line[1024];
+	int linenum = 0, n_runs = 0, n_failed = 0;
+	double total = 0;
+	while ( fgets(line,sizeof(line),in)!=NULL )
+	{
+		char name[64], file[1024];
+		int len = 0;
+		linenum++;
+		char *p = line;
+		while ( *p==' ' || *p=='\t' ) p++;
+		if ( *p=='#' || *p=='\n' || *p=='\r' || *p=='\0' )
+			continue;
+		if ( sscanf(p,"%63s %1023s %n",name,file,&len)<2 )
+		{
+			output_error("%s(%d): benchmark entry must specify a name and a model", suitefile, linenum);
+			n_failed++;
+			continue;
+		}
+		char *options = p+len;
+		options[strcspn(options,"\r\n")] = '\0';
+		if ( access(file,R_OK)!=0 )
+		{
+			output_error("%s(%d): benchmark %s model '%s' not found", suitefile, linenum, name, file);
+			n_failed++;
+			continue;
+		}
+		int run;
+		for ( run=1 ; run<=repeat ; run++ )
+		{
+			char stats[_BS_LAST][64];
+			double elapsed = 0;
+			int code = run_model(name,file,options,cmdargs,seed,&elapsed,stats);
+			if ( code!=XC_SUCCESS )
+			{
+				output_error("benchmark %s run %d failed with exit code %d (%s)", name, run, code, code>=0?exec_getexitcodestr((EXITCODE)code):"signal");
+				n_failed++;
+			}
+			else
+				output_message("%-32s run %d: %8.2f s", name, run, elapsed);
+			fprintf(out,"%s,%d,%d,%.3f",name,run,code,elapsed);
+			for ( i=0 ; i<_BS_LAST ; i++ )
+				fprintf(out,",%s",stats[i]);
+			fprintf(out,"\n");
+			fflush(out);
+			total += elapsed;
+			n_runs++;
+		}
+	}
+	fclose(in);
+	fclose(out);
+
+	output_message("\nBenchmark report:");
+	output_message("%d runs completed in %.1f seconds", n_runs, total);
+	if ( n_failed>0 )
+		output_message("%d runs failed", n_failed);
+	output_message("See '%s/%s' for details", global_workdir, report);
+	exit(n_failed==0 ? XC_SUCCESS : XC_TSTERR);
+}
@@ -0,0 +1,21 @@
+/* $Id$
+   Copyright (C) 2012 Battelle Memorial Institute
+ */
+
+#ifndef _BENCHMARK_H
+#define _BENCHMARK_H
+
+#include "platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int benchmark(int argc, char *argv[]);
+void benchmark_save(int64 passes, int64 tsteps, int64 init_time, int64 exec_time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -42,6 +42,7 @@ typedef unsigned long PASSCONFIG; /**< the pass configuration */
 #define PC_ABSTRACTONLY 0x100 /**< used to flag that the class should never be instantiated itself, only inherited classes should */
 #define PC_AUTOLOCK 0x200 /**< used to flag that sync operations should not be automatically write locked */
 #define PC_OBSERVER 0x400 /**< used to flag whether commit process needs to be delayed with respect to ordinary "in-the-loop" objects */
+#define PC_INITSAFE 0x800 /**< used to flag that init may run concurrently with other PC_INITSAFE objects (see init_sequence PARALLEL) */
 
 typedef enum {
 	NM_PREUPDATE = 0, /**< notify module before property change */
@@ -29,6 +29,7 @@
 #include "random.h"
 #include "loadshape.h"
 #include "enduse.h"
+#include "transform.h"
 #include "instance.h"
 #include "test.h"
 #include "setup.h"
@@ -421,6 +422,11 @@ static int scheduletest(int argc, char *argv[])
 	schedule_test();
 	return 0;
 }
+static int transformtest(int argc, char *argv[])
+{
+	transform_test();
+	return 0;
+}
 static int loadshapetest(int argc, char *argv[])
 {
 	loadshape_test();
@@ -1188,6 +1194,11 @@ static int locktest(int argc, char *argv[])
 	test_lock();
 	return CMDOK;
 }
+static int lockbench(int argc, char *argv[])
+{
+	test_lockbench();
+	return CMDOK;
+}
 
 static int workdir(int argc, char *argv[])
 {
@@ -1208,6 +1219,8 @@ static int workdir(int argc, char *argv[])
 
 #include "job.h"
 #include "validate.h"
+#include "benchmark.h"
+#include "telemetry.h"
 
 /*********************************************/
 /* ADD NEW CMDARG PROCESSORS ABOVE THIS HERE */
@@ -1249,13 +1262,16 @@ static CMDARG main[] = {
 	{"globaldump",	NULL,	globaldump,		NULL, "Perform a dump of the global variables" },
 	{"loadshapetest", NULL,	loadshapetest,	NULL, "Perform loadshape pseudo-object test" },
 	{"locktest",	NULL,	locktest,		NULL, "Perform memory locking test" },
+	{"lockbench",	NULL,	lockbench,		NULL, "Perform memory locking benchmark" },
 	{"modtest",		NULL,	modtest,		"<module>", "Perform test function provided by module" },
 	{"randtest",	NULL,	randtest,		NULL, "Perform random number generator test" },
 	{"scheduletest", NULL,	scheduletest,	NULL, "Perform schedule pseudo-object test" },	
 	{"test",		NULL,	test,			"<module>", "Perform unit test of module (deprecated)" },
+	{"transformtest", NULL,	transformtest,	NULL, "Perform transform batching test and benchmark" },
 	{"testall",		NULL,	testall,		"=<filename>", "Perform tests of modules listed in file" },
 	{"unitstest",	NULL,	unitstest,		NULL, "Perform unit conversion system test" },
 	{"validate",	NULL,	validate,		"...", "Perform model validation check" },
+	{"benchmark",	NULL,	benchmark,		"...", "Run the benchmark suite and report performance statistics" },
 
 	{NULL,NULL,NULL,NULL, "File and I/O Formatting"},
 	{"kml",			NULL,	kml,			"[=<filename>]", "Output to KML (Google Earth) file of model (only supported by some modules)" },
@@ -1278,6 +1294,7 @@ static CMDARG main[] = {
 	{"pidfile",		NULL,	pidfile,		"[=<filename>]", "Set the process ID file (default is gridlabd.pid)" },
 	{"threadcount", "T",	threadcount,	"<n>", "Set the maximum number of threads allowed" },
 	{"job",			NULL,	job,			"...", "Start a job"},
+	{"telemetry",	NULL,	telemetry,		"[<filename>]", "Print the live telemetry of a running simulation" },
 
 	{NULL,NULL,NULL,NULL, "System options"},
 	{"avlbalance",	NULL,	avlbalance,		NULL, "Toggles automatic balancing of object index" },
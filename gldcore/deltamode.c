@@ -244,7 +244,7 @@ DT delta_update(void)
 {
 	char temp_name_buff[64];
 	clock_t t = clock();
-	DT seconds_advance, timestep;
+	DT seconds_advance, timestep, next_timestep, timestep_min, step, event;
 	DELTAT temp_time;
 	unsigned int delta_iteration_remaining, delta_iteration_count;
 	SIMULATIONMODE interupdate_mode, interupdate_mode_result, clockupdate_result;
@@ -265,6 +265,12 @@ DT delta_update(void)
 		return DT_INVALID;
 	}
 
+	/* Bound a variable timestep - the first step is the one the modules asked for, up to the largest step */
+	timestep_min = ( global_deltamode_timestep_min>0 ) ? (DT)global_deltamode_timestep_min : timestep;
+	if ( global_deltamode_timestep_max>0 && timestep>global_deltamode_timestep_max )
+		timestep = (DT)global_deltamode_timestep_max;
+	step = next_timestep = timestep;
+
 	/* Populate global stop time as double - just do so only cast it once */
 	dbl_stop_time = (double)global_stoptime;
 
@@ -272,7 +278,7 @@ DT delta_update(void)
 	dbl_curr_clk_time = (double)global_clock;
 
 	/* process updates until mode is switched or 1 hour elapses */
-	for ( global_deltaclock=0; global_deltaclock<global_deltamode_maximumtime; global_deltaclock+=timestep )
+	for ( global_deltaclock=0; global_deltaclock<global_deltamode_maximumtime; global_deltaclock+=timestep, timestep=next_timestep )
 	{
 		/* Check to make sure we haven't reached a stop time */
 		global_delta_curr_clock = dbl_curr_clk_time + (double)global_deltaclock/(double)DT_SECOND;
@@ -402,16 +408,52 @@ DT delta_update(void)
 			return DT_INVALID;
 		}
 
+		/* profile */
+		if ( profile.t_min==0 || timestep<profile.t_min ) profile.t_min = timestep;
+		if ( profile.t_max==0 || timestep>profile.t_max ) profile.t_max = timestep;
+
 		if ( interupdate_mode==SM_EVENT )
 		{
 			/* no module wants deltamode to continue any further */
 			break;
 		}
+
+		/* choose the next timestep, if it may vary */
+		if ( global_deltamode_timestep_max>0 )
+		{
+			/* the regular step does not change right after entering deltamode, which is when the disturbance is */
+			if ( global_deltaclock>0 )
+			{
+				step = delta_nextstep(step,timestep_min);
+				if ( step==DT_INVALID )
+				{
+					output_error("delta_update(): nextstep failed");
+					/* TROUBLESHOOT
+					   A module failed to determine the next timestep while operating in deltamode with a variable timestep.
+					   Generally, this is an internal error and should be reported to the GridLAB-D developers.
+					 */
+					return DT_INVALID;
+				}
+			}
+
+			/* land exactly on the next event, even when that is closer than the smallest step */
+			event = delta_nextevent(global_deltaclock+timestep);
+			if ( event==DT_INVALID )
+			{
+				output_error("delta_update(): nextevent failed");
+				/* TROUBLESHOOT
+				   A module failed to determine the time of its next event while operating in deltamode with a variable timestep.
+				   Generally, this is an internal error and should be reported to the GridLAB-D developers.
+				 */
+				return DT_INVALID;
+			}
+			if ( event==0 )
+				next_timestep = ( timestep_min<step ) ? timestep_min : step;
+			else
+				next_timestep = ( event<step ) ? event : step;
+		}
 	}
 
-	/* profile */
-	if ( profile.t_min==0 || timestep<profile.t_min ) profile.t_min = timestep;
-	if ( profile.t_max==0 || timestep>profile.t_max ) profile.t_max = timestep;
 	profile.t_delta += global_deltaclock;
 
 	/* send postupdate messages */
@@ -460,6 +502,84 @@ static DT delta_preupdate(void)
 	return timestep;
 }
 
+/** Determine the regular timestep of the next deltamode update
+
+	This is only used when \p deltamode_timestep_max is set.  Each module that
+	exports deltamode_nextstep() returns the largest regular step it allows next,
+	or DT_INFINITY if it does not care.  A module whose objects need the step they
+	were set up with returns the step it is given, and a module that does not
+	export it keeps the step as it is.  Steps are never rejected and retried, because
+	object states cannot be rolled back, so no module grows the step from an error
+	estimate.  The step can at most double from one update to the next and stays
+	between \p deltamode_timestep_min and \p deltamode_timestep_max.
+
+	@return the next regular timestep, or DT_INVALID on failure
+ **/
+static DT delta_nextstep(DT step, DT timestep_min)
+{
+	clock_t t = clock();
+	DT next = ( step<(DT)global_deltamode_timestep_max/2 ) ? 2*step : (DT)global_deltamode_timestep_max;
+	MODULE **module;
+	for ( module=delta_modulelist; module<delta_modulelist+delta_modulecount; module++ )
+	{
+		DT dt = ( (*module)->deltastep!=NULL ) ? (*module)->deltastep(*module,global_clock,global_deltaclock,step) : step;
+		if ( dt==DT_INVALID )
+		{
+			output_error("delta_nextstep(): module %s failed", (*module)->name);
+			/* TROUBLESHOOT
+			   A module failed to determine its next timestep while operating in deltamode.
+			   Generally, this is an internal error and should be reported to the GridLAB-D developers.
+			 */
+			return DT_INVALID;
+		}
+		else if ( dt<next )
+			next = dt;
+	}
+	if ( next<timestep_min )
+		next = timestep_min;
+	profile.t_nextstep += clock() - t;
+	return next;
+}
+
+/** Determine how long after the next deltamode update the next event is
+
+	This is only used when \p deltamode_timestep_max is set.  Each module that
+	exports deltamode_nextevent() returns the time from the update at \p next_time
+	to its next event, e.g., a player sample, or DT_INFINITY if it has none.  The
+	step after that update is shortened to land on the event exactly, and is not
+	rounded up to \p deltamode_timestep_min.  A module returns 0 when its next
+	event is at that update, since it cannot see the event after it until then, and
+	the step after that update is then no more than \p deltamode_timestep_min.
+
+	@return the time to the next event, 0 if it is at the update, DT_INFINITY if there is none, or DT_INVALID on failure
+ **/
+static DT delta_nextevent(DELTAT next_time)
+{
+	clock_t t = clock();
+	DT next = DT_INFINITY;
+	MODULE **module;
+	for ( module=delta_modulelist; module<delta_modulelist+delta_modulecount; module++ )
+	{
+		DT dt;
+		if ( (*module)->deltaevent==NULL )
+			continue;
+		dt = (*module)->deltaevent(*module,global_clock,next_time);
+		if ( dt==DT_INVALID )
+		{
+			output_error("delta_nextevent(): module %s failed", (*module)->name);
+			/* TROUBLESHOOT
+			   A module failed to determine the time of its next event while operating in deltamode.
+			   Generally, this is an internal error and should be reported to the GridLAB-D developers.
+			 */
+			return DT_INVALID;
+		}
+		else if ( dt<next )
+			next = dt;
+	}
+	profile.t_nextstep += clock() - t;
+	return next;
+}
+
 static SIMULATIONMODE delta_interupdate(DT timestep,unsigned int iteration_count_val)
 {
 	clock_t t = clock();
@@ -11,6 +11,8 @@ DT delta_modedesired(DELTAMODEFLAGS *flags); /* ask module how many seconds unti
 static DT delta_preupdate(void); /* send preupdate messages ; dt==0|DT_INVALID failed, dt>0 timestep desired in deltamode  */
 static SIMULATIONMODE delta_interupdate(DT timestep, unsigned int iteration_count_val); /* send interupdate messages  - 0=INIT (used?), 1=EVENT, 2=DELTA, 3=DELTA_ITER, 255=ERROR */
 static SIMULATIONMODE delta_clockupdate(DT timestep, SIMULATIONMODE interupdate_result); /* notification that we are finished with the current deltamode timestep and are moving to the next timestep. */
+static DT delta_nextstep(DT timestep, DT timestep_min); /* ask modules for the next regular timestep when it may vary - DT_INVALID on failure */
+static DT delta_nextevent(DELTAT next_time); /* ask modules how long after the next update their next event is - DT_INFINITY if none, DT_INVALID on failure */
 static STATUS delta_postupdate(void); /* send postupdate messages - 0 = FAILED, 1=SUCCESS */
 
 typedef struct {
@@ -20,6 +22,7 @@ typedef struct {
 	clock_t t_clockupdate; /**< time in clockupdate */
 	clock_t t_interupdate; /**< time in interupdate */
 	clock_t t_postupdate; /**< time in postupdate */
+	clock_t t_nextstep; /**< time in nextstep */
 	unsigned int64 t_delta; /**< total elapsed delta mode time (s) */
 	unsigned int64 t_count; /**< number of updates */
 	unsigned int64 t_max;	/**< maximum delta (ns) */
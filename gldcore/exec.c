@@ -99,6 +99,8 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <sys/errno.h>
+#include <sys/wait.h>
+#include <fcntl.h>
 #define SOCKET int
 #define INVALID_SOCKET (-1)
 #define closesocket close
@@ -126,6 +128,7 @@
 #include "math.h"
 #include "time.h"
 #include "lock.h"
+#include "accumulator.h"
 #include "deltamode.h"
 #include "stream.h"
 #include "instance.h"
@@ -133,6 +136,9 @@
 #include "test.h"
 #include "link.h"
 #include "save.h"
+#include "benchmark.h"
+#include "server.h"
+#include "telemetry.h"
 
 #include "pthread.h"
 
@@ -267,9 +273,6 @@ int64 rlock_count = 0, rlock_spin = 0;
 int64 wlock_count = 0, wlock_spin = 0;
 #endif
 
-extern pthread_mutex_t mls_inst_lock;
-extern pthread_cond_t mls_inst_signal;
-
 //sjin: struct for pthread_create arguments
 struct arg_data {
 	int thread;
@@ -343,6 +346,127 @@ static STATUS show_progress(void)
 /***********************************************************************/
 /* CHECKPOINTS (DPC Apr 2011) */
 
+/* last checkpoint file written (deleted when the next one is complete unless checkpoint_keepall is set) */
+static char checkpoint_last[1024] = "";
+
+/* write a checkpoint file synchronously */
+static int checkpoint_write(char *fn)
+{
+	FILE *fp = fopen(fn,"w");
+	if ( fp==NULL )
+	{
+		output_error("unable to open checkpoint file '%s' for writing", fn);
+		return 0;
+	}
+	if ( stream(fp,SF_OUT)<=0 )
+	{
+		output_error("checkpoint failure (stream context is %s)",stream_context());
+		fclose(fp);
+		return 0;
+	}
+	fclose(fp);
+	return 1;
+}
+
+/* replace the previous checkpoint file with a newly completed one */
+static void checkpoint_complete(char *fn)
+{
+	if ( global_checkpoint_keepall==0 && strcmp(checkpoint_last,"")!=0 )
+		unlink(checkpoint_last);
+	strcpy(checkpoint_last,fn);
+}
+
+#ifndef WIN32
+/* forked checkpoint writer, if any */
+static pid_t checkpoint_pid = 0;
+static char checkpoint_pending[1024] = "";
+
+/** Collect the forked checkpoint writer
+	@returns 1 if no writer is outstanding, 0 if it is still running
+ **/
+static int checkpoint_collect(int wait)
+{
+	int status = 0;
+	pid_t pid;
+	char tmp[1024];
+
+	if ( checkpoint_pid==0 )
+		return 1;
+
+	pid = waitpid(checkpoint_pid,&status,wait?0:WNOHANG);
+	if ( pid==0 )
+		return 0;
+
+	/* the writer produces a temporary file so an interrupted write never looks like a checkpoint */
+	sprintf(tmp,"%s.tmp",checkpoint_pending);
+	if ( pid==checkpoint_pid && WIFEXITED(status) && WEXITSTATUS(status)==0 && rename(tmp,checkpoint_pending)==0 )
+	{
+		output_verbose("checkpoint '%s' completed", checkpoint_pending);
+		checkpoint_complete(checkpoint_pending);
+	}
+	else
+	{
+		output_error("checkpoint writer for '%s' failed", checkpoint_pending);
+		/*	TROUBLESHOOT
+			The background process that writes checkpoint files did not complete
+			normally, usually because the disk is full or the file could not be written.
+			The previous checkpoint file is kept.
+		 */
+		unlink(tmp);
+	}
+	checkpoint_pid = 0;
+	return 1;
+}
+
+/** Write a checkpoint from a copy-on-write fork of the process
+	@returns 1 if the writer was started, 0 if the checkpoint must be written synchronously
+ **/
+static int checkpoint_fork(char *fn)
+{
+	pid_t pid;
+	int fd;
+	char tmp[1024];
+
+	/* the file is opened here so the child needs neither stdio nor the heap */
+	sprintf(tmp,"%s.tmp",fn);
+	fd = open(tmp,O_WRONLY|O_CREAT|O_TRUNC,0666);
+	if ( fd<0 )
+	{
+		output_warning("unable to open checkpoint file '%s' (%s), writing checkpoint synchronously", tmp, strerror(errno));
+		/*	TROUBLESHOOT
+			The temporary file used by the background checkpoint writer could not be created.
+			The checkpoint is written by the simulation itself instead, which reports any
+			further problem with the checkpoint file.
+		 */
+		return 0;
+	}
+
+	pid = fork();
+	if ( pid<0 )
+	{
+		output_warning("unable to fork checkpoint writer (%s), writing checkpoint synchronously", strerror(errno));
+		/*	TROUBLESHOOT
+			The system could not create the background process used to write the checkpoint
+			file, usually because of process or memory limits.  The checkpoint is written by
+			the simulation itself instead, which pauses it until the file is complete.
+		 */
+		close(fd);
+		unlink(tmp);
+		return 0;
+	}
+	else if ( pid==0 )
+	{
+		/* child sees the memory image at the moment of the fork - other threads' locks may be held, so no stdio/malloc */
+		_exit(stream_fd(fd,SF_OUT)!=(size_t)-1 && close(fd)==0 ? 0 : 1);
+	}
+	close(fd);
+	checkpoint_pid = pid;
+	strcpy(checkpoint_pending,fn);
+	output_verbose("checkpoint '%s' started by process %d", fn, pid);
+	return 1;
+}
+#endif
+
 void do_checkpoint(void)
 {
 	/* last checkpoint value */
@@ -382,6 +506,11 @@ void do_checkpoint(void)
 		break;
 	}
 
+#ifndef WIN32
+	/* pick up a background writer that has finished */
+	checkpoint_collect(0);
+#endif
+
 	/* checkpoint may be needed */
 	if ( now > 0 )
 	{
@@ -392,8 +521,7 @@ void do_checkpoint(void)
 		/* checkpoint time lapsed */
 		if ( last_checkpoint + global_checkpoint_interval <= now )
 		{
-			static char fn[1024] = "";
-			FILE *fp = NULL;
+			char fn[1024];
 
 			/* default checkpoint filename */
 			if ( strcmp(global_checkpoint_file,"")==0 )
@@ -409,20 +537,28 @@ void do_checkpoint(void)
 					*ext = '\0';
 			}
 
-			/* delete old checkpoint file if not desired */
-			if ( global_checkpoint_keepall==0 && strcmp(fn,"")!=0 )
-				unlink(fn);
+#ifndef WIN32
+			/* previous background write still running - try again on the next pass */
+			if ( global_checkpoint_fork && checkpoint_collect(0)==0 )
+			{
+				output_verbose("checkpoint '%s' still being written, deferring next checkpoint", checkpoint_pending);
+				return;
+			}
+#endif
 
 			/* create current checkpoint save filename */
 			sprintf(fn,"%s.%d",global_checkpoint_file,global_checkpoint_seqnum++);
-			fp = fopen(fn,"w");
-			if ( fp==NULL )
-				output_error("unable to open checkpoint file '%s' for writing");
-			else
+
+#ifndef WIN32
+			if ( global_checkpoint_fork && checkpoint_fork(fn) )
 			{
-				if ( stream(fp,SF_OUT)<=0 )
-					output_error("checkpoint failure (stream context is %s)",stream_context());
-				fclose(fp);
+				last_checkpoint = now;
+				return;
+			}
+#endif
+			if ( checkpoint_write(fn) )
+			{
+				checkpoint_complete(fn);
 				last_checkpoint = now;
 			}
 		}
@@ -619,6 +755,27 @@ static STATUS init_by_creation()
 	return rv;
 }
 
+/* warn about objects that should have a name but don't */
+static void init_check_names(void)
+{
+	OBJECT *obj = object_get_first();
+	while (obj != 0)
+	{
+		if ((obj->oclass->passconfig & PC_FORCE_NAME) == PC_FORCE_NAME)
+		{
+			if (0 == strcmp(obj->name, ""))
+			{
+				output_warning("init: object %s:%d should have a name, but doesn't", obj->oclass->name, obj->id);
+				/* TROUBLESHOOT
+				   The object indicated has been flagged by the module which implements its class as one which must be named
+				   to work properly.  Please provide the object with a name and try again.
+				 */
+			}
+		}
+		obj = obj->next;
+	}
+}
+
 static int init_by_deferral_retry(OBJECT **def_array, int def_ct)
 {
 	OBJECT *obj;
@@ -751,25 +908,242 @@ static int init_by_deferral()
 	}
 	free(def_array);
 
-	obj = object_get_first();
-	while (obj != 0)
+	init_check_names();
+	return SUCCESS;
+}
+
+/* parallel initialization batch */
+struct init_data {
+	OBJECT **list; /* objects in the batch */
+	int *status; /* init result of each object in the batch */
+	int count; /* number of objects in the batch */
+	int thread; /* thread id */
+	int n_threads; /* number of threads working on the batch */
+};
+
+static void *init_batch_proc(void *arg)
+{
+	struct init_data *data = (struct init_data*)arg;
+	int i;
+	for ( i=data->thread ; i<data->count ; i+=data->n_threads )
+		data->status[i] = object_init(data->list[i]);
+	return NULL;
+}
+
+/* initialize a batch of independent objects, the results are returned in status */
+static STATUS init_batch(OBJECT **list, int *status, int count, int n_threads)
+{
+	struct init_data *data;
+	pthread_t *thread;
+	int n, started;
+
+	if ( n_threads>count )
+		n_threads = count;
+	if ( n_threads<2 )
 	{
-		if ((obj->oclass->passconfig & PC_FORCE_NAME) == PC_FORCE_NAME)
+		struct init_data single = {list,status,count,0,1};
+		init_batch_proc(&single);
+		return SUCCESS;
+	}
+
+	data = (struct init_data*)malloc(sizeof(struct init_data)*n_threads);
+	thread = (pthread_t*)malloc(sizeof(pthread_t)*n_threads);
+	if ( data==NULL || thread==NULL )
+	{
+		output_error("init_batch(): memory allocation failed");
+		free(data);
+		free(thread);
+		return FAILED;
+	}
+	for ( n=0 ; n<n_threads ; n++ )
+	{
+		data[n].list = list;
+		data[n].status = status;
+		data[n].count = count;
+		data[n].thread = n;
+		data[n].n_threads = n_threads;
+	}
+	for ( started=1 ; started<n_threads ; started++ )
+	{
+		if ( pthread_create(&thread[started],NULL,init_batch_proc,&data[started])!=0 )
 		{
-			if (0 == strcmp(obj->name, ""))
-			{
-				output_warning("init: object %s:%d should have a name, but doesn't", obj->oclass->name, obj->id);
-				/* TROUBLESHOOT
-				   The object indicated has been flagged by the module which implements its class as one which must be named
-				   to work properly.  Please provide the object with a name and try again.
-				 */
-			}
+			output_warning("init_batch(): unable to start init thread %d, continuing with %d thread(s)", started, started);
+			/* TROUBLESHOOT
+				The parallel initialization was unable to start one of its threads so
+				the main thread will initialize the objects that thread would have handled.
+				Reduce the value of the <b>threadcount</b> global variable to avoid this warning.
+			 */
+			break;
 		}
-		obj = obj->next;
 	}
+
+	/* the main thread handles the first share and any share left without a thread */
+	init_batch_proc(&data[0]);
+	for ( n=started ; n<n_threads ; n++ )
+		init_batch_proc(&data[n]);
+	for ( n=1 ; n<started ; n++ )
+		pthread_join(thread[n],NULL);
+	free(data);
+	free(thread);
 	return SUCCESS;
 }
 
+/* record the result of an object init, returns FAILED if the object failed */
+static STATUS init_result(OBJECT *obj, int status)
+{
+	char b[64];
+	switch ( status ) {
+	case 0:
+		output_error("init_by_parallel(): object %s initialization failed", object_name(obj, b, 63));
+		/* TROUBLESHOOT
+			The initialization of the named object has failed.  Make sure that the object's
+			requirements for initialization are satisfied and try again.
+		 */
+		return FAILED;
+	case 1:
+		wlock(&obj->lock);
+		obj->flags |= OF_INIT;
+		obj->flags &= ~OF_DEFERRED;
+		wunlock(&obj->lock);
+		break;
+	case 2:
+		wlock(&obj->lock);
+		obj->flags |= OF_DEFERRED;
+		wunlock(&obj->lock);
+		break;
+	// no default
+	}
+	return SUCCESS;
+}
+
+/* initialize objects concurrently
+
+   Each round first initializes the objects of classes that do not declare
+   PC_INITSAFE one at a time in creation order, exactly as the DEFERRED sequence
+   does.  The PC_INITSAFE objects are then sorted into levels by the number of
+   uninitialized parents above them, so an object is never initialized before
+   or alongside its parent, and each level is initialized concurrently.  The
+   results of a level are applied in creation order after the whole batch is
+   done, so OF_INIT changes only between batches and objects that defer on
+   another member of the same batch do so regardless of thread timing.
+   Deferred objects are retried in the next round.
+ */
+static STATUS init_by_parallel(void)
+{
+	int n = object_get_count();
+	int n_threads = global_threadcount>0 ? global_threadcount : processor_count();
+	OBJECT **pending = (OBJECT**)malloc(sizeof(OBJECT*)*n);
+	OBJECT **next = (OBJECT**)malloc(sizeof(OBJECT*)*n);
+	OBJECT **batch = (OBJECT**)malloc(sizeof(OBJECT*)*n);
+	int *level = (int*)malloc(sizeof(int)*n);
+	int *status = (int*)malloc(sizeof(int)*n);
+	int pending_ct = 0, tries = 0, batches = 0;
+	STATUS rv = SUCCESS;
+	OBJECT *obj;
+
+	if ( pending==NULL || next==NULL || batch==NULL || level==NULL || status==NULL )
+	{
+		output_error("init_by_parallel(): memory allocation failed");
+		rv = FAILED;
+		goto Done;
+	}
+	for ( obj=object_get_first() ; obj!=NULL ; obj=obj->next )
+		pending[pending_ct++] = obj;
+	output_verbose("initializing %d objects using %d thread(s)", pending_ct, n_threads);
+
+	while ( pending_ct>0 )
+	{
+		int i, max_level = 0, L, next_ct = 0;
+		OBJECT **swap;
+
+		if ( tries>global_init_max_defer )
+		{
+			output_error("init_by_parallel(): exhausted initialization attempts");
+			rv = FAILED;
+			goto Done;
+		}
+
+		/* objects that are not thread-safe are initialized alone in creation order */
+		for ( i=0 ; i<pending_ct ; i++ )
+		{
+			obj = pending[i];
+			level[i] = -1;
+			if ( (obj->oclass->passconfig&PC_INITSAFE)==0 && init_result(obj,object_init(obj))==FAILED )
+			{
+				rv = FAILED;
+				goto Done;
+			}
+		}
+
+		/* level of thread-safe objects is the number of uninitialized parents above them */
+		for ( i=0 ; i<pending_ct ; i++ )
+		{
+			OBJECT *parent;
+			if ( (pending[i]->oclass->passconfig&PC_INITSAFE)==0 )
+				continue;
+			level[i] = 0;
+			for ( parent=pending[i]->parent ; parent!=NULL && (parent->flags&OF_INIT)==0 && level[i]<n ; parent=parent->parent )
+				level[i]++;
+			if ( level[i]>max_level )
+				max_level = level[i];
+		}
+
+		/* thread-safe objects are initialized together one level at a time */
+		for ( L=0 ; L<=max_level ; L++ )
+		{
+			int batch_ct = 0;
+			for ( i=0 ; i<pending_ct ; i++ )
+			{
+				if ( level[i]==L )
+					batch[batch_ct++] = pending[i];
+			}
+			if ( batch_ct==0 )
+				continue;
+			if ( init_batch(batch,status,batch_ct,n_threads)==FAILED )
+			{
+				rv = FAILED;
+				goto Done;
+			}
+			batches++;
+			for ( i=0 ; i<batch_ct ; i++ )
+			{
+				if ( init_result(batch[i],status[i])==FAILED )
+				{
+					rv = FAILED;
+					goto Done;
+				}
+			}
+		}
+
+		/* deferred objects are retried in creation order */
+		for ( i=0 ; i<pending_ct ; i++ )
+		{
+			if ( pending[i]->flags&OF_DEFERRED )
+				next[next_ct++] = pending[i];
+		}
+		if ( next_ct==pending_ct )
+		{
+			output_error("init_by_parallel(): all uninitialized objects deferred, model is unable to initialize");
+			rv = FAILED;
+			goto Done;
+		}
+		swap = pending;
+		pending = next;
+		next = swap;
+		pending_ct = next_ct;
+		tries++;
+	}
+	output_verbose("initialization completed in %d round(s) with %d parallel batch(es)", tries, batches);
+	init_check_names();
+Done:
+	free(pending);
+	free(next);
+	free(batch);
+	free(level);
+	free(status);
+	return rv;
+}
+
 OBJECT **object_heartbeats = NULL;
 unsigned int n_object_heartbeats = 0;
 unsigned int max_object_heartbeats = 0;
@@ -796,6 +1170,9 @@ static STATUS init_all(void)
 		case IS_DEFERRED:
 			rv = init_by_deferral();
 			break;
+		case IS_PARALLEL:
+			rv = init_by_parallel();
+			break;
 		case IS_BOTTOMUP:
 			output_fatal("Bottom-up rank-based initialization mode not yet supported");
 			rv = FAILED;
@@ -982,7 +1359,10 @@ static void commit_call(MTIDATA output, MTIITEM item, MTIDATA input)
 	else if ((*t0 == obj->in_svc) && (obj->in_svc_micro != 0))
 		*t2 = obj->in_svc + 1;
 	else if ( obj->out_svc>=*t0 )
+	{
 		*t2 = obj->oclass->commit(obj,*t0);
+		if ( *t2==1 ) *t2 = TS_NEVER; /* 'old school' commit, as in object_commit() */
+	}
 	else
 		*t2 = TS_NEVER;
 }
@@ -1324,6 +1704,9 @@ static void *obj_syncproc(void *ptr)
 	unsigned int n;
 	int i = data->i;
 
+	// objects synchronized by this thread accumulate into its own buffers
+	accumulator_thread(data->n);
+
 	// begin processing loop
 	while (data->ok)
 	{
@@ -1672,6 +2055,7 @@ STATUS exec_start(void)
 	int pc_rv = 0; // precommit return value
 	STATUS fnl_rv = 0; // finalize all return value
 	time_t started_at = realtime_now(); // for profiler
+	int64 init_time = 0, exec_time = 0; // for benchmark
 	int j, k;
 	LISTITEM *ptr;
 	int incr;
@@ -1696,6 +2080,7 @@ STATUS exec_start(void)
 	exec_mls_init();
 
 	/* perform object initialization */
+	init_time = exec_clock();
 	if (init_all() == FAILED)
 	{
 		output_error("model initialization failed");
@@ -1707,6 +2092,8 @@ STATUS exec_start(void)
 		return FAILED;
 	}
 
+	init_time = exec_clock() - init_time;
+
 	/* establish rank index if necessary */
 	if (ranks == NULL && setup_ranks() == FAILED)
 	{
@@ -1779,6 +2166,14 @@ STATUS exec_start(void)
 		return FAILED;
 	}
 
+	/* start publishing telemetry, if any */
+	if ( telemetry_init()==FAILED )
+	{
+		output_error("telemetry startup failed");
+		return FAILED;
+	}
+	exec_time = exec_clock();
+
 	/* realtime startup */
 	if (global_run_realtime>0)
 	{
@@ -1794,11 +2189,8 @@ STATUS exec_start(void)
 	/*** GET FIRST SIGNAL FROM MASTER HERE ****/
 	if (global_multirun_mode == MRM_SLAVE)
 	{
-		pthread_cond_broadcast(&mls_inst_signal); // tell slaveproc() it's time to get rolling
 		output_debug("exec_start(), slave waiting for first time signal");
-		pthread_mutex_lock(&mls_inst_lock);
-		pthread_cond_wait(&mls_inst_signal, &mls_inst_lock);
-		pthread_mutex_unlock(&mls_inst_lock);
+		instance_slave_pause(); // tell slaveproc() it's time to get rolling
 		// will have copied data down and updated step_to with slave_cache
 		//global_clock = exec_sync_get(NULL); // copy time signal to gc
 		output_debug("exec_start(), slave received first time signal of %lli", global_clock);
@@ -2136,11 +2528,11 @@ STATUS exec_start(void)
 								for (n=0; n<n_threads[iObjRankList]; n++) {
 									thread[n].ok = true;
 									thread[n].i = iObjRankList;
+									thread[n].n = n;
 									if (pthread_create(&(thread[n].pt),NULL,obj_syncproc,&(thread[n]))!=0) {
 										output_fatal("obj_sync thread creation failed");
 										thread[n].ok = false;
-									} else
-										thread[n].n = n;
+									}
 								}
 
 							}
@@ -2176,6 +2568,9 @@ STATUS exec_start(void)
 							}
 						}
 					}
+
+					/* combine what the objects of this rank accumulated before the next rank runs */
+					accumulator_syncall();
 				}
 
 
@@ -2206,12 +2601,7 @@ STATUS exec_start(void)
 			{
 				output_debug("step_to = %lli", exec_sync_get(NULL));
 				output_debug("exec_start(), slave waiting for looped time signal");
-
-				pthread_cond_broadcast(&mls_inst_signal);
-
-				pthread_mutex_lock(&mls_inst_lock);
-				pthread_cond_wait(&mls_inst_signal, &mls_inst_lock);
-				pthread_mutex_unlock(&mls_inst_lock);
+				instance_slave_pause();
 
 				output_debug("exec_start(), slave received looped time signal (%lli)", exec_sync_get(NULL));
 			}
@@ -2241,6 +2631,12 @@ STATUS exec_start(void)
 
 				/* count number of timesteps */
 				tsteps++;
+
+				/* send the committed values to property streams */
+				server_stream_commit(global_clock);
+
+				/* publish the committed values to the telemetry ring */
+				telemetry_commit(global_clock);
 			}
 
 			/* check iteration limit */
@@ -2315,9 +2711,16 @@ STATUS exec_start(void)
 	}
 	ENDCATCH
 	output_debug("*** main loop ended at %lli; stoptime=%lli, n_events=%i, exitcode=%i ***", exec_sync_get(NULL), global_stoptime, exec_sync_getevents(NULL), exec_getexitcode());
+
+#ifndef WIN32
+	/* make sure the last checkpoint is complete */
+	checkpoint_collect(1);
+#endif
 	if(global_multirun_mode == MRM_MASTER)
 	{
 		instance_master_done(TS_NEVER); // tell everyone to pack up and go home
+		if ( instance_master_join()>0 && exec_getexitcode()==XC_SUCCESS )
+			exec_setexitcode(XC_PRCERR);
 	}
 
 	//sjin: GetMachineCycleCount
@@ -2327,8 +2730,13 @@ STATUS exec_start(void)
 	if(FAILED == fnl_rv)
 	{
 		output_error("finalize_all() failed");
+		if ( exec_getexitcode()==XC_SUCCESS )
+			exec_setexitcode(XC_RUNERR);
 	}
 
+	/* stop publishing telemetry so term scripts can read the finished ring */
+	telemetry_term();
+
 	/* run term scripts, if any */
 	if ( exec_run_termscripts()!=XC_SUCCESS )
 	{
@@ -2357,6 +2765,11 @@ STATUS exec_start(void)
 		pthread_cond_destroy(&done[k]);
 	}
 
+	/* save benchmark statistics */
+	exec_time = exec_clock() - exec_time;
+	if ( !exec_sync_isinvalid(NULL) )
+		benchmark_save(passes,tsteps,init_time,exec_time);
+
 	/* report performance */
 	if (global_profiler && !exec_sync_isinvalid(NULL) )
 	{
@@ -2372,6 +2785,7 @@ STATUS exec_start(void)
 		extern clock_t loadshape_synctime;
 		extern clock_t enduse_synctime;
 		extern clock_t transform_synctime;
+		extern int64 accumulator_combines;
 
 		CLASS *cl;
 		DELTAPROFILE *dp = delta_getprofile();
@@ -2409,6 +2823,7 @@ STATUS exec_start(void)
 		output_profile("Passes completed        %8d passes", passes);
 		output_profile("Time steps completed    %8d timesteps", tsteps);
 		output_profile("Convergence efficiency  %8.02lf passes/timestep", (double)passes/tsteps);
+		output_profile("Accumulator combines    %8"FMT_INT64"d combines", accumulator_combines);
 #ifndef NOLOCKS
 		output_profile("Read lock contention    %7.01lf%%", (rlock_spin>0 ? (1-(double)rlock_count/(double)rlock_spin)*100 : 0));
 		output_profile("Write lock contention   %7.01lf%%", (wlock_spin>0 ? (1-(double)wlock_count/(double)wlock_spin)*100 : 0));
@@ -2431,9 +2846,14 @@ STATUS exec_start(void)
 			output_profile("Object update time      %8.1lf s (%.1f%%)", (double)(dp->t_update)/(double)CLOCKS_PER_SEC, (double)(dp->t_update)/total*100); 
 			output_profile("Interupdate time        %8.1lf s (%.1f%%)", (double)(dp->t_interupdate)/(double)CLOCKS_PER_SEC, (double)(dp->t_interupdate)/total*100); 
 			output_profile("Postupdate time         %8.1lf s (%.1f%%)", (double)(dp->t_postupdate)/(double)CLOCKS_PER_SEC, (double)(dp->t_postupdate)/total*100);
+			if ( global_deltamode_timestep_max>0 )
+				output_profile("Nextstep time           %8.1lf s (%.1f%%)", (double)(dp->t_nextstep)/(double)CLOCKS_PER_SEC, (double)(dp->t_nextstep)/total*100);
 			output_profile("Total deltamode runtime %8.1lf s (100%%)", delta_runtime);
 			output_profile("Simulation rate         %8.1lf x realtime", delta_simtime/delta_runtime/1000);
 		}
+#ifndef NOLOCKS
+		lock_profile();
+#endif
 		output_profile("\n");
 	}
 
@@ -2948,9 +3368,14 @@ static int update_exports(void)
 		char value[1024];
 		if ( global_getvar(name,value,sizeof(value)) )
 		{
+#ifdef WIN32
 			char env[2048];
 			sprintf(env,"%s=%s",name,value);
 			if ( putenv(env)!=0 )
+#else
+			/* putenv() keeps the string itself, which must outlive this stack frame */
+			if ( setenv(name,value,1)!=0 )
+#endif
 				output_warning("unable to update script export '%s' with value '%s'", name, value);
 		}
 	}
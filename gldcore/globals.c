@@ -72,7 +72,8 @@ static KEYWORD isc_keys[] = {
 	{"CREATION", IS_CREATION, isc_keys+1},
 	{"DEFERRED", IS_DEFERRED, isc_keys+2},
 	{"BOTTOMUP", IS_BOTTOMUP, isc_keys+3},
-	{"TOPDOWN", IS_TOPDOWN, NULL}
+	{"TOPDOWN", IS_TOPDOWN, isc_keys+4},
+	{"PARALLEL", IS_PARALLEL, NULL}
 };
 
 static KEYWORD mcf_keys[] = {
@@ -98,6 +99,11 @@ static KEYWORD so_keys[] = {
 	{"NAMES", SO_NAMES, so_keys+1},
 	{"POSITIONS", SO_GEOCOORDS, NULL},
 };
+static KEYWORD lo_keys[] = {
+	{"NONE", LO_NONE, lo_keys+1},
+	{"ADAPTIVE", LO_ADAPTIVE, lo_keys+2},
+	{"SHAREDREAD", LO_SHAREDREAD, NULL},
+};
 static KEYWORD sm_keys[] = {
 	{"INIT", SM_INIT, sm_keys+1},
 	{"EVENT", SM_EVENT, sm_keys+2},
@@ -191,6 +197,7 @@ static struct s_varmap {
 	{"checkpoint_seqnum", PT_int32, &global_checkpoint_seqnum, PA_PUBLIC, "checkpoint sequence number"},
 	{"checkpoint_interval", PT_int32, &global_checkpoint_interval, PA_PUBLIC, "checkpoint interval"},
 	{"checkpoint_keepall", PT_bool, &global_checkpoint_keepall, PA_PUBLIC, "checkpoint file keep enable flag"},
+	{"checkpoint_fork", PT_bool, &global_checkpoint_fork, PA_PUBLIC, "checkpoint background write enable flag"},
 	{"check_version", PT_bool, &global_check_version, PA_PUBLIC, "check version enable flag"},
 	{"random_number_generator", PT_enumeration, &global_randomnumbergenerator, PA_PUBLIC, "random number generator version control flag", rng_keys},
 	{"mainloop_state", PT_enumeration, &global_mainloopstate, PA_PUBLIC, "main sync loop state flag", mls_keys},
@@ -220,6 +227,8 @@ static struct s_varmap {
 	{"simulation_mode",PT_enumeration,&global_simulation_mode,PA_PUBLIC, "current time simulation type",sm_keys},
 	{"deltamode_timestep",PT_int32,&global_deltamode_timestep,PA_PUBLIC, "uniform step size for deltamode simulations"},
 	{"deltamode_maximumtime", PT_int64,&global_deltamode_maximumtime,PA_PUBLIC, "maximum time (ns) deltamode can run"},
+	{"deltamode_timestep_min", PT_int64,&global_deltamode_timestep_min,PA_PUBLIC, "smallest step size (ns) for variable step deltamode simulations"},
+	{"deltamode_timestep_max", PT_int64,&global_deltamode_timestep_max,PA_PUBLIC, "largest step size (ns) for variable step deltamode simulations (0 for uniform steps)"},
 	{"deltaclock", PT_int64, &global_deltaclock, PA_PUBLIC, "cumulative delta runtime with respect to the global clock"},
 	{"delta_current_clock", PT_double, &global_delta_curr_clock, PA_PUBLIC, "Absolute delta time (global clock offset)"},
 	{"deltamode_updateorder", PT_char1024, &global_deltamode_updateorder, PA_REFERENCE, "order in which modules are update in deltamode"},
@@ -230,6 +239,12 @@ static struct s_varmap {
 	{"wget_options", PT_char1024, &global_wget_options, PA_PUBLIC, "wget options"},
 	{"svnroot", PT_char1024, &global_svnroot, PA_PUBLIC, "svnroot"},
 	{"allow_reinclude", PT_bool, &global_reinclude, PA_PUBLIC, "allow the same include file to be included multiple times"},
+	{"telemetry_file", PT_char1024, &global_telemetry_file, PA_PUBLIC, "file to which live telemetry is published"},
+	{"telemetry_properties", PT_char1024, &global_telemetry_properties, PA_PUBLIC, "values published in the telemetry ring"},
+	{"telemetry_depth", PT_int32, &global_telemetry_depth, PA_PUBLIC, "number of records kept in the telemetry ring"},
+	{"lock_options", PT_set, &global_lock_options, PA_PUBLIC, "memory locking options", lo_keys},
+	{"lock_spin", PT_int32, &global_lock_spin, PA_PUBLIC, "number of spins before a waiting lock yields"},
+	{"accumulators", PT_bool, &global_accumulators, PA_PUBLIC, "add loads into parents through per-thread accumulators instead of under a lock"},
 	/* add new global variables here */
 };
 
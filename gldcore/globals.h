@@ -133,7 +133,7 @@ GLOBAL int global_forbid_multiload INIT(0); /** flag to disable multiple GLM fil
 GLOBAL int global_skipsafe INIT(0); /** flag to allow skipping of safe syncs (see OF_SKIPSAFE) */
 typedef enum {DF_ISO=0, DF_US=1, DF_EURO=2} DATEFORMAT;
 GLOBAL int global_dateformat INIT(DF_ISO); /** date format (ISO=0, US=1, EURO=2) */
-typedef enum {IS_CREATION=0, IS_DEFERRED=1, IS_BOTTOMUP=2, IS_TOPDOWN=3} INITSEQ;
+typedef enum {IS_CREATION=0, IS_DEFERRED=1, IS_BOTTOMUP=2, IS_TOPDOWN=3, IS_PARALLEL=4} INITSEQ;
 GLOBAL int global_init_sequence INIT(IS_DEFERRED); /** initialization sequence, default is ordered-by-creation */
 #include "timestamp.h"
 #include "realtime.h"
@@ -207,6 +207,7 @@ GLOBAL char global_checkpoint_file[1024] INIT(""); /**< checkpoint file name is
 GLOBAL int global_checkpoint_seqnum INIT(0); /**< checkpoint sequence file number */
 GLOBAL int global_checkpoint_interval INIT(0); /** checkpoint interval (default is 3600 for CPT_WALL and 86400 for CPT_SIM */
 GLOBAL int global_checkpoint_keepall INIT(0); /** determines whether all checkpoint files are kept, non-zero keeps files, zero delete all but last */
+GLOBAL int global_checkpoint_fork INIT(0); /** determines whether checkpoint files are written by a forked copy of the process while the simulation continues, non-zero forks */
 
 /* version check */
 GLOBAL int global_check_version INIT(0); /**< check version flag */
@@ -250,6 +251,8 @@ typedef enum {
 GLOBAL SIMULATIONMODE global_simulation_mode INIT(SM_INIT); /**< simulation mode */
 GLOBAL DT global_deltamode_timestep INIT(10000000); /**< delta mode time step in ns (default is 10ms) */
 GLOBAL DELTAT global_deltamode_maximumtime INIT(3600000000000); /**< the maximum time (in ns) delta mode is allowed to run without an event (default is 1 hour) */
+GLOBAL DELTAT global_deltamode_timestep_min INIT(0); /**< the smallest variable delta mode time step in ns (default 0 is the deltamode_timestep) */
+GLOBAL DELTAT global_deltamode_timestep_max INIT(0); /**< the largest variable delta mode time step in ns (default 0 uses a uniform time step) */
 GLOBAL DELTAT global_deltaclock INIT(0); /**< the cumulative delta runtime with respect to the global clock */
 GLOBAL double global_delta_curr_clock INIT(0.0);	/**< Deltamode clock offset by main clock (not just delta offset) */
 GLOBAL char global_deltamode_updateorder[1025] INIT(""); /**< the order in which modules are updated */
@@ -315,6 +318,23 @@ GLOBAL char1024 global_svnroot INIT("http://gridlab-d.svn.sourceforge.net/svnroo
 GLOBAL char1024 global_wget_options INIT("maxsize:100MB;update:newer"); /**< maximum size of wget request */
 
 GLOBAL bool global_reinclude INIT(false); /**< allow the same include file to be included multiple times */
+
+/* telemetry ring */
+GLOBAL char1024 global_telemetry_file INIT(""); /**< file to which live telemetry is published (none if empty) */
+GLOBAL char1024 global_telemetry_properties INIT(""); /**< values published in the telemetry ring */
+GLOBAL int32 global_telemetry_depth INIT(256); /**< number of records kept in the telemetry ring */
+
+/* memory locking */
+typedef enum {
+	LO_NONE			= 0x00, /**< locks spin until they are released */
+	LO_ADAPTIVE		= 0x01, /**< locks spin briefly, then yield and park until they are released */
+	LO_SHAREDREAD	= 0x02, /**< read locks are shared by the readers */
+} LOCKOPTIONS; /**< lock options */
+GLOBAL set global_lock_options INIT(LO_NONE); /**< lock options */
+GLOBAL int32 global_lock_spin INIT(1000); /**< number of spins before a waiting adaptive lock yields */
+
+/* load accumulation */
+GLOBAL bool global_accumulators INIT(true); /**< add into parents through per-thread accumulators (false adds under a lock) */
 #ifdef __cplusplus
 }
 #endif
@@ -584,6 +584,7 @@ template <class T> inline int gl_set_value(OBJECT *obj, ///< the object whose pr
 		}
 	}
 	*ptr = value;
+	callback->change.notify(obj,prop);
 	if(obj->oclass->notify){
 		if(obj->oclass->notify(obj,NM_POSTUPDATE,prop) == 0){
 			gl_error("postupdate notify failure on %s in %s", prop->name, obj->name ? obj->name : "an unnamed object");
@@ -756,6 +757,11 @@ inline bool *gl_get_bool(OBJECT *obj, /**< object to set dependency */
 	@see aggregate_value()
  **/
 #define gl_run_aggregate (*callback->aggregate.refresh)
+
+/** Evaluate a list of aggregate properties
+	@see aggregate_values()
+ **/
+#define gl_run_aggregates (*callback->aggregate.refresh_list)
 /** @} **/
 
 /******************************************************************************
@@ -1193,6 +1199,100 @@ inline const char *gl_module_find_transform_function(TRANSFORMFUNCTION function)
 #endif
 /**@}*/
 
+/****************************
+ * Property change notification
+ */
+/** @defgroup gridlabd_h_change Property change notification
+ * @{
+ */
+#ifdef __cplusplus
+/** Subscribe to changes of a property (returns 0 if the property must still be polled) **/
+inline int gl_subscribe_changes(OBJECT *obj, PROPERTY *prop) { return callback->change.subscribe(obj,prop); };
+/** Report a change to a property declared with PF_NOTIFYCHANGE **/
+inline void gl_notify_change(OBJECT *obj, PROPERTY *prop) { callback->change.notify(obj,prop); };
+/** Get the change count of a subscribed property **/
+inline unsigned int gl_get_changes(OBJECT *obj, PROPERTY *prop) { return callback->change.count(obj,prop); };
+#else
+#define gl_subscribe_changes (*callback->change.subscribe) /* int (*change.subscribe)(OBJECT*,PROPERTY*) */
+#define gl_notify_change (*callback->change.notify) /* void (*change.notify)(OBJECT*,PROPERTY*) */
+#define gl_get_changes (*callback->change.count) /* unsigned int (*change.count)(OBJECT*,PROPERTY*) */
+#endif
+/**@}*/
+
+/****************************
+ * Multithreaded iterators
+ */
+/** @defgroup gridlabd_h_mti Multithreaded iterators
+	Modules can run loops over their objects on the core thread pool.  The
+	iterator functions are defined in threadpool.h.
+ * @{
+ */
+#ifdef __cplusplus
+/** Create a multithreaded iterator (returns NULL if the loop must be run single threaded) **/
+inline struct s_mtiteratorlist *gl_mti_init(const char *name, struct s_mtifunctions *fns, size_t minitems) { return callback->mti.init(name,fns,minitems); };
+/** Run a multithreaded iterator (returns 0 if the loop must be run single threaded) **/
+inline int gl_mti_run(void *result, struct s_mtiteratorlist *mti, void *input) { return callback->mti.run(result,mti,input); };
+#else
+#define gl_mti_init (*callback->mti.init) /* MTI *(*mti.init)(const char*,MTIFUNCTIONS*,size_t) */
+#define gl_mti_run (*callback->mti.run) /* int (*mti.run)(MTIDATA,MTI*,MTIDATA) */
+#endif
+/**@}*/
+
+/****************************
+ * Statistics windows
+ */
+/** @defgroup gridlabd_h_statwindow Statistics windows
+	Modules can keep running statistics of a sample stream without buffering
+	the samples.  The window functions are defined in statistics.h.
+ * @{
+ */
+#ifdef __cplusplus
+/** Create a statistics window of \p size samples (0 accumulates until reset), returns NULL on failure **/
+inline STATWINDOW *gl_statwindow_create(unsigned int size, unsigned int options=SWO_NONE, double quantile=0.5) { return callback->statwindow.create(size,options,quantile); };
+/** Destroy a statistics window **/
+inline void gl_statwindow_destroy(STATWINDOW *window) { callback->statwindow.destroy(window); };
+/** Remove all the samples from a statistics window **/
+inline void gl_statwindow_reset(STATWINDOW *window) { callback->statwindow.reset(window); };
+/** Add a sample to a statistics window **/
+inline void gl_statwindow_add(STATWINDOW *window, double value) { callback->statwindow.add(window,value); };
+/** Skip a sample slot of a statistics window **/
+inline void gl_statwindow_skip(STATWINDOW *window) { callback->statwindow.skip(window); };
+/** Get a statistic from a statistics window **/
+inline double gl_statwindow_get(STATWINDOW *window, STATWINDOWVALUE which) { return callback->statwindow.get(window,which); };
+#else
+#define gl_statwindow_create (*callback->statwindow.create) /* STATWINDOW *(*statwindow.create)(unsigned int,unsigned int,double) */
+#define gl_statwindow_destroy (*callback->statwindow.destroy) /* void (*statwindow.destroy)(STATWINDOW*) */
+#define gl_statwindow_reset (*callback->statwindow.reset) /* void (*statwindow.reset)(STATWINDOW*) */
+#define gl_statwindow_add (*callback->statwindow.add) /* void (*statwindow.add)(STATWINDOW*,double) */
+#define gl_statwindow_skip (*callback->statwindow.skip) /* void (*statwindow.skip)(STATWINDOW*) */
+#define gl_statwindow_get (*callback->statwindow.get) /* double (*statwindow.get)(STATWINDOW*,STATWINDOWVALUE) */
+#endif
+/**@}*/
+
+/****************************
+ * Accumulators
+ */
+/** @defgroup gridlabd_h_accumulator Accumulators
+	Modules can add values into another object, usually their parent, without
+	locking it.  The values are combined by the core once all the objects of
+	the rank have been synchronized.  The accumulator functions are defined
+	in accumulator.h.
+ * @{
+ */
+#ifdef __cplusplus
+/** Get the accumulator of \p n values, creating it if needed, returns NULL on failure **/
+inline ACCUMULATOR *gl_accumulator_create(complex *value, unsigned int n) { return callback->accumulator.create(value,n); };
+/** Add values to an accumulator **/
+inline void gl_accumulator_add(ACCUMULATOR *acc, complex *values) { callback->accumulator.add(acc,values); };
+/** Subtract values from an accumulator **/
+inline void gl_accumulator_sub(ACCUMULATOR *acc, complex *values) { callback->accumulator.sub(acc,values); };
+#else
+#define gl_accumulator_create (*callback->accumulator.create) /* ACCUMULATOR *(*accumulator.create)(complex*,unsigned int) */
+#define gl_accumulator_add (*callback->accumulator.add) /* void (*accumulator.add)(ACCUMULATOR*,complex*) */
+#define gl_accumulator_sub (*callback->accumulator.sub) /* void (*accumulator.sub)(ACCUMULATOR*,complex*) */
+#endif
+/**@}*/
+
 #ifdef __cplusplus
 inline randomvar *gl_randomvar_getfirst(void) { return callback->randomvar.getnext(NULL); };
 inline randomvar *gl_randomvar_getnext(randomvar *var) { return callback->randomvar.getnext(var); };
@@ -2100,12 +2200,15 @@ public: // special operations
 	inline set get_set(void) { if ( pstruct.prop->ptype == PT_set ) return *(set*)get_addr(); exception("get_set() called on a property that is not a set"); };
 	inline gld_object* get_objectref(void) { if ( is_objectref() ) return ::get_object(*(OBJECT**)get_addr()); else return NULL; };
 	template <class T> inline void getp(T &value) { ::rlock(&obj->lock); value = *(T*)get_addr(); ::runlock(&obj->lock); };
-	template <class T> inline void setp(T &value) { ::wlock(&obj->lock); *(T*)get_addr()=value; ::wunlock(&obj->lock); };
+	template <class T> inline void setp(T &value) { ::wlock(&obj->lock); *(T*)get_addr()=value; ::wunlock(&obj->lock); notify_change(); };
 	template <class T> inline void getp(T &value, gld_rlock&) { value = *(T*)get_addr(); };
 	template <class T> inline void getp(T &value, gld_wlock&) { value = *(T*)get_addr(); };
-	template <class T> inline void setp(T &value, gld_wlock&) { *(T*)get_addr()=value; };
-	inline void setp(enumeration value) { ::wlock(&obj->lock); *(enumeration*)get_addr()=value; ::wunlock(&obj->lock); };
-	inline void setp(set value) { ::wlock(&obj->lock); *(set*)get_addr()=value; ::wunlock(&obj->lock); };
+	template <class T> inline void setp(T &value, gld_wlock&) { *(T*)get_addr()=value; notify_change(); };
+	inline void setp(enumeration value) { ::wlock(&obj->lock); *(enumeration*)get_addr()=value; ::wunlock(&obj->lock); notify_change(); };
+	inline void setp(set value) { ::wlock(&obj->lock); *(set*)get_addr()=value; ::wunlock(&obj->lock); notify_change(); };
+	inline void notify_change(void) { if ( obj!=NULL ) callback->change.notify(obj,pstruct.prop); };
+	inline bool subscribe_changes(void) { return obj!=NULL && callback->change.subscribe(obj,pstruct.prop)!=0; };
+	inline unsigned int get_changes(void) { return obj!=NULL ? callback->change.count(obj,pstruct.prop) : 0; };
 	inline gld_keyword* find_keyword(unsigned long value) { return get_first_keyword()->find(value); };
 	inline gld_keyword* find_keyword(const char *name) { return get_first_keyword()->find(name); };
 	inline bool compare(char *op, char *a, char *b=NULL, char *p=NULL) 
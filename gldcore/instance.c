@@ -18,6 +18,11 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <sys/errno.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <semaphore.h>
+#include <time.h>
+#include <unistd.h>
 #define SOCKET int
 #define INVALID_SOCKET (-1)
 #define closesocket close
@@ -219,7 +224,12 @@ void *instance_runproc(void *ptr)
 			rc = -1;
 			break;
 #else
-			// shmem not written yet
+			/* run new instance with this executable and wait for it to finish */
+			sprintf(cmd,"%s %s %s --slave %s:%"FMT_INT64"x %s", global_execname, global_verbose_mode?"--verbose":"", global_debug_output?"--debug":"", global_hostname,inst->cacheid, inst->model);
+			output_verbose("starting new instance with command '%s'", cmd);
+			rc = system(cmd);
+			if ( rc>0 )
+				rc = WIFEXITED(rc) ? WEXITSTATUS(rc) : -1;
 #endif
 			break;
 		case CI_SOCKET:
@@ -335,7 +345,10 @@ int instance_master_wait_mmap(instance *inst){
 		}
 	ResetEvent(inst->hMaster);
 	// copy data to cache
-	memcpy(inst->cache, inst->buffer, inst->cachesize);
+	if ( INSTANCE_DIRECT(inst) ) /* linkages are read in place */
+		memcpy(inst->cache, inst->buffer, sizeof(MESSAGE));
+	else
+		memcpy(inst->cache, inst->buffer, inst->cachesize);
 	return status;
 #else
 	output_error("instance_master_wait_mmap(): should not have been called outside Windows");
@@ -343,6 +356,92 @@ int instance_master_wait_mmap(instance *inst){
 #endif
 }
 
+#ifndef WIN32
+/** instance_shmem_wait
+	Wait on a shared memory instance semaphore.
+	@returns 1 when signalled, 0 on timeout or failure
+ **/
+int instance_shmem_wait(void *sem, int32 timeout)
+{
+	int rc;
+	if ( timeout<0 )
+	{
+		while ( (rc=sem_wait((sem_t*)sem))!=0 && errno==EINTR ) {}
+		return rc==0 ? 1 : 0;
+	}
+	else
+	{
+#ifdef __APPLE__
+		/* no sem_timedwait */
+		int32 waited;
+		for ( waited=0 ; waited<=timeout ; waited++ )
+		{
+			if ( sem_trywait((sem_t*)sem)==0 )
+				return 1;
+			usleep(1000);
+		}
+		errno = ETIMEDOUT;
+		return 0;
+#else
+		struct timespec until;
+		clock_gettime(CLOCK_REALTIME,&until);
+		until.tv_sec += timeout/1000;
+		until.tv_nsec += (long)(timeout%1000)*1000000;
+		if ( until.tv_nsec>=1000000000 )
+		{
+			until.tv_sec++;
+			until.tv_nsec -= 1000000000;
+		}
+		while ( (rc=sem_timedwait((sem_t*)sem,&until))!=0 && errno==EINTR ) {}
+		return rc==0 ? 1 : 0;
+#endif
+	}
+}
+
+/** instance_shmem_unlink
+	Remove the names of a shared memory instance's cache and semaphores.  The slave opens them by
+	name, so this is done once the slave has signalled its initialization (or failed to); the
+	objects themselves remain in use until both sides unmap and close them.
+ **/
+void instance_shmem_unlink(instance *inst)
+{
+	char name[64];
+	sprintf(name,"/GLD-%"FMT_INT64"x",inst->cacheid);
+	shm_unlink(name);
+	sprintf(name,"/GLD-%"FMT_INT64"x-M",inst->cacheid);
+	sem_unlink(name);
+	sprintf(name,"/GLD-%"FMT_INT64"x-S",inst->cacheid);
+	sem_unlink(name);
+}
+#endif
+
+int instance_master_wait_shmem(instance *inst){
+#ifndef WIN32
+	int status = 0;
+
+	if(0 == inst){
+		output_error("instance_master_wait_shmem(): null inst pointer");
+		return status;
+	}
+
+	status = instance_shmem_wait(inst->hMaster,global_signal_timeout);
+	if ( status )
+		output_debug("slave %d wait completed", inst->id);
+	else
+		output_error("slave %d wait %s", inst->id, errno==ETIMEDOUT?"timeout":strerror(errno));
+
+	// copy data to cache
+	if ( INSTANCE_DIRECT(inst) ) /* linkages are read in place */
+		memcpy(inst->cache, inst->buffer, sizeof(MESSAGE));
+	else
+		memcpy(inst->cache, inst->buffer, inst->cachesize);
+	return status;
+#else
+	output_error("instance_master_wait_shmem(): should not have been called under Windows");
+	return 0;
+#endif
+}
+
 int instance_master_wait_socket(instance *inst){
 
 	if(0 == inst){
@@ -397,7 +496,9 @@ int instance_master_wait(void)
 			status = instance_master_wait_mmap(inst);
 		}
 #else
-	// @todo linux/unix slave signalling
+		if(inst->cnxtype == CI_SHMEM){
+			status = instance_master_wait_shmem(inst);
+		}
 #endif
 		if(inst->cnxtype == CI_SOCKET){
 			status = instance_master_wait_socket(inst);
@@ -427,7 +528,13 @@ void instance_master_done_mmap(instance *inst){
 }
 
 void instance_master_done_shmem(instance *inst){
-	;	// send
+	if(0 == inst){
+		output_error("instance_master_done_shmem(): null inst pointer");
+		return;
+	}
+#ifndef WIN32
+	sem_post((sem_t*)inst->hSlave);
+#endif
 }
 
 void instance_master_done_socket(instance *inst){
@@ -495,6 +602,30 @@ void instance_master_done(TIMESTAMP t1)
 
 
 
+/** instance_master_join
+	Wait for the slave instance controllers to finish after the master is done.
+	@returns the number of slaves that did not exit normally
+ **/
+int instance_master_join(void)
+{
+	instance *inst;
+	int failed = 0;
+	for ( inst=instance_list ; inst!=NULL ; inst=inst->next )
+	{
+		void *rc = NULL;
+		if ( pthread_join(inst->threadid,&rc)!=0 || rc!=NULL )
+		{
+			output_error("slave %d for model '%s' did not complete normally", inst->id, inst->model);
+			/* TROUBLESHOOT
+				A slave instance exited with an error.  Check the slave's output (it is prefixed with S
+				and the slave number) for the reason it failed.
+			 */
+			failed++;
+		}
+	}
+	return failed;
+}
+
 /** instance_init
     Initialize an instance object.  This occurs on the master side for each slave instance.
 	return 1 on failure, 0 on success.
@@ -515,6 +646,14 @@ STATUS instance_init(instance *inst)
 		{"shmem", CI_SHMEM},
 		{"socket", CI_SOCKET},
 	};
+	int linkagecnt = 2;
+	struct {
+		char *word;
+		int16 flags;
+	} linkagetype[] = {
+		{"text", 0},
+		{"binary", MF_BINARY},
+	};
 	
 	if(0 == inst){
 		output_error("instance_init(): null inst pointer");
@@ -548,6 +687,21 @@ STATUS instance_init(instance *inst)
 		inst->cnxtype = CI_SHMEM;
 #endif
 	}
+
+	// validate linkage format
+	inst->flags = 0;
+	if(inst->linkagestr[0] != 0){
+		for (i = 0; i < linkagecnt; ++i){
+			if(0 == strcmp(inst->linkagestr, linkagetype[i].word)){
+				inst->flags |= linkagetype[i].flags;
+				break;
+			}
+		}
+		if(i == linkagecnt){ // exhausted the list without finding a match
+			output_error("instance_init(): unrecognized linkage format '%s' for instance '%s'", inst->linkagestr, inst->model);
+			return FAILED;
+		}
+	}
 	// calculate message buffer requirements
 	/* initialize linkages */
 	inst->cachesize = sizeof(MESSAGE);
@@ -588,20 +742,28 @@ STATUS instance_init(instance *inst)
 	
 	//	initialize cache
 	inst->cache->id = inst->id = instances_count;
+	inst->cache->flags = inst->flags;
 
 	//output_verbose("inst_init(): slave %d cache at %x, ts at %x", instances_count, inst->cache, &(inst->cache->ts));
 
 	// write property lists
 	// properties are written into the buffer as "obj1.prop1,obj2.prop2 obj3.prop3,obj4.prop4\0".
 	//	a space separates the writers from the readers.
+	//	binary linkages tag each name with the property type, e.g., "obj1.prop1:1".
 	for ( lnk=inst->write ; lnk!=NULL ; lnk=lnk->next ){
-		sprintf(inst->message->name_buffer+name_offset, "%s.%s%c", lnk->remote.obj, lnk->remote.prop, (lnk->next == 0 ? ' ' : ','));
+		if ( lnk->binary )
+			sprintf(inst->message->name_buffer+name_offset, "%s.%s:%d%c", lnk->remote.obj, lnk->remote.prop, lnk->target.prop->ptype, (lnk->next == 0 ? ' ' : ','));
+		else
+			sprintf(inst->message->name_buffer+name_offset, "%s.%s%c", lnk->remote.obj, lnk->remote.prop, (lnk->next == 0 ? ' ' : ','));
 		lnk->addr = (char *)(inst->message->data_buffer + prop_offset);
 		name_offset += lnk->name_size;
 		prop_offset += lnk->prop_size;
 	}
 	for ( lnk=inst->read ; lnk!=NULL ; lnk=lnk->next ){
-		sprintf(inst->message->name_buffer+name_offset, "%s.%s%c", lnk->remote.obj, lnk->remote.prop, (lnk->next == 0 ? '\0' : ','));
+		if ( lnk->binary )
+			sprintf(inst->message->name_buffer+name_offset, "%s.%s:%d%c", lnk->remote.obj, lnk->remote.prop, lnk->target.prop->ptype, (lnk->next == 0 ? '\0' : ','));
+		else
+			sprintf(inst->message->name_buffer+name_offset, "%s.%s%c", lnk->remote.obj, lnk->remote.prop, (lnk->next == 0 ? '\0' : ','));
 		lnk->addr = (char *)(inst->message->data_buffer + prop_offset);
 		name_offset += lnk->name_size;
 		prop_offset += lnk->prop_size;
@@ -619,6 +781,14 @@ STATUS instance_init(instance *inst)
 		output_error("instance_init(): instance_connect() failed");
 		return FAILED;
 	}
+	// binary linkages over a memory map are exchanged in place in the shared view
+	if ( INSTANCE_DIRECT(inst) )
+	{
+		for ( lnk=inst->write ; lnk!=NULL ; lnk=lnk->next )
+			lnk->addr = inst->buffer + (lnk->addr - (char*)inst->cache);
+		for ( lnk=inst->read ; lnk!=NULL ; lnk=lnk->next )
+			lnk->addr = inst->buffer + (lnk->addr - (char*)inst->cache);
+	}
 	// start instance_proc thread
 	/* start the slave instance */
 	if ( pthread_create(&(inst->threadid), NULL, instance_runproc, (void*)inst) )
@@ -648,9 +818,6 @@ STATUS instance_initall(void)
 		global_multirun_mode = MRM_MASTER;
 		output_verbose("entering multirun mode");
 		output_prefix_enable();
-		pthread_mutex_lock(&mls_inst_lock);
-		pthread_cond_wait(&mls_inst_signal, &mls_inst_lock);
-		
 	} else {
 		return SUCCESS;
 	}
@@ -663,6 +830,14 @@ STATUS instance_initall(void)
 
 	// wait for slaves to signal init done
 	rv = instance_master_wait();
+#ifndef WIN32
+	// slaves have opened their shared memory by now (or never will)
+	for ( inst=instance_list ; inst!=NULL ; inst=inst->next )
+	{
+		if ( inst->cnxtype==CI_SHMEM )
+			instance_shmem_unlink(inst);
+	}
+#endif
 	if(0 == rv){
 		output_error("instance_initall(): final wait() failed");
 		return FAILED;
@@ -694,7 +869,10 @@ STATUS instance_write_slave(instance *inst)
 		}
 	}
 	//output_verbose("copying %d bytes from %x to %x (%lli)", inst->cachesize, inst->cache, inst->buffer, inst->cache->ts);
-	memcpy(inst->buffer, inst->cache, inst->cachesize);
+	if ( INSTANCE_DIRECT(inst) ) /* linkages were written in place */
+		memcpy(inst->buffer, inst->cache, sizeof(MESSAGE));
+	else
+		memcpy(inst->buffer, inst->cache, inst->cachesize);
 	printcontent(inst->buffer, (int)inst->cachesize);
 	return SUCCESS;
 }
@@ -31,6 +31,8 @@
 #define MSG_ERR		"GLDERROR"
 #define MSG_DONE	"GLDDONE"
 
+#define MF_BINARY	0x0001 ///< linkages are exchanged as raw property data
+
 typedef enum {
 	IST_DEFAULT = 0,
 	IST_MASTER_INIT = 1,
@@ -57,6 +59,7 @@ typedef struct s_message {
 	TIMESTAMP ts;				///< timestamp
 	int16 name_size;
 	int16 data_size;
+	int16 flags;				///< message flags (MF_BINARY)
 	char data;					///< first character in link data
 } MESSAGE; ///< message cache structure
 
@@ -111,6 +114,10 @@ typedef struct s_instance {
 	int16 writer_count;
 	int16 reader_count;
 
+	/* linkage format */
+	char32 linkagestr;
+	int16 flags;			///< message flags (MF_BINARY)
+
 	/* connection information */
 	char32 cnxtypestr;
 	CNXTYPE cnxtype;
@@ -123,9 +130,9 @@ typedef struct s_instance {
 		};
 #else // linux/unix
 		struct {
-			int fd; ///<
-			int shmkey; ///<
-			int shmid; ///<
+			int fd; ///< shared memory object descriptor
+			void* hMaster; ///< slave->master semaphore (sem_t*)
+			void* hSlave; ///< master->slave semaphore (sem_t*)
 		};
 #endif
 		struct {
@@ -148,17 +155,27 @@ typedef struct s_instance_pickle {
 	int16	name_size;
 	int16	prop_size;
 	int16	id;
+	int16	flags;
 	TIMESTAMP		ts;
 } INSTANCE_PICKLE;
 
+/** Binary linkages over a memory map or shared memory are read and written in place in the shared view */
+#define INSTANCE_DIRECT(I) (((I)->flags&MF_BINARY)==MF_BINARY && ((I)->cnxtype==CI_MMAP || (I)->cnxtype==CI_SHMEM))
+
 STATUS messagewrapper_init(MESSAGEWRAPPER **msgwpr,	MESSAGE *msg);
+#ifndef WIN32
+int instance_shmem_wait(void *sem, int32 timeout);
+void instance_shmem_unlink(instance *inst);
+#endif
 instance *instance_create(char *name);
 STATUS instance_init(instance *inst);
 STATUS instance_initall(void);
 void instance_master_done(TIMESTAMP t1);
+int instance_master_join(void);
 STATUS instance_slave_init(void);
 int instance_slave_wait(void);
 void instance_slave_done(void);
+void instance_slave_pause(void);
 TIMESTAMP instance_presync(instance *inst, TIMESTAMP t1);
 TIMESTAMP instance_sync(instance *inst, TIMESTAMP t1);
 TIMESTAMP instance_postsync(instance *inst, TIMESTAMP t1);
@@ -169,6 +186,7 @@ STATUS instance_dispose();
 int linkage_create_reader(instance *inst, char *fromobj, char *fromvar, char *toobj, char *tovar);
 int linkage_create_writer(instance *inst, char *fromobj, char *fromvar, char *toobj, char *tovar);
 STATUS linkage_init(instance *inst, linkage *lnk);
+STATUS linkage_init_binary(linkage *lnk);
 STATUS linkage_master_to_slave(char *buffer, linkage *lnk);
 STATUS linkage_slave_to_master(char *buffer, linkage *lnk);
 
@@ -95,7 +95,79 @@ STATUS instance_cnx_mmap(instance *inst){
 }
 
 STATUS instance_cnx_shmem(instance *inst){
+#ifndef WIN32
+		char cachename[1024];
+		char eventname[64];
+
+		if(inst == 0){
+			output_error("instance_cnx_shmem: no instance provided");
+			/*	TROUBLESHOOT
+				There was an internal error that was not caught prior to attempting to construct
+				the message-passing layer without an instance for context.
+				*/
+			return FAILED;
+		}
+
+		/* setup cache (named like the Windows memory map, the slave opens it by name) */
+		sprintf(cachename,"/GLD-%"FMT_INT64"x",inst->cacheid);
+		inst->fd = shm_open(cachename,O_RDWR|O_CREAT|O_EXCL,0600);
+		if ( inst->fd<0 )
+		{
+			output_error("unable to create cache '%s' for instance '%s' (%s)", cachename, inst->model, strerror(errno));
+			/* TROUBLESHOOT
+			   The shared memory object used to exchange data with a slave instance on this host could not be
+			   created.  If the error reports that the file exists, a cache left by a previous run that was
+			   killed is using the same id; remove it from /dev/shm and try again.
+			   */
+			return FAILED;
+		}
+		if ( ftruncate(inst->fd,(off_t)inst->cachesize)!=0 )
+		{
+			output_error("unable to size cache '%s' for instance '%s' (%s)", cachename, inst->model, strerror(errno));
+			shm_unlink(cachename);
+			return FAILED;
+		}
+		inst->buffer = (char *)mmap(NULL,inst->cachesize,PROT_READ|PROT_WRITE,MAP_SHARED,inst->fd,0);
+		if ( inst->buffer==MAP_FAILED )
+		{
+			output_error("unable to map view of cache '%s' for instance '%s' (%s)", cachename, inst->model, strerror(errno));
+			inst->buffer = NULL;
+			shm_unlink(cachename);
+			return FAILED;
+		}
+		output_debug("cache '%s' map view for model '%s' ok", cachename, inst->model);
+		output_verbose("slave %d assigned to '%s'", inst->id, inst->model);
+
+		/* copy existing message buffer to cache */
+		memcpy(inst->buffer, inst->cache, inst->cachesize);
+
+		/* setup master signalling semaphore */
+		sprintf(eventname,"/GLD-%"FMT_INT64"x-M", inst->cacheid);
+		inst->hMaster = (void*)sem_open(eventname,O_CREAT|O_EXCL,0600,0); /* initially unsignalled */
+		if ( inst->hMaster==(void*)SEM_FAILED )
+		{
+			output_error("unable to create event signal '%s' for slave %d (%s)", eventname, inst->id, strerror(errno));
+			inst->hMaster = NULL;
+			instance_shmem_unlink(inst);
+			return FAILED;
+		}
+
+		/* setup slave signalling semaphore */
+		sprintf(eventname,"/GLD-%"FMT_INT64"x-S", inst->cacheid);
+		inst->hSlave = (void*)sem_open(eventname,O_CREAT|O_EXCL,0600,0); /* initially unsignalled */
+		if ( inst->hSlave==(void*)SEM_FAILED )
+		{
+			output_error("unable to create event signal '%s' for slave %d (%s)", eventname, inst->id, strerror(errno));
+			inst->hSlave = NULL;
+			instance_shmem_unlink(inst);
+			return FAILED;
+		}
+		output_debug("created event signals for slave %d", inst->id);
+		return SUCCESS;
+#else
+	output_error("Shared memory (shmem) instance mode is not supported under Windows, please use Memory Map (mmap) instead.");
 	return FAILED;
+#endif
 }
 
 STATUS instance_cnx_socket(instance *inst){
@@ -390,6 +462,7 @@ STATUS instance_cnx_socket(instance *inst){
 	pickle.name_size = (int16)(inst->name_size);
 	pickle.prop_size = (int16)(inst->prop_size);
 	pickle.id = inst->id;
+	pickle.flags = inst->flags;
 	pickle.ts = global_clock;
 	output_debug("pickle: %"FMT_INT64"d %d %d %d %d %"FMT_INT64, pickle.cacheid, pickle.cachesize, pickle.name_size, pickle.prop_size, pickle.id, pickle.ts);
 	// send instance struct
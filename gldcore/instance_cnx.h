@@ -18,6 +18,12 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <semaphore.h>
+#include <errno.h>
+#include <string.h>
 #endif
 
 #include <pthread.h>
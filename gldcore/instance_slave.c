@@ -83,6 +83,7 @@ STATUS instance_slave_parse_prop_list(char *line, linkage **root, LINKAGETYPE ty
 	PROPERTY *prop = 0;
 	linkage *link = 0, *end = 0;
 	int tokenct = 0;
+	int ptype = 0;
 
 	if(line == 0){
 		output_error("instance_slave_parse_prop_list(): null line pointer");
@@ -97,8 +98,8 @@ STATUS instance_slave_parse_prop_list(char *line, linkage **root, LINKAGETYPE ty
 
 	token = strtok(line, ", \0\n\r");	// @todo should use strtok_r, will change later
 	while(token != 0){
-		tokenct = sscanf(token, "%[A-Za-z0-9_].%[A-Za-z0-9_]", objname, propname);
-		if(2 != tokenct){
+		tokenct = sscanf(token, "%[A-Za-z0-9_].%[A-Za-z0-9_]:%d", objname, propname, &ptype);
+		if(2 > tokenct || ((local_inst.flags&MF_BINARY)==MF_BINARY && 3 != tokenct)){
 			// @todo check for global properties instead
 			output_error("instance_slave_link_properties(): unable to parse '%s' (ct = %d)", token, tokenct);
 			return FAILED;
@@ -129,7 +130,22 @@ STATUS instance_slave_parse_prop_list(char *line, linkage **root, LINKAGETYPE ty
 		link->type = type;
 		link->next = 0;
 		
-		link->prop_size = property_minimum_buffersize(link->target.prop);
+		if((local_inst.flags&MF_BINARY)==MF_BINARY){
+			if(ptype != prop->ptype){
+				output_error("instance_slave_link_properties(): prop '%s' in object '%s' is a %s but the master linked a %s", propname, objname, class_get_property_typename(prop->ptype), class_get_property_typename((PROPERTYTYPE)ptype));
+				/* TROUBLESHOOT
+					Binary linkages copy raw property data so the master and slave properties
+					must have the same type.  Link properties of the same type or use text
+					linkages for this instance.
+				 */
+				return FAILED;
+			}
+			if(FAILED == linkage_init_binary(link)){
+				return FAILED;
+			}
+		} else {
+			link->prop_size = property_minimum_buffersize(link->target.prop);
+		}
 		link->name_size = strlen(token)+1; // +1 since there was a comma or space trimmed off
 		link->size = link->name_size + link->prop_size;
 
@@ -159,6 +175,7 @@ STATUS instance_slave_link_properties(){
 	linkage *link = 0;
 	size_t maxlen = 0;
 	size_t pickle_size = 0;
+	char *base = 0;
 
 	output_verbose("instance_slave_link_properties(): entered");
 	if(local_inst.message == 0){
@@ -222,18 +239,34 @@ STATUS instance_slave_link_properties(){
 		local_inst.message->data_size = (int16 *)&(local_inst.prop_size);
 		local_inst.message->data_buffer = (char *)malloc(local_inst.prop_size);
 	}
-	offset = 0;
+	// binary linkages over a memory map are exchanged in place in the shared view
+	if(INSTANCE_DIRECT(&local_inst)){
+		offset = local_inst.message->data_buffer - (char *)local_inst.cache;
+		base = (char *)local_inst.filemap;
+	} else {
+		offset = 0;
+		base = local_inst.message->data_buffer;
+	}
 	for(link = local_inst.write; link != 0; link = link->next){
-		link->addr = local_inst.message->data_buffer + offset;
+		link->addr = base + offset;
 		offset += link->prop_size;
 	}
 	for(link = local_inst.read; link != 0; link = link->next){
-		link->addr = local_inst.message->data_buffer + offset;
+		link->addr = base + offset;
 		offset += link->prop_size;
 	}
 	// compare pickles
 	if(0 != pickle_size){
 		if(pickle_size != local_inst.prop_size){
+			if((local_inst.flags&MF_BINARY)==MF_BINARY){
+				output_error("instance_slave_link_properties(): pickle prop_size and calculated prop_size do not match!");
+				/* TROUBLESHOOT
+					Binary linkages require the master and slave to agree on the size of every
+					linked value.  This usually means the master and slave were built for
+					different platforms.  Use text linkages for this instance.
+				 */
+				return FAILED;
+			}
 			output_warning("instance_slave_link_properties(): pickle prop_size and calculated prop_size do not match!");
 		}
 	}
@@ -269,7 +302,10 @@ int instance_slave_wait_mmap(){
 	}
 	ResetEvent(local_inst.hSlave);
 	// copy the data from the mmap to the cache
-	memcpy(local_inst.cache, local_inst.filemap, local_inst.cachesize);
+	if ( INSTANCE_DIRECT(&local_inst) ) /* linkages are read in place */
+		memcpy(local_inst.cache, local_inst.filemap, sizeof(MESSAGE));
+	else
+		memcpy(local_inst.cache, local_inst.filemap, local_inst.cachesize);
 	printcontent((char*)local_inst.cache, local_inst.cachesize);
 	output_verbose("wait_mmap: resumed with fmap ts = %lli", tc->ts);
 #else
@@ -279,8 +315,29 @@ int instance_slave_wait_mmap(){
 	
 	/* copy inbound linkages */
 //	output_verbose("instance_slave_wait_mmap(): slave %d controller reading links", slave_id);
-	memcpy(local_inst.cache, local_inst.filemap, local_inst.cachesize);
+	if ( INSTANCE_DIRECT(&local_inst) )
+		memcpy(local_inst.cache, local_inst.filemap, sizeof(MESSAGE));
+	else
+		memcpy(local_inst.cache, local_inst.filemap, local_inst.cachesize);
+
+	return status;
+}
+
+int instance_slave_wait_shmem(){
+	int status = 0;
+#ifndef WIN32
+	status = instance_shmem_wait(local_inst.hSlave,global_signal_timeout);
+	if ( status )
+		output_verbose("instance_slave_wait_shmem(): slave %d wait completed", slave_id);
+	else
+		output_error("instance_slave_wait_shmem(): slave %d wait %s", slave_id, errno==ETIMEDOUT?"timeout":strerror(errno));
 
+	/* copy inbound linkages */
+	if ( INSTANCE_DIRECT(&local_inst) ) /* linkages are read in place */
+		memcpy(local_inst.cache, local_inst.filemap, sizeof(MESSAGE));
+	else
+		memcpy(local_inst.cache, local_inst.filemap, local_inst.cachesize);
+#endif
 	return status;
 }
 
@@ -348,7 +405,7 @@ int instance_slave_wait(void)
 	} else if(local_inst.cnxtype == CI_SOCKET){
 		status = instance_slave_wait_socket();
 	} else if(local_inst.cnxtype == CI_SHMEM){
-		; // linux-specific
+		status = instance_slave_wait_shmem();
 	}
 	/* signal main loop to resume with new timestamp */
 	return status;
@@ -357,7 +414,10 @@ int instance_slave_wait(void)
 int instance_slave_done_mmap(){
 	// this works for MMAP, needs function with switches (or struct w/ func* )
 	output_verbose("instance_slave_done_mmap(): copying %d bytes from %x to %x", local_inst.cachesize, local_inst.cache, local_inst.filemap);
-	memcpy(local_inst.filemap, local_inst.cache, local_inst.cachesize);
+	if ( INSTANCE_DIRECT(&local_inst) ) /* linkages were written in place */
+		memcpy(local_inst.filemap, local_inst.cache, sizeof(MESSAGE));
+	else
+		memcpy(local_inst.filemap, local_inst.cache, local_inst.cachesize);
 //	printcontent(local_inst.filemap, (int)local_inst.cachesize);
 
 #ifdef WIN32
@@ -368,6 +428,18 @@ int instance_slave_done_mmap(){
 	return 0;
 }
 
+int instance_slave_done_shmem(){
+	if ( INSTANCE_DIRECT(&local_inst) ) /* linkages were written in place */
+		memcpy(local_inst.filemap, local_inst.cache, sizeof(MESSAGE));
+	else
+		memcpy(local_inst.filemap, local_inst.cache, local_inst.cachesize);
+#ifndef WIN32
+	if ( sem_post((sem_t*)local_inst.hMaster)!=0 )
+		return -1;
+#endif
+	return 0;
+}
+
 int instance_slave_done_socket(){
 	size_t offset = 0;
 	int rv = 0;
@@ -424,6 +496,7 @@ void instance_slave_done(void)
 			rv = instance_slave_done_mmap();
 			break;
 		case CI_SHMEM:
+			rv = instance_slave_done_shmem();
 			break;
 		case CI_SOCKET:
 			rv = instance_slave_done_socket();
@@ -439,6 +512,46 @@ void instance_slave_done(void)
 	}
 }
 
+/* turns taken by the slave main loop and the slave controller (guarded by mls_inst_lock) */
+typedef enum {
+	MLS_TURN_MAIN=0,		///< main loop is running a pass
+	MLS_TURN_CONTROLLER=1,	///< controller is exchanging with the master
+	MLS_TURN_STOPPED=2,		///< controller has exited, main loop runs on its own
+} MLSTURN;
+static MLSTURN mls_inst_turn = MLS_TURN_MAIN;
+
+/* give the turn to the other side and wait until it's given back (unless the controller has stopped) */
+static void instance_slave_turn(MLSTURN turn)
+{
+	pthread_mutex_lock(&mls_inst_lock);
+	if ( mls_inst_turn!=MLS_TURN_STOPPED )
+	{
+		mls_inst_turn = turn;
+		pthread_cond_broadcast(&mls_inst_signal);
+		while ( mls_inst_turn==turn )
+			pthread_cond_wait(&mls_inst_signal, &mls_inst_lock);
+	}
+	pthread_mutex_unlock(&mls_inst_lock);
+}
+
+/* controller stops exchanging with the master - main loop no longer pauses */
+static void instance_slave_stop(void)
+{
+	pthread_mutex_lock(&mls_inst_lock);
+	mls_inst_turn = MLS_TURN_STOPPED;
+	pthread_cond_broadcast(&mls_inst_signal);
+	pthread_mutex_unlock(&mls_inst_lock);
+}
+
+/** instance_slave_pause
+	Called by the slave main loop at the end of each pass: the controller sends the pass
+	results to the master and returns control when the master has posted the next time.
+ **/
+void instance_slave_pause(void)
+{
+	instance_slave_turn(MLS_TURN_CONTROLLER);
+}
+
 /** instance_slaveproc
     Create main slave control loop to maintain sync with master.
 	Anything that is dependant on objects being loaded happens here.
@@ -449,15 +562,17 @@ void *instance_slaveproc(void *ptr)
 	STATUS rv = SUCCESS;
 	output_verbose("instance_slaveproc(): slave %d controller startup in progress", slave_id);
 
+	/* wait for the main loop to be ready for its first time signal */
 	pthread_mutex_lock(&mls_inst_lock);
-	pthread_cond_wait(&mls_inst_signal, &mls_inst_lock);
+	while ( mls_inst_turn!=MLS_TURN_CONTROLLER )
+		pthread_cond_wait(&mls_inst_signal, &mls_inst_lock);
 	pthread_mutex_unlock(&mls_inst_lock);
 
 	rv = instance_slave_link_properties();
 
 	instance_slave_done(); // signals to master that this side's ready
 
-	do{
+	while ( rv == SUCCESS ) {
 		/* wait for master to signal slave */
 		output_verbose("instance_slaveproc(): slave %d controller waiting", slave_id);
 		if ( 0 == instance_slave_wait() )
@@ -465,7 +580,6 @@ void *instance_slaveproc(void *ptr)
 			/* stop the main loop and exit the slave controller */
 			output_error("instance_slaveproc(): slave %d controller wait failure, thread stopping", slave_id);
 			exec_setexitcode(XC_PRCERR);
-			pthread_cond_broadcast(&mls_inst_signal);
 			break;
 		}
 
@@ -478,29 +592,19 @@ void *instance_slaveproc(void *ptr)
 			}
 		}
 
-//		output_debug("continuing");
-		
-		/* resume the main loop */
+		/* the master's time is the slave's next time */
 		// note, if TS_NEVER, we want the slave's exec loop to end normally
-		//output_debug("slave %d controller resuming exec with %lli", slave_id, local_inst.cache->ts);
 		output_debug("slave %d controller resuming exec with %lli", local_inst.cache->id, local_inst.cache->ts);
-		output_debug("slave %d controller setting step_to %lli to cache->ts %lli", local_inst.cache->id, exec_sync_get(NULL), local_inst.cache->ts);
-		exec_sync_merge(NULL,(void*)&local_inst.cache);
-
-		pthread_cond_broadcast(&mls_inst_signal);
-
+		exec_sync_reset(NULL);
+		exec_sync_set(NULL,local_inst.cache->ts);
 		if(local_inst.cache->ts == TS_NEVER){
 			break;
 		}
 
-		/* wait for main loop to pause */
+		/* resume the main loop and wait for it to pause */
 		output_verbose("slave %d controller waiting for main to complete", slave_id);
+		instance_slave_turn(MLS_TURN_MAIN);
 
-		pthread_mutex_lock(&mls_inst_lock);
-		pthread_cond_wait(&mls_inst_signal, &mls_inst_lock);
-		pthread_mutex_unlock(&mls_inst_lock);
-
-		/* @todo copy output linkages */
 		output_debug("slave %d controller writing links", slave_id);
 		for ( lnk=local_inst.read ; lnk!=NULL ; lnk=lnk->next ){
 			if(FAILED == linkage_slave_to_master(0, lnk)){
@@ -509,15 +613,13 @@ void *instance_slaveproc(void *ptr)
 				break;
 			}
 		}
-//		output_debug("continuing");
 
-		/* copy the next time stamp */
-		/* how about we copy the time we want to step to and see what the master says, instead? -MH */
-		exec_sync_reset((void*)&local_inst.cache);
-		exec_sync_set((void*)&local_inst.cache,0);
+		/* the time the slave wants to step to goes back to the master */
+		local_inst.cache->ts = exec_sync_get(NULL);
 
 		instance_slave_done();
-	} while (global_clock != TS_NEVER && rv == SUCCESS);
+	}
+	instance_slave_stop();
 	output_verbose("slave %"FMT_INT64" completion state reached", local_inst.cacheid);
 	pthread_exit(NULL);
 	return NULL;
@@ -573,6 +675,7 @@ STATUS instance_slave_init_mem(){
 	local_inst.buffer = (char *)malloc(local_inst.cachesize);
 	local_inst.cache = (MESSAGE *)malloc(local_inst.cachesize);
 	local_inst.id = slave_id = tmsg.id;
+	local_inst.flags = tmsg.flags;
 
 	// THIS COPIES THE DATA
 	memcpy(local_inst.cache, local_inst.filemap, local_inst.cachesize);
@@ -580,7 +683,7 @@ STATUS instance_slave_init_mem(){
 	
 	local_inst.name_size = *(local_inst.message->name_size);
 	local_inst.prop_size = *(local_inst.message->data_size);
-	exec_sync_merge(NULL,(void*)&local_inst.cache);
+	exec_sync_set(NULL,local_inst.cache->ts);
 
 	/* open slave signalling event */
 	sprintf(eventName,"GLD-%"FMT_INT64"x-S", global_master_port);
@@ -609,7 +712,69 @@ STATUS instance_slave_init_mem(){
 	}
 	return SUCCESS;
 #else
-	// @todo linux/unix slave signalling
+	MESSAGE tmsg;
+	char eventName[256];
+	char cacheName[256];
+	struct stat info;
+
+	output_debug("instance_slave_init_mem()");
+	local_inst.cacheid = global_master_port;
+	sprintf(cacheName,"/GLD-%"FMT_INT64"x",global_master_port);
+	local_inst.fd = shm_open(cacheName,O_RDWR,0);
+	if ( local_inst.fd<0 || fstat(local_inst.fd,&info)!=0 || info.st_size<(off_t)sizeof(MESSAGE) )
+	{
+		output_error("unable to open cache '%s' for slave (%s)", cacheName, strerror(errno));
+		return FAILED;
+	}
+	local_inst.filemap = (char*)mmap(NULL,(size_t)info.st_size,PROT_READ|PROT_WRITE,MAP_SHARED,local_inst.fd,0);
+	if ( local_inst.filemap==MAP_FAILED )
+	{
+		output_error("unable to map view of cache '%s' for slave (%s)", cacheName, strerror(errno));
+		return FAILED;
+	}
+	output_debug("cache '%s' opened for slave", cacheName);
+
+	memcpy(&tmsg, local_inst.filemap, sizeof(MESSAGE));
+	if(tmsg.name_size < 0 || tmsg.data_size < 0 || tmsg.asize > (size_t)info.st_size){
+		output_error("cache '%s' does not hold a valid instance message", cacheName);
+		return FAILED;
+	}
+
+	// initialize buffer/cache
+	local_inst.buffer_size = local_inst.cachesize = tmsg.asize;
+	local_inst.buffer = (char *)malloc(local_inst.cachesize);
+	local_inst.cache = (MESSAGE *)malloc(local_inst.cachesize);
+	if ( local_inst.buffer==NULL || local_inst.cache==NULL )
+	{
+		output_error("instance_slave_init_mem(): malloc failure");
+		return FAILED;
+	}
+	local_inst.id = slave_id = tmsg.id;
+	local_inst.flags = tmsg.flags;
+	memcpy(local_inst.cache, local_inst.filemap, local_inst.cachesize);
+	messagewrapper_init(&(local_inst.message), local_inst.cache);
+
+	local_inst.name_size = *(local_inst.message->name_size);
+	local_inst.prop_size = *(local_inst.message->data_size);
+	exec_sync_set(NULL,local_inst.cache->ts);
+
+	/* open slave and master signalling semaphores */
+	sprintf(eventName,"/GLD-%"FMT_INT64"x-S", global_master_port);
+	local_inst.hSlave = (void*)sem_open(eventName,0);
+	if ( local_inst.hSlave==(void*)SEM_FAILED )
+	{
+		output_error("unable to open event signal '%s' for slave %d (%s)", eventName, slave_id, strerror(errno));
+		return FAILED;
+	}
+	sprintf(eventName,"/GLD-%"FMT_INT64"x-M", global_master_port);
+	local_inst.hMaster = (void*)sem_open(eventName,0);
+	if ( local_inst.hMaster==(void*)SEM_FAILED )
+	{
+		output_error("unable to open event signal '%s' for slave %d (%s)", eventName, slave_id, strerror(errno));
+		return FAILED;
+	}
+	output_debug("opened event signals for slave %d", slave_id);
+	return SUCCESS;
 #endif
 }
 
@@ -713,6 +878,7 @@ STATUS instance_slave_init_socket(){
 	local_inst.name_size = pickle.name_size;
 	local_inst.prop_size = pickle.prop_size;
 	local_inst.id = slave_id = pickle.id;
+	local_inst.flags = pickle.flags;
 	local_inst.buffer = (char *)malloc(local_inst.cachesize);
 	local_inst.cache = (MESSAGE *)malloc(local_inst.cachesize);
 	memset(local_inst.buffer, 0, local_inst.cachesize);
@@ -720,8 +886,8 @@ STATUS instance_slave_init_socket(){
 	local_inst.cache->name_size = (int16)local_inst.name_size;
 	local_inst.cache->data_size = (int16)local_inst.prop_size;
 	local_inst.cache->id = local_inst.id;
-	exec_sync_set((void*)&local_inst.cache,pickle.ts);
-	exec_sync_merge(NULL,(void*)&local_inst.cache);
+	local_inst.cache->flags = local_inst.flags;
+	exec_sync_set(NULL,pickle.ts);
 	if(0 == local_inst.buffer){
 		output_error("malloc() error with li.buffer");
 		return FAILED;
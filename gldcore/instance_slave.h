@@ -11,7 +11,14 @@
 #define _WIN32_WINNT 0x0400
 #include <winsock2.h>
 #include <windows.h>
-
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <semaphore.h>
+#include <errno.h>
+#include <string.h>
 #endif
 
 
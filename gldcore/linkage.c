@@ -5,6 +5,7 @@
 #include "output.h"
 #include "object.h"
 #include "property.h"
+#include "class.h"
 
 /** linkage_create_writer
     Add a master->slave linkage to an instance object.
@@ -80,6 +81,104 @@ int linkage_create_reader(instance *inst, char *fromobj, char *fromvar, char *to
 	}
 }
 
+/** linkage_binary_type
+	Checks whether a property's value can be exchanged as raw data, i.e., it is
+	fixed size and contains no pointers.
+	@returns 1 if raw exchange is possible, 0 if not
+ **/
+static int linkage_binary_type(PROPERTYTYPE ptype)
+{
+	switch ( ptype ) {
+	case PT_double:
+	case PT_complex:
+	case PT_enumeration:
+	case PT_set:
+	case PT_int16:
+	case PT_int32:
+	case PT_int64:
+	case PT_char8:
+	case PT_char32:
+	case PT_char256:
+	case PT_char1024:
+	case PT_bool:
+	case PT_timestamp:
+	case PT_float:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/** linkage_init_binary
+	Size a linkage for raw data exchange.  The linkage buffer holds a
+	change flag followed by the property value.
+	@returns SUCCESS or FAILED
+ **/
+STATUS linkage_init_binary(linkage *lnk)
+{
+	PROPERTY *prop = lnk->target.prop;
+	if ( !linkage_binary_type(prop->ptype) )
+	{
+		output_error("linkage %s:%s type %s cannot be exchanged in binary", lnk->local.obj, lnk->local.prop, class_get_property_typename(prop->ptype));
+		/* TROUBLESHOOT
+			Binary linkages copy the property value as raw data, which is only possible
+			for fixed size values that do not refer to memory in the instance.  Use
+			text linkages for this instance or link a different property.
+		 */
+		return FAILED;
+	}
+	lnk->binary = 1;
+	lnk->primed = 0;
+	lnk->value_size = property_size(prop);
+	lnk->prop_size = lnk->value_size + 1;
+	return SUCCESS;
+}
+
+/* copy the property value into the linkage buffer, flagging it only when it changed */
+static STATUS linkage_write_binary(linkage *lnk)
+{
+	char *value = (char*)GETADDR(lnk->target.obj,lnk->target.prop);
+	if ( !lnk->primed || memcmp(lnk->addr+1,value,lnk->value_size)!=0 )
+	{
+		memcpy(lnk->addr+1,value,lnk->value_size);
+		lnk->addr[0] = 1;
+		lnk->primed = 1;
+	}
+	else
+		lnk->addr[0] = 0;
+	return SUCCESS;
+}
+
+/* copy a changed value from the linkage buffer into the property */
+static STATUS linkage_read_binary(linkage *lnk)
+{
+	OBJECT *obj = lnk->target.obj;
+	PROPERTY *prop = lnk->target.prop;
+	if ( lnk->addr[0]==0 )
+		return SUCCESS;
+
+	/* notifiers expect the value as a string */
+	if ( obj->oclass->notify || prop->notify )
+	{
+		double value[1032/sizeof(double)]; /* aligned copy of the largest raw value */
+		char buffer[1025];
+		memcpy(value,lnk->addr+1,lnk->value_size);
+		if ( class_property_to_string(prop,value,buffer,sizeof(buffer))<=0 
+			|| object_set_value_by_addr(obj,GETADDR(obj,prop),buffer,prop)==0 )
+			return FAILED;
+		return SUCCESS;
+	}
+	if ( prop->access!=PA_PUBLIC )
+	{
+		output_error("trying to set the value of non-public property %s in %s", prop->name, obj->oclass->name);
+		return FAILED;
+	}
+	if ( prop->flags&PF_RECALC ) 
+		obj->flags |= OF_RECALC;
+	memcpy(GETADDR(obj,prop),lnk->addr+1,lnk->value_size);
+	return SUCCESS;
+}
+
 /** linkage_master_to_slave
     Updates the instance cache for a master->slave linkage.
 	@returns 1 on success, 0 on failure
@@ -100,6 +199,22 @@ STATUS linkage_master_to_slave(char *buffer, linkage *lnk)
 		output_error("linkage_master_to_slave has null lnk->target.obj pointer");
 		return FAILED;
 	}
+	if ( lnk->binary )
+	{
+		switch ( global_multirun_mode ) {
+		case MRM_MASTER:
+			return linkage_write_binary(lnk);
+		case MRM_SLAVE:
+			if ( linkage_read_binary(lnk)==FAILED )
+			{
+				output_error("linkage_master_to_slave failed for link %s.%s", lnk->target.obj->name, lnk->target.prop->name);
+				return FAILED;
+			}
+			return SUCCESS;
+		default:
+			return SUCCESS;
+		}
+	}
 	size = (int)property_minimum_buffersize(lnk->target.prop);
 	switch ( global_multirun_mode ) {
 		case MRM_MASTER:
@@ -141,6 +256,22 @@ STATUS linkage_slave_to_master(char *buffer, linkage *lnk)
 		output_error("linkage_master_to_slave has null lnk->target.obj pointer");
 		return FAILED;
 	}
+	if ( lnk->binary )
+	{
+		switch ( global_multirun_mode ) {
+		case MRM_MASTER:
+			if ( linkage_read_binary(lnk)==FAILED )
+			{
+				output_error("linkage_slave_to_master failed for link %s.%s", lnk->target.obj->name, lnk->target.prop->name);
+				return FAILED;
+			}
+			return SUCCESS;
+		case MRM_SLAVE:
+			return linkage_write_binary(lnk);
+		default:
+			return SUCCESS;
+		}
+	}
 
 	switch ( global_multirun_mode ) {
 	case MRM_MASTER:
@@ -189,6 +320,14 @@ STATUS linkage_init(instance *inst, linkage *lnk)
 	/* calculate buffer size */
 	lnk->prop_size = property_minimum_buffersize(lnk->target.prop);
 	lnk->name_size = strlen(lnk->remote.obj) + strlen(lnk->remote.prop) + 2;
+	if ( (inst->flags&MF_BINARY)==MF_BINARY )
+	{
+		/* binary linkage names carry the property type so the slave can check it */
+		char ptype[16];
+		if ( linkage_init_binary(lnk)==FAILED )
+			return FAILED;
+		lnk->name_size += sprintf(ptype,":%d",lnk->target.prop->ptype);
+	}
 	lnk->size = lnk->name_size + lnk->prop_size;
 
 	output_verbose("initialized linkage between local %s:%s and remote %s:%s", lnk->local.obj, lnk->local.prop, lnk->remote.obj, lnk->remote.prop);
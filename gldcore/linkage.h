@@ -28,6 +28,9 @@ typedef struct s_linkage {
 	size_t size;	 ///< buffer size in MESSAGE
 	size_t name_size;
 	size_t prop_size;
+	int binary; ///< raw property data is exchanged
+	int primed; ///< raw property data has been written at least once
+	size_t value_size; ///< size of the raw property data
 	struct s_linkage *next; ///<
 } linkage; ///<
 
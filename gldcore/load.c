@@ -4911,6 +4911,11 @@ static int linkage_term(PARSER,instance *inst)
 		ACCEPT;
 		DONE;
 	}
+	OR if ( LITERAL("linkage") && WHITE && TERM(value(HERE,inst->linkagestr,sizeof(inst->linkagestr))) && WHITE, LITERAL(";"))
+	{
+		ACCEPT;
+		DONE;
+	}
 	OR if ( LITERAL("execdir") && WHITE && TERM(value(HERE,inst->execdir,sizeof(inst->execdir))) && WHITE, LITERAL(";"))
 	{
 		ACCEPT;
@@ -865,12 +865,159 @@ TIMESTAMP loadshape_sync(loadshape *ls, TIMESTAMP t1)
 	return ls->t2>0?ls->t2:TS_NEVER;
 }
 
+/* Loadshapes of the same type and schedule are synchronized together in batches.
+   Each shape is only synchronized when its next event is due, except scheduled shapes
+   that are ramping and queued shapes, which are updated at every pass.  Queued shapes
+   draw a new arrival rate whenever they are synchronized while off, so they keep the
+   cadence of the unbatched loop to give the same random draws. */
+typedef struct s_loadshapebatch {
+	MACHINETYPE type;	/**< type of the shapes in the batch */
+	SCHEDULE *schedule;	/**< schedule driving the shapes in the batch */
+	loadshape **shape;	/**< the shapes in the batch */
+	TIMESTAMP *t2;		/**< time of the next event of each shape */
+	unsigned int n;		/**< number of shapes in the batch */
+	TIMESTAMP due;		/**< earliest time at which a shape must be synchronized */
+	TIMESTAMP next;		/**< earliest next event of the shapes */
+} LOADSHAPEBATCH;
+
+static LOADSHAPEBATCH *batch_list = NULL;
+static unsigned int n_batches = 0;
+
+/* time at which a shape must be synchronized again given the time of its next event */
+static TIMESTAMP loadshape_due(loadshape *ls, TIMESTAMP t2)
+{
+	return ((ls->type==MT_SCHEDULED && ls->r!=0) || ls->type==MT_QUEUED) ? TS_ZERO : t2;
+}
+
+typedef struct s_loadshapesort {
+	loadshape *ls;
+	unsigned int id;
+} LOADSHAPESORT;
+
+/* order shapes by type, then schedule, then order of creation */
+static int loadshape_compare(const void *a, const void *b)
+{
+	const LOADSHAPESORT *p = (const LOADSHAPESORT*)a, *q = (const LOADSHAPESORT*)b;
+	int c;
+	if ( p->ls->type!=q->ls->type )
+		return p->ls->type<q->ls->type ? -1 : 1;
+	if ( p->ls->schedule!=q->ls->schedule )
+	{
+		if ( p->ls->schedule==NULL ) return -1;
+		if ( q->ls->schedule==NULL ) return 1;
+		c = strcmp(p->ls->schedule->name,q->ls->schedule->name);
+		if ( c!=0 ) return c;
+		return p->ls->schedule<q->ls->schedule ? -1 : 1;
+	}
+	return p->id<q->id ? -1 : (p->id>q->id ? 1 : 0);
+}
+
+/* group the shapes into batches of at most max_size shapes */
+static int loadshape_batches(unsigned int max_size)
+{
+	loadshape **shape_array = (loadshape**)malloc(sizeof(loadshape*)*n_shapes);
+	TIMESTAMP *t2_array = (TIMESTAMP*)malloc(sizeof(TIMESTAMP)*n_shapes);
+	LOADSHAPESORT *sort = (LOADSHAPESORT*)malloc(sizeof(LOADSHAPESORT)*n_shapes);
+	loadshape *ls;
+	unsigned int n;
+
+	batch_list = (LOADSHAPEBATCH*)malloc(sizeof(LOADSHAPEBATCH)*n_shapes);
+	if ( shape_array==NULL || t2_array==NULL || sort==NULL || batch_list==NULL )
+	{
+		output_error("loadshape_syncall(): unable to allocate memory for %d loadshape batches", n_shapes);
+		/* TROUBLESHOOT
+			The system ran out of memory while grouping the loadshapes into batches.
+			Try freeing up system memory and try again.
+		 */
+		return 0;
+	}
+
+	/* the list is in reverse order of creation */
+	for ( ls=loadshape_list, n=n_shapes ; ls!=NULL ; ls=ls->next )
+	{
+		n--;
+		sort[n].ls = ls;
+		sort[n].id = n;
+	}
+	qsort(sort,n_shapes,sizeof(LOADSHAPESORT),loadshape_compare);
+
+	n_batches = 0;
+	for ( n=0 ; n<n_shapes ; n++ )
+	{
+		LOADSHAPEBATCH *b = n_batches>0 ? batch_list+n_batches-1 : NULL;
+		ls = sort[n].ls;
+		shape_array[n] = ls;
+		t2_array[n] = TS_ZERO; /* all shapes are synchronized on the first pass */
+		if ( b==NULL || b->type!=ls->type || b->schedule!=ls->schedule || b->n==max_size )
+		{
+			b = batch_list + n_batches++;
+			b->type = ls->type;
+			b->schedule = ls->schedule;
+			b->shape = shape_array+n;
+			b->t2 = t2_array+n;
+			b->n = 0;
+			b->due = TS_ZERO;
+			b->next = TS_NEVER;
+		}
+		b->n++;
+	}
+	free(sort);
+	output_debug("loadshape_syncall grouped %d shapes into %d batches", n_shapes, n_batches);
+	return 1;
+}
+
+/* synchronize the shapes of a batch that are due */
+static TIMESTAMP loadshape_syncbatch(LOADSHAPEBATCH *b, TIMESTAMP t1)
+{
+	TIMESTAMP due = TS_NEVER, next = TS_NEVER;
+	unsigned int n;
+
+	/* no event in the batch yet */
+	if ( b->due>t1 )
+		return b->next;
+
+	/* analog shapes only follow their common schedule, so the schedule is read once for the batch */
+	if ( b->type==MT_ANALOG && b->schedule!=NULL && b->schedule->duration>0 )
+	{
+		TIMESTAMP next_t = b->schedule->next_t;
+		for ( n=0 ; n<b->n ; n++ )
+		{
+			loadshape *ls = b->shape[n];
+			if ( t1>ls->t0 )
+			{
+				sync_analog(ls,0);
+				ls->t2 = next_t;
+			}
+			ls->t0 = t1;
+			b->t2[n] = ls->t2>0 ? ls->t2 : TS_NEVER;
+			if ( b->t2[n]<next ) next = b->t2[n];
+		}
+		due = next;
+	}
+	else
+	{
+		for ( n=0 ; n<b->n ; n++ )
+		{
+			loadshape *ls = b->shape[n];
+			TIMESTAMP t;
+			if ( loadshape_due(ls,b->t2[n])<=t1 )
+				b->t2[n] = loadshape_sync(ls,t1);
+			t = loadshape_due(ls,b->t2[n]);
+			if ( t<due ) due = t;
+			if ( b->t2[n]<next ) next = b->t2[n];
+		}
+	}
+	b->due = due;
+	b->next = next;
+	return next;
+}
+
 typedef struct s_loadshapesyncdata {
 	unsigned int n;
 	pthread_t pt;
 	bool ok;
-	loadshape *ls;
-	unsigned int ns;
+	LOADSHAPEBATCH *batch;
+	unsigned int nb;
 	TIMESTAMP t0;
 	unsigned int ran;
 } LOADSHAPESYNCDATA;
@@ -888,7 +1035,6 @@ clock_t loadshape_synctime = 0;
 void *loadshape_syncproc(void *ptr)
 {
 	LOADSHAPESYNCDATA *data = (LOADSHAPESYNCDATA*)ptr;
-	loadshape *s;
 	unsigned int n;
 	TIMESTAMP t2;
 
@@ -905,11 +1051,11 @@ void *loadshape_syncproc(void *ptr)
 		// unlock access to start count
 		pthread_mutex_unlock(&startlock_ls);
 
-		// process the list for this thread
+		// process the batches for this thread
 		t2 = TS_NEVER;
-		for ( s=data->ls, n=0 ; s!=NULL, n<data->ns ; s=s->next, n++ )
+		for ( n=0 ; n<data->nb ; n++ )
 		{
-			TIMESTAMP t = loadshape_sync(s,next_t1_ls);
+			TIMESTAMP t = loadshape_syncbatch(data->batch+n,next_t1_ls);
 			if (t<t2) t2 = t;
 		}
 
@@ -948,8 +1094,7 @@ TIMESTAMP loadshape_syncall(TIMESTAMP t1)
 	// number of threads desired
 	if (n_threads_ls==0) 
 	{
-		loadshape *s;
-		int n_items, ln=0;
+		unsigned int n_items = n_shapes, ln=0;
 
 		output_debug("loadshape_syncall setting up for %d shapes", n_shapes);
 
@@ -957,7 +1102,6 @@ TIMESTAMP loadshape_syncall(TIMESTAMP t1)
 		n_threads_ls = global_threadcount;
 		if (n_threads_ls>1)
 		{
-			unsigned int n;
 			if (n_shapes<n_threads_ls*4)
 				n_threads_ls = n_shapes/4;
 
@@ -967,26 +1111,39 @@ TIMESTAMP loadshape_syncall(TIMESTAMP t1)
 
 			// determine shapes per thread
 			n_items = n_shapes/n_threads_ls;
-			n_threads_ls = n_shapes/n_items;
 			if (n_threads_ls*n_items<n_shapes) // not enough slots yet
-				n_threads_ls++; // add one underused threads
+				n_items++;
+		}
 
-			output_debug("loadshape_syncall is using %d of %d available threads", n_threads_ls, global_threadcount);
-			output_debug("loadshape_syncall is assigning %d shapes per thread", n_items);
+		// group the shapes so that no batch spans more than one thread
+		if ( !loadshape_batches(n_items) )
+			throw_exception("loadshape_syncall(): unable to setup loadshape batches");
+
+		if (n_threads_ls>1)
+		{
+			unsigned int n, ns=0;
 
 			// allocate thread list
-			thread_ls = (LOADSHAPESYNCDATA*)malloc(sizeof(LOADSHAPESYNCDATA)*n_threads_ls);
-			memset(thread_ls,0,sizeof(LOADSHAPESYNCDATA)*n_threads_ls);
+			thread_ls = (LOADSHAPESYNCDATA*)malloc(sizeof(LOADSHAPESYNCDATA)*n_batches);
+			memset(thread_ls,0,sizeof(LOADSHAPESYNCDATA)*n_batches);
 
-			// assign starting shape for each thread
-			for (s=loadshape_list; s!=NULL; s=s->next)
+			// assign consecutive batches to each thread
+			for (n=0; n<n_batches; n++)
 			{
-				if (thread_ls[ln].ns==n_items)
+				if (thread_ls[ln].nb>0 && ns+batch_list[n].n>n_items)
+				{
 					ln++;
-				if (thread_ls[ln].ns==0)
-					thread_ls[ln].ls = s;
-				thread_ls[ln].ns++;
+					ns = 0;
+				}
+				if (thread_ls[ln].nb==0)
+					thread_ls[ln].batch = batch_list+n;
+				thread_ls[ln].nb++;
+				ns += batch_list[n].n;
 			}
+			n_threads_ls = ln+1;
+
+			output_debug("loadshape_syncall is using %d of %d available threads", n_threads_ls, global_threadcount);
+			output_debug("loadshape_syncall is assigning up to %d shapes per thread", n_items);
 
 			// create threads
 			for (n=0; n<n_threads_ls; n++)
@@ -1010,11 +1167,11 @@ TIMESTAMP loadshape_syncall(TIMESTAMP t1)
 	// no threading required
 	if (n_threads_ls<2) 
 	{
-		// process list directly
-		loadshape *s;
-		for (s=loadshape_list; s!=NULL; s=s->next)
+		// process batches directly
+		unsigned int n;
+		for (n=0; n<n_batches; n++)
 		{
-			TIMESTAMP t3 = loadshape_sync(s,t1);
+			TIMESTAMP t3 = loadshape_syncbatch(batch_list+n,t1);
 			if (t3<t2) t2 = t3;
 		}
 		next_t2_ls = t2;
@@ -8,12 +8,29 @@
 	Any time more than one object can concurrently write to the same
 	region of memory, it is necessary to implement locking to prevent
 	one object from overwriting the changes made by another.  
+
+	By default a thread that finds a lock taken spins until it is released.
+	When \p lock_options includes \p ADAPTIVE, the thread spins for \p lock_spin
+	tries, then yields its processor for a while, and finally parks until the
+	lock is released (on Linux the thread sleeps on a futex, elsewhere it sleeps
+	for a short time).  When \p lock_options includes \p SHAREDREAD, read locks are shared
+	by the readers and a write lock waits for the readers to finish.
+
+	When the profiler is enabled, the waits are counted by lock and the locks
+	with the longest waits are reported with the profile, by object and class.
  @{	  
  **/
 
 #include "lock.h"
 #include "exception.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "globals.h"
+#include "output.h"
+#include "object.h"
 
 //#define LOCKTRACE // enable this to trace locking events back to variables
 #define MAXSPIN 1000000000
@@ -34,33 +51,62 @@
 #if defined(__APPLE__)
 	#include <libkern/OSAtomic.h>
 	#define atomic_compare_and_swap(dest, comp, xchg) OSAtomicCompareAndSwap32Barrier(comp, xchg, (volatile int32_t *) dest)
-	#define atomic_increment(ptr) OSAtomicIncrement32Barrier((volatile int32_t *) ptr)
+	#define atomic_add(ptr, n) OSAtomicAdd32Barrier((int32_t)(n), (volatile int32_t *) ptr)
+	#define atomic_add64(ptr, n) OSAtomicAdd64Barrier((int64_t)(n), (volatile int64_t *) ptr)
 #elif defined(WIN32) && !defined __MINGW32__
+	#include <windows.h>
 	#include <intrin.h>
 	#pragma intrinsic(_InterlockedCompareExchange)
-	#pragma intrinsic(_InterlockedIncrement)
+	#pragma intrinsic(_InterlockedExchangeAdd)
 	#define atomic_compare_and_swap(dest, comp, xchg) (_InterlockedCompareExchange((volatile long *) dest, xchg, comp) == comp)
-	#define atomic_increment(ptr) _InterlockedIncrement((volatile long *) ptr)
+	#define atomic_add(ptr, n) _InterlockedExchangeAdd((volatile long *) ptr, (long)(n))
+	#define atomic_add64(ptr, n) InterlockedExchangeAdd64((volatile LONGLONG *) ptr, (LONGLONG)(n))
 	#ifndef inline
 		#define inline __inline
 	#endif
 #elif defined HAVE___SYNC_BOOL_COMPARE_AND_SWAP
 	#define atomic_compare_and_swap __sync_bool_compare_and_swap
 	#ifdef HAVE___SYNC_ADD_AND_FETCH
-		#define atomic_increment(ptr) __sync_add_and_fetch((volatile long *)ptr, 1)
+		#define atomic_add(ptr, n) __sync_add_and_fetch((volatile unsigned int *)(ptr), (unsigned int)(n))
+		#define atomic_add64(ptr, n) __sync_add_and_fetch((volatile int64 *)(ptr), (int64)(n))
 	#else
-		static inline unsigned int atomic_increment(unsigned int *ptr)
+		static inline unsigned int atomic_add32(volatile unsigned int *ptr, unsigned int n)
 		{
 			unsigned int value;
 			do {
-				value = *(volatile long *)ptr;
-			} while (!__sync_bool_compare_and_swap((volatile long*)ptr, value, value + 1));
-			return value;
+				value = *ptr;
+			} while (!__sync_bool_compare_and_swap(ptr, value, value + n));
+			return value + n;
+		}
+		static inline int64 atomic_add64_cas(volatile int64 *ptr, int64 n)
+		{
+			int64 value;
+			do {
+				value = *ptr;
+			} while (!__sync_bool_compare_and_swap(ptr, value, value + n));
+			return value + n;
 		}
+		#define atomic_add(ptr, n) atomic_add32((volatile unsigned int *)(ptr), (unsigned int)(n))
+		#define atomic_add64(ptr, n) atomic_add64_cas((volatile int64 *)(ptr), (int64)(n))
 	#endif
 #else
 	#error "Locking is not supported on this system"
 #endif
+#define atomic_increment(ptr) atomic_add(ptr, 1)
+
+/* processor hint while spinning and processor yield */
+#if defined(WIN32) && !defined __MINGW32__
+	#define lock_pause() YieldProcessor()
+	#define lock_yield() SwitchToThread()
+#else
+	#include <sched.h>
+	#if defined(__i386__) || defined(__x86_64__)
+		#define lock_pause() __asm__ __volatile__("pause")
+	#else
+		#define lock_pause()
+	#endif
+	#define lock_yield() sched_yield()
+#endif
 
 /** Enable lock trace 
  **/
@@ -148,54 +194,432 @@ void register_lock(unsigned int *lock)
    (2) an atomic compare-and-swap (CAS) operation is performed to take the lock by setting the low bit to 1
    (3) if the CAS operation fails, the lock process starts over at (1)
    (4) to unlock the lock value is incremented (which clears the low bit and increments the lock count).
+   The low 24 bits of the lock value are the lock count, so it changes every time the lock is taken
+   and released (the timestamp cache relies on this).  The high 8 bits count the shared readers,
+   which are only used when the SHAREDREAD lock option is set:
+   (5) a shared read lock is taken by incrementing the reader count when the low bit is 0
+   (6) a write lock is taken as in (1)-(3), and then waits until the reader count is 0
+   (7) to unlock a shared read lock the reader count is decremented.
+   A read lock is released according to how it was taken, so the lock options may be changed at any time.
  */
+#define LOCK_VERSION 0x00ffffff /* lock count (the low bit is set while the lock is taken) */
+#define LOCK_READER 0x01000000 /* one shared reader */
+#define LOCK_READERS 0xff000000 /* shared reader count */
+
+#define LOCK_YIELDS 100 /* number of yields before a waiting thread parks */
+#define LOCK_PARKTIME 1000000 /* longest time (ns) a thread parks before checking the lock again */
+#define LOCK_MAXPARK 60000 /* number of parks before a lock times out */
+#define LOCK_BUCKETS 256 /* number of parked thread counters */
+#define LOCK_SITES 4096 /* number of locks for which waits are counted */
+#define LOCK_PROBES 64 /* number of entries searched for a lock */
+#define LOCK_HISTOGRAM 8 /* number of wait time bins (<1us, then x4 per bin) */
+#define LOCK_TOPSITES 10 /* number of locks reported by the profiler */
+
+#define LOCK_HASH(X) (((unsigned int)((size_t)(X)>>2)*2654435761u)>>12)
+
+extern "C" int64 rlock_count, rlock_spin, wlock_count, wlock_spin;
+
+/* number of threads parked on the locks in each bucket */
+static volatile unsigned int parked[LOCK_BUCKETS];
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <time.h>
+/* sleep until the lock is released, if the lock value is still the one seen */
+static inline void lock_park(unsigned int *lock, unsigned int value)
+{
+	struct timespec timeout = {0,LOCK_PARKTIME};
+	syscall(SYS_futex,lock,FUTEX_WAIT_PRIVATE,value,&timeout,NULL,0);
+}
+/* wake the threads parked on a lock */
+static inline void lock_wake(unsigned int *lock)
+{
+	syscall(SYS_futex,lock,FUTEX_WAKE_PRIVATE,INT_MAX,NULL,NULL,0);
+}
+#elif defined(WIN32) && !defined __MINGW32__
+#define lock_park(L,V) Sleep(LOCK_PARKTIME/1000000)
+#define lock_wake(L)
+#else
+#include <unistd.h>
+#define lock_park(L,V) usleep(LOCK_PARKTIME/1000)
+#define lock_wake(L)
+#endif
+
+/* monotonic clock (ns) used to time the waits */
+#if defined(WIN32) && !defined __MINGW32__
+static int64 lock_clock(void)
+{
+	static LARGE_INTEGER freq = {0};
+	LARGE_INTEGER now;
+	if ( freq.QuadPart==0 )
+		QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&now);
+	return (int64)(now.QuadPart*(1e9/freq.QuadPart));
+}
+#else
+#include <time.h>
+static int64 lock_clock(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC,&now);
+	return (int64)now.tv_sec*1000000000 + now.tv_nsec;
+}
+#endif
+
+/** Waits of a lock
+ **/
+typedef struct s_locksite {
+	unsigned int *lock; /**< the lock (NULL if the entry is not used) */
+	int64 waits; /**< number of times the lock was taken after waiting */
+	int64 spins; /**< number of spins while waiting */
+	int64 yields; /**< number of yields while waiting */
+	int64 parks; /**< number of parks while waiting */
+	int64 wait_time; /**< total time waited (ns) */
+	int64 histogram[LOCK_HISTOGRAM]; /**< number of waits by wait time */
+} LOCKSITE;
+static LOCKSITE locksite[LOCK_SITES+1]; /* the last entry counts the waits of locks that do not fit */
+static unsigned int locksite_lock = 0;
+
+/* a wait for a lock in progress */
+typedef struct s_lockwait {
+	unsigned int spins, yields, parks;
+	int64 started;
+} LOCKWAIT;
+
+/* find the waits of a lock, adding the lock if it is not found */
+static LOCKSITE *lock_site(unsigned int *lock)
+{
+	unsigned int hash = LOCK_HASH(lock);
+	unsigned int n;
+	for ( n=0 ; n<LOCK_PROBES ; n++ )
+	{
+		LOCKSITE *site = &locksite[(hash+n)&(LOCK_SITES-1)];
+		unsigned int *used = *(unsigned int *volatile*)&site->lock;
+		if ( used==NULL )
+		{
+			while ( !atomic_compare_and_swap(&locksite_lock,0,1) )
+				lock_pause();
+			if ( site->lock==NULL )
+				site->lock = lock;
+			used = site->lock;
+			atomic_add(&locksite_lock,-1);
+		}
+		if ( used==lock )
+			return site;
+	}
+	return &locksite[LOCK_SITES];
+}
+
+/* wait once for a lock that was taken when its value was read */
+static void lock_wait(unsigned int *lock, unsigned int value, LOCKWAIT *wait, bool write)
+{
+	if ( global_profiler && wait->started==0 )
+		wait->started = lock_clock();
+	if ( !(global_lock_options&LO_ADAPTIVE) || wait->spins<(unsigned int)global_lock_spin )
+	{
+		if ( wait->spins++==MAXSPIN )
+			throw_exception("%s lock timeout", write?"write":"read");
+		lock_pause();
+	}
+	else if ( wait->yields<LOCK_YIELDS )
+	{
+		wait->yields++;
+		lock_yield();
+	}
+	else
+	{
+		volatile unsigned int *count = &parked[LOCK_HASH(lock)&(LOCK_BUCKETS-1)];
+		if ( wait->parks++==LOCK_MAXPARK )
+			throw_exception("%s lock timeout", write?"write":"read");
+		/* the count must be raised before the lock is checked so the unlock cannot miss this thread */
+		atomic_increment(count);
+		if ( *(volatile unsigned int*)lock==value )
+			lock_park(lock,value);
+		atomic_add(count,-1);
+	}
+}
+
+/* count the lock taken and the wait, if any */
+static void lock_taken(unsigned int *lock, LOCKWAIT *wait, int64 *count, int64 *spin)
+{
+	unsigned int tries = wait->spins + wait->yields + wait->parks;
+	atomic_add64(count,1);
+	atomic_add64(spin,tries+1);
+	if ( tries>0 )
+	{
+		LOCKSITE *site = lock_site(lock);
+		int64 dt = lock_clock() - wait->started;
+		int64 us = dt/1000;
+		int bin = 0;
+		if ( us>=1 )
+			for ( bin=1 ; bin<LOCK_HISTOGRAM-1 && us>=4 ; bin++ )
+				us /= 4;
+		atomic_add64(&site->waits,1);
+		atomic_add64(&site->spins,wait->spins);
+		atomic_add64(&site->yields,wait->yields);
+		atomic_add64(&site->parks,wait->parks);
+		atomic_add64(&site->wait_time,dt);
+		atomic_add64(&site->histogram[bin],1);
+	}
+}
+
+/* take the lock exclusively */
+static inline void lock_exclusive(unsigned int *lock, bool write)
+{
+	LOCKWAIT wait = {0,0,0,0};
+	unsigned int value;
+	check_lock(lock,write,false);
+	while ( true )
+	{
+		value = *(volatile unsigned int*)lock;
+		if ( !(value&1) && atomic_compare_and_swap(lock, value, value + 1) )
+			break;
+		lock_wait(lock,value,&wait,write);
+	}
+	/* shared readers that got the lock before this thread must finish */
+	while ( (value=*(volatile unsigned int*)lock)&LOCK_READERS )
+		lock_wait(lock,value,&wait,write);
+	if ( global_profiler )
+	{
+		if ( write )
+			lock_taken(lock,&wait,&wlock_count,&wlock_spin);
+		else
+			lock_taken(lock,&wait,&rlock_count,&rlock_spin);
+	}
+}
+
+/* release the lock taken exclusively */
+static inline void unlock_exclusive(unsigned int *lock)
+{
+	unsigned int value;
+	do {
+		value = *(volatile unsigned int*)lock;
+	} while ( !atomic_compare_and_swap(lock, value, (value&LOCK_READERS)|((value+1)&LOCK_VERSION)) );
+	if ( parked[LOCK_HASH(lock)&(LOCK_BUCKETS-1)]>0 )
+		lock_wake(lock);
+}
+
 /** Read lock
  **/
 extern "C" void rlock(unsigned int *lock)
 {
-	unsigned int timeout = MAXSPIN;
+	LOCKWAIT wait = {0,0,0,0};
 	unsigned int value;
-	extern unsigned int rlock_count, rlock_spin;
+	if ( !(global_lock_options&LO_SHAREDREAD) )
+	{
+		lock_exclusive(lock,false);
+		return;
+	}
 	check_lock(lock,false,false);
-	atomic_increment(&rlock_count);
-	do {
-		value = (*lock);
-		atomic_increment(&rlock_spin);
-		if ( timeout--==0 ) 
-			throw_exception("read lock timeout");
-	} while ((value&1) || !atomic_compare_and_swap(lock, value, value + 1));
+	while ( true )
+	{
+		value = *(volatile unsigned int*)lock;
+		if ( !(value&1) && (value&LOCK_READERS)!=LOCK_READERS && atomic_compare_and_swap(lock, value, value + LOCK_READER) )
+			break;
+		lock_wait(lock,value,&wait,false);
+	}
+	if ( global_profiler )
+		lock_taken(lock,&wait,&rlock_count,&rlock_spin);
 }
 /** Write lock 
  **/
 extern "C" void wlock(unsigned int *lock)
 {
-	unsigned int timeout = MAXSPIN;
-	unsigned int value;
-	extern unsigned int wlock_count, wlock_spin;
-	check_lock(lock,true,false);
-	atomic_increment(&wlock_count);
-	do {
-		value = (*lock);
-		atomic_increment(&wlock_spin);
-		if ( timeout--==0 ) 
-			throw_exception("write lock timeout");
-	} while ((value&1) || !atomic_compare_and_swap(lock, value, value + 1));
+	lock_exclusive(lock,true);
 }
 /** Read unlock
  **/
 extern "C" void runlock(unsigned int *lock)
 {
-	unsigned int value = *lock;
 	check_lock(lock,false,true);
-	atomic_increment(lock);
+	if ( *(volatile unsigned int*)lock&LOCK_READERS )
+	{
+		atomic_add(lock,-LOCK_READER);
+		if ( parked[LOCK_HASH(lock)&(LOCK_BUCKETS-1)]>0 )
+			lock_wake(lock);
+	}
+	else
+		unlock_exclusive(lock);
 }
 /** Write unlock
  **/
 extern "C" void wunlock(unsigned int *lock)
 {
-	unsigned int value = *lock;
 	check_lock(lock,true,true);
-	atomic_increment(lock);
+	unlock_exclusive(lock);
+}
+
+/* a lock reported by the profiler */
+typedef struct s_lockreport {
+	LOCKSITE *site;
+	CLASS *oclass; /* class of the object that contains the lock (NULL if none) */
+	char name[256];
+} LOCKREPORT;
+
+static int lockreport_by_address(const void *a, const void *b)
+{
+	size_t x = (size_t)((LOCKREPORT*)a)->site->lock, y = (size_t)((LOCKREPORT*)b)->site->lock;
+	return x<y ? -1 : (x>y ? 1 : 0);
+}
+static int lockreport_by_wait(const void *a, const void *b)
+{
+	int64 x = ((LOCKREPORT*)a)->site->wait_time, y = ((LOCKREPORT*)b)->site->wait_time;
+	return x>y ? -1 : (x<y ? 1 : 0);
+}
+
+/* name the lock found in an object */
+static void lock_name(LOCKREPORT *report, OBJECT *obj)
+{
+	char objname[256];
+	size_t offset = (char*)report->site->lock - (char*)(obj+1);
+	CLASS *oclass;
+	object_name(obj,objname,sizeof(objname));
+	report->oclass = obj->oclass;
+	if ( report->site->lock==&obj->lock || (char*)report->site->lock<(char*)(obj+1) )
+	{
+		snprintf(report->name,sizeof(report->name),"%s",objname);
+		return;
+	}
+	for ( oclass=obj->oclass ; oclass!=NULL ; oclass=oclass->parent )
+	{
+		PROPERTY *prop;
+		for ( prop=oclass->pmap ; prop!=NULL && prop->oclass==oclass ; prop=prop->next )
+		{
+			if ( (size_t)prop->addr<=offset && offset<(size_t)prop->addr+property_size(prop) )
+			{
+				snprintf(report->name,sizeof(report->name),"%s.%s",objname,prop->name);
+				return;
+			}
+		}
+	}
+	snprintf(report->name,sizeof(report->name),"%s+%d",objname,(int)offset);
+}
+
+/* print the wait time histogram */
+static void lock_histogram(const char *name, int64 waits, int64 wait_time, int64 *histogram)
+{
+	char buffer[1024];
+	int len = snprintf(buffer,sizeof(buffer),"%-24.24s %10" FMT_INT64 "d %10.1f ",name,waits,wait_time/1e6);
+	int bin;
+	for ( bin=0 ; bin<LOCK_HISTOGRAM ; bin++ )
+		len += snprintf(buffer+len,sizeof(buffer)-len," %7" FMT_INT64 "d",histogram[bin]);
+	output_profile("%s",buffer);
+}
+
+/** Report the locks that were waited for
+ **/
+extern "C" void lock_profile(void)
+{
+	LOCKREPORT *report;
+	OBJECT *obj;
+	CLASS *oclass;
+	unsigned int n, i, used = 0;
+	int64 waits = 0;
+
+	for ( n=0 ; n<LOCK_SITES ; n++ )
+	{
+		if ( locksite[n].lock!=NULL && locksite[n].waits>0 )
+			used++;
+	}
+	if ( used==0 && locksite[LOCK_SITES].waits==0 )
+		return;
+	report = (LOCKREPORT*)malloc(sizeof(LOCKREPORT)*(used+1));
+	if ( report==NULL )
+		return;
+	for ( n=0, i=0 ; n<LOCK_SITES ; n++ )
+	{
+		if ( locksite[n].lock!=NULL && locksite[n].waits>0 )
+		{
+			report[i].site = &locksite[n];
+			report[i].oclass = NULL;
+			snprintf(report[i].name,sizeof(report[i].name),"%p",locksite[n].lock);
+			i++;
+		}
+	}
+
+	/* find the objects and classes that contain the locks */
+	qsort(report,used,sizeof(LOCKREPORT),lockreport_by_address);
+	for ( obj=object_get_first() ; obj!=NULL ; obj=obj->next )
+	{
+		char *start = (char*)obj, *end = (char*)(obj+1) + obj->oclass->size;
+		unsigned int lo = 0, hi = used;
+		while ( lo<hi )
+		{
+			unsigned int mid = (lo+hi)/2;
+			if ( (char*)report[mid].site->lock<start )
+				lo = mid+1;
+			else
+				hi = mid;
+		}
+		for ( ; lo<used && (char*)report[lo].site->lock<end ; lo++ )
+			lock_name(&report[lo],obj);
+	}
+	for ( oclass=class_get_first_class() ; oclass!=NULL ; oclass=oclass->next )
+	{
+		for ( n=0 ; n<used ; n++ )
+		{
+			if ( report[n].site->lock==&oclass->profiler.lock )
+			{
+				report[n].oclass = oclass;
+				snprintf(report[n].name,sizeof(report[n].name),"%s (profiler)",oclass->name);
+			}
+		}
+	}
+
+	/* locks with the longest waits */
+	qsort(report,used,sizeof(LOCKREPORT),lockreport_by_wait);
+	for ( n=0 ; n<used ; n++ )
+		waits += report[n].site->waits;
+	output_profile("\nLock wait profile (%d locks, %" FMT_INT64 "d waits)", used, waits+locksite[LOCK_SITES].waits);
+	output_profile("==========================================\n");
+	output_profile("%-24s %10s %9s %9s %9s %10s", "Lock", "Waits", "Spins", "Yields", "Parks", "Wait (ms)");
+	output_profile("%-24s %10s %9s %9s %9s %10s", "----", "-----", "-----", "------", "-----", "---------");
+	for ( n=0 ; n<used && n<LOCK_TOPSITES ; n++ )
+	{
+		LOCKSITE *site = report[n].site;
+		output_profile("%-24.24s %10" FMT_INT64 "d %9" FMT_INT64 "d %9" FMT_INT64 "d %9" FMT_INT64 "d %10.1f",
+			report[n].name, site->waits, site->spins, site->yields, site->parks, site->wait_time/1e6);
+	}
+	if ( locksite[LOCK_SITES].waits>0 )
+		output_profile("%-24.24s %10" FMT_INT64 "d %9" FMT_INT64 "d %9" FMT_INT64 "d %9" FMT_INT64 "d %10.1f", "(other locks)",
+			locksite[LOCK_SITES].waits, locksite[LOCK_SITES].spins, locksite[LOCK_SITES].yields, locksite[LOCK_SITES].parks, 
+			locksite[LOCK_SITES].wait_time/1e6);
+
+	/* wait times by class */
+	output_profile("\n%-24s %10s %10s  %7s %7s %7s %7s %7s %7s %7s %7s", "Class", "Waits", "Wait (ms)",
+		"<1us", "<4us", "<16us", "<64us", "<256us", "<1ms", "<4ms", ">=4ms");
+	output_profile("%-24s %10s %10s  %7s %7s %7s %7s %7s %7s %7s %7s", "-----", "-----", "---------",
+		"----", "----", "-----", "-----", "------", "----", "----", "-----");
+	for ( oclass=class_get_first_class() ; ; oclass=oclass->next )
+	{
+		int64 total = 0, wait_time = 0, histogram[LOCK_HISTOGRAM];
+		int bin;
+		memset(histogram,0,sizeof(histogram));
+		for ( n=0 ; n<used ; n++ )
+		{
+			if ( report[n].oclass==oclass )
+			{
+				total += report[n].site->waits;
+				wait_time += report[n].site->wait_time;
+				for ( bin=0 ; bin<LOCK_HISTOGRAM ; bin++ )
+					histogram[bin] += report[n].site->histogram[bin];
+			}
+		}
+		if ( oclass==NULL )
+		{
+			for ( bin=0 ; bin<LOCK_HISTOGRAM ; bin++ )
+				histogram[bin] += locksite[LOCK_SITES].histogram[bin];
+			total += locksite[LOCK_SITES].waits;
+			if ( total>0 )
+				lock_histogram("(other)",total,wait_time+locksite[LOCK_SITES].wait_time,histogram);
+			break;
+		}
+		if ( total>0 )
+			lock_histogram(oclass->name,total,wait_time,histogram);
+	}
+	free(report);
 }
 
 #elif defined METHOD1 
@@ -82,6 +82,9 @@
 #include "exec.h"
 #include "stream.h"
 #include "transform.h"
+#include "threadpool.h"
+#include "statistics.h"
+#include "accumulator.h"
 
 #include "console.h"
 
@@ -193,7 +196,7 @@ static CALLBACKS callbacks = {
 	class_find_property,
 	module_malloc,
 	module_free,
-	{aggregate_mkgroup,aggregate_value,},
+	{aggregate_mkgroup,aggregate_value,aggregate_values,},
 	{module_getvar_addr,module_get_first,module_depends,module_find_transform_function},
 	{random_uniform, random_normal, random_bernoulli, random_pareto, random_lognormal, random_sampled, random_exponential, random_type, random_value, pseudorandom_value, random_triangle, random_beta, random_gamma, random_weibull, random_rayleigh},
 	object_isa,
@@ -226,6 +229,10 @@ static CALLBACKS callbacks = {
 	{transform_getnext,transform_add_linear,transform_add_external,transform_apply},
 	{randomvar_getnext,randomvar_getspec},
 	{version_major,version_minor,version_patch,version_build,version_branch},
+	{object_subscribe_changes,object_notify_change,object_get_changes},
+	{mti_init,mti_run},
+	{statwindow_create,statwindow_destroy,statwindow_reset,statwindow_add,statwindow_skip,statwindow_get},
+	{accumulator_create,accumulator_add,accumulator_sub},
 	MAGIC /* used to check structure */
 };
 CALLBACKS *module_callbacks(void) { return &callbacks; }
@@ -466,6 +473,8 @@ MODULE *module_load(const char *file, /**< module filename, searches \p PATH */
 	mod->interupdate = (SIMULATIONMODE(*)(void*,int64,unsigned int64,unsigned long, unsigned int))DLSYM(hLib,"interupdate");
 	mod->deltaClockUpdate = (SIMULATIONMODE(*)(void *, double, unsigned long, SIMULATIONMODE))DLSYM(hLib,"deltaClockUpdate");
 	mod->postupdate = (STATUS(*)(void*,int64,unsigned int64))DLSYM(hLib,"postupdate");
+	mod->deltastep = (unsigned long(*)(void*,int64,unsigned int64,unsigned long))DLSYM(hLib,"deltamode_nextstep");
+	mod->deltaevent = (unsigned long(*)(void*,int64,unsigned int64))DLSYM(hLib,"deltamode_nextevent");
 	/* clock  update */
 	mod->clockupdate = (TIMESTAMP(*)(TIMESTAMP))DLSYM(hLib,"clock_update");
 	mod->cmdargs = (int(*)(int,char**))DLSYM(hLib,"cmdargs");
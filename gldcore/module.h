@@ -31,6 +31,8 @@ struct s_module_list {
 	SIMULATIONMODE (*interupdate)(void*,int64,unsigned int64,unsigned long,unsigned int);
 	SIMULATIONMODE (*deltaClockUpdate)(void *, double, unsigned long, SIMULATIONMODE);
 	STATUS (*postupdate)(void*,int64,unsigned int64);
+	unsigned long (*deltastep)(void*,int64,unsigned int64,unsigned long);
+	unsigned long (*deltaevent)(void*,int64,unsigned int64);
 	/* clock hook*/
 	TIMESTAMP (*clockupdate)(TIMESTAMP *);
 	int (*cmdargs)(int,char**);
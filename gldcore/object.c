@@ -46,6 +46,7 @@
 /* object list */
 static OBJECTNUM next_object_id = 0;
 static OBJECTNUM deleted_object_count = 0;
+static unsigned int service_change_count = 0;
 static OBJECT *first_object = NULL;
 static OBJECT *last_object = NULL;
 static OBJECTNUM object_array_size = 0;
@@ -110,6 +111,14 @@ unsigned int object_get_count(){
 	return next_object_id - deleted_object_count;
 }
 
+/** Get the number of in/out service changes made through object headers
+
+	@return the count of service changes since the model was loaded
+ **/
+unsigned int object_get_service_changes(void){
+	return service_change_count;
+}
+
 /** Get a named property of an object.  
 
 	Note that you must use object_get_value_by_name to retrieve the value of
@@ -345,6 +354,7 @@ OBJECT *object_create_single(CLASS *oclass){ /**< the class of the object */
 	obj->flags = OF_NONE;
 	obj->rng_state = randwarn(NULL);
 	obj->heartbeat = 0;
+	obj->changes = NULL;
 
 	for ( prop=obj->oclass->pmap; prop!=NULL; prop=(prop->next?prop->next:(prop->oclass->parent?prop->oclass->parent->pmap:NULL)))
 		property_create(prop,(void*)((char *)(obj+1)+(int64)(prop->addr)));
@@ -411,6 +421,7 @@ OBJECT *object_create_foreign(OBJECT *obj) /**< a pointer to the OBJECT data str
 	obj->out_svc = TS_NEVER;
 	obj->out_svc_micro = 0;
 	obj->out_svc_double = (double)obj->out_svc;
+	obj->changes = NULL;
 	obj->flags = OF_FOREIGN;
 	
 	if(first_object == NULL){
@@ -798,6 +809,7 @@ int object_set_value_by_addr(OBJECT *obj, /**< the object to alter */
 	}
 	if(prop->notify_override != true){
 		result = class_string_to_property(prop,addr,value);
+		object_notify_change(obj,prop);
 	}
 	if(obj->oclass->notify){
 		if(obj->oclass->notify(obj,NM_POSTUPDATE,prop,value) == 0){
@@ -927,6 +939,7 @@ static int set_header_value(OBJECT *obj, char *name, char *value)
 			obj->in_svc = tval;
 			obj->in_svc_micro = temp_microseconds;
 			obj->in_svc_double = tval_double;
+			service_change_count++;
 			return SUCCESS;
 		}
 	}
@@ -949,6 +962,7 @@ static int set_header_value(OBJECT *obj, char *name, char *value)
 			obj->out_svc = tval;
 			obj->out_svc_micro = temp_microseconds;
 			obj->out_svc_double = tval_double;
+			service_change_count++;
 			return SUCCESS;
 		}
 	}
@@ -1041,6 +1055,7 @@ int object_set_int16_by_name(OBJECT *obj, PROPERTYNAME name, int16 value)
 		return 0;
 	}
 	*(int16 *)((char *)(obj+1)+(int64)(prop->addr)) = value; /* warning: cast from pointer to integer of different size */
+	object_notify_change(obj,prop);
 	return 1;
 }
 
@@ -1062,6 +1077,7 @@ int object_set_int32_by_name(OBJECT *obj, PROPERTYNAME name, int32 value)
 		return 0;
 	}
 	*(int32 *)((char *)(obj+1)+(int64)(prop->addr)) = value; /* warning: cast from pointer to integer of different size */
+	object_notify_change(obj,prop);
 	return 1;
 }
 
@@ -1083,6 +1099,7 @@ int object_set_int64_by_name(OBJECT *obj, PROPERTYNAME name, int64 value)
 		return 0;
 	}
 	*(int64 *)((char *)(obj+1)+(int64)(prop->addr)) = value; /* warning: cast from pointer to integer of different size */
+	object_notify_change(obj,prop);
 	return 1;
 }
 
@@ -1104,6 +1121,7 @@ int object_set_double_by_name(OBJECT *obj, PROPERTYNAME name, double value)
 		return 0;
 	}
 	*(double*)((char *)(obj+1)+(int64)(prop->addr)) = value; /* warning: cast from pointer to integer of different size */
+	object_notify_change(obj,prop);
 	return 1;
 }
 
@@ -1125,9 +1143,70 @@ int object_set_complex_by_name(OBJECT *obj, PROPERTYNAME name, complex value)
 		return 0;
 	}
 	*(complex*)((char *)(obj+1)+(int64)(prop->addr)) = value; /* warning: cast from pointer to integer of different size */
+	object_notify_change(obj,prop);
+	return 1;
+}
+
+/* Property change notification
+
+   Consumers that would otherwise poll a property every pass (recorders, exports)
+   can subscribe to its changes instead.  Each subscribed object carries a small
+   table of change counters indexed by property offset; every write that goes
+   through the object_set_* API, a transform, or a module that flags the property
+   with PF_NOTIFYCHANGE increments the counter of the property.  A subscriber
+   remembers the last count it saw and only has to read the property when the
+   count moves.  Properties that share a slot cause spurious changes, never
+   missed ones.
+ */
+#define OBJECT_CHANGE_SLOTS 64
+#define OBJECT_CHANGE_SLOT(P) (((size_t)((P)->addr)/sizeof(double))%OBJECT_CHANGE_SLOTS)
+
+/** Subscribe to changes of a property
+	@return 1 if every write to the property is reported so the subscriber may rely
+	on object_get_changes(), 0 if the property must still be polled
+ **/
+int object_subscribe_changes(OBJECT *obj, /**< the object to watch */
+							 PROPERTY *prop) /**< the property to watch */
+{
+	if ( (prop->flags&PF_NOTIFYCHANGE)==0 )
+		return 0;
+	if ( obj->changes==NULL )
+	{
+		wlock(&obj->lock);
+		if ( obj->changes==NULL )
+			obj->changes = (unsigned int*)calloc(OBJECT_CHANGE_SLOTS,sizeof(unsigned int));
+		wunlock(&obj->lock);
+		if ( obj->changes==NULL )
+		{
+			output_error("object_subscribe_changes(obj=%s:%d, prop='%s'): memory allocation failed", obj->oclass->name, obj->id, prop->name);
+			/* TROUBLESHOOT
+				The system has run out of memory and is unable to track property changes.  
+				Try freeing up system memory and try again.
+			 */
+			return 0;
+		}
+	}
 	return 1;
 }
 
+/** Report a change to a property to its subscribers, if any
+ **/
+void object_notify_change(OBJECT *obj, /**< the object that changed */
+						  PROPERTY *prop) /**< the property that changed */
+{
+	if ( obj->changes!=NULL )
+		obj->changes[OBJECT_CHANGE_SLOT(prop)]++;
+}
+
+/** Get the change count of a property
+	@return the number of changes reported since the first subscription
+ **/
+unsigned int object_get_changes(OBJECT *obj, /**< the object to check */
+								PROPERTY *prop) /**< the property to check */
+{
+	return obj->changes!=NULL ? obj->changes[OBJECT_CHANGE_SLOT(prop)] : 0;
+}
+
 /** Get a property value by reference to its physical address
 	@return the number of characters written to the buffer; 0 if failed
  **/
@@ -1299,10 +1378,16 @@ static int _set_rankx(OBJECT *obj, OBJECTRANK rank, OBJECT *first)
 	}
 	for ( obj=first ; obj!=NULL ; obj=obj->parent )
 		obj->flags &= ~OF_RERANK;
+	return first->rank;
 }
+static unsigned int rank_lock = 0; /* ranks may be changed by objects initializing concurrently */
 static int set_rank(OBJECT *obj, OBJECTRANK rank, OBJECT *first)
 {
-	global_bigranks==TRUE ? _set_rankx(obj,rank,NULL) : _set_rank(obj,rank,NULL);
+	int rv;
+	wlock(&rank_lock);
+	rv = global_bigranks==TRUE ? _set_rankx(obj,rank,NULL) : _set_rank(obj,rank,NULL);
+	wunlock(&rank_lock);
+	return rv;
 }
 
 /** Set the rank of an object but forcing it's parent
@@ -2253,38 +2338,21 @@ static OBJECTTREE *object_tree_add(OBJECT *obj, OBJECTNAME name){
 }
 
 /*	Finds a name in the tree
+	Returns the link that points to the matching node so the caller can replace it.
  */
-static OBJECTTREE **findin_tree(OBJECTTREE *tree, OBJECTNAME name)
+static OBJECTTREE **findin_tree(OBJECTTREE **tree, OBJECTNAME name)
 {
-	static OBJECTTREE **temptree = NULL;
-	if(tree == NULL){
-		return NULL;
-	} else {
-		int rel = strcmp(tree->name, name);
-		if(rel > 0){
-			if(tree->before != NULL){
-				if(strcmp(tree->before->name, name) == 0){
-					return &(tree->before);
-				} else {
-					return findin_tree(tree->before, name);
-				}
-			} else {
-				return NULL;
-			}
-		} else if(rel<0) {
-			if(tree->after != NULL){
-				if(strcmp(tree->after->name, name) == 0){
-					return &(tree->after);
-				} else {
-					return findin_tree(tree->after, name);
-				}
-			} else {
-				return NULL;
-			}
-		} else {
-			return (temptree = &tree);
-		}
+	while ( *tree!=NULL )
+	{
+		int rel = strcmp((*tree)->name, name);
+		if ( rel>0 )
+			tree = &((*tree)->before);
+		else if ( rel<0 )
+			tree = &((*tree)->after);
+		else
+			return tree;
 	}
+	return NULL;
 }
 
 /*	Deletes a name from the tree
@@ -2292,7 +2360,7 @@ static OBJECTTREE **findin_tree(OBJECTTREE *tree, OBJECTNAME name)
  */
 void object_tree_delete(OBJECT *obj, OBJECTNAME name)
 {
-	OBJECTTREE **item = findin_tree(top,name);
+	OBJECTTREE **item = findin_tree(&top,name);
 	OBJECTTREE *temp = NULL, **dtemp = NULL;
 
 	if(item != NULL && strcmp((*item)->name, name)!=0){
@@ -2338,7 +2406,7 @@ void object_tree_delete(OBJECT *obj, OBJECTNAME name)
 OBJECT *object_find_name(OBJECTNAME name){
 	OBJECTTREE **item = NULL;
 
-	item = findin_tree(top, name);
+	item = findin_tree(&top, name);
 	
 	if(item != NULL && *item != NULL){
 		return (*item)->obj;
@@ -17,6 +17,8 @@
 #include "schedule.h"
 #include "transform.h"
 #include "enduse.h"
+#include "statistics.h"
+#include "accumulator.h"
 
 /* this must match property_type list in object.c */
 typedef unsigned int OBJECTRANK; /**< Object rank number */
@@ -90,10 +92,14 @@ typedef struct s_object_list {
 	unsigned int lock; /**< object lock */
 	unsigned int rng_state; /**< random number generator state */
 	TIMESTAMP heartbeat; /**< heartbeat call interval (in sim-seconds) */
+	unsigned int *changes; /**< property change counters, NULL until a subscriber asks for them (see object_subscribe_changes) */
 	uint32 flags; /**< object flags */
 	/* IMPORTANT: flags must be last */
 } OBJECT; /**< Object header structure */
 
+struct s_mtiteratorlist; /* multithreaded iterators are defined in threadpool.h */
+struct s_mtifunctions;
+
 /* this is the callback table for modules
  * the table is initialized in module.cpp
  */
@@ -159,6 +165,7 @@ typedef struct s_callbacks {
 	struct {
 		struct s_aggregate *(*create)(char *aggregator, char *group_expression);
 		double (*refresh)(struct s_aggregate *aggregate);
+		unsigned int (*refresh_list)(struct s_aggregate *aggregate, double *values, unsigned int size);
 	} aggregate;
 	struct {
 		void *(*getvar)(MODULE *module, const char *varname);
@@ -324,6 +331,28 @@ typedef struct s_callbacks {
 		unsigned int (*build)(void);
 		const char * (*branch)(void);
 	} version;
+	struct {
+		int (*subscribe)(OBJECT*,PROPERTY*);
+		void (*notify)(OBJECT*,PROPERTY*);
+		unsigned int (*count)(OBJECT*,PROPERTY*);
+	} change;
+	struct {
+		struct s_mtiteratorlist *(*init)(const char *name, struct s_mtifunctions *fns, size_t minitems);
+		int (*run)(void *result, struct s_mtiteratorlist *mti, void *input);
+	} mti;
+	struct {
+		STATWINDOW *(*create)(unsigned int size, unsigned int options, double quantile);
+		void (*destroy)(STATWINDOW *window);
+		void (*reset)(STATWINDOW *window);
+		void (*add)(STATWINDOW *window, double value);
+		void (*skip)(STATWINDOW *window);
+		double (*get)(STATWINDOW *window, STATWINDOWVALUE which);
+	} statwindow;
+	struct {
+		ACCUMULATOR *(*create)(complex *value, unsigned int n);
+		void (*add)(ACCUMULATOR *acc, complex *values);
+		void (*sub)(ACCUMULATOR *acc, complex *values);
+	} accumulator;
 	long unsigned int magic; /* used to check structure alignment */
 } CALLBACKS; /**< core callback function table */
 
@@ -354,6 +383,9 @@ int object_set_double_by_name(OBJECT *obj, PROPERTYNAME name, double value);
 bool *object_get_bool(OBJECT *obj, PROPERTY *prop);
 bool *object_get_bool_by_name(OBJECT *obj, char *name);
 int object_set_complex_by_name(OBJECT *obj, PROPERTYNAME name, complex value);
+int object_subscribe_changes(OBJECT *obj, PROPERTY *prop);
+void object_notify_change(OBJECT *obj, PROPERTY *prop);
+unsigned int object_get_changes(OBJECT *obj, PROPERTY *prop);
 int object_get_value_by_name(OBJECT *obj, PROPERTYNAME name, char *value, int size);
 int object_get_value_by_addr(OBJECT *obj, void *addr, char *value, int size, PROPERTY *prop);
 int object_set_value_by_type(PROPERTYTYPE,void *addr, char *value);
@@ -396,6 +428,7 @@ OBJECT *object_find_by_id(OBJECTNUM id);
 OBJECT *object_get_first(void);
 OBJECT *object_get_next(OBJECT *obj);
 unsigned int object_get_count(void);
+unsigned int object_get_service_changes(void);
 int object_dump(char *buffer, int size, OBJECT *obj);
 int object_save(char *buffer, int size, OBJECT *obj);
 int object_saveall(FILE *fp);
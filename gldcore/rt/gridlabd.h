@@ -539,6 +539,7 @@ typedef struct s_keyword KEYWORD;
 typedef uint32 PROPERTYFLAGS;
 #define PF_RECALC	0x0001 /**< property has a recalc trigger (only works if recalc_<class> is exported) */
 #define PF_CHARSET	0x0002 /**< set supports single character keywords (avoids use of |) */
+#define PF_NOTIFYCHANGE 0x0008 /**< every write to the property is reported using object_notify_change() so subscribers need not poll it */
 
 struct s_property_map {
 	CLASS *oclass; /**< class implementing the property */
@@ -725,6 +726,7 @@ struct s_object_list {
 	unsigned int lock; /**< object lock */
 	unsigned int rng_state; /**< random number generator state */
 	TIMESTAMP heartbeat; /**< heartbeat call interval (in sim-seconds) */
+	unsigned int *changes; /**< property change counters, NULL until a subscriber asks for them (see object_subscribe_changes) */
 	uint32 flags; /**< object flags */
 	/* IMPORTANT: flags must be last */
 }; /**< Object header structure */
@@ -1089,6 +1091,27 @@ typedef struct s_transform {
 	struct s_transform *next; ///* next item in linked list
 } TRANSFORM;
 
+struct s_mtiteratorlist; /* multithreaded iterators are defined in threadpool.h */
+struct s_mtifunctions;
+
+typedef enum {
+	SWO_NONE		= 0x00, /**< count, sum, mean and variance only */
+	SWO_MINMAX		= 0x01, /**< track the minimum and maximum (unbounded windows always do) */
+	SWO_QUANTILE	= 0x02, /**< estimate a quantile (unbounded windows only) */
+} STATWINDOWOPTIONS;
+typedef enum {
+	SWV_COUNT		= 0, /**< number of samples in the window */
+	SWV_SUM			= 1, /**< sum of the samples */
+	SWV_MEAN		= 2, /**< mean of the samples */
+	SWV_VARIANCE	= 3, /**< population variance of the samples */
+	SWV_STDEV		= 4, /**< population standard deviation of the samples */
+	SWV_MIN			= 5, /**< smallest sample */
+	SWV_MAX			= 6, /**< largest sample */
+	SWV_QUANTILE	= 7, /**< quantile estimate */
+} STATWINDOWVALUE;
+typedef struct s_statwindow STATWINDOW; /* statistics windows are defined in statistics.h */
+typedef struct s_accumulator ACCUMULATOR; /* accumulators are defined in accumulator.h */
+
 typedef struct s_callbacks {
 	TIMESTAMP *global_clock;
 	double *global_delta_curr_clock;
@@ -1151,6 +1174,7 @@ typedef struct s_callbacks {
 	struct {
 		struct s_aggregate *(*create)(char *aggregator, char *group_expression);
 		double (*refresh)(struct s_aggregate *aggregate);
+		unsigned int (*refresh_list)(struct s_aggregate *aggregate, double *values, unsigned int size);
 	} aggregate;
 	struct {
 		void *(*getvar)(MODULE *module, char *varname);
@@ -1316,6 +1340,28 @@ typedef struct s_callbacks {
 		unsigned int (*build)(void);
 		const char * (*branch)(void);
 	} version;
+	struct {
+		int (*subscribe)(OBJECT*,PROPERTY*);
+		void (*notify)(OBJECT*,PROPERTY*);
+		unsigned int (*count)(OBJECT*,PROPERTY*);
+	} change;
+	struct {
+		struct s_mtiteratorlist *(*init)(const char *name, struct s_mtifunctions *fns, size_t minitems);
+		int (*run)(void *result, struct s_mtiteratorlist *mti, void *input);
+	} mti;
+	struct {
+		STATWINDOW *(*create)(unsigned int size, unsigned int options, double quantile);
+		void (*destroy)(STATWINDOW *window);
+		void (*reset)(STATWINDOW *window);
+		void (*add)(STATWINDOW *window, double value);
+		void (*skip)(STATWINDOW *window);
+		double (*get)(STATWINDOW *window, STATWINDOWVALUE which);
+	} statwindow;
+	struct {
+		ACCUMULATOR *(*create)(complex *value, unsigned int n);
+		void (*add)(ACCUMULATOR *acc, complex *values);
+		void (*sub)(ACCUMULATOR *acc, complex *values);
+	} accumulator;
 	long unsigned int magic; /* used to check structure alignment */
 } CALLBACKS; /**< core callback function table */
 
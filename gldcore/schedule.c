@@ -181,7 +181,7 @@ int find_value_index (SCHEDULE *sch, /// schedule to search
 
 int schedule_compile_block(SCHEDULE *sch, char *blockname, char *blockdef)
 {
-	char *token = NULL;
+	char *token = NULL, *last = NULL;
 	unsigned int minute=0;
 
 	/* check block count */
@@ -196,7 +196,7 @@ int schedule_compile_block(SCHEDULE *sch, char *blockname, char *blockdef)
 
 	/* first index is always default value 0 */
 	sch->count[sch->block]=1;
-	while ( (token=strtok(token==NULL?blockdef:NULL,";\r\n"))!=NULL )
+	while ( (token=strtok_s(token==NULL?blockdef:NULL,";\r\n",&last))!=NULL ) /* schedules may be compiled concurrently */
 	{
 		struct {
 			char *name;
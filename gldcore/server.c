@@ -17,6 +17,7 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <sys/errno.h>
+#include <fcntl.h>
 #define SOCKET int
 #define INVALID_SOCKET (-1)
 
@@ -25,6 +26,7 @@
 #include <memory.h>
 #include <string.h>
 #include <errno.h>
+#include <ctype.h>
 #include <pthread.h>
 
 #include "server.h"
@@ -38,6 +40,11 @@
 #include "legal.h"
 
 #include "gui.h"
+#include "lock.h"
+
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 
 #define MAXSTR		1024		// maximum string length
 
@@ -78,6 +85,9 @@ int GetLastError()
 
 void server_request(int);	// Function to handle clients' request(s)
 void *http_response(void *ptr);
+#ifdef HAVE_SYS_EPOLL_H
+static int server_event_loop(SOCKET listenfd);
+#endif
 
 /** Send the data to the client
 	@returns the number of bytes sent if successful, -1 if failed (errno is set).
@@ -123,6 +133,10 @@ static void *server_routine(void *arg)
 	}
 	started = 1;
 	sockfd = (SOCKET)arg;
+#ifdef HAVE_SYS_EPOLL_H
+	status = server_event_loop(sockfd);
+	output_verbose("server shutdown");
+#else
 	// repeat forever..
 	static int active = 0;
 	void *result = NULL;
@@ -164,6 +178,7 @@ static void *server_routine(void *arg)
 	}
 	output_verbose("server shutdown");
 Done:
+#endif
 	started = 0;
 	return (void*)&status;
 }
@@ -247,7 +262,7 @@ Retry:
 	output_verbose("bind ok to address");
 #endif	
 	/* listen for connection */
-	listen(sockfd,5);
+	listen(sockfd,SOMAXCONN);
 	output_verbose("server listening to port %d", portNumber);
 	global_server_portnum = portNumber;
 
@@ -282,6 +297,13 @@ STATUS server_join(void)
  HTTPCNX routines
  */
 
+/** Growable data buffer used for queued output **/
+typedef struct s_httpbuf {
+	char *data;
+	size_t len;
+	size_t max;
+} HTTPBUF;
+
 typedef struct s_httpcnx {
 	char query[1024];
 	char *buffer;
@@ -291,8 +313,57 @@ typedef struct s_httpcnx {
 	char *type;
 	SOCKET s;
 	bool cooked;
+	bool keep_alive; /**< connection stays open after the response is sent */
+	bool queued; /**< output is queued for the event loop instead of sent directly */
+	bool closing; /**< connection closes once queued output is sent */
+	bool writing; /**< event loop is waiting for the socket to accept more output */
+	bool deferred; /**< output is held for the event loop to pick up instead of sent (worker jobs) */
+	bool busy; /**< a worker job is handling a request received on this connection */
+	char *body; /**< request body, if any */
+	HTTPBUF input; /**< request data not yet processed */
+	HTTPBUF output; /**< response data not yet sent */
+	size_t sent; /**< amount of output already sent */
+	struct s_httpstream *stream; /**< property stream sent on this connection, if any */
+	struct s_httpcnx *next; /**< next connection handled by the event loop */
 } HTTPCNX;
 
+/** Append data to a buffer
+	@returns 1 on success, 0 on failure
+ **/
+static int httpbuf_write(HTTPBUF *buf, const char *data, size_t len)
+{
+	if ( buf->len+len+1>buf->max )
+	{
+		size_t max = buf->max==0 ? 4096 : buf->max;
+		char *bigger;
+		while ( buf->len+len+1>max ) max *= 2;
+		bigger = (char*)realloc(buf->data,max);
+		if ( bigger==NULL )
+		{
+			output_error("httpbuf_write(): unable to extend buffer to %d bytes", (int)max);
+			return 0;
+		}
+		buf->data = bigger;
+		buf->max = max;
+	}
+	memcpy(buf->data+buf->len,data,len);
+	buf->len += len;
+	buf->data[buf->len] = '\0';
+	return 1;
+}
+
+/** Free the contents of a buffer **/
+static void httpbuf_free(HTTPBUF *buf)
+{
+	free(buf->data);
+	memset(buf,0,sizeof(HTTPBUF));
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+static void http_flush(HTTPCNX *http);
+static int http_job_start(HTTPCNX *http, int (*request)(HTTPCNX*,char*), char *uri, char *success, char *failure);
+#endif
+
 /** Create an HTTPCNX connection handle
     @returns HTTPCNX connection handle pointer on success, NULL on failure
  **/
@@ -371,6 +442,21 @@ static void http_type(HTTPCNX *http, char *type)
 {
 	http->type = type;
 }
+/** Send data on the HTTPCNX connection, or queue it when the event loop handles the connection **/
+static void http_output(HTTPCNX *http, char *data, size_t len)
+{
+#ifdef HAVE_SYS_EPOLL_H
+	if ( http->queued )
+	{
+		if ( !httpbuf_write(&http->output,data,len) )
+			http->closing = true;
+		if ( !http->deferred )
+			http_flush(http);
+		return;
+	}
+#endif
+	send_data(http->s,data,len);
+}
 /** Send the HTTPCNX response **/
 static void http_send(HTTPCNX *http)
 {
@@ -384,10 +470,11 @@ static void http_send(HTTPCNX *http)
 	len += sprintf(header+len, "Cache-Control: no-cache\n");
 	len += sprintf(header+len, "Cache-Control: no-store\n");
 	len += sprintf(header+len, "Expires: -1\n");
+	len += sprintf(header+len, "Connection: %s\n", http->keep_alive?"keep-alive":"close");
 	len += sprintf(header+len,"\n");
-	send_data(http->s,header,len);
+	http_output(http,header,len);
 	if (http->len>0)
-		send_data(http->s,http->buffer,http->len);
+		http_output(http,http->buffer,http->len);
 	http->len = 0;
 }
 /** Cook the contents of the HTTPCNX message buffer, if limit==0 returns only bytes needed to store result */
@@ -477,6 +564,13 @@ static void http_close(HTTPCNX *http)
 {
 	if (http->len>0)
 		http_send(http);
+	if ( http->queued )
+	{
+		/* the event loop closes the socket once the output is sent */
+		http->keep_alive = false;
+		http->closing = true;
+		return;
+	}
 #ifdef WIN32
 	closesocket(http->s);
 #else
@@ -1699,16 +1793,306 @@ int http_favicon(HTTPCNX *http)
 	return http_copy(http,"icon",fullpath,false);
 }
 
-/** Process an incoming request
-	@returns nothing
+/********************************************************
+ Batched property queries and property streams
+ */
+
+/** An item of a batched property query **/
+typedef struct s_httpitem {
+	char name[1024]; /**< the name used in the query (object/property or global) */
+	OBJECT *obj; /**< the object, NULL for a global variable */
+	PROPERTY *prop; /**< the property, NULL if it must be looked up by name */
+} HTTPITEM;
+
+/** A property stream sent on a connection at each committed timestep **/
+typedef struct s_httpstream {
+	HTTPCNX *http; /**< the connection on which the stream is sent */
+	HTTPITEM *item; /**< the properties sent */
+	unsigned int n_items; /**< the number of properties sent */
+	HTTPBUF pending; /**< events not yet sent */
+	unsigned int dropped; /**< events dropped because the client is not reading them */
+	struct s_httpstream *next;
+} HTTPSTREAM;
+
+#define STREAM_MAXPENDING 1048576 /* maximum unsent event data per stream before events are dropped */
+static HTTPSTREAM *stream_list = NULL; /**< active property streams */
+static unsigned int stream_lock = 0; /**< lock on the stream list and pending events */
+static volatile unsigned int n_streams = 0; /**< number of active property streams */
+
+/** Find an object by name or class:id **/
+static OBJECT *http_find_object(char *name)
+{
+	char *id = strchr(name,':');
+	if ( id==NULL )
+		return object_find_name(name);
+	else
+		return object_find_by_id(atoi(id+1));
+}
+
+/** Parse a list of object/property and global variable names
+	The names may be separated by commas, semicolons, ampersands or whitespace.
+	@returns the number of items parsed, -1 on failure
  **/
-void *http_response(void *ptr)
+static int http_items_parse(char *list, HTTPITEM **items)
 {
-	SOCKET fd = (SOCKET)ptr;
-	HTTPCNX *http = http_create(fd);
-	size_t len;
+	char *p, *next;
+	int n = 0, max = 0;
+	*items = NULL;
+	for ( p=list ; p!=NULL && *p!='\0' ; p=next )
+	{
+		size_t len = strcspn(p,",;& \t\r\n");
+		HTTPITEM *item;
+		char *propname;
+		next = p[len]=='\0' ? NULL : p+len+1;
+		if ( len==0 )
+			continue;
+		if ( len>=sizeof(item->name) )
+		{
+			output_error("http_items_parse(): item name '%.32s...' is too long", p);
+			free(*items);
+			*items = NULL;
+			return -1;
+		}
+		if ( n==max )
+		{
+			HTTPITEM *bigger = (HTTPITEM*)realloc(*items,sizeof(HTTPITEM)*(max=(max==0?64:max*2)));
+			if ( bigger==NULL )
+			{
+				output_error("http_items_parse(): memory allocation failed");
+				free(*items);
+				*items = NULL;
+				return -1;
+			}
+			*items = bigger;
+		}
+		item = (*items)+n++;
+		memset(item,0,sizeof(HTTPITEM));
+		strncpy(item->name,p,len);
+		http_decode(item->name);
+
+		/* object property */
+		propname = strchr(item->name,'/');
+		if ( propname!=NULL )
+		{
+			*propname = '\0';
+			item->obj = http_find_object(item->name);
+			*propname = '/';
+			if ( item->obj!=NULL )
+				item->prop = class_find_property(item->obj->oclass,propname+1);
+		}
+	}
+	return n;
+}
+
+/** Write a string to a buffer as a JSON string **/
+static void http_json_string(HTTPBUF *out, char *value)
+{
+	char buffer[2048], *p = buffer;
+	httpbuf_write(out,"\"",1);
+	for ( ; *value!='\0' ; value++ )
+	{
+		if ( p-buffer>sizeof(buffer)-8 )
+		{
+			httpbuf_write(out,buffer,p-buffer);
+			p = buffer;
+		}
+		if ( *value=='"' || *value=='\\' )
+			*p++ = '\\';
+		if ( (unsigned char)*value<' ' )
+			p += sprintf(p,"\\u%04x",(unsigned char)*value);
+		else
+			*p++ = *value;
+	}
+	httpbuf_write(out,buffer,p-buffer);
+	httpbuf_write(out,"\"",1);
+}
+
+/** Write the current values of the items to a buffer as a single line of JSON
+	Items that cannot be read are given the value null.
+ **/
+static void http_items_format(HTTPBUF *out, HTTPITEM *item, unsigned int n_items)
+{
+	char buffer[1024];
+	unsigned int n;
+	httpbuf_write(out,"{\"timestamp\": ",14);
+	if ( convert_from_timestamp(global_clock,buffer,sizeof(buffer)) )
+		http_json_string(out,buffer);
+	else
+		httpbuf_write(out,"null",4);
+	httpbuf_write(out,", \"values\": {",13);
+	for ( n=0 ; n<n_items ; n++, item++ )
+	{
+		int ok;
+		if ( n>0 )
+			httpbuf_write(out,", ",2);
+		http_json_string(out,item->name);
+		httpbuf_write(out,": ",2);
+		if ( item->prop!=NULL )
+			ok = class_property_to_string(item->prop,GETADDR(item->obj,item->prop),buffer,sizeof(buffer))>0;
+		else if ( item->obj!=NULL )
+			ok = object_get_value_by_name(item->obj,strchr(item->name,'/')+1,buffer,sizeof(buffer))>0;
+		else
+			ok = strchr(item->name,'/')==NULL && global_getvar(item->name,buffer,sizeof(buffer))!=NULL;
+		if ( ok )
+			http_json_string(out,http_unquote(buffer));
+		else
+			httpbuf_write(out,"null",4);
+	}
+	httpbuf_write(out,"}}",2);
+}
+
+/** Process an incoming batched property query
+	The names are given in the URI or, for a POST, in the request body.
+	@returns non-zero on success, 0 on failure (errno set)
+ **/
+int http_batch_request(HTTPCNX *http, char *uri)
+{
+	HTTPITEM *item;
+	HTTPBUF out;
+	int n_items = http_items_parse(uri[0]!='\0'?uri:(http->body?http->body:""),&item);
+	if ( n_items<0 )
+		return 0;
+	memset(&out,0,sizeof(out));
+	http_items_format(&out,item,n_items);
+	httpbuf_write(&out,"\n",1);
+	http_write(http,out.data,out.len);
+	http_type(http,"text/json");
+	httpbuf_free(&out);
+	free(item);
+	return 1;
+}
+
+/** Process an incoming property stream request
+	The named properties are sent as a server-sent event at each committed timestep
+	until the client closes the connection.
+	@returns non-zero on success, 0 on failure (errno set)
+ **/
+int http_stream_request(HTTPCNX *http, char *uri)
+{
+	HTTPSTREAM *stream;
+	static char header[] = "HTTP/1.1 " HTTP_OK "\nContent-Type: text/event-stream\nCache-Control: no-cache\nConnection: keep-alive\n\n";
+	int n_items;
+	if ( !http->queued )
+	{
+		output_error("http_stream_request(): property streams are not supported on this platform");
+		/* TROUBLESHOOT
+			Property streams are only available when the server uses its event loop,
+			which requires epoll support.  Use the /batch/ request to poll the values instead.
+		 */
+		return 0;
+	}
+	if ( http->stream!=NULL )
+	{
+		output_error("http_stream_request(): a property stream is already active on socket %d", http->s);
+		return 0;
+	}
+	stream = (HTTPSTREAM*)malloc(sizeof(HTTPSTREAM));
+	if ( stream==NULL )
+		return 0;
+	memset(stream,0,sizeof(HTTPSTREAM));
+	n_items = http_items_parse(uri[0]!='\0'?uri:(http->body?http->body:""),&stream->item);
+	if ( n_items<=0 )
+	{
+		output_error("http_stream_request(): no properties requested");
+		free(stream->item);
+		free(stream);
+		return 0;
+	}
+	stream->n_items = n_items;
+	stream->http = http;
+
+	/* start the event stream with the current values */
+	http_output(http,header,sizeof(header)-1);
+	http_output(http,"data: ",6);
+	{
+		HTTPBUF out;
+		memset(&out,0,sizeof(out));
+		http_items_format(&out,stream->item,stream->n_items);
+		httpbuf_write(&out,"\n\n",2);
+		http_output(http,out.data,out.len);
+		httpbuf_free(&out);
+	}
+
+	wlock(&stream_lock);
+	stream->next = stream_list;
+	stream_list = stream;
+	n_streams++;
+	wunlock(&stream_lock);
+	http->stream = stream;
+	output_verbose("streaming %d properties on socket %d", n_items, http->s);
+	return 1;
+}
+
+/** Remove the property stream of a connection **/
+static void http_stream_close(HTTPCNX *http)
+{
+	HTTPSTREAM **p;
+	if ( http->stream==NULL )
+		return;
+	wlock(&stream_lock);
+	for ( p=&stream_list ; *p!=NULL ; p=&(*p)->next )
+	{
+		if ( *p==http->stream )
+		{
+			*p = http->stream->next;
+			n_streams--;
+			break;
+		}
+	}
+	wunlock(&stream_lock);
+	if ( http->stream->dropped>0 )
+		output_warning("property stream on socket %d dropped %d events because the client was not reading them", http->s, http->stream->dropped);
+	httpbuf_free(&http->stream->pending);
+	free(http->stream->item);
+	free(http->stream);
+	http->stream = NULL;
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+static int wake_pipe[2] = {-1,-1}; /**< pipe used to wake the event loop when stream events are pending */
+#endif
+
+/** Queue the current values of all property streams
+	This is called by the main loop after each committed timestep, so the values
+	sent are those of the timestep even if the event loop sends them later.
+ **/
+void server_stream_commit(TIMESTAMP t)
+{
+	HTTPSTREAM *stream;
+	if ( n_streams==0 )
+		return;
+	wlock(&stream_lock);
+	for ( stream=stream_list ; stream!=NULL ; stream=stream->next )
+	{
+		if ( stream->pending.len>=STREAM_MAXPENDING )
+		{
+			stream->dropped++;
+			continue;
+		}
+		httpbuf_write(&stream->pending,"data: ",6);
+		http_items_format(&stream->pending,stream->item,stream->n_items);
+		httpbuf_write(&stream->pending,"\n\n",2);
+	}
+	wunlock(&stream_lock);
+#ifdef HAVE_SYS_EPOLL_H
+	if ( wake_pipe[1]>=0 && write(wake_pipe[1],"",1)<0 && errno!=EAGAIN )
+		output_warning("server_stream_commit(): unable to wake server event loop: %s", strerror(errno));
+#endif
+}
+
+/** Process a request
+	The request header must be null-terminated; the body, if any, is in http->body.
+	@returns non-zero if the connection should be kept open, 0 if it should be closed
+ **/
+static int http_process(HTTPCNX *http, char *request)
+{
+	/* first term is always the request */
+	char method[32];
+	char uri[1024];
+	char version[32];
+	char *p = strchr(request,'\r');
+	int v;
 	int content_length = 0;
-	char *user_agent = NULL;
 	char *host = NULL;
 	int keep_alive = 0;
 	char *connection = NULL;
@@ -1726,117 +2110,657 @@ void *http_response(void *ptr)
 		{"Accept", STRING, (void*)&accept, 0},
 	};
 
-	while ( (int)(len=recv_data(fd,http->query,sizeof(http->query)))>0 )
+	/* initialize the response */
+	http_reset(http);
+	http->keep_alive = false;
+
+	/* read the request string */
+	if (sscanf(request,"%31s %1023s %31s",method,uri,version)!=3)
 	{
-		/* first term is always the request */
-		char *request = http->query;
-		char method[32];
-		char uri[1024];
-		char version[32];
-		char *p = strchr(http->query,'\r');
-		int v;
-		
-		/* initialize the response */
-		http_reset(http);
+		http_status(http,HTTP_BADREQUEST);
+		output_error("request [%s] is bad", request);
+		http_send(http);
+		return 0;
+	}
 
-		/* read the request string */
-		if (sscanf(request,"%s %s %s",method,uri,version)!=3)
+	/* read the rest of the header */
+	while (p!=NULL && (p=strchr(p,'\r'))!=NULL) 
+	{
+ 		*p = '\0';
+		p+=2;
+		for ( v=0 ; v<sizeof(map)/sizeof(map[0]) ; v++ )
+		{
+			if (map[v].sz==0) map[v].sz = strlen(map[v].name);
+			if (strnicmp(map[v].name,p,map[v].sz)==0 && strncmp(p+map[v].sz,": ",2)==0)
+			{
+				if (map[v].type==INTEGER) { *(int*)(map[v].value) = atoi(p+map[v].sz+2); break; }
+				else if (map[v].type==STRING) { *(char**)map[v].value = p+map[v].sz+2; break; }
+			}
+		}
+	}
+	output_verbose("%s (host='%s', len=%d, keep-alive=%d)",request,host?host:"???",content_length, keep_alive);
+
+	/* HTTP/1.1 connections are persistent unless the client asks otherwise,
+	   but the thread-per-connection server handles one request per connection */
+	if ( !http->queued )
+		http->keep_alive = false;
+	else if ( stricmp(version,"HTTP/1.1")==0 )
+		http->keep_alive = !(connection && stricmp(connection,"close")==0);
+	else
+		http->keep_alive = (connection && stricmp(connection,"keep-alive")==0);
+
+	/* reject anything but a GET, except for queries that may need a body */
+	if ( stricmp(method,"GET")!=0 && !(stricmp(method,"POST")==0 && (strncmp(uri,"/batch/",7)==0 || strncmp(uri,"/stream/",8)==0)) )
+	{
+		http_status(http,HTTP_METHODNOTALLOWED);
+		/* technically, we should add an Allow entry to the response header */
+		output_error("request [%s %s %s]: '%s' is not an allowed method", method, uri, version, method);
+		http->keep_alive = false;
+		http_send(http);
+		return 0;
+	}
+
+	/* handle request */
+	if ( strcmp(uri,"/favicon.ico")==0 )
+	{
+		if ( http_favicon(http) )
+			http_status(http,HTTP_OK);
+		else
+			http_status(http,HTTP_NOTFOUND);
+		http_send(http);
+	}
+	else {
+		static struct s_map {
+			char *path;
+			int (*request)(HTTPCNX*,char*);
+			char *success;
+			char *failure;
+			bool external; /* runs an external program */
+		} map[] = {
+			/* this is the map of recognize request types */
+			{"/control/",	http_control_request,	HTTP_ACCEPTED, HTTP_NOTFOUND, false},
+			{"/open/",		http_open_request,		HTTP_ACCEPTED, HTTP_NOTFOUND, false},
+			{"/raw/",		http_raw_request,		HTTP_OK, HTTP_NOTFOUND, false},
+			{"/xml/",		http_xml_request,		HTTP_OK, HTTP_NOTFOUND, false},
+			{"/gui/",		http_gui_request,		HTTP_OK, HTTP_NOTFOUND, false},
+			{"/output/",	http_output_request,	HTTP_OK, HTTP_NOTFOUND, false},
+			{"/action/",	http_action_request,	HTTP_ACCEPTED,HTTP_NOTFOUND, false},
+			{"/rt/",		http_get_rt,			HTTP_OK, HTTP_NOTFOUND, false},
+			{"/rb/",		http_get_rb,			HTTP_OK, HTTP_NOTFOUND, false},
+			{"/perl/",		http_run_perl,			HTTP_OK, HTTP_NOTFOUND, true},
+			{"/gnuplot/",	http_run_gnuplot,		HTTP_OK, HTTP_NOTFOUND, true},
+			{"/java/",		http_run_java,			HTTP_OK, HTTP_NOTFOUND, true},
+			{"/python/",	http_run_python,		HTTP_OK, HTTP_NOTFOUND, true},
+			{"/r/",			http_run_r,				HTTP_OK, HTTP_NOTFOUND, true},
+			{"/scilab/",	http_run_scilab,		HTTP_OK, HTTP_NOTFOUND, true},
+			{"/octave/",	http_run_octave,		HTTP_OK, HTTP_NOTFOUND, true},
+			{"/kml/", 		http_kml_request,		HTTP_OK, HTTP_NOTFOUND, false},
+			{"/json/",		http_json_request,		HTTP_OK, HTTP_NOTFOUND, false},
+			{"/batch/",		http_batch_request,		HTTP_OK, HTTP_NOTFOUND, false},
+			{"/stream/",	http_stream_request,	HTTP_OK, HTTP_NOTFOUND, false},
+		};
+		int n;
+		for ( n=0 ; n<sizeof(map)/sizeof(map[0]) ; n++ )
+		{
+			size_t len = strlen(map[n].path);
+			if (strncmp(uri,map[n].path,len)==0)
+			{
+#ifdef HAVE_SYS_EPOLL_H
+				/* external programs can run for a long time so they don't hold up the event loop */
+				if ( map[n].external && http->queued )
+					return http_job_start(http,map[n].request,uri+len,map[n].success,map[n].failure);
+#endif
+				if ( map[n].request(http,uri+len) )
+					http_status(http,map[n].success);
+				else
+					http_status(http,map[n].failure);
+
+				/* a stream sends its own response */
+				if ( http->stream==NULL )
+					http_send(http);
+				return http->keep_alive;
+			}
+		}
+		http_status(http,HTTP_NOTFOUND);
+		http->keep_alive = false;
+		http_send(http);
+		return 0;
+	}
+	return http->keep_alive;
+}
+
+/** Process incoming requests on a connection (one thread per connection)
+	@returns nothing
+ **/
+void *http_response(void *ptr)
+{
+	SOCKET fd = (SOCKET)ptr;
+	HTTPCNX *http = http_create(fd);
+	size_t len;
+
+	while ( (int)(len=recv_data(fd,http->query,sizeof(http->query)-1))>0 )
+	{
+		char *body;
+		http->query[len] = '\0';
+		body = strstr(http->query,"\r\n\r\n");
+		if ( body!=NULL )
 		{
-			http_status(http,HTTP_BADREQUEST);
-			output_error("request [%s] is bad", request);
-			http_send(http);
+			*body = '\0';
+			http->body = body+4;
+		}
+		else
+			http->body = NULL;
+		if ( !http_process(http,http->query) )
 			break;
+	}
+	http_close(http);
+	output_verbose("socket %d closed",http->s);
+	return 0;
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+/********************************************************
+ Event loop
+ */
+
+static int epoll_fd = -1; /**< event loop descriptor */
+static HTTPCNX *http_list = NULL; /**< connections handled by the event loop */
+
+/** Set a socket to non-blocking mode **/
+static int set_nonblocking(int fd)
+{
+	int flags = fcntl(fd,F_GETFL,0);
+	return flags<0 ? -1 : fcntl(fd,F_SETFL,flags|O_NONBLOCK);
+}
+
+/** Set the events the event loop waits for on a connection
+	Input is not read while a worker job handles a request from the connection.
+ **/
+static void http_poll(HTTPCNX *http)
+{
+	struct epoll_event event;
+	memset(&event,0,sizeof(event));
+	event.events = (http->busy?0:EPOLLIN)|(http->writing?EPOLLOUT:0);
+	event.data.ptr = http;
+	epoll_ctl(epoll_fd,EPOLL_CTL_MOD,http->s,&event);
+}
+
+/** Send as much queued output as the socket accepts **/
+static void http_flush(HTTPCNX *http)
+{
+	bool writing;
+	while ( http->sent<http->output.len )
+	{
+		ssize_t len = send(http->s,http->output.data+http->sent,http->output.len-http->sent,MSG_NOSIGNAL);
+		if ( len<0 )
+		{
+			if ( errno==EINTR )
+				continue;
+			if ( errno!=EAGAIN && errno!=EWOULDBLOCK )
+			{
+				output_verbose("socket %d send failed: %s", http->s, strerror(errno));
+				http->output.len = http->sent = 0;
+				http->closing = true;
+				return;
+			}
+			break;
+		}
+		http->sent += len;
+	}
+	if ( http->sent==http->output.len )
+		http->output.len = http->sent = 0;
+
+	/* wait for the socket to accept more output if any remains */
+	writing = http->output.len>0;
+	if ( writing!=http->writing )
+	{
+		http->writing = writing;
+		http_poll(http);
+	}
+}
+
+/** Close a connection handled by the event loop **/
+static void http_destroy(HTTPCNX *http)
+{
+	HTTPCNX **p;
+	for ( p=&http_list ; *p!=NULL ; p=&(*p)->next )
+	{
+		if ( *p==http )
+		{
+			*p = http->next;
+			break;
+		}
+	}
+	http_stream_close(http);
+	epoll_ctl(epoll_fd,EPOLL_CTL_DEL,http->s,NULL);
+	close(http->s);
+	output_verbose("socket %d closed",http->s);
+	httpbuf_free(&http->input);
+	httpbuf_free(&http->output);
+	free(http->buffer);
+	free(http);
+	if ( global_server_quit_on_close )
+		shutdown_now();
+}
+
+#define HTTP_MAXREQUEST 1048576 /* largest request (header and body) accepted */
+
+/** Answer a request that cannot be processed and close the connection **/
+static void http_reject(HTTPCNX *http, char *status)
+{
+	output_error("request on socket %d rejected: %s", http->s, status);
+	http_reset(http);
+	http_status(http,status);
+	http->len = 0;
+	http->keep_alive = false;
+	http_send(http);
+	http->input.len = 0;
+	http->closing = true;
+}
+
+/** Read the Content-Length header of a request
+	@returns the length of the body, 0 if none, or -1 if the length is malformed
+ **/
+static long http_content_length(char *header)
+{
+	char *cl = header, *end;
+	unsigned long len;
+	while ( (cl=strchr(cl,'\n'))!=NULL )
+	{
+		cl++;
+		if ( strnicmp(cl,"Content-Length:",15)==0 )
+		{
+			cl += 15;
+			while ( *cl==' ' || *cl=='\t' ) cl++;
+			if ( !isdigit(*cl) )
+				return -1;
+			errno = 0;
+			len = strtoul(cl,&end,10);
+			while ( *end==' ' || *end=='\t' ) end++;
+			if ( errno==ERANGE || (*end!='\r' && *end!='\0') )
+				return -1;
+			return len>HTTP_MAXREQUEST ? HTTP_MAXREQUEST+1 : (long)len;
 		}
+	}
+	return 0;
+}
+
+/** Process the complete requests received on a connection **/
+static void http_receive(HTTPCNX *http)
+{
+	char buffer[4096];
+	size_t used = 0;
+	bool eof = false;
 
-		/* read the rest of the header */
-		while (p!=NULL && (p=strchr(p,'\r'))!=NULL) 
+	/* leave the rest in the socket until the requests already received are done */
+	while ( http->input.len<=HTTP_MAXREQUEST )
+	{
+		ssize_t len = recv(http->s,buffer,sizeof(buffer),0);
+		if ( len>0 )
 		{
- 			*p = '\0';
-			p+=2;
-			for ( v=0 ; v<sizeof(map)/sizeof(map[0]) ; v++ )
+			if ( !httpbuf_write(&http->input,buffer,len) )
 			{
-				if (map[v].sz==0) map[v].sz = strlen(map[v].name);
-				if (strnicmp(map[v].name,p,map[v].sz)==0 && strncmp(p+map[v].sz,": ",2)==0)
-				{
-					if (map[v].type==INTEGER) { *(int*)(map[v].value) = atoi(p+map[v].sz+2); break; }
-					else if (map[v].type==STRING) { *(char**)map[v].value = p+map[v].sz+2; break; }
-				}
+				http->closing = true;
+				return;
 			}
 		}
-		output_verbose("%s (host='%s', len=%d, keep-alive=%d)",http->query,host?host:"???",content_length, keep_alive);
+		else if ( len==0 )
+		{
+			eof = true;
+			break;
+		}
+		else if ( errno==EINTR )
+			continue;
+		else
+		{
+			if ( errno!=EAGAIN && errno!=EWOULDBLOCK )
+				http->closing = true;
+			break;
+		}
+	}
+
+	/* handle each complete request in turn (requests may be pipelined) */
+	while ( used<http->input.len && !http->closing && !http->busy )
+	{
+		char *request = http->input.data+used;
+		char *eoh = strstr(request,"\r\n\r\n");
+		size_t header_len, content_length;
+		long body_len;
+		char save;
+		if ( eoh==NULL )
+			break;
+		header_len = eoh+4-request;
 
-		/* reject anything but a GET */
-		if (stricmp(method,"GET")!=0)
+		/* wait for the body, if any */
+		*eoh = '\0';
+		body_len = http_content_length(request);
+		if ( body_len<0 )
 		{
-			http_status(http,HTTP_METHODNOTALLOWED);
-			/* technically, we should add an Allow entry to the response header */
-			output_error("request [%s %s %s]: '%s' is not an allowed method", method, uri, version, method);
-			http_send(http);
+			http_reject(http,HTTP_BADREQUEST);
+			return;
+		}
+		if ( header_len+body_len>HTTP_MAXREQUEST )
+		{
+			http_reject(http,HTTP_REQUESTENTITYTOOLARGE);
+			return;
+		}
+		content_length = (size_t)body_len;
+		if ( used+header_len+content_length>http->input.len )
+		{
+			*eoh = '\r';
 			break;
 		}
 
-		/* handle request */
-		if ( strcmp(uri,"/favicon.ico")==0 )
+		/* the body is null-terminated during processing */
+		http->body = request+header_len;
+		save = http->body[content_length];
+		http->body[content_length] = '\0';
+		if ( !http_process(http,request) )
+			http->closing = true;
+		http->body[content_length] = save;
+		http->body = NULL;
+		used += header_len+content_length;
+	}
+	if ( used>0 )
+	{
+		memmove(http->input.data,http->input.data+used,http->input.len-used);
+		http->input.len -= used;
+	}
+
+	/* a request that is still incomplete at this size never will be */
+	if ( http->input.len>HTTP_MAXREQUEST && !http->busy && !http->closing )
+	{
+		http_reject(http,HTTP_REQUESTENTITYTOOLARGE);
+		return;
+	}
+
+	/* the client has finished sending requests */
+	if ( eof )
+		http->closing = true;
+}
+
+/********************************************************
+ Worker jobs
+ */
+
+/** Request handled on a worker thread **/
+typedef struct s_httpjob {
+	HTTPCNX *http; /**< the connection the request was received on */
+	HTTPCNX *work; /**< the handle the response is written to */
+	int (*request)(HTTPCNX*,char*); /**< the request handler */
+	char uri[1024]; /**< the request argument */
+	char *success; /**< status when the handler succeeds */
+	char *failure; /**< status when the handler fails */
+	struct s_httpjob *next; /**< next finished job */
+} HTTPJOB;
+static HTTPJOB *job_done = NULL; /**< jobs finished but not yet collected by the event loop */
+static unsigned int job_lock = 0; /**< lock on the finished job list */
+
+/** Run a request handler and hand the response back to the event loop **/
+static void *http_job_run(void *arg)
+{
+	HTTPJOB *job = (HTTPJOB*)arg;
+	if ( job->request(job->work,job->uri) )
+		http_status(job->work,job->success);
+	else
+		http_status(job->work,job->failure);
+	http_send(job->work);
+	wlock(&job_lock);
+	job->next = job_done;
+	job_done = job;
+	wunlock(&job_lock);
+	if ( write(wake_pipe[1],"",1)<0 && errno!=EAGAIN )
+		output_warning("http_job_run(): unable to wake server event loop: %s", strerror(errno));
+	return NULL;
+}
+
+/** Start a worker job for a request
+	The connection reads no further requests until the job is done, so responses stay in order.
+	@returns non-zero if the connection should be kept open, 0 if it should be closed
+ **/
+static int http_job_start(HTTPCNX *http, int (*request)(HTTPCNX*,char*), char *uri, char *success, char *failure)
+{
+	pthread_t id;
+	pthread_attr_t attr;
+	HTTPJOB *job = (HTTPJOB*)malloc(sizeof(HTTPJOB));
+	if ( job!=NULL )
+	{
+		memset(job,0,sizeof(HTTPJOB));
+		job->work = http_create(http->s);
+	}
+	if ( job==NULL || job->work==NULL || job->work->buffer==NULL || strlen(uri)>=sizeof(job->uri) )
+	{
+		output_error("unable to queue request '%s' on socket %d", uri, http->s);
+		/* TROUBLESHOOT
+			The server could not allocate the memory needed to run a request for an external program,
+			or the request is too long.  Try freeing up system memory, or shorten the request.
+		 */
+		goto Failed;
+	}
+	job->http = http;
+	job->request = request;
+	strcpy(job->uri,uri);
+	job->success = success;
+	job->failure = failure;
+	job->work->queued = job->work->deferred = true;
+	job->work->keep_alive = http->keep_alive;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr,PTHREAD_CREATE_DETACHED);
+	if ( pthread_create(&id,&attr,http_job_run,(void*)job)!=0 )
+	{
+		pthread_attr_destroy(&attr);
+		output_error("unable to start worker thread for request '%s' on socket %d", uri, http->s);
+		goto Failed;
+	}
+	pthread_attr_destroy(&attr);
+	http->busy = true;
+	http_poll(http);
+	return http->keep_alive;
+
+Failed:
+	if ( job!=NULL && job->work!=NULL )
+	{
+		free(job->work->buffer);
+		free(job->work);
+	}
+	free(job);
+	http_status(http,HTTP_SERVICEUNAVAILABLE);
+	http->keep_alive = false;
+	http_send(http);
+	return 0;
+}
+
+/** Queue the responses of finished worker jobs and resume their connections **/
+static void http_job_collect(void)
+{
+	HTTPJOB *job, *next;
+	wlock(&job_lock);
+	job = job_done;
+	job_done = NULL;
+	wunlock(&job_lock);
+	for ( ; job!=NULL ; job=next )
+	{
+		HTTPCNX *http = job->http;
+		next = job->next;
+		http->busy = false;
+		if ( !http->closing )
+		{
+			if ( !httpbuf_write(&http->output,job->work->output.data,job->work->output.len) || !job->work->keep_alive )
+				http->closing = true;
+			http_poll(http);
+			http_flush(http);
+
+			/* requests that arrived while the job ran */
+			if ( !http->closing )
+				http_receive(http);
+		}
+		httpbuf_free(&job->work->output);
+		free(job->work->buffer);
+		free(job->work);
+		free(job);
+		if ( http->closing && http->output.len==0 )
+			http_destroy(http);
+	}
+}
+
+/** Move pending stream events to their connections **/
+static void http_stream_flush(void)
+{
+	HTTPSTREAM *stream;
+	wlock(&stream_lock);
+	for ( stream=stream_list ; stream!=NULL ; stream=stream->next )
+	{
+		/* only when the previous events are sent so a slow client cannot use unbounded memory */
+		if ( stream->pending.len>0 && stream->http->output.len==0 )
 		{
-			if ( http_favicon(http) )
-				http_status(http,HTTP_OK);
-			else
-				http_status(http,HTTP_NOTFOUND);
-			http_send(http);
+			httpbuf_write(&stream->http->output,stream->pending.data,stream->pending.len);
+			stream->pending.len = 0;
+		}
+	}
+	wunlock(&stream_lock);
+}
+
+/** Accept and handle connections until the server is shut down
+	Each connection may carry several requests (keep-alive), and
+	connections carrying property streams are kept open until the
+	client closes them.
+	@returns 0 on normal shutdown, the error code otherwise
+ **/
+static int server_event_loop(SOCKET listenfd)
+{
+	static int listen_tag, wake_tag;
+	struct epoll_event event, events[64];
+	HTTPCNX *http;
+	int status = 0;
+
+	epoll_fd = epoll_create(64);
+	if ( epoll_fd<0 || pipe(wake_pipe)<0 )
+	{
+		status = GetLastError();
+		output_error("server event loop startup failed: %s", strerror(status));
+		return status;
+	}
+	set_nonblocking(listenfd);
+	set_nonblocking(wake_pipe[0]);
+	set_nonblocking(wake_pipe[1]);
+	memset(&event,0,sizeof(event));
+	event.events = EPOLLIN;
+	event.data.ptr = &listen_tag;
+	epoll_ctl(epoll_fd,EPOLL_CTL_ADD,listenfd,&event);
+	event.data.ptr = &wake_tag;
+	epoll_ctl(epoll_fd,EPOLL_CTL_ADD,wake_pipe[0],&event);
+
+	while ( !shutdown_server )
+	{
+		int n, i;
+
+		/* wake up periodically to check for shutdown */
+		n = epoll_wait(epoll_fd,events,sizeof(events)/sizeof(events[0]),1000);
+		if ( n<0 )
+		{
+			if ( errno==EINTR )
+				continue;
+			status = GetLastError();
+			output_error("server event loop wait failed: %s", strerror(status));
+			break;
 		}
-		else {
-			static struct s_map {
-				char *path;
-				int (*request)(HTTPCNX*,char*);
-				char *success;
-				char *failure;
-			} map[] = {
-				/* this is the map of recognize request types */
-				{"/control/",	http_control_request,	HTTP_ACCEPTED, HTTP_NOTFOUND},
-				{"/open/",		http_open_request,		HTTP_ACCEPTED, HTTP_NOTFOUND},
-				{"/raw/",		http_raw_request,		HTTP_OK, HTTP_NOTFOUND},
-				{"/xml/",		http_xml_request,		HTTP_OK, HTTP_NOTFOUND},
-				{"/gui/",		http_gui_request,		HTTP_OK, HTTP_NOTFOUND},
-				{"/output/",	http_output_request,	HTTP_OK, HTTP_NOTFOUND},
-				{"/action/",	http_action_request,	HTTP_ACCEPTED,HTTP_NOTFOUND},
-				{"/rt/",		http_get_rt,			HTTP_OK, HTTP_NOTFOUND},
-				{"/rb/",		http_get_rb,			HTTP_OK, HTTP_NOTFOUND},
-				{"/perl/",		http_run_perl,			HTTP_OK, HTTP_NOTFOUND},
-				{"/gnuplot/",	http_run_gnuplot,		HTTP_OK, HTTP_NOTFOUND},
-				{"/java/",		http_run_java,			HTTP_OK, HTTP_NOTFOUND},
-				{"/python/",	http_run_python,		HTTP_OK, HTTP_NOTFOUND},
-				{"/r/",			http_run_r,				HTTP_OK, HTTP_NOTFOUND},
-				{"/scilab/",	http_run_scilab,		HTTP_OK, HTTP_NOTFOUND},
-				{"/octave/",	http_run_octave,		HTTP_OK, HTTP_NOTFOUND},
-				{"/kml/", 		http_kml_request,		HTTP_OK, HTTP_NOTFOUND},
-				{"/json/",		http_json_request,		HTTP_OK, HTTP_NOTFOUND},
-			};
-			int n;
-			for ( n=0 ; n<sizeof(map)/sizeof(map[0]) ; n++ )
+		for ( i=0 ; i<n && !shutdown_server ; i++ )
+		{
+			if ( events[i].data.ptr==&listen_tag )
 			{
-				size_t len = strlen(map[n].path);
-				if (strncmp(uri,map[n].path,len)==0)
+				/* accept all pending connections */
+				for (;;)
 				{
-					if ( map[n].request(http,uri+len) )
-						http_status(http,map[n].success);
-					else
-						http_status(http,map[n].failure);
-					http_send(http);
-
-					/* keep-alive not desired*/
-					if (connection && stricmp(connection,"close")==0)
+					struct sockaddr_in cli_addr;
+					socklen_t clilen = sizeof(cli_addr);
+					SOCKET newsockfd = accept(listenfd,(struct sockaddr *)&cli_addr,&clilen);
+					char *saddr;
+					if ( (int)newsockfd<0 )
+					{
+						if ( errno!=EAGAIN && errno!=EWOULDBLOCK && errno!=EINTR && !shutdown_server )
+							output_error("server accept error on fd=%d: code %d", listenfd, GetLastError());
 						break;
-					else
+					}
+					saddr = inet_ntoa(cli_addr.sin_addr);
+					if ( !client_allowed(saddr) )
+					{
+						output_error("denying connection from %s on port %d",saddr, cli_addr.sin_port);
+						close(newsockfd);
 						continue;
+					}
+					output_verbose("accepting connection from %s on port %d",saddr, cli_addr.sin_port);
+					http = http_create(newsockfd);
+					http->queued = true;
+					set_nonblocking(newsockfd);
+					event.events = EPOLLIN;
+					event.data.ptr = http;
+					if ( epoll_ctl(epoll_fd,EPOLL_CTL_ADD,newsockfd,&event)<0 )
+					{
+						output_error("unable to add connection from %s to server event loop", saddr);
+						close(newsockfd);
+						free(http->buffer);
+						free(http);
+						continue;
+					}
+					http->next = http_list;
+					http_list = http;
+					gui_wait_status(0);
 				}
 			}
-			break;
+			else if ( events[i].data.ptr==&wake_tag )
+			{
+				/* worker jobs are done or stream events are pending */
+				char buffer[256];
+				while ( read(wake_pipe[0],buffer,sizeof(buffer))>0 );
+				http_job_collect();
+				http_stream_flush();
+				for ( http=http_list ; http!=NULL ; http=http->next )
+				{
+					if ( http->stream!=NULL && http->output.len>0 )
+						http_flush(http);
+				}
+			}
+			else
+			{
+				http = (HTTPCNX*)events[i].data.ptr;
+				if ( events[i].events&(EPOLLERR|EPOLLHUP) )
+					http->closing = true;
+				else
+				{
+					if ( events[i].events&EPOLLIN )
+						http_receive(http);
+					if ( events[i].events&EPOLLOUT )
+					{
+						http_flush(http);
+						if ( http->stream!=NULL && http->output.len==0 )
+						{
+							http_stream_flush();
+							http_flush(http);
+						}
+					}
+				}
+				if ( http->closing && http->busy )
+					epoll_ctl(epoll_fd,EPOLL_CTL_DEL,http->s,NULL); /* its worker job destroys it when done */
+				else if ( http->closing && (http->output.len==0 || (events[i].events&(EPOLLERR|EPOLLHUP))) )
+					http_destroy(http);
+			}
 		}
+	}
 
+	/* close remaining connections */
+	while ( http_list!=NULL )
+	{
+		http = http_list;
+		http_list = http->next;
+		http_stream_close(http);
+		close(http->s);
+		httpbuf_free(&http->input);
+		httpbuf_free(&http->output);
+		free(http->buffer);
+		free(http);
 	}
-	http_close(http);
-	output_verbose("socket %d closed",http->s);
-	return 0;
+	close(epoll_fd);
+	epoll_fd = -1;
+	return status;
 }
-
-
+#endif
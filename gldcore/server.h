@@ -16,5 +16,6 @@ int filelength(int fd);
 
 STATUS server_startup(int argc, char *argv[]);
 STATUS server_join(void);
+void server_stream_commit(TIMESTAMP t);
 
 #endif
@@ -0,0 +1,548 @@
+/** $Id$
+	Copyright (C) 2008 Battelle Memorial Institute
+	@file statistics.c
+	@addtogroup statwindow
+	@ingroup core
+
+	Streaming statistics windows.
+
+	Bounded windows keep their samples in a ring of slots so the oldest
+	sample can be taken out of the running sums when it is replaced.  The
+	sums are of the deviations from a reference value and of their squares,
+	and they are compensated (Neumaier) so adding and removing samples does
+	not accumulate round-off.  The reference value is moved to the mean once
+	per window length, which keeps the variance free of cancellation.
+
+	The minimum and maximum use monotonic deques of slots: the deque of the
+	maximum holds slots whose values decrease from the oldest to the newest,
+	so its oldest slot always holds the largest sample.  A new sample
+	removes the newer slots it dominates, and the slot being replaced
+	leaves the deque when it is the oldest.
+
+	Unbounded windows keep the quantile estimate with the P-square
+	algorithm of Jain and Chlamtac (Comm. ACM 28(10), 1985).
+ @{
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "globals.h"
+#include "output.h"
+#include "statistics.h"
+
+/* add a sample to the running mean and variance of an unbounded window */
+static void welford_add(STATWINDOW *w, double x)
+{
+	double d = x - w->mean;
+	w->count++;
+	w->mean += d/w->count;
+	w->m2 += d*(x - w->mean);
+}
+
+/* add a value to a compensated sum */
+static void sum_add(double *sum, double *c, double x)
+{
+	double t = *sum + x;
+	if ( fabs(*sum)>=fabs(x) )
+		*c += (*sum - t) + x;
+	else
+		*c += (x - t) + *sum;
+	*sum = t;
+}
+
+/* add (sign=1) or remove (sign=-1) a sample of a bounded window */
+static void window_update(STATWINDOW *w, double x, int sign)
+{
+	double d = x - w->shift;
+	sum_add(&w->s, &w->sc, sign*d);
+	sum_add(&w->ss, &w->ssc, sign*d*d);
+	if ( sign>0 )
+		w->count++;
+	else
+		w->count--;
+}
+
+/* move the reference value of a bounded window to the mean and recalculate the sums */
+static void window_resync(STATWINDOW *w)
+{
+	unsigned int i, slot, first = (w->head + w->size - w->used) % w->size;
+	double sum = 0.0;
+	w->resync = w->size;
+	if ( w->count==0 )
+		return;
+	for ( i=0 ; i<w->used ; i++ )
+	{
+		slot = (first + i) % w->size;
+		if ( w->valid[slot] )
+			sum += w->value[slot];
+	}
+	w->shift = sum/w->count;
+	w->s = w->sc = w->ss = w->ssc = 0.0;
+	for ( i=0 ; i<w->used ; i++ )
+	{
+		slot = (first + i) % w->size;
+		if ( w->valid[slot] )
+		{
+			double d = w->value[slot] - w->shift;
+			sum_add(&w->s, &w->sc, d);
+			sum_add(&w->ss, &w->ssc, d*d);
+		}
+	}
+}
+
+/* free the slot at the head of a bounded window for the next sample */
+static void window_advance(STATWINDOW *w)
+{
+	unsigned int slot = w->head;
+	if ( w->used==w->size )
+	{
+		if ( w->valid[slot] )
+			window_update(w,w->value[slot],-1);
+		if ( w->minq.n>0 && w->minq.slot[w->minq.first]==slot )
+		{
+			w->minq.first = (w->minq.first+1) % w->size;
+			w->minq.n--;
+		}
+		if ( w->maxq.n>0 && w->maxq.slot[w->maxq.first]==slot )
+		{
+			w->maxq.first = (w->maxq.first+1) % w->size;
+			w->maxq.n--;
+		}
+	}
+	else
+		w->used++;
+}
+
+/* finish a sample or skip at the head of a bounded window */
+static void window_commit(STATWINDOW *w)
+{
+	w->head = (w->head+1) % w->size;
+	if ( --w->resync==0 )
+		window_resync(w);
+}
+
+/* update the P-square markers with a new sample (the first five are kept sorted) */
+static void quantile_add(STATWINDOW *w, double x)
+{
+	int i, k;
+	if ( w->count<=5 )
+	{
+		/* count already includes x */
+		for ( i=w->count-1 ; i>0 && w->q[i-1]>x ; i-- )
+			w->q[i] = w->q[i-1];
+		w->q[i] = x;
+		if ( w->count==5 )
+		{
+			for ( i=0 ; i<5 ; i++ )
+				w->n[i] = i;
+			w->np[0] = 0; w->np[1] = 2*w->p; w->np[2] = 4*w->p; w->np[3] = 2+2*w->p; w->np[4] = 4;
+			w->dn[0] = 0; w->dn[1] = w->p/2; w->dn[2] = w->p; w->dn[3] = (1+w->p)/2; w->dn[4] = 1;
+		}
+		return;
+	}
+
+	/* find the cell of the sample and adjust the extreme markers */
+	if ( x<w->q[0] )
+	{
+		w->q[0] = x;
+		k = 0;
+	}
+	else if ( x>=w->q[4] )
+	{
+		w->q[4] = x;
+		k = 3;
+	}
+	else
+		for ( k=0 ; k<3 && x>=w->q[k+1] ; k++ ) {}
+	for ( i=k+1 ; i<5 ; i++ )
+		w->n[i]++;
+	for ( i=0 ; i<5 ; i++ )
+		w->np[i] += w->dn[i];
+
+	/* move the middle markers toward their desired positions */
+	for ( i=1 ; i<4 ; i++ )
+	{
+		double d = w->np[i] - w->n[i];
+		if ( (d>=1 && w->n[i+1]-w->n[i]>1) || (d<=-1 && w->n[i-1]-w->n[i]<-1) )
+		{
+			int s = d<0 ? -1 : 1;
+			double q = w->q[i] + (double)s/(w->n[i+1]-w->n[i-1])
+				* ((w->n[i]-w->n[i-1]+s)*(w->q[i+1]-w->q[i])/(w->n[i+1]-w->n[i])
+				+ (w->n[i+1]-w->n[i]-s)*(w->q[i]-w->q[i-1])/(w->n[i]-w->n[i-1]));
+			if ( w->q[i-1]<q && q<w->q[i+1] )
+				w->q[i] = q; /* parabolic */
+			else
+				w->q[i] += s*(w->q[i+s]-w->q[i])/(w->n[i+s]-w->n[i]); /* linear */
+			w->n[i] += s;
+		}
+	}
+}
+
+/* get the quantile of an unbounded window */
+static double quantile_get(STATWINDOW *w)
+{
+	if ( w->count==0 )
+		return 0.0;
+	else if ( w->count<=5 )
+	{
+		/* exact: interpolate between the nearest ranks */
+		double r = w->p*(w->count-1);
+		int i = (int)floor(r);
+		if ( i+1<(int)w->count )
+			return w->q[i] + (r-i)*(w->q[i+1]-w->q[i]);
+		else
+			return w->q[i];
+	}
+	else
+		return w->q[2];
+}
+
+/* get the variance of a window with samples */
+static double variance(STATWINDOW *w)
+{
+	if ( w->size==0 )
+		return w->m2/w->count;
+	else
+	{
+		double s = w->s + w->sc;
+		double v = ((w->ss + w->ssc) - s*s/w->count)/w->count;
+		return v>0 ? v : 0.0;
+	}
+}
+
+/** Create a statistics window
+	@returns the new window, or NULL on failure
+ **/
+STATWINDOW *statwindow_create(unsigned int size, /**< number of samples in the window (0 to accumulate until reset) */
+							  unsigned int options, /**< #STATWINDOWOPTIONS */
+							  double quantile) /**< quantile to estimate, if #SWO_QUANTILE is set (e.g., 0.5 for the median) */
+{
+	STATWINDOW *w;
+	if ( size>0 && (options&SWO_QUANTILE) )
+	{
+		output_error("statwindow_create(size=%u): quantiles are only supported for unbounded windows", size);
+		/* TROUBLESHOOT
+			The quantile estimate cannot take samples back out, so it can only be used by windows that
+			accumulate all their samples until they are reset, i.e., windows of size 0.
+		 */
+		return NULL;
+	}
+	if ( (options&SWO_QUANTILE) && (quantile<=0 || quantile>=1) )
+	{
+		output_error("statwindow_create(quantile=%g): quantile must be between 0 and 1", quantile);
+		/* TROUBLESHOOT
+			The quantile of a statistics window must be strictly between 0 and 1, e.g., 0.5 for the median.
+		 */
+		return NULL;
+	}
+	w = (STATWINDOW*)malloc(sizeof(STATWINDOW));
+	if ( w==NULL )
+		return NULL;
+	memset(w,0,sizeof(STATWINDOW));
+	w->size = size;
+	w->options = options;
+	w->p = quantile;
+	if ( size>0 )
+	{
+		w->value = (double*)malloc(sizeof(double)*size);
+		w->valid = (unsigned char*)malloc(size);
+		if ( options&SWO_MINMAX )
+		{
+			w->minq.slot = (unsigned int*)malloc(sizeof(unsigned int)*size);
+			w->maxq.slot = (unsigned int*)malloc(sizeof(unsigned int)*size);
+		}
+		if ( w->value==NULL || w->valid==NULL || ((options&SWO_MINMAX) && (w->minq.slot==NULL || w->maxq.slot==NULL)) )
+		{
+			output_error("statwindow_create(size=%u): memory allocation failed", size);
+			statwindow_destroy(w);
+			return NULL;
+		}
+	}
+	statwindow_reset(w);
+	return w;
+}
+
+/** Destroy a statistics window
+ **/
+void statwindow_destroy(STATWINDOW *w)
+{
+	if ( w==NULL )
+		return;
+	free(w->value);
+	free(w->valid);
+	free(w->minq.slot);
+	free(w->maxq.slot);
+	free(w);
+}
+
+/** Remove all the samples from a statistics window
+ **/
+void statwindow_reset(STATWINDOW *w)
+{
+	w->count = 0;
+	w->mean = w->m2 = 0.0;
+	w->shift = w->s = w->sc = w->ss = w->ssc = 0.0;
+	w->head = w->used = 0;
+	w->resync = w->size;
+	w->minq.first = w->minq.n = 0;
+	w->maxq.first = w->maxq.n = 0;
+	w->sum = w->min = w->max = 0.0;
+}
+
+/** Add a sample to a statistics window
+ **/
+void statwindow_add(STATWINDOW *w, double x)
+{
+	if ( w->size==0 )
+	{
+		if ( w->count==0 || x<w->min ) w->min = x;
+		if ( w->count==0 || x>w->max ) w->max = x;
+		w->sum += x;
+		welford_add(w,x);
+		if ( w->options&SWO_QUANTILE )
+			quantile_add(w,x);
+		return;
+	}
+
+	window_advance(w);
+	w->value[w->head] = x;
+	w->valid[w->head] = 1;
+	if ( w->count==0 )
+		w->shift = x;
+	window_update(w,x,1);
+	if ( w->options&SWO_MINMAX )
+	{
+		/* drop the newer slots the sample dominates and append it */
+		while ( w->minq.n>0 && w->value[w->minq.slot[(w->minq.first+w->minq.n-1)%w->size]]>=x )
+			w->minq.n--;
+		w->minq.slot[(w->minq.first+w->minq.n++)%w->size] = w->head;
+		while ( w->maxq.n>0 && w->value[w->maxq.slot[(w->maxq.first+w->maxq.n-1)%w->size]]<=x )
+			w->maxq.n--;
+		w->maxq.slot[(w->maxq.first+w->maxq.n++)%w->size] = w->head;
+	}
+	window_commit(w);
+}
+
+/** Skip a slot of a statistics window
+	The skipped slot takes the place of a sample in a bounded window
+	but it is not counted in the statistics.  Unbounded windows ignore skips.
+ **/
+void statwindow_skip(STATWINDOW *w)
+{
+	if ( w->size==0 )
+		return;
+	window_advance(w);
+	w->valid[w->head] = 0;
+	window_commit(w);
+}
+
+/** Get a statistic from a statistics window
+	@returns the value, or 0 if the window has no samples
+ **/
+double statwindow_get(STATWINDOW *w, STATWINDOWVALUE which)
+{
+	if ( which==SWV_COUNT )
+		return (double)w->count;
+	if ( w->count==0 )
+		return 0.0;
+	switch ( which ) {
+	case SWV_SUM:
+		return w->size==0 ? w->sum : w->shift*w->count + (w->s+w->sc);
+	case SWV_MEAN:
+		return w->size==0 ? w->sum/w->count : w->shift + (w->s+w->sc)/w->count;
+	case SWV_VARIANCE:
+		return variance(w);
+	case SWV_STDEV:
+		return sqrt(variance(w));
+	case SWV_MIN:
+		if ( w->size==0 )
+			return w->min;
+		return (w->options&SWO_MINMAX) ? w->value[w->minq.slot[w->minq.first]] : 0.0;
+	case SWV_MAX:
+		if ( w->size==0 )
+			return w->max;
+		return (w->options&SWO_MINMAX) ? w->value[w->maxq.slot[w->maxq.first]] : 0.0;
+	case SWV_QUANTILE:
+		return (w->options&SWO_QUANTILE) ? quantile_get(w) : 0.0;
+	default:
+		return 0.0;
+	}
+}
+
+/* deterministic sample stream for the tests (the core random generator is seeded by the model) */
+static double test_sample(unsigned int *state)
+{
+	*state = *state*1103515245 + 12345;
+	return (double)((*state>>8)&0xffff)/65536.0;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+	double x = *(const double*)a, y = *(const double*)b;
+	return x<y ? -1 : (x>y ? 1 : 0);
+}
+
+/* exact quantile of sorted samples, interpolated between the nearest ranks */
+static double test_quantile(double *sorted, unsigned int n, double p)
+{
+	double r = p*(n-1);
+	unsigned int i = (unsigned int)floor(r);
+	return i+1<n ? sorted[i] + (r-i)*(sorted[i+1]-sorted[i]) : sorted[i];
+}
+
+/* compare a window statistic with its exact value */
+static int test_check(const char *name, unsigned int n, double value, double expected, double precision)
+{
+	if ( fabs(value-expected)>precision*(1+fabs(expected)) )
+	{
+		output_test("FAILED: %s after %u samples is %.12g, expected %.12g", name, n, value, expected);
+		return 1;
+	}
+	return 0;
+}
+
+/** Test the statistics windows against values computed from the samples
+	@returns the number of failed checks
+ **/
+int statwindow_test(void)
+{
+	unsigned int sizes[] = {1, 7, 100};
+	double quantiles[] = {0.5, 0.1, 0.9};
+	unsigned int state = 38, s, k, n;
+	int failed = 0, succeeded = 0;
+	double *sample = (double*)malloc(sizeof(double)*10000);
+	double *sorted = (double*)malloc(sizeof(double)*10000);
+	unsigned char *skipped = (unsigned char*)malloc(10000);
+
+	output_test("BEGIN: statistics window tests");
+	if ( sample==NULL || sorted==NULL || skipped==NULL )
+	{
+		output_test("FAILED: memory allocation failed");
+		free(sample); free(sorted); free(skipped);
+		return 1;
+	}
+
+	/* bounded windows: every statistic after every sample, with skipped slots and an offset that defeats naive sums */
+	for ( s=0 ; s<sizeof(sizes)/sizeof(sizes[0]) ; s++ )
+	{
+		STATWINDOW *w = statwindow_create(sizes[s],SWO_MINMAX,0);
+		if ( w==NULL )
+		{
+			output_test("FAILED: unable to create a window of size %u", sizes[s]);
+			failed++;
+			continue;
+		}
+		for ( n=0 ; n<1000 ; n++ )
+		{
+			unsigned int first = n+1>sizes[s] ? n+1-sizes[s] : 0, count = 0;
+			double sum = 0, ss = 0, min = 0, max = 0, mean;
+			int bad = 0;
+			sample[n] = 1e6 + 100*test_sample(&state);
+			skipped[n] = (n%13==5);
+			if ( skipped[n] )
+				statwindow_skip(w);
+			else
+				statwindow_add(w,sample[n]);
+			for ( k=first ; k<=n ; k++ )
+			{
+				if ( skipped[k] )
+					continue;
+				if ( count==0 || sample[k]<min ) min = sample[k];
+				if ( count==0 || sample[k]>max ) max = sample[k];
+				sum += sample[k];
+				count++;
+			}
+			mean = count>0 ? sum/count : 0;
+			for ( k=first ; k<=n ; k++ )
+				if ( !skipped[k] )
+					ss += (sample[k]-mean)*(sample[k]-mean);
+			bad += test_check("bounded count",n+1,statwindow_get(w,SWV_COUNT),count,0);
+			if ( count>0 )
+			{
+				bad += test_check("bounded min",n+1,statwindow_get(w,SWV_MIN),min,0);
+				bad += test_check("bounded max",n+1,statwindow_get(w,SWV_MAX),max,0);
+				bad += test_check("bounded mean",n+1,statwindow_get(w,SWV_MEAN),mean,1e-12);
+				bad += test_check("bounded variance",n+1,statwindow_get(w,SWV_VARIANCE),ss/count,1e-6);
+			}
+			if ( bad>0 )
+			{
+				output_test("FAILED: window of size %u", sizes[s]);
+				failed++;
+				break;
+			}
+			succeeded++;
+		}
+		statwindow_destroy(w);
+	}
+
+	/* unbounded windows: exact values, exact quantiles up to five samples and estimates after that */
+	for ( s=0 ; s<sizeof(quantiles)/sizeof(quantiles[0]) ; s++ )
+	{
+		STATWINDOW *w = statwindow_create(0,SWO_QUANTILE,quantiles[s]);
+		double sum = 0, min = 0, max = 0, mean, ss = 0;
+		int bad = 0;
+		if ( w==NULL )
+		{
+			output_test("FAILED: unable to create an unbounded window for quantile %g", quantiles[s]);
+			failed++;
+			continue;
+		}
+		for ( n=0 ; n<10000 ; n++ )
+		{
+			sample[n] = test_sample(&state);
+			statwindow_add(w,sample[n]);
+			sum += sample[n];
+			if ( n==0 || sample[n]<min ) min = sample[n];
+			if ( n==0 || sample[n]>max ) max = sample[n];
+			if ( n<5 )
+			{
+				memcpy(sorted,sample,sizeof(double)*(n+1));
+				qsort(sorted,n+1,sizeof(double),compare_double);
+				bad += test_check("exact quantile",n+1,statwindow_get(w,SWV_QUANTILE),test_quantile(sorted,n+1,quantiles[s]),1e-12);
+			}
+		}
+		mean = sum/n;
+		for ( k=0 ; k<n ; k++ )
+			ss += (sample[k]-mean)*(sample[k]-mean);
+		memcpy(sorted,sample,sizeof(double)*n);
+		qsort(sorted,n,sizeof(double),compare_double);
+		bad += test_check("unbounded count",n,statwindow_get(w,SWV_COUNT),n,0);
+		bad += test_check("unbounded min",n,statwindow_get(w,SWV_MIN),min,0);
+		bad += test_check("unbounded max",n,statwindow_get(w,SWV_MAX),max,0);
+		bad += test_check("unbounded sum",n,statwindow_get(w,SWV_SUM),sum,0);
+		bad += test_check("unbounded mean",n,statwindow_get(w,SWV_MEAN),mean,0);
+		bad += test_check("unbounded variance",n,statwindow_get(w,SWV_VARIANCE),ss/n,1e-12);
+		/* the samples are uniform on [0,1), so the estimate error is a fraction of the range */
+		bad += test_check("quantile estimate",n,statwindow_get(w,SWV_QUANTILE),test_quantile(sorted,n,quantiles[s]),0.01);
+		statwindow_reset(w);
+		bad += test_check("reset count",0,statwindow_get(w,SWV_COUNT),0,0);
+		statwindow_destroy(w);
+		if ( bad>0 )
+		{
+			output_test("FAILED: unbounded window for quantile %g", quantiles[s]);
+			failed++;
+		}
+		else
+			succeeded++;
+	}
+
+	/* quantiles are refused for bounded windows */
+	if ( statwindow_create(10,SWO_QUANTILE,0.5)!=NULL )
+	{
+		output_test("FAILED: bounded window accepted a quantile");
+		failed++;
+	}
+	else
+		succeeded++;
+
+	free(sample);
+	free(sorted);
+	free(skipped);
+	output_test("END: statistics window tests, %d succeeded, %d failed", succeeded, failed);
+	output_verbose("statistics window tests: %d succeeded, %d failed (see '%s' for details)", succeeded, failed, global_testoutputfile);
+	return failed;
+}
+
+/**@}**/
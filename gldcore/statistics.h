@@ -0,0 +1,107 @@
+/** $Id$
+    Copyright (C) 2008 Battelle Memorial Institute
+
+@file statistics.h
+@addtogroup statwindow Streaming statistics
+@ingroup core
+
+Statistics windows (#STATWINDOW) compute running statistics over a stream
+of samples without keeping the whole stream.  Each sample is added in
+O(1) amortized time.
+
+A window with a non-zero size holds the most recent samples only.  When the
+window is full each new sample pushes the oldest one out.  The window keeps
+
+* the count, mean and variance of its samples, kept as compensated sums
+  that are recalculated once per window length, and
+* the minimum and maximum, using monotonic deques of the window slots, if
+  #SWO_MINMAX is set.
+
+A slot can be skipped (#statwindow_skip) to keep the window aligned with
+the sample clock when a sample is not to be counted.
+
+A window with zero size accumulates all samples until it is reset.  It
+keeps the count, mean, variance, minimum and maximum in a few scalars and
+can also estimate a quantile with the P-square algorithm (#SWO_QUANTILE),
+which uses five markers instead of the samples.  The estimate is exact
+until the sixth sample.
+
+The mean of an unbounded window is its sum divided by its count, so it
+matches a mean computed over a buffer of the same samples.  The variance
+is the population variance, i.e., the sum of squared deviations divided by
+the number of samples.
+
+@{**/
+
+#ifndef _STATISTICS_H
+#define _STATISTICS_H
+
+/** Statistics window options **/
+typedef enum {
+	SWO_NONE		= 0x00, /**< count, sum, mean and variance only */
+	SWO_MINMAX		= 0x01, /**< track the minimum and maximum (unbounded windows always do) */
+	SWO_QUANTILE	= 0x02, /**< estimate a quantile (unbounded windows only) */
+} STATWINDOWOPTIONS;
+
+/** Statistics window values **/
+typedef enum {
+	SWV_COUNT		= 0, /**< number of samples in the window */
+	SWV_SUM			= 1, /**< sum of the samples */
+	SWV_MEAN		= 2, /**< mean of the samples */
+	SWV_VARIANCE	= 3, /**< population variance of the samples */
+	SWV_STDEV		= 4, /**< population standard deviation of the samples */
+	SWV_MIN			= 5, /**< smallest sample (bounded windows require #SWO_MINMAX) */
+	SWV_MAX			= 6, /**< largest sample (bounded windows require #SWO_MINMAX) */
+	SWV_QUANTILE	= 7, /**< quantile estimate (requires #SWO_QUANTILE) */
+} STATWINDOWVALUE;
+
+/** Statistics window **/
+typedef struct s_statwindow {
+	unsigned int size;		/**< number of slots in the window (0 for unbounded) */
+	unsigned int options;	/**< #STATWINDOWOPTIONS */
+	unsigned int count;		/**< number of samples in the window */
+	/* bounded windows */
+	double *value;			/**< slot values */
+	unsigned char *valid;	/**< slot holds a sample (0 if skipped) */
+	unsigned int head;		/**< slot of the next sample */
+	unsigned int used;		/**< number of slots used so far */
+	unsigned int resync;	/**< slots left until the sums are recalculated */
+	double shift;			/**< reference value of the sums (the mean at the last recalculation) */
+	double s, sc;			/**< sum of the deviations from the reference value, and its compensation */
+	double ss, ssc;		/**< sum of the squared deviations, and its compensation */
+	struct {
+		unsigned int *slot;	/**< slots in the deque, oldest first */
+		unsigned int first;	/**< position of the oldest slot */
+		unsigned int n;		/**< number of slots in the deque */
+	} minq, maxq;			/**< monotonic deques for the minimum and maximum */
+	/* unbounded windows */
+	double sum;				/**< sum of the samples */
+	double mean;			/**< running mean (Welford) */
+	double m2;				/**< running sum of squared deviations from the mean */
+	double min, max;		/**< smallest and largest samples */
+	double p;				/**< quantile to estimate */
+	double q[5];			/**< P-square marker heights */
+	double np[5];			/**< P-square desired marker positions */
+	double dn[5];			/**< P-square desired position increments */
+	int n[5];				/**< P-square marker positions */
+} STATWINDOW; /**< statistics window */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+STATWINDOW *statwindow_create(unsigned int size, unsigned int options, double quantile);
+void statwindow_destroy(STATWINDOW *window);
+void statwindow_reset(STATWINDOW *window);
+void statwindow_add(STATWINDOW *window, double value);
+void statwindow_skip(STATWINDOW *window);
+double statwindow_get(STATWINDOW *window, STATWINDOWVALUE which);
+int statwindow_test(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/**@}**/
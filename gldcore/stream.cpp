@@ -2,6 +2,13 @@
  *
  */
 
+#include <errno.h>
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 #include "output.h"
 #include "stream.h"
 #include "module.h"
@@ -51,6 +58,50 @@ extern "C" {
 /* stream handle */
 static FILE *fp = NULL;
 
+/* raw output descriptor (used instead of fp by stream_fd) */
+static int fd = -1;
+static char fd_buffer[65536];
+static size_t fd_used = 0;
+
+/* write raw output without stdio or heap allocation */
+static int stream_fd_flush(void)
+{
+	size_t done = 0;
+	while ( done<fd_used )
+	{
+		int n = write(fd,fd_buffer+done,(unsigned int)(fd_used-done));
+		if ( n<0 && errno==EINTR ) continue;
+		if ( n<=0 ) return 0;
+		done += n;
+	}
+	fd_used = 0;
+	return 1;
+}
+
+/* write output to the stream handle
+	@returns number of bytes written
+ */
+static size_t stream_write(const void *ptr, size_t len)
+{
+	if ( fd<0 )
+		return fwrite(ptr,1,len,fp);
+
+	const char *p = (const char*)ptr;
+	size_t left = len;
+	while ( left>0 )
+	{
+		size_t n = sizeof(fd_buffer)-fd_used;
+		if ( n>left ) n = left;
+		memcpy(fd_buffer+fd_used,p,n);
+		fd_used += n;
+		p += n;
+		left -= n;
+		if ( fd_used==sizeof(fd_buffer) && !stream_fd_flush() )
+			return len-left-n;
+	}
+	return len;
+}
+
 /* stream size */
 static size_t count=0;
 
@@ -312,29 +363,30 @@ size_t stream(void *ptr, ///< pointer to buffer
 	{
 #ifdef _DEBUG
 		if ( is_str ) len = strlen((char*)ptr);
-		unsigned int a = fprintf(fp,"%d ",len);
-		if ( a<0 ) throw;
+		char code[32];
+		size_t a = sprintf(code,"%d ",len);
+		if ( stream_write(code,a)!=a ) throw;
 		unsigned int i;
 		for ( i=0 ; i<len ; i++ )
 		{
 			int c = ((unsigned char*)ptr)[i];
 			size_t b=1;
 			if ( !is_str || c<32 || c>126 || c=='\\' )
-				b = fprintf(fp,"\\%02x",c);
-			else if ( fputc(c,fp)==EOF ) b=-1;
-			if ( b==-1 ) throw;
+				b = sprintf(code,"\\%02x",c);
+			else
+				code[0] = (char)c;
+			if ( stream_write(code,b)!=b ) throw;
 			a+=b;
 		}
-		unsigned int b = fprintf(fp,"\n");
-		if ( b<0 ) throw;
-		a+=b;
+		if ( stream_write("\n",1)!=1 ) throw;
+		a+=1;
 		stream_pos += a;
 		return a;
 #else
 		if ( is_str ) len = strlen((char*)ptr);
-		size_t a = fwrite((void*)&len,1,sizeof(len),fp);
+		size_t a = stream_write((void*)&len,sizeof(len));
 		if ( a!=sizeof(len) ) throw;
-		size_t b = fwrite((void*)ptr,1,len,fp);
+		size_t b = stream_write((void*)ptr,len);
 		if ( b!=len ) throw;
 		a+=b;
 		stream_pos += a;
@@ -475,18 +527,20 @@ void stream(OBJECT *obj)
 		char oname[64]; if ( obj ) strcpy(oname,obj->name?obj->name:"");
 		stream(oname,sizeof(oname));
 
-		OBJECT *data=(OBJECT*)malloc(size); if ( obj ) memcpy(data,obj,size);
-		stream(data,size);
-
 		// TODO forecast and namespace
 
 		if ( flags&SF_OUT ) 
 		{
+			// written straight from the object (no allocation, which also keeps forked checkpoint writers safe)
+			stream(obj,size);
 			obj = obj->next;
-			free(data);
 		}
 		else if ( flags&SF_IN ) 
+		{
+			OBJECT *data=(OBJECT*)malloc(size);
+			stream(data,size);
 			object_stream_fixup(data,cname,oname);
+		}
 	}
 	stream("/OBJ");
 }
@@ -514,35 +568,41 @@ void stream(GLOBALVAR *var)
 	stream("/VAR");
 }
 
-size_t stream(FILE *fileptr,int opts)
+// complete stream
+static void stream_all(void)
 {
-	stream_pos = 0;
-	fp = fileptr;
-	flags = opts;
-	output_debug("starting stream on file %d with options %x", fileno(fp), flags);
-	try {
+	// header
+	stream("GLD30");
 
-		// header
-		stream("GLD30");
+	// runtime classes
+	try { stream(class_get_first_runtime()); } catch (int) {};
 
-		// runtime classes
-		try { stream(class_get_first_runtime()); } catch (int) {};
+	// modules
+	try { stream(module_get_first()); } catch (int) {}
 
-		// modules
-		try { stream(module_get_first()); } catch (int) {}
+	// objects
+	try { stream(object_get_first()); } catch (int) {};
 
-		// objects
-		try { stream(object_get_first()); } catch (int) {};
+	// globals
+	try { stream(global_getnext(NULL)); } catch (int) {};
 
-		// globals
-		try { stream(global_getnext(NULL)); } catch (int) {};
+	// module data
+	struct s_stream *s;
+	for ( s=stream_list ; s!=NULL ; s=s->next )
+	{	
+		s->call((int)flags,(STREAMCALLBACK)stream_callback);
+	}
+}
 
-		// module data
-		struct s_stream *s;
-		for ( s=stream_list ; s!=NULL ; s=s->next )
-		{	
-			s->call((int)flags,(STREAMCALLBACK)stream_callback);
-		}
+size_t stream(FILE *fileptr,int opts)
+{
+	stream_pos = 0;
+	fp = fileptr;
+	fd = -1;
+	flags = opts;
+	output_debug("starting stream on file %d with options %x", fileno(fp), flags);
+	try {
+		stream_all();
 		output_debug("done processing stream on file %d with options %x", fileno(fp), flags);
 		return stream_pos;
 	}
@@ -558,6 +618,35 @@ size_t stream(FILE *fileptr,int opts)
 	}
 }
 
+/** Write a stream to an open file descriptor
+
+	Unlike stream(FILE*,int), this uses neither stdio nor the heap and reports nothing, so
+	it is safe to call in a process forked from a multithreaded one, where another thread
+	may have held a stdio or allocator lock at the time of the fork.
+	@returns Bytes written, or -1 on failure
+ **/
+size_t stream_fd(int fildes,int opts)
+{
+	if ( (opts&SF_IN) || fildes<0 )
+		return -1;
+	stream_pos = 0;
+	fp = NULL;
+	fd = fildes;
+	fd_used = 0;
+	flags = opts;
+	try {
+		stream_all();
+	}
+	catch (...)
+	{
+		fd = -1;
+		return -1;
+	}
+	size_t result = stream_fd_flush() ? stream_pos : -1;
+	fd = -1;
+	return result;
+}
+
 #define stream_type(T) extern "C" size_t stream_##T(void *ptr, size_t len, PROPERTY *prop) { return stream((T*)ptr,len); }
 #include "stream_type.h"
 #undef stream_type
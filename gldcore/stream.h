@@ -34,6 +34,7 @@ typedef size_t (*STREAMCALLBACK)(void*,size_t,bool,void*);
 typedef size_t (*STREAMCALL)(int flags,STREAMCALLBACK call);
 void stream_register(STREAMCALL);
 size_t stream(FILE *fp, int flags);
+size_t stream_fd(int fd, int flags);
 char* stream_context();
 #endif
 
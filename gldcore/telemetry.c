@@ -0,0 +1,461 @@
+/* $Id$
+   Copyright (C) 2012 Battelle Memorial Institute
+	@file telemetry.c
+	@addtogroup telemetry
+	@ingroup core
+
+	Writer for the telemetry ring.  The published values are resolved to
+	addresses once when the simulation starts, so each commit only copies
+	the values into the next record of the memory-mapped ring.
+ @{
+ **/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/mman.h>
+#endif
+
+#include "platform.h"
+#include "globals.h"
+#include "output.h"
+#include "object.h"
+#include "class.h"
+#include "convert.h"
+#include "exception.h"
+#include "telemetry.h"
+
+#if defined(WIN32) && !defined(__MINGW32__)
+#define telemetry_barrier() MemoryBarrier()
+#else
+#define telemetry_barrier() __sync_synchronize()
+#endif
+
+/** A value published in the telemetry ring **/
+typedef struct s_telemetryitem {
+	void *addr; /**< the address of the value */
+	PROPERTYTYPE type; /**< the type of the value */
+} TELEMETRYITEM;
+
+static TELEMETRYITEM *item_list = NULL; /**< the published values */
+static char *name_list = NULL; /**< the names of the published values */
+static unsigned int n_items = 0, max_items = 0;
+static TELEMETRY_HEADER *header = NULL; /**< the mapped telemetry file */
+static size_t map_size = 0;
+static int map_fd = -1;
+
+/** Add a value to the list of published values
+	@returns non-zero on success, 0 on failure
+ **/
+static int telemetry_add_item(char *name, void *addr, PROPERTYTYPE type)
+{
+	switch ( type ) {
+	case PT_double:
+	case PT_float:
+	case PT_int16:
+	case PT_int32:
+	case PT_int64:
+	case PT_enumeration:
+	case PT_set:
+	case PT_bool:
+	case PT_timestamp:
+		break;
+	default:
+		output_error("telemetry item '%s' is a %s, which cannot be published", name, class_get_property_typename(type));
+		/* TROUBLESHOOT
+			Only numeric properties (double, float, integers, enumerations, sets, booleans,
+			timestamps and complex numbers) can be published in the telemetry ring.
+			Remove the property from the <b>telemetry_properties</b> list.
+		 */
+		return 0;
+	}
+	if ( n_items==max_items )
+	{
+		unsigned int max = max_items==0 ? 256 : max_items*2;
+		TELEMETRYITEM *items = (TELEMETRYITEM*)realloc(item_list,sizeof(TELEMETRYITEM)*max);
+		char *names = items==NULL ? NULL : (char*)realloc(name_list,(size_t)TELEMETRY_NAMESIZE*max);
+		if ( items==NULL || names==NULL )
+		{
+			output_error("telemetry item list memory allocation failed");
+			if ( items!=NULL ) item_list = items;
+			return 0;
+		}
+		item_list = items;
+		name_list = names;
+		max_items = max;
+	}
+	item_list[n_items].addr = addr;
+	item_list[n_items].type = type;
+	strncpy(name_list+(size_t)n_items*TELEMETRY_NAMESIZE,name,TELEMETRY_NAMESIZE-1);
+	name_list[(size_t)n_items*TELEMETRY_NAMESIZE+TELEMETRY_NAMESIZE-1] = '\0';
+	n_items++;
+	return 1;
+}
+
+/** Add a value, splitting complex values into their parts **/
+static int telemetry_add_value(char *name, void *addr, PROPERTYTYPE type)
+{
+	if ( type==PT_complex )
+	{
+		char part[1024];
+		sprintf(part,"%.1000s.real",name);
+		if ( !telemetry_add_item(part,&((complex*)addr)->r,PT_double) )
+			return 0;
+		sprintf(part,"%.1000s.imag",name);
+		return telemetry_add_item(part,&((complex*)addr)->i,PT_double);
+	}
+	else
+		return telemetry_add_item(name,addr,type);
+}
+
+/** Add a property of an object **/
+static int telemetry_add_property(OBJECT *obj, char *propname)
+{
+	char name[1024], oname[64];
+	PROPERTY *prop = object_get_property(obj,propname,NULL);
+	sprintf(name,"%.63s/%.900s",object_name(obj,oname,sizeof(oname)-1),propname);
+	if ( prop==NULL )
+	{
+		output_error("telemetry item '%s' not found", name);
+		return 0;
+	}
+	return telemetry_add_value(name,GETADDR(obj,prop),prop->ptype);
+}
+
+/** Add the items in a list
+	@returns non-zero on success, 0 on failure
+ **/
+static int telemetry_add_list(char *list, int depth)
+{
+	char *p, *next;
+	for ( p=list ; p!=NULL && *p!='\0' ; p=next )
+	{
+		char item[1024], *propname;
+		size_t len = strcspn(p,",; \t\r\n");
+		next = p[len]=='\0' ? NULL : p+len+1;
+		if ( len==0 )
+			continue;
+		if ( len>=sizeof(item) )
+		{
+			output_error("telemetry item '%.32s...' is too long", p);
+			return 0;
+		}
+		strncpy(item,p,len);
+		item[len] = '\0';
+
+		/* more items in a file */
+		if ( item[0]=='@' )
+		{
+			FILE *fp;
+			char buffer[65536];
+			size_t n;
+			int ok;
+			if ( depth>8 )
+			{
+				output_error("telemetry item file '%s' nested too deeply", item+1);
+				return 0;
+			}
+			fp = fopen(item+1,"r");
+			if ( fp==NULL )
+			{
+				output_error("telemetry item file '%s' could not be opened: %s", item+1, strerror(errno));
+				return 0;
+			}
+			n = fread(buffer,1,sizeof(buffer)-1,fp);
+			fclose(fp);
+			if ( n==sizeof(buffer)-1 )
+			{
+				output_error("telemetry item file '%s' is too large", item+1);
+				return 0;
+			}
+			buffer[n] = '\0';
+			ok = telemetry_add_list(buffer,depth+1);
+			if ( !ok )
+				return 0;
+			continue;
+		}
+
+		propname = strchr(item,'/');
+		if ( propname==NULL )
+		{
+			/* global variable */
+			GLOBALVAR *var = global_find(item);
+			if ( var==NULL )
+			{
+				output_error("telemetry item '%s' is not a global variable", item);
+				return 0;
+			}
+			if ( !telemetry_add_value(item,var->prop->addr,var->prop->ptype) )
+				return 0;
+		}
+		else
+		{
+			char *id = strchr(item,':');
+			*propname++ = '\0';
+			if ( id!=NULL && strcmp(id,":*")==0 )
+			{
+				/* every object of a class */
+				OBJECT *obj;
+				unsigned int count = 0;
+				*id = '\0';
+				for ( obj=object_get_first() ; obj!=NULL ; obj=object_get_next(obj) )
+				{
+					if ( strcmp(obj->oclass->name,item)!=0 )
+						continue;
+					if ( !telemetry_add_property(obj,propname) )
+						return 0;
+					count++;
+				}
+				if ( count==0 )
+					output_warning("telemetry item '%s:*/%s' does not match any object", item, propname);
+			}
+			else
+			{
+				OBJECT *obj = id==NULL ? object_find_name(item) : object_find_by_id(atoi(id+1));
+				if ( obj==NULL )
+				{
+					output_error("telemetry item object '%s' not found", item);
+					return 0;
+				}
+				if ( !telemetry_add_property(obj,propname) )
+					return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+/** Create the telemetry ring
+	This is called after the model is initialized.
+	@returns SUCCESS when the ring is created or not needed, FAILED otherwise
+ **/
+int telemetry_init(void)
+{
+	uint64_t names_offset, records_offset;
+	uint32_t record_size;
+
+	if ( global_telemetry_file[0]=='\0' )
+		return SUCCESS;
+#ifdef WIN32
+	output_error("telemetry is not supported on this platform");
+	return FAILED;
+#else
+	if ( global_telemetry_depth<2 )
+	{
+		output_error("telemetry_depth must be at least 2");
+		return FAILED;
+	}
+	if ( !telemetry_add_list(global_telemetry_properties,0) )
+		return FAILED;
+	if ( n_items==0 )
+	{
+		output_error("telemetry_file is set but no telemetry_properties are given");
+		/* TROUBLESHOOT
+			The telemetry ring was requested by setting <b>telemetry_file</b> but
+			the <b>telemetry_properties</b> list is empty.  Set it to the list of values to publish.
+		 */
+		return FAILED;
+	}
+
+	/* layout */
+	record_size = (uint32_t)TELEMETRY_RECORDSIZE(n_items);
+	names_offset = (sizeof(TELEMETRY_HEADER)+63)&~(uint64_t)63;
+	records_offset = (names_offset+(uint64_t)n_items*TELEMETRY_NAMESIZE+63)&~(uint64_t)63;
+	map_size = (size_t)(records_offset+(uint64_t)record_size*global_telemetry_depth);
+
+	/* a new file is created so readers of a previous run keep their mapping */
+	unlink(global_telemetry_file);
+	map_fd = open(global_telemetry_file,O_RDWR|O_CREAT|O_TRUNC,0644);
+	if ( map_fd<0 || ftruncate(map_fd,map_size)<0 )
+	{
+		output_error("unable to create telemetry file '%s': %s", global_telemetry_file, strerror(errno));
+		if ( map_fd>=0 ) close(map_fd);
+		map_fd = -1;
+		return FAILED;
+	}
+	header = (TELEMETRY_HEADER*)mmap(NULL,map_size,PROT_READ|PROT_WRITE,MAP_SHARED,map_fd,0);
+	if ( header==(TELEMETRY_HEADER*)MAP_FAILED )
+	{
+		output_error("unable to map telemetry file '%s': %s", global_telemetry_file, strerror(errno));
+		close(map_fd);
+		map_fd = -1;
+		header = NULL;
+		return FAILED;
+	}
+
+	/* the magic number is set last so readers only see a complete header */
+	header->version = TELEMETRY_VERSION;
+	header->header_size = sizeof(TELEMETRY_HEADER);
+	header->name_size = TELEMETRY_NAMESIZE;
+	header->n_values = n_items;
+	header->n_records = global_telemetry_depth;
+	header->record_size = record_size;
+	header->state = TLM_RUNNING;
+	header->names_offset = names_offset;
+	header->records_offset = records_offset;
+	header->pid = getpid();
+	header->sequence = 0;
+	memcpy((char*)header+names_offset,name_list,(size_t)n_items*TELEMETRY_NAMESIZE);
+	telemetry_barrier();
+	header->magic = TELEMETRY_MAGIC;
+	output_verbose("telemetry publishing %d values in %d records to '%s'", n_items, global_telemetry_depth, global_telemetry_file);
+	return SUCCESS;
+#endif
+}
+
+/** Write the published values to the next record of the ring
+	This is called by the main loop after each committed timestep.
+ **/
+void telemetry_commit(int64_t t)
+{
+	uint64_t n;
+	TELEMETRY_RECORD *record;
+	TELEMETRYITEM *item;
+	double *value;
+	if ( header==NULL )
+		return;
+	n = header->sequence;
+	record = (TELEMETRY_RECORD*)((char*)header+header->records_offset+(size_t)(n%header->n_records)*header->record_size);
+	record->sequence = 2*n+1;
+	telemetry_barrier();
+	record->timestamp = t;
+	for ( item=item_list, value=record->value ; item<item_list+n_items ; item++, value++ )
+	{
+		switch ( item->type ) {
+		case PT_double: *value = *(double*)item->addr; break;
+		case PT_float: *value = *(float*)item->addr; break;
+		case PT_int16: *value = *(int16*)item->addr; break;
+		case PT_int32: *value = *(int32*)item->addr; break;
+		case PT_int64: *value = (double)*(int64*)item->addr; break;
+		case PT_enumeration: *value = *(enumeration*)item->addr; break;
+		case PT_set: *value = (double)*(set*)item->addr; break;
+		case PT_bool: *value = *(bool*)item->addr; break;
+		case PT_timestamp: *value = (double)*(TIMESTAMP*)item->addr; break;
+		default: *value = 0; break;
+		}
+	}
+	telemetry_barrier();
+	record->sequence = 2*n+2;
+	telemetry_barrier();
+	header->sequence = n+1;
+}
+
+/** Mark the telemetry ring done and release it
+	The file is left in place so readers can get the last records.
+ **/
+void telemetry_term(void)
+{
+	if ( header==NULL )
+		return;
+#ifndef WIN32
+	header->state = TLM_DONE;
+	telemetry_barrier();
+	munmap(header,map_size);
+	close(map_fd);
+#endif
+	header = NULL;
+	map_fd = -1;
+	free(item_list);
+	free(name_list);
+	item_list = NULL;
+	name_list = NULL;
+	n_items = max_items = 0;
+}
+
+/** Print the records of a telemetry ring as they are written
+	This implements the <b>--telemetry [<file>]</b> command line option, which
+	follows a running simulation and prints its telemetry as CSV until the
+	simulation is done.
+ **/
+int telemetry(int argc, char *argv[])
+{
+	char *filename = argc>1 ? argv[1] : global_telemetry_file;
+	TELEMETRY *tlm;
+	double *value;
+	uint64_t next, skipped = 0;
+	uint32_t i, n;
+
+	if ( filename[0]=='\0' )
+	{
+		output_fatal("--telemetry requires the name of a telemetry file");
+		exit(XC_ARGERR);
+	}
+	tlm = telemetry_open(filename);
+	if ( tlm==NULL )
+	{
+		output_fatal("unable to open telemetry file '%s'", filename);
+		/* TROUBLESHOOT
+			The telemetry file does not exist, is not a telemetry ring, or was written
+			by a different version of GridLAB-D.  Check that the simulation is running
+			with <b>telemetry_file</b> set to the same file.
+		 */
+		exit(XC_IOERR);
+	}
+	n = telemetry_count(tlm);
+	value = (double*)malloc(sizeof(double)*n);
+	if ( value==NULL )
+	{
+		output_fatal("telemetry value buffer allocation failed");
+		exit(XC_IOERR);
+	}
+	printf("timestamp");
+	for ( i=0 ; i<n ; i++ )
+		printf(",%s",telemetry_name(tlm,i));
+	printf("\n");
+
+	/* start with the oldest record still in the ring */
+	next = telemetry_sequence(tlm);
+	next = next>tlm->header->n_records ? next-tlm->header->n_records : 0;
+	for (;;)
+	{
+		int64_t t;
+		int done = telemetry_done(tlm);
+		uint64_t last = telemetry_sequence(tlm);
+		if ( next==last )
+		{
+			fflush(stdout);
+#ifndef WIN32
+			if ( done || kill((pid_t)tlm->header->pid,0)!=0 )
+				break;
+			usleep(10000);
+#else
+			break;
+#endif
+			continue;
+		}
+		switch ( telemetry_read(tlm,next,&t,value) ) {
+		case 1:
+			{
+				char buffer[64];
+				printf("%s",convert_from_timestamp(t,buffer,sizeof(buffer))?buffer:"INVALID");
+				for ( i=0 ; i<n ; i++ )
+					printf(",%.15g",value[i]);
+				printf("\n");
+				next++;
+			}
+			break;
+		case -1:
+			/* the writer overtook us, skip to the oldest record still in the ring */
+			next = telemetry_sequence(tlm);
+			next = next>tlm->header->n_records ? next-tlm->header->n_records : 0;
+			skipped++;
+			break;
+		default:
+			break;
+		}
+	}
+	if ( skipped>0 )
+		output_warning("telemetry reader fell behind the simulation %"FMT_INT64"u times and skipped records", skipped);
+	free(value);
+	telemetry_close(tlm);
+	exit(XC_SUCCESS);
+}
+
+/**@}**/
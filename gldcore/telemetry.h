@@ -0,0 +1,112 @@
+/* $Id$
+   Copyright (C) 2012 Battelle Memorial Institute
+	@file telemetry.h
+	@addtogroup telemetry Live telemetry
+	@ingroup core
+
+	The telemetry ring publishes a fixed set of values at each committed
+	timestep to a memory-mapped file so that monitoring tools can read the
+	live state of a simulation without any system calls by the simulator.
+	The ring is enabled by setting the \p telemetry_file global to the name of
+	the file (e.g., \p /dev/shm/gridlabd.tlm) and the \p telemetry_properties
+	global to the list of values published, e.g.,
+
+	<code>#set telemetry_properties=house:*\/air_temperature,meter_1/measured_real_power,clock</code>
+
+	Items are separated by commas, semicolons or whitespace and may be
+	- \p name/property for a property of a named object,
+	- \p class:id/property for a property of an unnamed object,
+	- \p class:*\/property for the property of every object of a class,
+	- \p name for a global variable, or
+	- \p \@file to read more items from a file.
+	Complex values are published as two values, with ".real" and ".imag"
+	added to their names.  All values are published as doubles.
+
+	The file contains a TELEMETRY_HEADER, followed by the name table at
+	\p names_offset (\p n_values names of \p name_size bytes each, null
+	terminated), followed by the ring of \p n_records records at
+	\p records_offset, each \p record_size bytes long.  Record \e n is stored
+	in slot \e n % \p n_records.  The header \p sequence is the number of
+	records written so far, so the latest record is \p sequence-1.
+
+	Each record is protected by its own sequence number: it is odd while
+	the record is being written and is 2(\e n+1) once record \e n is complete.
+	A reader must check the record sequence before and after copying the
+	record, and discard the copy if it changed.  The reader functions below
+	implement this and may be compiled into other programs with
+	telemetry_reader.c, which only depends on this file.
+ @{
+ **/
+
+#ifndef _TELEMETRY_H
+#define _TELEMETRY_H
+
+#include <stdint.h>
+
+#define TELEMETRY_MAGIC 0x544c4447 /* "GDLT" once the ring is ready to read */
+#define TELEMETRY_VERSION 1 /* increment when the file layout changes */
+#define TELEMETRY_NAMESIZE 128 /* size of each entry in the name table */
+
+typedef enum {
+	TLM_RUNNING=0, /**< the simulation is publishing records */
+	TLM_DONE=1, /**< the simulation is finished and no more records will be written */
+} TELEMETRYSTATE;
+
+/** The telemetry file header */
+typedef struct s_telemetry_header {
+	uint32_t magic; /**< TELEMETRY_MAGIC once the header and names are complete */
+	uint32_t version; /**< TELEMETRY_VERSION of the writer */
+	uint32_t header_size; /**< size of this header */
+	uint32_t name_size; /**< size of each entry in the name table */
+	uint32_t n_values; /**< number of values in each record */
+	uint32_t n_records; /**< number of records in the ring */
+	uint32_t record_size; /**< size of each record */
+	volatile uint32_t state; /**< TELEMETRYSTATE of the writer */
+	uint64_t names_offset; /**< offset of the name table from the start of the file */
+	uint64_t records_offset; /**< offset of the first record from the start of the file */
+	int64_t pid; /**< process id of the writer */
+	volatile uint64_t sequence; /**< number of records written so far */
+} TELEMETRY_HEADER;
+
+/** A telemetry record */
+typedef struct s_telemetry_record {
+	volatile uint64_t sequence; /**< odd while the record is written, 2(n+1) when record n is complete */
+	int64_t timestamp; /**< the simulation clock (seconds since 1/1/1970 UTC) */
+	double value[1]; /**< the values, n_values of them */
+} TELEMETRY_RECORD;
+
+#define TELEMETRY_RECORDSIZE(N) (sizeof(TELEMETRY_RECORD)+((N)>0?(N)-1:0)*sizeof(double))
+
+/** A telemetry file opened by a reader */
+typedef struct s_telemetry {
+	int fd; /**< the file descriptor */
+	size_t size; /**< the size of the mapped file */
+	TELEMETRY_HEADER *header; /**< the mapped file */
+} TELEMETRY;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* writer (simulator) */
+int telemetry_init(void);
+void telemetry_commit(int64_t t);
+void telemetry_term(void);
+int telemetry(int argc, char *argv[]);
+
+/* reader */
+TELEMETRY *telemetry_open(const char *filename);
+void telemetry_close(TELEMETRY *tlm);
+uint32_t telemetry_count(TELEMETRY *tlm);
+const char *telemetry_name(TELEMETRY *tlm, uint32_t n);
+uint64_t telemetry_sequence(TELEMETRY *tlm);
+int telemetry_done(TELEMETRY *tlm);
+int telemetry_read(TELEMETRY *tlm, uint64_t n, int64_t *timestamp, double *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/**@}**/
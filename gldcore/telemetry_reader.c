@@ -0,0 +1,143 @@
+/* $Id$
+   Copyright (C) 2012 Battelle Memorial Institute
+	@file telemetry_reader.c
+	@addtogroup telemetry
+	@ingroup core
+
+	Reader functions for the telemetry ring.  This file only depends on
+	telemetry.h so it can be compiled into monitoring tools.
+ @{
+ **/
+
+#include <stdlib.h>
+#include <string.h>
+#include "telemetry.h"
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(WIN32) && !defined(__MINGW32__)
+#include <windows.h>
+#define telemetry_barrier() MemoryBarrier()
+#else
+#define telemetry_barrier() __sync_synchronize()
+#endif
+
+/** Open a telemetry file for reading
+	@returns the telemetry handle, or NULL if the file is not a ready telemetry ring
+ **/
+TELEMETRY *telemetry_open(const char *filename)
+{
+#ifdef WIN32
+	return NULL;
+#else
+	TELEMETRY *tlm;
+	TELEMETRY_HEADER *header;
+	struct stat info;
+	int fd = open(filename,O_RDONLY);
+	if ( fd<0 )
+		return NULL;
+	if ( fstat(fd,&info)<0 || info.st_size<(off_t)sizeof(TELEMETRY_HEADER) )
+	{
+		close(fd);
+		return NULL;
+	}
+	header = (TELEMETRY_HEADER*)mmap(NULL,info.st_size,PROT_READ,MAP_SHARED,fd,0);
+	if ( header==(TELEMETRY_HEADER*)MAP_FAILED )
+	{
+		close(fd);
+		return NULL;
+	}
+	telemetry_barrier();
+	if ( header->magic!=TELEMETRY_MAGIC || header->version!=TELEMETRY_VERSION
+		|| header->records_offset+(uint64_t)header->n_records*header->record_size>(uint64_t)info.st_size )
+	{
+		munmap(header,info.st_size);
+		close(fd);
+		return NULL;
+	}
+	tlm = (TELEMETRY*)malloc(sizeof(TELEMETRY));
+	if ( tlm==NULL )
+	{
+		munmap(header,info.st_size);
+		close(fd);
+		return NULL;
+	}
+	tlm->fd = fd;
+	tlm->size = info.st_size;
+	tlm->header = header;
+	return tlm;
+#endif
+}
+
+/** Close a telemetry file **/
+void telemetry_close(TELEMETRY *tlm)
+{
+#ifndef WIN32
+	munmap(tlm->header,tlm->size);
+	close(tlm->fd);
+#endif
+	free(tlm);
+}
+
+/** Get the number of values in each record **/
+uint32_t telemetry_count(TELEMETRY *tlm)
+{
+	return tlm->header->n_values;
+}
+
+/** Get the name of a value
+	@returns the name, or NULL if there is no such value
+ **/
+const char *telemetry_name(TELEMETRY *tlm, uint32_t n)
+{
+	if ( n>=tlm->header->n_values )
+		return NULL;
+	return (const char*)tlm->header+tlm->header->names_offset+(size_t)n*tlm->header->name_size;
+}
+
+/** Get the number of records written so far
+	The latest record is the sequence less one.
+ **/
+uint64_t telemetry_sequence(TELEMETRY *tlm)
+{
+	uint64_t sequence = tlm->header->sequence;
+	telemetry_barrier();
+	return sequence;
+}
+
+/** Check whether the writer is done
+	@returns non-zero when no more records will be written
+ **/
+int telemetry_done(TELEMETRY *tlm)
+{
+	return tlm->header->state==TLM_DONE;
+}
+
+/** Read a record
+	The values must have room for telemetry_count() doubles.
+	@returns 1 on success, 0 if the record is not written yet, -1 if it was overwritten
+ **/
+int telemetry_read(TELEMETRY *tlm, uint64_t n, int64_t *timestamp, double *value)
+{
+	TELEMETRY_HEADER *header = tlm->header;
+	TELEMETRY_RECORD *record = (TELEMETRY_RECORD*)((char*)header+header->records_offset+(size_t)(n%header->n_records)*header->record_size);
+	uint64_t complete = 2*(n+1), sequence;
+
+	sequence = record->sequence;
+	telemetry_barrier();
+	if ( sequence<complete )
+		return 0;
+	if ( sequence>complete )
+		return -1;
+	*timestamp = record->timestamp;
+	memcpy(value,record->value,header->n_values*sizeof(double));
+	telemetry_barrier();
+	return record->sequence==complete ? 1 : -1;
+}
+
+/**@}**/
@@ -4,6 +4,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "globals.h"
 #include "cmdarg.h"
@@ -27,6 +28,7 @@ static TESTLIST test_list[] = {
 	{"schedule",	schedule_test,		0, test_list+4},
 	{"loadshape",	loadshape_test,		0, test_list+5},
 	{"enduse",		enduse_test,		0, test_list+6},
+	{"statwindow",	statwindow_test,	0, test_list+7},
 	{"lock",		test_lock,			0, NULL}, /* last test in list has no next */
 	/* add new core test routines before this line */
 }, *last_test = test_list+sizeof(test_list)/sizeof(test_list[0])-1;
@@ -107,7 +109,7 @@ static volatile int done = 0;
 
 static void *test_lock_proc(void *ptr)
 {
-	int id = *(int*)ptr;
+	int id = (int)(size_t)ptr;
 	int m;
 	output_test("thread %d created ok", (unsigned int)id);
 	for ( m=0 ; m<TESTCOUNT ; m++ )
@@ -141,7 +143,7 @@ int test_lock(void)
 	{
 		pthread_t pt;
 		count[n] = 0;
-		if ( pthread_create(&pt,NULL,test_lock_proc,(void*)&n)!=0 )
+		if ( pthread_create(&pt,NULL,test_lock_proc,(void*)(size_t)n)!=0 )
 		{
 			output_test("thread creation failed");
 			return FAILED;
@@ -184,3 +186,132 @@ int test_lock(void)
 	return SUCCESS;
 }
 
+
+/***********************************************************************
+ * MEMORY LOCK BENCHMARK
+ */
+#include "threadpool.h"
+#define LOCKBENCH_THREADS 64 /* largest number of threads */
+#define LOCKBENCH_TIME 500 /* duration of each run (ms) */
+#define LOCKBENCH_READS 9 /* number of read locks per write lock */
+
+typedef struct s_lockbench {
+	unsigned int id;
+	int64 reads, writes, errors;
+	char pad[64]; /* keep the counters of each thread on a separate cache line */
+} LOCKBENCH;
+static unsigned int bench_key = 0;
+static volatile unsigned int bench_value[2] = {0,0};
+static volatile int bench_done = 0;
+
+static void *lockbench_proc(void *ptr)
+{
+	LOCKBENCH *my = (LOCKBENCH*)ptr;
+	unsigned int n = my->id;
+	while ( !bench_done )
+	{
+		if ( n++%(LOCKBENCH_READS+1)==0 )
+		{
+			wlock(&bench_key);
+			bench_value[0]++;
+			bench_value[1]++;
+			wunlock(&bench_key);
+			my->writes++;
+		}
+		else
+		{
+			unsigned int a, b;
+			rlock(&bench_key);
+			a = bench_value[0];
+			b = bench_value[1];
+			runlock(&bench_key);
+			if ( a!=b ) /* a write was seen half done */
+				my->errors++;
+			my->reads++;
+		}
+	}
+	return (void*)0;
+}
+
+/* run the threads for a while and return the number of locks per second */
+static double lockbench_run(unsigned int threads, set options, int64 *errors)
+{
+	pthread_t pt[LOCKBENCH_THREADS];
+	LOCKBENCH data[LOCKBENCH_THREADS];
+	int64 start, elapsed, locks = 0, writes = 0;
+	unsigned int n;
+
+	global_lock_options = options;
+	bench_done = 0;
+	bench_value[0] = bench_value[1] = 0;
+	start = exec_clock();
+	for ( n=0 ; n<threads ; n++ )
+	{
+		memset(&data[n],0,sizeof(LOCKBENCH));
+		data[n].id = n;
+		if ( pthread_create(&pt[n],NULL,lockbench_proc,(void*)&data[n])!=0 )
+		{
+			output_test("thread creation failed");
+			(*errors)++;
+			break;
+		}
+	}
+	threads = n;
+	exec_sleep(LOCKBENCH_TIME*1000);
+	bench_done = 1;
+	for ( n=0 ; n<threads ; n++ )
+	{
+		pthread_join(pt[n],NULL);
+		locks += data[n].reads + data[n].writes;
+		writes += data[n].writes;
+		*errors += data[n].errors;
+	}
+	elapsed = exec_clock()-start;
+	if ( writes!=bench_value[0] )
+	{
+		output_test("%d threads made %"FMT_INT64"d writes but %d were counted", threads, writes, bench_value[0]);
+		(*errors)++;
+	}
+	return elapsed>0 ? (double)locks*CLOCKS_PER_SEC/elapsed : 0;
+}
+
+int test_lockbench(void)
+{
+	static struct {
+		char *name;
+		set options;
+	} mode[] = {
+		{"SPIN", LO_NONE},
+		{"ADAPTIVE", LO_ADAPTIVE},
+		{"SHAREDREAD", LO_ADAPTIVE|LO_SHAREDREAD},
+	};
+	set options = global_lock_options;
+	unsigned int threads, m;
+	int64 errors = 0;
+
+	output_test("*** Begin memory locking benchmark");
+	global_suppress_repeat_messages = 0;
+	output_message("lockbench: %d processors, %d ms per run, %d reads per write", processor_count(), LOCKBENCH_TIME, LOCKBENCH_READS);
+	output_message("THREADS  %12s %12s %12s  (locks/s)", mode[0].name, mode[1].name, mode[2].name);
+	output_message("-------  ------------ ------------ ------------");
+	for ( threads=1 ; threads<=LOCKBENCH_THREADS ; threads*=2 )
+	{
+		char buffer[256];
+		int len = sprintf(buffer,"%7d ",threads);
+		for ( m=0 ; m<sizeof(mode)/sizeof(mode[0]) ; m++ )
+		{
+			double rate = lockbench_run(threads,mode[m].options,&errors);
+			output_test("%d threads, %s locks: %.0f locks/s", threads, mode[m].name, rate);
+			len += sprintf(buffer+len," %12.0f",rate);
+		}
+		output_message("%s",buffer);
+	}
+	global_lock_options = options;
+	if ( errors>0 )
+	{
+		output_error("lockbench: %"FMT_INT64"d locking errors found--see test.txt for more information", errors);
+		output_test("TEST FAILED");
+	}
+	output_test("*** End memory locking benchmark");
+	return errors>0 ? FAILED : SUCCESS;
+}
@@ -14,5 +14,6 @@ int test_request(char *name);
 int test_exec(void);
 
 int test_lock(void);
+int test_lockbench(void);
  
 #endif
@@ -243,8 +243,10 @@ MTI *mti_init(const char *name, MTIFUNCTIONS *fn, size_t minitems)
 				item = fn->get(item);
 			}
 
-			/* create thread to handle the list */
-			proc->enabled  = ( pthread_create(&proc->thread_id,NULL,(void*(*)(void*))iterator_proc,proc)==0 );
+			/* create thread to handle the list (enabled must be set before the thread checks it) */
+			proc->enabled = TRUE;
+			if ( pthread_create(&proc->thread_id,NULL,(void*(*)(void*))iterator_proc,proc)!=0 )
+				proc->enabled = FALSE;
 			mti_debug(mti,"proc=%d; enabled=%d, nitems=%d", p, proc->enabled, proc->n_items);
 		}
 	}
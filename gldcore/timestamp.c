@@ -203,6 +203,104 @@ int local_tzoffset(TIMESTAMP t)
 #endif
 }
 
+/** Local date cache
+	Most local time conversions during a run are for timestamps within a day or so
+	of the global clock (the clock itself, schedule skews, player and market
+	lookups), so the calendar part of the conversion is kept for a few local days
+	and only the time of day is computed when a timestamp falls in a cached day.
+	Days that contain a DST transition are never cached, so the local offset is
+	constant over every cached entry.  Each entry is guarded by a sequence lock:
+	writers hold the entry's lock (odd value) while updating it and readers retry
+	on the slow path if the value changed while they copied the entry.
+ **/
+#define DTCACHE_SIZE 8 /* number of local days cached (must be a power of 2) */
+typedef struct s_dtcache {
+	unsigned int lock; /**< sequence lock (odd while the entry is being updated) */
+	TIMESTAMP start; /**< GMT timestamp of local midnight (0 if entry is unused) */
+	DATETIME dt; /**< local datetime at midnight */
+} DTCACHE;
+static DTCACHE dtcache[DTCACHE_SIZE];
+static int dtcache_enabled = 1;
+
+#if defined(WIN32) && !defined(__MINGW32__)
+	#include <intrin.h>
+	#define dtcache_barrier() _ReadWriteBarrier()
+#else
+	#define dtcache_barrier() __sync_synchronize()
+#endif
+
+/** Clear the local date cache (required whenever the timezone rules change)
+ **/
+static void dtcache_reset(void)
+{
+	int n;
+	for ( n=0 ; n<DTCACHE_SIZE ; n++ )
+	{
+		wlock(&dtcache[n].lock);
+		dtcache[n].start = 0;
+		wunlock(&dtcache[n].lock);
+	}
+}
+
+/** Convert a GMT timestamp using the local date cache
+	@return 1 if the day was found in the cache, 0 if the full conversion is needed
+ **/
+static int dtcache_get(TIMESTAMP ts, DATETIME *dt)
+{
+	/* the local day is the standard time day or the one after it when DST is in effect */
+	TIMESTAMP day = (ts-tzoffset)/DAY;
+	int n;
+	if ( ts<tzoffset )
+		return 0;
+	for ( n=0 ; n<2 ; n++ )
+	{
+		volatile DTCACHE *entry = &dtcache[(day+n)&(DTCACHE_SIZE-1)];
+		unsigned int seq = entry->lock;
+		TIMESTAMP start, rem;
+		if ( seq&1 )
+			continue;
+		dtcache_barrier();
+		start = entry->start;
+		if ( start==0 || ts<start || ts>=start+DAY )
+			continue;
+		memcpy(dt,(DATETIME*)&entry->dt,sizeof(DATETIME));
+		dtcache_barrier();
+		if ( entry->lock!=seq )
+			return 0;
+
+		/* only the time of day differs from local midnight */
+		rem = ts - start;
+		dt->timestamp = ts;
+		dt->hour = (unsigned short)(rem / HOUR);
+		rem %= HOUR;
+		dt->minute = (unsigned short)(rem / MINUTE);
+		rem %= MINUTE;
+		dt->second = (unsigned short)(rem / SECOND);
+		return 1;
+	}
+	return 0;
+}
+
+/** Save the day of a converted timestamp in the local date cache
+ **/
+static void dtcache_put(DATETIME *dt)
+{
+	TIMESTAMP start = dt->timestamp - (dt->hour*HOUR + dt->minute*MINUTE + dt->second*SECOND);
+	int dst = isdst(dt->timestamp);
+	DTCACHE *entry;
+	if ( dt->nanosecond!=0 || isdst(start)!=dst || isdst(start+DAY-1)!=dst )
+		return; /* day contains a DST transition */
+	entry = &dtcache[((LOCALTIME(start))/DAY)&(DTCACHE_SIZE-1)];
+	if ( entry->start==start )
+		return;
+	wlock(&entry->lock);
+	entry->start = start;
+	entry->dt = *dt;
+	entry->dt.timestamp = start;
+	entry->dt.hour = entry->dt.minute = entry->dt.second = 0;
+	wunlock(&entry->lock);
+}
+
 /** Converts a GMT timestamp to local datetime struct
 	Adjusts to TZ if possible
  **/
@@ -214,12 +312,6 @@ int local_datetime(TIMESTAMP ts, DATETIME *dt)
 	TIMESTAMP local;
 	int tsyear;
 
-#ifdef USE_TS_CACHE
-	/* allow caching */
-	static TIMESTAMP old_ts =0;
-	static DATETIME old_dt;
-#endif
-
 	if( ts == TS_NEVER || ts==TS_ZERO )
 		return 0;
 
@@ -228,13 +320,9 @@ int local_datetime(TIMESTAMP ts, DATETIME *dt)
 		output_error("local_datetime(ts=%lli,...): invalid local_datetime request",ts);
 		return 0;
 	}
-#ifdef USE_TS_CACHE
-	/* check cache */
-	if (old_ts == ts && old_ts!=0)
-		memcpy(dt,&old_dt,sizeof(DATETIME));
-	else
-		old_ts = 0;
-#endif
+	/* check local date cache */
+	if ( dtcache_enabled && dtcache_get(ts,dt) )
+		return 1;
 
 	local = LOCALTIME(ts);
 	tsyear = timestamp_year(local, &rem);
@@ -324,11 +412,9 @@ int local_datetime(TIMESTAMP ts, DATETIME *dt)
 	/* timezone offset in seconds */
 	dt->tzoffset = (int)(tzoffset - (isdst(dt->timestamp)?3600:0));
 
-#ifdef USE_TS_CACHE
-	/* cache result */
-	old_ts = ts;
-	memcpy(&old_dt,dt,sizeof(old_dt));
-#endif
+	/* cache local date */
+	if ( dtcache_enabled )
+		dtcache_put(dt);
 	return 1;
 }
 
@@ -725,6 +811,7 @@ void load_tzspecs(char *tz){
 
 	found = 0;
 	tzvalid = 0;
+	dtcache_reset();
 	pTzname = tz_name(tz);
 
 	if(pTzname == 0){
@@ -833,6 +920,7 @@ void load_tzspecs(char *tz){
 
 	fclose(fp);
 	tzvalid = 1;
+	dtcache_reset();
 }
 
 /** Establish the default timezone for time conversion.
@@ -1318,6 +1406,62 @@ int timestamp_test(void)
 		}
 	}
 	output_test("END: round robin test",steptxt);
+
+	/* compare cached and uncached conversions and measure the conversion rate */
+	step = 7*MINUTE+SECOND;
+	convert_from_timestamp(step,steptxt,sizeof(steptxt));
+	output_test("BEGIN: local date cache test at %s timesteps",steptxt);
+	{
+		TIMESTAMP t0 = DAY*365*(NYEARS-10);
+		TIMESTAMP t1 = t0 + DAY*365*2;
+		clock_t uncached_time, cached_time, start;
+		int count = 0;
+		for (ts=t0; ts<t1; ts+=step)
+		{
+			DATETIME a, b;
+			int ok_a, ok_b;
+			dtcache_enabled = 0;
+			ok_a = local_datetime(ts,&a);
+			dtcache_enabled = 1;
+			ok_b = local_datetime(ts,&b);
+			if ( ok_a!=ok_b || a.timestamp!=b.timestamp || a.year!=b.year || a.month!=b.month || a.day!=b.day
+				|| a.hour!=b.hour || a.minute!=b.minute || a.second!=b.second || a.nanosecond!=b.nanosecond
+				|| a.weekday!=b.weekday || a.yearday!=b.yearday || a.is_dst!=b.is_dst || a.tzoffset!=b.tzoffset
+				|| strncmp(a.tz,b.tz,sizeof(a.tz))!=0 )
+			{
+				output_test("FAILED: cached local time %04d-%02d-%02d %02d:%02d:%02d %s does not match %04d-%02d-%02d %02d:%02d:%02d %s for ts=%"FMT_INT64"d",
+					b.year,b.month,b.day,b.hour,b.minute,b.second,b.tz,a.year,a.month,a.day,a.hour,a.minute,a.second,a.tz,ts);
+				failed++;
+			}
+			else
+				succeeded++;
+		}
+
+		/* conversion rate over a day around a moving clock, as schedules and players see it */
+		step = 5*MINUTE;
+		dtcache_enabled = 0;
+		start = clock();
+		for (ts=t0; ts<t1; ts+=step)
+		{
+			DATETIME t;
+			count += local_datetime(ts,&t) + local_datetime(ts-HOUR,&t) + local_datetime(ts+HOUR,&t);
+		}
+		uncached_time = clock()-start;
+		dtcache_enabled = 1;
+		start = clock();
+		for (ts=t0; ts<t1; ts+=step)
+		{
+			DATETIME t;
+			count += local_datetime(ts,&t) + local_datetime(ts-HOUR,&t) + local_datetime(ts+HOUR,&t);
+		}
+		cached_time = clock()-start;
+		count /= 2;
+		output_test("local date cache: %d conversions, uncached %.1f ns/call, cached %.1f ns/call", count,
+			(double)uncached_time*1e9/CLOCKS_PER_SEC/count, (double)cached_time*1e9/CLOCKS_PER_SEC/count);
+		output_message("dsttest: local_datetime() uncached %.1f ns/call, cached %.1f ns/call",
+			(double)uncached_time*1e9/CLOCKS_PER_SEC/count, (double)cached_time*1e9/CLOCKS_PER_SEC/count);
+	}
+	output_test("END: local date cache test");
 	output_test("END: daylight saving time tests for %d to %d", YEAR0, YEAR0+NYEARS);
 	output_verbose("daylight saving time tests: %d succeeded, %d failed (see '%s' for details)", succeeded, failed, global_testoutputfile);
 	return failed;
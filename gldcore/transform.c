@@ -8,6 +8,7 @@
 #include <float.h>
 #include <ctype.h>
 #include <pthread.h>
+#include <time.h>
 
 #include "platform.h"
 #include "object.h"
@@ -17,9 +18,35 @@
 #include "exception.h"
 #include "module.h"
 #include "exec.h"
+#include "timestamp.h"
 
 static TRANSFORM *schedule_xformlist=NULL;
 
+/* compiled form of the transform list (see transform_compile) */
+typedef struct s_transformbatch {
+	SCHEDULE *schedule; ///< source schedule shared by the batch
+	double *source; ///< source value shared by the batch
+	TIMESTAMP skew; ///< schedule skew shared by the targets of the batch
+	unsigned int n; ///< number of transforms in the batch
+	TRANSFORM **xform; ///< transforms in the batch
+	TIMESTAMP **target_skew; ///< schedule skew of the object of each target
+	double **target; ///< target of each transform
+	double *scale; ///< scale of each transform
+	double *bias; ///< bias of each transform
+	double *value; ///< output of each transform
+} TRANSFORMBATCH;
+typedef struct s_transformstep {
+	TRANSFORM *xform; ///< transform applied by itself, NULL for a batch
+	TRANSFORMBATCH *batch; ///< batch of linear schedule transforms, NULL for a single transform
+} TRANSFORMSTEP;
+typedef struct s_transformprogram {
+	size_t n; ///< number of steps
+	TRANSFORMSTEP *step; ///< steps in transform list order
+	int stale; ///< a target skew changed since the program was compiled
+} TRANSFORMPROGRAM;
+static TRANSFORMPROGRAM *schedule_xformprog=NULL;
+static void transform_invalidate(void);
+
 /****************************************************************
  * GridLAB-D Variable Handling for transform functions
  ****************************************************************/
@@ -253,6 +280,7 @@ int transform_add_filter(OBJECT *target_obj,		/* pointer to the target object (l
 	xform->t2 = (int64)(global_starttime/tf->timestep)*tf->timestep + tf->timeskew;
 	xform->next = schedule_xformlist;
 	schedule_xformlist = xform;
+	transform_invalidate();
 
 	if ( global_debug_output )
 	{
@@ -302,6 +330,7 @@ int transform_add_external(	OBJECT *target_obj,		/* pointer to the target object
 
 	xform->next = schedule_xformlist;
 	schedule_xformlist = xform;
+	transform_invalidate();
 	output_debug("added external transform %s:%s <- %s(%s:%s)", object_name(target_obj,buffer1,sizeof(buffer1)),target_prop->name,function, object_name(source_obj,buffer2,sizeof(buffer2)),source_prop->name);
 	return 1;
 }
@@ -332,6 +361,7 @@ int transform_add_linear(	TRANSFORMSOURCE stype,	/* specifies the type of source
 	xform->function_type = XT_LINEAR;
 	xform->next = schedule_xformlist;
 	schedule_xformlist = xform;
+	transform_invalidate();
 	output_debug("added linear transform %s:%s <- scale=%.3g, bias=%.3g", object_name(obj,buffer,sizeof(buffer)), prop->name, scale, bias);
 	return 1;
 }
@@ -342,7 +372,7 @@ void cast_from_double(PROPERTYTYPE ptype, void *addr, double value)
 	case PT_void: break;
 	case PT_double: *(double*)addr = value; break;
 	case PT_complex: ((complex*)addr)->r = value; ((complex*)addr)->i = 0; break;
-	case PT_bool: *(int32*)addr = (value!=0); 
+	case PT_bool: *(int32*)addr = (value!=0); break;
 	case PT_int16: *(int16*)addr = (int16)value; break;
 	case PT_int32: *(int32*)addr = (int32)value; break;
 	case PT_int64: *(int64*)addr = (int64)value; break;
@@ -357,6 +387,26 @@ void cast_from_double(PROPERTYTYPE ptype, void *addr, double value)
 	}
 }
 
+/* check whether cast_from_double() would change the value at addr */
+static int cast_changes(PROPERTYTYPE ptype, void *addr, double value)
+{
+	switch ( ptype ) {
+	case PT_double: return *(double*)addr != value;
+	case PT_complex: return ((complex*)addr)->r != value || ((complex*)addr)->i != 0;
+	case PT_bool: return *(int32*)addr != (value!=0);
+	case PT_int16: return *(int16*)addr != (int16)value;
+	case PT_int32: return *(int32*)addr != (int32)value;
+	case PT_int64: return *(int64*)addr != (int64)value;
+	case PT_enumeration: return *(enumeration*)addr != (enumeration)value;
+	case PT_set: return *(set*)addr != (set)value;
+	case PT_timestamp: return *(int64*)addr != (int64)value;
+	case PT_float: return *(float*)addr != (float)value;
+	case PT_loadshape: return ((loadshape*)addr)->load != value;
+	case PT_enduse: return ((enduse*)addr)->total.r != value;
+	default: return 0;
+	}
+}
+
 TIMESTAMP apply_filter(TRANSFERFUNCTION *f,	///< transfer function
 					   double *u,			///< input vector
 					   double *x,			///< state vector
@@ -393,12 +443,19 @@ TIMESTAMP transform_apply(TIMESTAMP t1, TRANSFORM *xform, double *source)
 {
 	char buffer[1024];
 	TIMESTAMP t2;
+	double value;
 	switch (xform->function_type) {
 	case XT_LINEAR:
 #ifdef _DEBUG
 		output_debug("running linear transform for %s:%s", object_name(xform->target_obj,buffer,sizeof(buffer)), xform->target_prop->name);
 #endif
-		cast_from_double(xform->target_prop->ptype, xform->target, (source?(*source):(*(xform->source))) * xform->scale + xform->bias);
+		value = (source?(*source):(*(xform->source))) * xform->scale + xform->bias;
+		/* most sources hold their value for many passes so the target is only written and reported when it changes */
+		if ( cast_changes(xform->target_prop->ptype, xform->target, value) )
+		{
+			cast_from_double(xform->target_prop->ptype, xform->target, value);
+			object_notify_change(xform->target_obj,xform->target_prop);
+		}
 		t2 = TS_NEVER;
 		break;
 	case XT_EXTERNAL:
@@ -406,6 +463,7 @@ TIMESTAMP transform_apply(TIMESTAMP t1, TRANSFORM *xform, double *source)
 		output_debug("running external transform for %s:%s", object_name(xform->target_obj,buffer,sizeof(buffer)), xform->target_prop->name);
 #endif
 		xform->retval = (*xform->function)(xform->nlhs, xform->plhs, xform->nrhs, xform->prhs);
+		object_notify_change(xform->target_obj,xform->target_prop);
 		if ( xform->retval==-1 ) /* error */
 			t2 = TS_ZERO;
 		else if ( xform->retval==0 ) /* no timer */
@@ -418,7 +476,12 @@ TIMESTAMP transform_apply(TIMESTAMP t1, TRANSFORM *xform, double *source)
 		output_debug("running filter transform for %s:%s", object_name(xform->target_obj,buffer,sizeof(buffer)), xform->target_prop->name);
 #endif
 		if ( xform->t2 <= t1 )
+		{
+			value = *(xform->y);
 			xform->t2 = apply_filter(xform->tf,xform->source,xform->x,xform->y,t1);
+			if ( *(xform->y)!=value )
+				object_notify_change(xform->target_obj,xform->target_prop);
+		}
 		t2 = xform->t2;
 		break;
 	default:
@@ -429,40 +492,332 @@ TIMESTAMP transform_apply(TIMESTAMP t1, TRANSFORM *xform, double *source)
 	return t2;
 }
 
-clock_t transform_synctime = 0;
-TIMESTAMP transform_syncall(TIMESTAMP t1, TRANSFORMSOURCE source)
+/* apply a single transform, including the schedule skew of its target */
+static TIMESTAMP transform_update(TIMESTAMP t1, TRANSFORM *xform)
 {
-	TRANSFORM *xform;
-	clock_t start = (clock_t)exec_clock();
 	TIMESTAMP t2 = TS_NEVER;
-	TIMESTAMP tskew, tSkewSince, tSkewNext, t;
+	TIMESTAMP tskew, t;
+	if((xform->source_type == XS_SCHEDULE) && (xform->target_obj->schedule_skew != 0)){
+	    tskew = t1 - xform->target_obj->schedule_skew; // subtract so the +12 is 'twelve seconds later', not earlier
+	    SCHEDULEINDEX index = schedule_index(xform->source_schedule,tskew);
+	    int32 dtnext = schedule_dtnext(xform->source_schedule,index)*60;
+	    double value = schedule_value(xform->source_schedule,index);
+	    t = (dtnext == 0 ? TS_NEVER : t1 + dtnext - (tskew % 60));
+	    if ( t < t2 ) t2 = t;
+		if((tskew <= xform->source_schedule->since) || (tskew >= xform->source_schedule->next_t)){
+			t = transform_apply(t1,xform,&value);
+			if ( t<t2 ) t2=t;
+		} 
+		else 
+		{
+			t = transform_apply(t1,xform,NULL);
+			if ( t<t2 ) t2=t;
+		}
+	} else {
+		t = transform_apply(t1,xform,NULL);
+		if ( t<t2 ) t2=t;
+	}
+	return t2;
+}
 
-	/* process the schedule transformations */
-	for (xform=schedule_xformlist; xform!=NULL; xform=xform->next)
+/* apply a transform list one transform at a time */
+static TIMESTAMP transform_walk(TRANSFORM *list, TIMESTAMP t1, TRANSFORMSOURCE source)
+{
+	TRANSFORM *xform;
+	TIMESTAMP t2 = TS_NEVER, t;
+	for (xform=list; xform!=NULL; xform=xform->next)
 	{	
 		if (xform->source_type&source){
-			if((xform->source_type == XS_SCHEDULE) && (xform->target_obj->schedule_skew != 0)){
-			    tskew = t1 - xform->target_obj->schedule_skew; // subtract so the +12 is 'twelve seconds later', not earlier
-			    SCHEDULEINDEX index = schedule_index(xform->source_schedule,tskew);
-			    int32 dtnext = schedule_dtnext(xform->source_schedule,index)*60;
-			    double value = schedule_value(xform->source_schedule,index);
-			    t = (dtnext == 0 ? TS_NEVER : t1 + dtnext - (tskew % 60));
-			    if ( t < t2 ) t2 = t;
-				if((tskew <= xform->source_schedule->since) || (tskew >= xform->source_schedule->next_t)){
-					t = transform_apply(t1,xform,&value);
-					if ( t<t2 ) t2=t;
-				} 
-				else 
+			t = transform_update(t1,xform);
+			if ( t<t2 ) t2=t;
+		}
+	}
+	return t2;
+}
+
+/****************************************************************
+ * Transform batching
+ ****************************************************************/
+
+/* Linear transforms fed by a schedule are by far the most common transforms
+   (typically one per scheduled enduse or house parameter).  Before the list is
+   first applied it is compiled into a sequence of steps.  Consecutive linear
+   schedule transforms onto double properties are grouped by schedule and skew
+   so that each group does one schedule lookup and evaluates all its targets
+   with a loop over contiguous coefficients that the compiler can vectorize.
+   All other transforms remain single steps in their original order.  The skew
+   of the targets is checked on every pass, and when one has changed the batch
+   is applied one transform at a time and the list is compiled again.
+ */
+static int transform_batchable(TRANSFORM *xform)
+{
+	return xform->function_type==XT_LINEAR 
+		&& xform->source_type==XS_SCHEDULE 
+		&& xform->source_schedule!=NULL 
+		&& xform->target_prop->ptype==PT_double;
+}
+typedef struct s_transformtarget {
+	void *addr; ///< target address
+	size_t pos; ///< position in the transform list
+} TRANSFORMTARGET;
+static int compare_target(const void *a, const void *b)
+{
+	void *x = ((TRANSFORMTARGET*)a)->addr, *y = ((TRANSFORMTARGET*)b)->addr;
+	return x<y ? -1 : ( x>y ? 1 : 0 );
+}
+static int compare_source(const void *a, const void *b)
+{
+	TRANSFORM *x = *(TRANSFORM**)a, *y = *(TRANSFORM**)b;
+	TIMESTAMP xskew = x->target_obj->schedule_skew, yskew = y->target_obj->schedule_skew;
+	if ( x->source_schedule!=y->source_schedule ) return x->source_schedule<y->source_schedule ? -1 : 1;
+	if ( x->source!=y->source ) return x->source<y->source ? -1 : 1;
+	if ( xskew!=yskew ) return xskew<yskew ? -1 : 1;
+	return 0;
+}
+static void transform_program_free(TRANSFORMPROGRAM *prog)
+{
+	size_t n;
+	if ( prog==NULL ) return;
+	for ( n=0 ; n<prog->n ; n++ )
+	{
+		TRANSFORMBATCH *batch = prog->step[n].batch;
+		if ( batch==NULL ) continue;
+		free(batch->xform);
+		free(batch->target_skew);
+		free(batch->target);
+		free(batch->scale);
+		free(batch->bias);
+		free(batch->value);
+		free(batch);
+	}
+	free(prog->step);
+	free(prog);
+}
+static void transform_invalidate(void)
+{
+	transform_program_free(schedule_xformprog);
+	schedule_xformprog = NULL;
+}
+static TRANSFORMBATCH *transform_batch_create(TRANSFORM **xform, unsigned int n)
+{
+	unsigned int i;
+	TRANSFORMBATCH *batch = (TRANSFORMBATCH*)malloc(sizeof(TRANSFORMBATCH));
+	if ( batch==NULL )
+		return NULL;
+	batch->schedule = xform[0]->source_schedule;
+	batch->source = xform[0]->source;
+	batch->skew = xform[0]->target_obj->schedule_skew;
+	batch->n = n;
+	batch->xform = (TRANSFORM**)malloc(sizeof(TRANSFORM*)*n);
+	batch->target_skew = (TIMESTAMP**)malloc(sizeof(TIMESTAMP*)*n);
+	batch->target = (double**)malloc(sizeof(double*)*n);
+	batch->scale = (double*)malloc(sizeof(double)*n);
+	batch->bias = (double*)malloc(sizeof(double)*n);
+	batch->value = (double*)malloc(sizeof(double)*n);
+	if ( batch->xform==NULL || batch->target_skew==NULL || batch->target==NULL || batch->scale==NULL || batch->bias==NULL || batch->value==NULL )
+	{
+		free(batch->xform);
+		free(batch->target_skew);
+		free(batch->target);
+		free(batch->scale);
+		free(batch->bias);
+		free(batch->value);
+		free(batch);
+		return NULL;
+	}
+	for ( i=0 ; i<n ; i++ )
+	{
+		batch->xform[i] = xform[i];
+		batch->target_skew[i] = &(xform[i]->target_obj->schedule_skew);
+		batch->target[i] = xform[i]->target;
+		batch->scale[i] = xform[i]->scale;
+		batch->bias[i] = xform[i]->bias;
+	}
+	return batch;
+}
+/* compile a transform list into steps
+   @return the program, or NULL if it could not be built (the list must then be walked)
+ */
+static TRANSFORMPROGRAM *transform_compile(TRANSFORM *list)
+{
+	TRANSFORMPROGRAM *prog;
+	TRANSFORM *xform, **item;
+	TRANSFORMTARGET *sorted;
+	char *single;
+	size_t n, i, j, k, count=0, nbatches=0, nbatched=0;
+
+	for ( xform=list ; xform!=NULL ; xform=xform->next )
+		count++;
+	prog = (TRANSFORMPROGRAM*)malloc(sizeof(TRANSFORMPROGRAM));
+	item = (TRANSFORM**)malloc(sizeof(TRANSFORM*)*(count+1));
+	sorted = (TRANSFORMTARGET*)malloc(sizeof(TRANSFORMTARGET)*(count+1));
+	single = (char*)malloc(count+1);
+	if ( prog==NULL || item==NULL || sorted==NULL || single==NULL )
+		goto Failed;
+	prog->n = 0;
+	prog->stale = 0;
+	prog->step = (TRANSFORMSTEP*)malloc(sizeof(TRANSFORMSTEP)*(count+1));
+	if ( prog->step==NULL )
+		goto Failed;
+
+	/* transforms that share a target must be applied in list order so they cannot be batched */
+	for ( n=0,xform=list ; xform!=NULL ; xform=xform->next,n++ )
+	{
+		item[n] = xform;
+		single[n] = !transform_batchable(xform);
+		sorted[n].addr = single[n] ? NULL : xform->target;
+		sorted[n].pos = n;
+	}
+	qsort(sorted,count,sizeof(TRANSFORMTARGET),compare_target);
+	for ( n=1 ; n<count ; n++ )
+	{
+		if ( sorted[n].addr!=NULL && sorted[n].addr==sorted[n-1].addr )
+			single[sorted[n].pos] = single[sorted[n-1].pos] = 1;
+	}
+
+	/* build the steps */
+	for ( i=0 ; i<count ; i=j )
+	{
+		if ( single[i] )
+		{
+			prog->step[prog->n].xform = item[i];
+			prog->step[prog->n].batch = NULL;
+			prog->n++;
+			j = i+1;
+			continue;
+		}
+
+		/* group the run of batchable transforms by source and skew */
+		for ( j=i ; j<count && !single[j] ; j++ ) {}
+		qsort(item+i,j-i,sizeof(TRANSFORM*),compare_source);
+		for ( k=i ; k<j ; k=n )
+		{
+			TRANSFORMBATCH *batch;
+			for ( n=k+1 ; n<j && compare_source(item+k,item+n)==0 ; n++ ) {}
+			batch = transform_batch_create(item+k,(unsigned int)(n-k));
+			if ( batch==NULL )
+				goto Failed;
+			prog->step[prog->n].xform = NULL;
+			prog->step[prog->n].batch = batch;
+			prog->n++;
+			nbatches++;
+			nbatched += n-k;
+		}
+	}
+	output_verbose("transform list compiled into %d steps (%d transforms in %d batches)", (int)prog->n, (int)nbatched, (int)nbatches);
+	free(item);
+	free(sorted);
+	free(single);
+	return prog;
+
+Failed:
+	output_error("transform_compile(): memory allocation failure");
+	/* TROUBLESHOOT
+		The system has run out of memory while grouping transforms into batches.  The transforms
+		will still be applied one at a time, but you should try freeing up system memory.
+	 */
+	transform_program_free(prog);
+	free(item);
+	free(sorted);
+	free(single);
+	return NULL;
+}
+
+/* check that the targets of a batch still have the skew it was compiled with */
+static int transform_batch_current(TRANSFORMBATCH *batch)
+{
+	unsigned int i;
+	for ( i=0 ; i<batch->n ; i++ )
+	{
+		if ( *(batch->target_skew[i])!=batch->skew )
+			return 0;
+	}
+	return 1;
+}
+
+/* apply a batch of linear schedule transforms */
+static TIMESTAMP transform_apply_batch(TIMESTAMP t1, TRANSFORMBATCH *batch)
+{
+	TIMESTAMP t2 = TS_NEVER;
+	double x = *(batch->source);
+	double *value = batch->value;
+	const double *scale = batch->scale, *bias = batch->bias;
+	unsigned int i, n = batch->n;
+
+	if ( batch->skew!=0 )
+	{
+		TIMESTAMP tskew = t1 - batch->skew; // same as transform_update()
+		SCHEDULEINDEX index = schedule_index(batch->schedule,tskew);
+		int32 dtnext = schedule_dtnext(batch->schedule,index)*60;
+		t2 = (dtnext == 0 ? TS_NEVER : t1 + dtnext - (tskew % 60));
+		if ( (tskew <= batch->schedule->since) || (tskew >= batch->schedule->next_t) )
+			x = schedule_value(batch->schedule,index);
+	}
+
+	/* evaluate (vectorizable) */
+	for ( i=0 ; i<n ; i++ )
+		value[i] = x * scale[i] + bias[i];
+
+	/* store and report changes */
+	for ( i=0 ; i<n ; i++ )
+	{
+		if ( *(batch->target[i])!=value[i] )
+			object_notify_change(batch->xform[i]->target_obj,batch->xform[i]->target_prop);
+		*(batch->target[i]) = value[i];
+	}
+	return t2;
+}
+
+/* apply a compiled transform list */
+static TIMESTAMP transform_run(TRANSFORMPROGRAM *prog, TIMESTAMP t1, TRANSFORMSOURCE source)
+{
+	TIMESTAMP t2 = TS_NEVER, t;
+	TRANSFORMSTEP *step;
+	for ( step=prog->step ; step<prog->step+prog->n ; step++ )
+	{
+		if ( step->batch!=NULL )
+		{
+			unsigned int i;
+			if ( (source&XS_SCHEDULE)==0 )
+				continue;
+			if ( transform_batch_current(step->batch) )
+				t = transform_apply_batch(t1,step->batch);
+			else
+			{
+				/* the batch must be regrouped, so apply its transforms with their own skews for now */
+				for ( i=0, t=TS_NEVER ; i<step->batch->n ; i++ )
 				{
-					t = transform_apply(t1,xform,NULL);
-					if ( t<t2 ) t2=t;
+					TIMESTAMP t3 = transform_update(t1,step->batch->xform[i]);
+					if ( t3<t ) t=t3;
 				}
-			} else {
-				t = transform_apply(t1,xform,NULL);
-				if ( t<t2 ) t2=t;
+				prog->stale = 1;
 			}
 		}
+		else if ( step->xform->source_type&source )
+			t = transform_update(t1,step->xform);
+		else
+			continue;
+		if ( t<t2 ) t2=t;
 	}
+	return t2;
+}
+
+clock_t transform_synctime = 0;
+TIMESTAMP transform_syncall(TIMESTAMP t1, TRANSFORMSOURCE source)
+{
+	clock_t start = (clock_t)exec_clock();
+	TIMESTAMP t2;
+
+	if ( schedule_xformprog==NULL && schedule_xformlist!=NULL )
+		schedule_xformprog = transform_compile(schedule_xformlist);
+	if ( schedule_xformprog!=NULL )
+	{
+		t2 = transform_run(schedule_xformprog,t1,source);
+		if ( schedule_xformprog->stale )
+			transform_invalidate();
+	}
+	else
+		t2 = transform_walk(schedule_xformlist,t1,source);
 	transform_synctime += (clock_t)exec_clock() - start;
 	return t2;
 }
@@ -482,3 +837,137 @@ int transform_saveall(FILE *fp)
 	}
 	return count;
 }
+
+/** Test the transform batching against the single transform implementation
+	and report the time taken by each for a large set of schedule transforms
+	@return the number of tests failed
+ **/
+int transform_test(void)
+{
+	const unsigned int n_objects = 25000, n_targets = 4;
+	const unsigned int n = n_objects*n_targets;
+	const TIMESTAMP skew[] = {0,0,900,-1800,3600};
+	SCHEDULE *sched[2];
+	OBJECT *obj = (OBJECT*)calloc(n_objects,sizeof(OBJECT));
+	PROPERTY prop;
+	TRANSFORM *xform = (TRANSFORM*)calloc(2*n,sizeof(TRANSFORM));
+	double *target = (double*)calloc(2*n,sizeof(double));
+	TRANSFORM *single_list = NULL, *batch_list = NULL;
+	TRANSFORMPROGRAM *prog;
+	TIMESTAMP t, start = convert_to_timestamp("2010/07/04 00:00:00");
+	clock_t single_time = 0, batch_time = 0, t0;
+	unsigned int i, passes = 0, recompiles = 0, failed = 0, ok = 0;
+
+	output_test("\nBEGIN: transform tests");
+	if ( obj==NULL || xform==NULL || target==NULL )
+	{
+		output_error("transformtest: memory allocation failed");
+		free(obj); free(xform); free(target);
+		return 1;
+	}
+	sched[0] = schedule_create("transformtest-load","* 0-6 * * * 0.3; * 7-17 * * * 0.7; * 18-23 * * * 1.1;");
+	sched[1] = schedule_create("transformtest-setpoint","* 0-5 * * * 72; * 6-21 * * * 76; * 22-23 * * * 72;");
+	if ( sched[0]==NULL || sched[1]==NULL )
+	{
+		output_error("transformtest: unable to create test schedules");
+		free(obj); free(xform); free(target);
+		return 1;
+	}
+	memset(&prop,0,sizeof(prop));
+	strcpy(prop.name,"value");
+	prop.ptype = PT_double;
+
+	/* two identical sets of transforms onto separate targets */
+	for ( i=0 ; i<n_objects ; i++ )
+		obj[i].schedule_skew = skew[i%(sizeof(skew)/sizeof(skew[0]))];
+	for ( i=0 ; i<2*n ; i++ )
+	{
+		unsigned int k = i%n;
+		SCHEDULE *s = sched[k%2];
+		TRANSFORM *x = xform+i;
+		x->source_type = XS_SCHEDULE;
+		x->source = &(s->value);
+		x->source_addr = &(s->value);
+		x->source_schedule = s;
+		x->target_obj = obj+k/n_targets;
+		x->target_prop = &prop;
+		x->target = target+i;
+		x->scale = 1.0 + 0.1*(k%7);
+		x->bias = (double)(k%3);
+		x->function_type = XT_LINEAR;
+		if ( i<n ) { x->next = single_list; single_list = x; }
+		else { x->next = batch_list; batch_list = x; }
+	}
+	prog = transform_compile(batch_list);
+	if ( prog==NULL )
+	{
+		output_error("transformtest: unable to compile transforms");
+		free(obj); free(xform); free(target);
+		return 1;
+	}
+
+	/* run two days in 5 minute steps, moving a third of the targets to another skew after the first day */
+	for ( t=start ; t<start+2*86400 ; t+=300, passes++ )
+	{
+		TIMESTAMP t2single, t2batch;
+		char ts[64];
+		if ( t==start+86400 )
+		{
+			for ( i=0 ; i<n_objects ; i+=3 )
+				obj[i].schedule_skew += 600;
+		}
+		schedule_sync(sched[0],t);
+		schedule_sync(sched[1],t);
+		t0 = clock();
+		t2single = transform_walk(single_list,t,XS_SCHEDULE);
+		single_time += clock()-t0;
+		t0 = clock();
+		t2batch = transform_run(prog,t,XS_SCHEDULE);
+		batch_time += clock()-t0;
+		if ( t2single!=t2batch || memcmp(target,target+n,sizeof(double)*n)!=0 )
+		{
+			output_test(" ! batched transforms differ from single transforms at %s", convert_from_timestamp(t,ts,sizeof(ts))?ts:"???");
+			failed++;
+		}
+		else
+			ok++;
+		if ( prog->stale )
+		{
+			transform_program_free(prog);
+			prog = transform_compile(batch_list);
+			if ( prog==NULL )
+			{
+				output_error("transformtest: unable to recompile transforms");
+				free(obj); free(xform); free(target);
+				return 1;
+			}
+			recompiles++;
+		}
+	}
+	if ( recompiles!=1 )
+	{
+		output_test(" ! transforms were compiled again %d times after the skew change", recompiles);
+		failed++;
+	}
+	output_test("transformtest: %d transforms in %d steps, %d passes", n, (int)prog->n, passes);
+	output_message("transformtest: %d transforms, single %.3f ms/pass, batched %.3f ms/pass", n,
+		(double)single_time*1000/CLOCKS_PER_SEC/passes, (double)batch_time*1000/CLOCKS_PER_SEC/passes);
+	transform_program_free(prog);
+	free(obj);
+	free(xform);
+	free(target);
+
+	/* report results */
+	if (failed)
+	{
+		output_error("transformtest: %d transform tests failed--see test.txt for more information",failed);
+		output_test("!!! %d transform tests failed",failed);
+	}
+	else
+	{
+		output_verbose("%d transform tests completed with no errors--see test.txt for details",ok);
+		output_test("transformtest: %d transform tests completed, 0 errors found",ok);
+	}
+	output_test("END: transform tests");
+	return failed;
+}
@@ -111,6 +111,7 @@ int transform_add_filter(struct s_object_list *target_obj, struct s_property_map
 int transfer_function_add(char *tfname, char *domain, double timestep, double timeskew, unsigned int n, double *a, unsigned int m, double *b);
 
 int transform_saveall(FILE *fp);
+int transform_test(void);
 
 #ifdef __cplusplus
 }
@@ -399,20 +399,47 @@ int auction::init(OBJECT *parent)
 	if(statistic_count > 0){
 		statdata = (double *)malloc(sizeof(double) * statistic_count);
 	}
-	if(longest_statistic > 0){
-		history_count = (uint32)longest_statistic / (uint32)(this->period) + 2;
-		new_prices = (double *)malloc(sizeof(double) * history_count);
-		new_market_failures = (double *)malloc(sizeof(double) * history_count);
-	} else {
-		history_count = 1;
-		new_prices = (double *)malloc(sizeof(double));
-		new_market_failures = (double *)malloc(sizeof(double));
-	}
-	price_index = 0;
 	price_count = 0;
-	for(i = 0; i < history_count; ++i){
-		new_prices[i] = init_price;
-		new_market_failures[i] = CT_EXACT; // initialize all markets as NOT FAILED
+	past_price = init_price;
+	past_clearing_type = CT_EXACT; // initialize all markets as NOT FAILED
+	if(statistic_count > 0){
+		STATISTIC *stat, *other;
+		stat_windows = (STATWINDOW **)malloc(sizeof(STATWINDOW *) * statistic_count);
+		for(i = 0, stat = stats; stat != NULL; ++i, stat = stat->next){
+			uint32 sample_need = (uint32)(stat->interval / this->period);
+			uint32 j;
+			// the mean and stdev over the same frame and interval share a window
+			stat_windows[i] = NULL;
+			for(j = 0, other = stats; j < i; ++j, other = other->next){
+				if(other->stat_mode == stat->stat_mode && other->interval == stat->interval){
+					stat_windows[i] = stat_windows[j];
+					break;
+				}
+			}
+			if(stat_windows[i] != NULL){
+				continue;
+			}
+			if(sample_need == 0){
+				continue; // shorter than the market period, the statistic has no samples
+			}
+			stat_windows[i] = gl_statwindow_create(sample_need);
+			if(stat_windows[i] == NULL){
+				gl_error("auction unable to create the price window for statistic '%s'", stat->prop->name);
+				/* TROUBLESHOOT
+					The window that holds the prices of a market statistic could not be created.  Check
+					the previous error messages for the cause.
+					*/
+				return 0;
+			}
+			// the history starts with every market clearing at the initial price
+			for(j = 0; j < sample_need; ++j){
+				if((ignore_pricecap == IP_TRUE) && ((init_price == pricecap) || (init_price == -pricecap))){
+					gl_statwindow_skip(stat_windows[i]);
+				} else {
+					gl_statwindow_add(stat_windows[i], init_price);
+				}
+			}
+		}
 	}
 
 	if(init_stdev < 0.0){
@@ -529,17 +556,14 @@ int auction::init_statistics(){
 int auction::update_statistics(){
 	OBJECT *obj = OBJECTHDR(this);
 	STATISTIC *current = 0;
+	STATWINDOW *window = 0;
 	uint32 sample_need = 0;
-	unsigned int start = 0, stop = 0;
 	unsigned int i = 0;
-	unsigned int idx = 0;
-	unsigned int skipped = 0;
 	double mean = 0.0;
-	double stdev = 0.0;
 	if(statistic_count < 1){
 		return 1; // no statistics
 	}
-	if(new_prices == 0){
+	if(stat_windows == 0){
 		return 0;
 	}
 	if(statdata == 0){
@@ -548,27 +572,11 @@ int auction::update_statistics(){
 	if(stats == 0){
 		return 1; // should've been caught with statistic_count < 1
 	}
-	for(current = stats; current != 0; current = current->next){
-		mean = 0.0;
+	for(i = 0, current = stats; current != 0; ++i, current = current->next){
+		window = stat_windows[i];
 		sample_need = (uint32)(current->interval / this->period);
-		if(current->stat_mode == ST_CURR){
-			stop = price_index;
-		} else if(current->stat_mode == ST_PAST){
-			stop = price_index - 1;
-		}
-		start = (unsigned int)((history_count + stop - sample_need) % history_count); // one off for initial period delay
-		for(i = 0; i < sample_need; ++i){
-			idx = (start + i + history_count) % history_count;
-			if( (ignore_pricecap == IP_TRUE) && ((new_prices[idx] == pricecap) || (new_prices[idx] == -pricecap))){
-				++skipped;
-			} else if( (ignore_failedmarket == IFM_TRUE) && (new_market_failures[idx] == CT_FAILURE) )  {
-				++skipped;
-			} else {
-				mean += new_prices[idx];
-			}
-		}
-		if(skipped != sample_need){
-			mean /= (sample_need - skipped);
+		if(window != 0 && gl_statwindow_get(window, SWV_COUNT) > 0){
+			mean = gl_statwindow_get(window, SWV_MEAN);
 		} else {
 			mean = 0; // problem!
 			gl_warning("All values in auction statistic calculations were skipped. Setting mean to zero.");
@@ -584,31 +592,15 @@ int auction::update_statistics(){
 		if(current->stat_type == SY_MEAN){
 			current->value = mean;
 		} else if(current->stat_type == SY_STDEV){
-			double x = 0.0;
 			if(sample_need + (current->stat_mode == ST_PAST ? 1 : 0) > total_samples){ // extra sample for 'past' values
 				//	still in initial period, use init_stdev
 				current->value = init_stdev;
+			} else if(window != 0 && gl_statwindow_get(window, SWV_COUNT) > 0){
+				// deviation about the mean used, which is not the window mean when future prices are used
+				double offset = gl_statwindow_get(window, SWV_MEAN) - mean;
+				current->value = sqrt(gl_statwindow_get(window, SWV_VARIANCE) + offset * offset);
 			} else {
-				stdev = 0.0;
-				for(i = 0; i < sample_need; ++i){
-					idx = (start + i + history_count) % history_count;
-					if( (ignore_pricecap == IP_TRUE) && ((new_prices[idx] == pricecap) || (new_prices[idx] == -pricecap))){
-						// Ignore the value
-					}
-					else if( (ignore_failedmarket == IFM_TRUE) && (new_market_failures[idx] == CT_FAILURE) ) {
-						// Ignore the value
-					}
-					else {
-						x = new_prices[idx] - mean;
-						stdev += x * x;
-					}
-				}
-				if(skipped != sample_need){
-					stdev /= (sample_need - skipped);
-				} else {
-					stdev = 0; // problem!
-				}
-				current->value = sqrt(stdev);
+				current->value = 0; // problem!
 			}
 		}
 		if(statistic_mode == ST_ON){
@@ -620,6 +612,31 @@ int auction::update_statistics(){
 	return 1;
 }
 
+/*	Add a market clearing to the price windows of the statistics.  The current windows
+	get the new clearing and the past windows get the clearing before it. */
+void auction::push_statistics(double price, enumeration type){
+	STATISTIC *stat = 0;
+	unsigned int i = 0, j = 0;
+	for(i = 0, stat = stats; stat != 0; ++i, stat = stat->next){
+		double value = (stat->stat_mode == ST_PAST ? past_price : price);
+		enumeration value_type = (stat->stat_mode == ST_PAST ? past_clearing_type : type);
+		// skip windows shared with an earlier statistic
+		for(j = 0; j < i && stat_windows[j] != stat_windows[i]; ++j);
+		if(j < i || stat_windows[i] == 0){
+			continue;
+		}
+		if( (ignore_pricecap == IP_TRUE) && ((value == pricecap) || (value == -pricecap))){
+			gl_statwindow_skip(stat_windows[i]);
+		} else if( (ignore_failedmarket == IFM_TRUE) && (value_type == CT_FAILURE) ) {
+			gl_statwindow_skip(stat_windows[i]);
+		} else {
+			gl_statwindow_add(stat_windows[i], value);
+		}
+	}
+	past_price = price;
+	past_clearing_type = type;
+}
+
 /*	Take the current market values and enqueue them on the end of the latency frame queue. */
 int auction::push_market_frame(TIMESTAMP t1){
 	MARKETFRAME *frame = 0;
@@ -1369,14 +1386,8 @@ void auction::clear_market(void)
 		marginal_frac = 0.0;
 	}
 
-	if(history_count > 0){
-		if(price_index == history_count){
-			price_index = 0;
-		}
-		new_prices[price_index] = next.price;
-		new_market_failures[price_index] = current_frame.clearing_type;
-		//int update_rv = update_statistics();
-		++price_index;
+	if(stat_windows != 0){
+		push_statistics(next.price, current_frame.clearing_type);
 	}
 
 	/* limit price */
@@ -69,6 +69,7 @@ private:
 	// functions
 	int init_statistics();
 	int update_statistics();
+	void push_statistics(double price, enumeration type);
 	int push_market_frame(TIMESTAMP t1);
 	int check_next_market(TIMESTAMP t1);
 	TIMESTAMP pop_market_frame(TIMESTAMP t1);
@@ -118,12 +119,11 @@ public:
 	double clearing_scalar;
 	
 	// statistics
-	double *new_prices;
-	double *new_market_failures; //0 indicates it did NOT fail, 1 indicates failure
+	STATWINDOW **stat_windows; // price window of each statistic, shared by statistics of the same frame and interval
+	double past_price; // last clearing price, which enters the past windows at the next clearing
+	enumeration past_clearing_type;
 	double *statdata;
-	unsigned int price_index;
 	unsigned int64 price_count;
-	uint32 history_count;
 	// latency market frame queue
 	MARKETFRAME next_frame;
 	MARKETFRAME past_frame;
@@ -82,6 +82,14 @@ EXPORT CLASS *init(CALLBACKS *fntable, MODULE *module, int argc, char *argv[])
 	gl_global_create("powerflow::NR_iteration_limit",PT_int64,&NR_iteration_limit,NULL);
 	gl_global_create("powerflow::NR_deltamode_iteration_limit",PT_int64,&NR_delta_iteration_limit,NULL);
 	gl_global_create("powerflow::NR_superLU_procs",PT_int32,&NR_superLU_procs,NULL);
+	gl_global_create("powerflow::NR_voltage_predictor",PT_bool,&NR_voltage_predictor,PT_DESCRIPTION,"Extrapolate the initial Newton-Raphson voltages from the last two converged solutions",NULL);
+	gl_global_create("powerflow::NR_chord_iterations",PT_int64,&NR_chord_iterations,PT_DESCRIPTION,"Number of initial Newton-Raphson iterations that may reuse the previous Jacobian factorization (0 disables)",NULL);
+	gl_global_create("powerflow::NR_chord_mismatch_limit",PT_double,&NR_chord_mismatch_limit,PT_UNITS,"V",PT_DESCRIPTION,"Voltage update above which a reused Jacobian factorization is discarded",NULL);
+	gl_global_create("powerflow::NR_deltamode_frozen_jacobian",PT_bool,&NR_deltamode_frozen_jacobian,PT_DESCRIPTION,"Reuse the Newton-Raphson factorization across deltamode steps until a topology/admittance change or a non-contracting update",NULL);
+	gl_global_create("powerflow::NR_solution_count",PT_int64,&NR_solution_count,PT_DESCRIPTION,"Number of Newton-Raphson solutions performed",NULL);
+	gl_global_create("powerflow::NR_iteration_count",PT_int64,&NR_iteration_count,PT_DESCRIPTION,"Total Newton-Raphson iterations performed",NULL);
+	gl_global_create("powerflow::NR_chord_count",PT_int64,&NR_chord_count,PT_DESCRIPTION,"Newton-Raphson iterations solved with a reused Jacobian factorization",NULL);
+	gl_global_create("powerflow::NR_solver_time",PT_double,&NR_solver_time,PT_UNITS,"s",PT_DESCRIPTION,"Total wall time spent in the Newton-Raphson solver",NULL);
 	gl_global_create("powerflow::default_maximum_voltage_error",PT_double,&default_maximum_voltage_error,NULL);
 	gl_global_create("powerflow::default_maximum_power_error",PT_double,&default_maximum_power_error,NULL);
 	gl_global_create("powerflow::NR_admit_change",PT_bool,&NR_admit_change,NULL);
@@ -445,6 +453,18 @@ EXPORT STATUS postupdate(MODULE *module, TIMESTAMP t0, unsigned int64 dt)
 	}
 }
 
+//nextstep function of deltamode
+//Module-level call after each deltamode timestep when the timestep may vary
+//The phasor solution does not depend on the timestep, but the in-rush companion
+//models are built for the timestep they started with, so they hold it
+EXPORT unsigned long deltamode_nextstep(MODULE *module, TIMESTAMP t0, unsigned int64 delta_time, unsigned long dt)
+{
+	if ((enable_subsecond_models == true) && (enable_inrush_calculations == true))
+		return dt;
+	else
+		return DT_INFINITY;
+}
+
 //Extra function for deltamode calls - allows module-level calls "out of order"
 //mode variable is for selection of call (only 1 for now)
 int delta_extra_function(unsigned int mode)
@@ -492,6 +512,19 @@ int delta_extra_function(unsigned int mode)
 	return 1;	
 }
 
+//Module termination function
+//Reports the Newton-Raphson solver statistics and releases any retained factorization
+EXPORT void term(void)
+{
+	if (NR_solution_count > 0)
+	{
+		gl_verbose("powerflow: %lld Newton-Raphson solutions, %lld iterations (%.2f per solution, %lld reused factorizations), %.3f s solver time",
+			NR_solution_count, NR_iteration_count, (double)NR_iteration_count/(double)NR_solution_count, NR_chord_count, NR_solver_time);
+	}
+
+	NR_chord_release();
+}
+
 CDECL int do_kill()
 {
 	/* if global memory needs to be released, this is a good time to do it */
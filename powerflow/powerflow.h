@@ -75,6 +75,14 @@ GLOBAL TIMESTAMP NR_retval INIT(TS_NEVER);			/**< Newton-Raphson current return
 GLOBAL OBJECT *NR_swing_bus INIT(NULL);				/**< Newton-Raphson swing bus */
 GLOBAL int NR_swing_bus_reference INIT(-1);			/**< Newton-Raphson swing bus index reference in NR_busdata */
 GLOBAL int64 NR_delta_iteration_limit INIT(10);		/**< Newton-Raphson iteration limit (per deltamode timestep) */
+GLOBAL bool NR_voltage_predictor INIT(false);		/**< Newton-Raphson initial voltage guess extrapolated from the last two converged solutions */
+GLOBAL int64 NR_chord_iterations INIT(0);			/**< Newton-Raphson iterations per solution that may reuse the previous Jacobian factorization (0=disabled) */
+GLOBAL double NR_chord_mismatch_limit INIT(1.0);	/**< Newton-Raphson voltage update [V] above which a reused Jacobian factorization is discarded */
+GLOBAL bool NR_deltamode_frozen_jacobian INIT(false);	/**< Newton-Raphson deltamode steps reuse the factorization from the last topology/admittance change */
+GLOBAL int64 NR_solution_count INIT(0);				/**< Newton-Raphson statistics - number of solver_nr calls */
+GLOBAL int64 NR_iteration_count INIT(0);			/**< Newton-Raphson statistics - total iterations over all solver_nr calls */
+GLOBAL int64 NR_chord_count INIT(0);				/**< Newton-Raphson statistics - iterations solved with a reused Jacobian factorization */
+GLOBAL double NR_solver_time INIT(0.0);				/**< Newton-Raphson statistics - total wall time spent in solver_nr [s] */
 GLOBAL bool FBS_swing_set INIT(false);				/**< Forward-Back Sweep swing assignment variable */
 GLOBAL bool show_matrix_values INIT(false);			/**< flag to enable dumping matrix calculations as they occur */
 GLOBAL double primary_voltage_ratio INIT(60.0);		/**< primary voltage ratio (@todo explain primary_voltage_ratio in powerflow (ticket #131) */
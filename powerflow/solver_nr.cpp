@@ -46,6 +46,13 @@ Initialization after returning to service?
 /* access to module global variables */
 #include "powerflow.h"
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
 //Generic solver variables
 NR_SOLVER_VARS matrices_LU;
 
@@ -56,6 +63,12 @@ SuperMatrix A_LU,B_LU;
 //External solver global
 void *ext_solver_glob_vars;
 
+//Retained factorization for chord (Shamanskii) Newton iterations
+SuperMatrix L_LU_chord, U_LU_chord;
+bool LU_chord_valid = false;
+unsigned int LU_chord_size = 0;
+NRSOLVERMODE LU_chord_type = PF_NORMAL;
+
 //Initialize the sparse notation
 void sparse_init(SPARSE* sm, int nels, int ncols)
 {
@@ -221,6 +234,136 @@ void sparse_tonr(SPARSE* sm, NR_SOLVER_VARS *matrices_LU)
 	}
 }
 
+//Wall clock for the solver statistics
+double NR_wallclock(void)
+{
+#ifdef _WIN32
+	//the performance counter has far finer resolution than clock()
+	static LARGE_INTEGER freq = {0};
+	LARGE_INTEGER now;
+	if (freq.QuadPart == 0)
+		QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&now);
+	return (double)now.QuadPart/(double)freq.QuadPart;
+#else
+	struct timeval tv;
+	gettimeofday(&tv,NULL);
+	return (double)tv.tv_sec + (double)tv.tv_usec*1e-6;
+#endif
+}
+
+//Release the factorization retained for chord iterations, if any
+void NR_chord_release(void)
+{
+	if (LU_chord_valid == true)
+	{
+#ifdef MT
+		Destroy_SuperNode_SCP(&L_LU_chord);
+		Destroy_CompCol_NCP(&U_LU_chord);
+#else
+		Destroy_SuperNode_Matrix(&L_LU_chord);
+		Destroy_CompCol_Matrix(&U_LU_chord);
+#endif
+		LU_chord_valid = false;
+	}
+}
+
+//Determine which of the three voltage entries of a bus the solver updates - bit 0 = V[0], bit 1 = V[1], bit 2 = V[2]
+static unsigned char NR_updated_phases(BUSDATA *bus_entry)
+{
+	unsigned char mask = 0;
+
+	if ((bus_entry->phases & 0x80) == 0x80)	//Split phase - 1 and 2 only
+		return 0x03;
+
+	if ((bus_entry->phases & 0x04) == 0x04)	//A
+		mask |= 0x01;
+	if ((bus_entry->phases & 0x02) == 0x02)	//B
+		mask |= 0x02;
+	if ((bus_entry->phases & 0x01) == 0x01)	//C
+		mask |= 0x04;
+
+	return mask;
+}
+
+//Store converged voltages for the initial voltage predictor - keeps the last solution of the last two timesteps
+static void NR_store_voltages(unsigned int bus_count, BUSDATA *bus, NR_SOLVER_STRUCT *powerflow_values)
+{
+	unsigned int indexer;
+	complex *temp_hist;
+
+	//Allocate the history on first use
+	if (powerflow_values->V_hist_last == NULL)
+	{
+		powerflow_values->V_hist_last = (complex *)gl_malloc(3*bus_count*sizeof(complex));
+		powerflow_values->V_hist_prev = (complex *)gl_malloc(3*bus_count*sizeof(complex));
+
+		if ((powerflow_values->V_hist_last == NULL) || (powerflow_values->V_hist_prev == NULL))
+		{
+			GL_THROW("NR: Failed to allocate memory for one of the necessary matrices");
+			//Defined elsewhere
+		}
+
+		powerflow_values->V_hist_time[0] = 0;
+		powerflow_values->V_hist_time[1] = 0;
+	}
+
+	//New timestep - shift the history, otherwise just refresh the latest solution
+	if (powerflow_values->V_hist_time[0] != gl_globalclock)
+	{
+		temp_hist = powerflow_values->V_hist_prev;
+		powerflow_values->V_hist_prev = powerflow_values->V_hist_last;
+		powerflow_values->V_hist_last = temp_hist;
+		powerflow_values->V_hist_time[1] = powerflow_values->V_hist_time[0];
+		powerflow_values->V_hist_time[0] = gl_globalclock;
+	}
+
+	for (indexer=0; indexer<bus_count; indexer++)
+	{
+		powerflow_values->V_hist_last[3*indexer] = bus[indexer].V[0];
+		powerflow_values->V_hist_last[3*indexer+1] = bus[indexer].V[1];
+		powerflow_values->V_hist_last[3*indexer+2] = bus[indexer].V[2];
+	}
+}
+
+//Extrapolate the initial voltages of PQ buses from the last two converged timesteps
+static void NR_predict_voltages(unsigned int bus_count, BUSDATA *bus, NR_SOLVER_STRUCT *powerflow_values)
+{
+	unsigned int indexer;
+	unsigned char phase_mask, jindex;
+	double ratio;
+	TIMESTAMP t_last = powerflow_values->V_hist_time[0];
+	TIMESTAMP t_prev = powerflow_values->V_hist_time[1];
+
+	//Need two distinct solutions in the past, and only predict once per timestep
+	if ((powerflow_values->V_hist_last == NULL) || (t_prev <= 0) || (t_last <= t_prev) || (gl_globalclock <= t_last) || (powerflow_values->V_pred_time == gl_globalclock))
+		return;
+
+	powerflow_values->V_pred_time = gl_globalclock;
+
+	//Linear extrapolation, limited to one history interval so long steps don't overshoot
+	ratio = (double)(gl_globalclock - t_last)/(double)(t_last - t_prev);
+	if (ratio > 1.0)
+		ratio = 1.0;
+
+	for (indexer=0; indexer<bus_count; indexer++)
+	{
+		//Only PQ buses - SWING and PV voltages are specified
+		if (bus[indexer].type != 0)
+			continue;
+
+		phase_mask = NR_updated_phases(&bus[indexer]);
+
+		for (jindex=0; jindex<3; jindex++)
+		{
+			if ((phase_mask & (0x01 << jindex)) != 0)
+			{
+				bus[indexer].V[jindex] += (powerflow_values->V_hist_last[3*indexer+jindex] - powerflow_values->V_hist_prev[3*indexer+jindex])*ratio;
+			}
+		}
+	}
+}
+
 /** Newton-Raphson solver
 	Solves a power flow problem using the Newton-Raphson method
 	
@@ -326,11 +469,40 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 #ifndef MT
 	superlu_options_t options;	//Additional variables for sequential superLU
 	SuperLUStat_t stat;
+#else
+	Gstat_t chord_stat;			//Statistics structure for superLU_MT triangular solves
 #endif
 
+	//Chord (reused Jacobian factorization) flags
+	bool chord_allowed, chord_solve, jacobian_frozen;
+	double chord_last_mismatch;
+
+	//Solver statistics
+	double solve_start_time = NR_wallclock();
+
 	//Ensure bad computations flag is set first
 	*bad_computations = false;
 
+	//Deltamode steps may hold the factorization until the next topology/admittance change
+	jacobian_frozen = ((NR_deltamode_frozen_jacobian == true) && (powerflow_type == PF_DYNCALC));
+
+	//Determine if the previous factorization may be reused for the first iterations
+	chord_allowed = (((NR_chord_iterations > 0) || jacobian_frozen) && (matrix_solver_method==MM_SUPERLU) && (mesh_imped_vals == NULL) && (powerflow_type != PF_DYNINIT));
+	chord_solve = false;
+	chord_last_mismatch = 0.0;
+
+	//Any admittance change or solver mode change invalidates a retained factorization
+	if ((chord_allowed == false) || NR_admit_change || (powerflow_type != LU_chord_type))
+	{
+		NR_chord_release();
+	}
+
+	//Start from an extrapolated voltage guess, if desired
+	if ((NR_voltage_predictor == true) && (powerflow_type == PF_NORMAL) && (mesh_imped_vals == NULL) && (NR_admit_change == false))
+	{
+		NR_predict_voltages(bus_count,bus,powerflow_values);
+	}
+
 	//Determine special circumstances of SWING bus -- do we want it to truly participate right
 	if (powerflow_type != PF_NORMAL)
 	{
@@ -5116,57 +5288,65 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 			return 0;					//Just return some arbitrary value - not technically bad
 		}
 
-		if (powerflow_values->Y_Amatrix == NULL)
-		{
-			powerflow_values->Y_Amatrix = (SPARSE*) gl_malloc(sizeof(SPARSE));
+		//See if the retained factorization will be reused for this iteration (chord Newton) - if so, the
+		//Jacobian does not need to be assembled (the right-hand side is all that changes)
+		chord_solve = (chord_allowed && LU_chord_valid && (LU_chord_size == 2*powerflow_values->total_variables) &&
+			((Iteration < NR_chord_iterations) || jacobian_frozen) && (powerflow_values->NR_realloc_needed == false));
 
-			//Make sure it worked
+		if ((chord_solve == false) || (NRMatDumpMethod != MD_NONE))
+		{
 			if (powerflow_values->Y_Amatrix == NULL)
-				GL_THROW("NR: Failed to allocate memory for one of the necessary matrices");
+			{
+				powerflow_values->Y_Amatrix = (SPARSE*) gl_malloc(sizeof(SPARSE));
 
-			//Initiliaze it
-			sparse_init(powerflow_values->Y_Amatrix, size_Amatrix, 6*NR_bus_count);
-		}
-		else if (powerflow_values->NR_realloc_needed)	//If one of the above changed, we changed too
-		{
-			//Destroy the old version
-			sparse_clear(powerflow_values->Y_Amatrix);
+				//Make sure it worked
+				if (powerflow_values->Y_Amatrix == NULL)
+					GL_THROW("NR: Failed to allocate memory for one of the necessary matrices");
 
-			//Create a new 
-			sparse_init(powerflow_values->Y_Amatrix, size_Amatrix, 6*NR_bus_count);
-		}
-		else
-		{
-			//Just clear it out
-			sparse_reset(powerflow_values->Y_Amatrix, 6*NR_bus_count);
-		}
+				//Initiliaze it
+				sparse_init(powerflow_values->Y_Amatrix, size_Amatrix, 6*NR_bus_count);
+			}
+			else if (powerflow_values->NR_realloc_needed)	//If one of the above changed, we changed too
+			{
+				//Destroy the old version
+				sparse_clear(powerflow_values->Y_Amatrix);
 
-		//integrate off diagonal components
-		for (indexer=0; indexer<powerflow_values->size_offdiag_PQ*2; indexer++)
-		{
-			row = powerflow_values->Y_offdiag_PQ[indexer].row_ind;
-			col = powerflow_values->Y_offdiag_PQ[indexer].col_ind;
-			value = powerflow_values->Y_offdiag_PQ[indexer].Y_value;
-			sparse_add(powerflow_values->Y_Amatrix, row, col, value);
-		}
+				//Create a new 
+				sparse_init(powerflow_values->Y_Amatrix, size_Amatrix, 6*NR_bus_count);
+			}
+			else
+			{
+				//Just clear it out
+				sparse_reset(powerflow_values->Y_Amatrix, 6*NR_bus_count);
+			}
 
-		//Integrate fixed portions of diagonal components
-		for (indexer=powerflow_values->size_offdiag_PQ*2; indexer< (powerflow_values->size_offdiag_PQ*2 + powerflow_values->size_diag_fixed*2); indexer++)
-		{
-			row = powerflow_values->Y_diag_fixed[indexer - powerflow_values->size_offdiag_PQ*2 ].row_ind;
-			col = powerflow_values->Y_diag_fixed[indexer - powerflow_values->size_offdiag_PQ*2 ].col_ind;
-			value = powerflow_values->Y_diag_fixed[indexer - powerflow_values->size_offdiag_PQ*2 ].Y_value;
-			sparse_add(powerflow_values->Y_Amatrix, row, col, value);
-		}
+			//integrate off diagonal components
+			for (indexer=0; indexer<powerflow_values->size_offdiag_PQ*2; indexer++)
+			{
+				row = powerflow_values->Y_offdiag_PQ[indexer].row_ind;
+				col = powerflow_values->Y_offdiag_PQ[indexer].col_ind;
+				value = powerflow_values->Y_offdiag_PQ[indexer].Y_value;
+				sparse_add(powerflow_values->Y_Amatrix, row, col, value);
+			}
 
-		//Integrate the variable portions of the diagonal components
-		for (indexer=powerflow_values->size_offdiag_PQ*2 + powerflow_values->size_diag_fixed*2; indexer< size_Amatrix; indexer++)
-		{
-			row = powerflow_values->Y_diag_update[indexer - powerflow_values->size_offdiag_PQ*2 - powerflow_values->size_diag_fixed*2].row_ind;
-			col = powerflow_values->Y_diag_update[indexer - powerflow_values->size_offdiag_PQ*2 - powerflow_values->size_diag_fixed*2].col_ind;
-			value = powerflow_values->Y_diag_update[indexer - powerflow_values->size_offdiag_PQ*2 - powerflow_values->size_diag_fixed*2].Y_value;
-			sparse_add(powerflow_values->Y_Amatrix, row, col, value);
-		}
+			//Integrate fixed portions of diagonal components
+			for (indexer=powerflow_values->size_offdiag_PQ*2; indexer< (powerflow_values->size_offdiag_PQ*2 + powerflow_values->size_diag_fixed*2); indexer++)
+			{
+				row = powerflow_values->Y_diag_fixed[indexer - powerflow_values->size_offdiag_PQ*2 ].row_ind;
+				col = powerflow_values->Y_diag_fixed[indexer - powerflow_values->size_offdiag_PQ*2 ].col_ind;
+				value = powerflow_values->Y_diag_fixed[indexer - powerflow_values->size_offdiag_PQ*2 ].Y_value;
+				sparse_add(powerflow_values->Y_Amatrix, row, col, value);
+			}
+
+			//Integrate the variable portions of the diagonal components
+			for (indexer=powerflow_values->size_offdiag_PQ*2 + powerflow_values->size_diag_fixed*2; indexer< size_Amatrix; indexer++)
+			{
+				row = powerflow_values->Y_diag_update[indexer - powerflow_values->size_offdiag_PQ*2 - powerflow_values->size_diag_fixed*2].row_ind;
+				col = powerflow_values->Y_diag_update[indexer - powerflow_values->size_offdiag_PQ*2 - powerflow_values->size_diag_fixed*2].col_ind;
+				value = powerflow_values->Y_diag_update[indexer - powerflow_values->size_offdiag_PQ*2 - powerflow_values->size_diag_fixed*2].Y_value;
+				sparse_add(powerflow_values->Y_Amatrix, row, col, value);
+			}
+		}//End Jacobian assembly
 
 		//See if we want to dump out the matrix values
 		if (NRMatDumpMethod != MD_NONE)
@@ -5334,6 +5514,9 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 		}
 		else if (powerflow_values->NR_realloc_needed)	//Something changed, we'll just destroy everything and start over
 		{
+			//Any retained factorization no longer matches
+			NR_chord_release();
+
 			//Get rid of all of them first
 			gl_free(matrices_LU.a_LU);
 			gl_free(matrices_LU.rows_LU);
@@ -5407,6 +5590,9 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 		}
 		else if (powerflow_values->prev_m != m)	//Non-reallocing size change occurred
 		{
+			//Any retained factorization no longer matches
+			NR_chord_release();
+
 			if (matrix_solver_method==MM_SUPERLU)
 			{
 				//Update relevant portions
@@ -5439,8 +5625,12 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 		//Default else - not superLU
 #endif
 		
-		sparse_tonr(powerflow_values->Y_Amatrix, &matrices_LU);
-		matrices_LU.cols_LU[n] = nnz ;// number of non-zeros;
+		//A reused factorization only needs the right-hand side
+		if (chord_solve == false)
+		{
+			sparse_tonr(powerflow_values->Y_Amatrix, &matrices_LU);
+			matrices_LU.cols_LU[n] = nnz ;// number of non-zeros;
+		}
 
 		//Determine how to populate the rhs vector
 		if (mesh_imped_vals == NULL)	//Normal powerflow, copy in the values
@@ -5697,20 +5887,42 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 			{
 #ifdef MT
 				//superLU_MT commands
+				if (chord_solve)
+				{
+					//Only the triangular solves - perm_c/perm_r still hold the retained factorization's permutations
+					StatAlloc(n, 1, sp_ienv(1), sp_ienv(2), &chord_stat);
+					StatInit(n, 1, &chord_stat);
 
-				//Populate perm_c
-				get_perm_c(1, &A_LU, perm_c);
+					dgstrs(NOTRANS, &L_LU_chord, &U_LU_chord, perm_r, perm_c, &B_LU, &chord_stat, &info);
 
-				//Solve the system
-				pdgssv(NR_superLU_procs, &A_LU, perm_c, perm_r, &L_LU, &U_LU, &B_LU, &info);
+					StatFree(&chord_stat);
+				}
+				else
+				{
+					//Populate perm_c
+					get_perm_c(1, &A_LU, perm_c);
+
+					//Solve the system
+					pdgssv(NR_superLU_procs, &A_LU, perm_c, perm_r, &L_LU, &U_LU, &B_LU, &info);
+				}
 #else
 				//sequential superLU
 
 				StatInit ( &stat );
 
-				// solve the system
-				dgssv(&options, &A_LU, perm_c, perm_r, &L_LU, &U_LU, &B_LU, &stat, &info);
+				if (chord_solve)
+				{
+					//Only the triangular solves - perm_c/perm_r still hold the retained factorization's permutations
+					dgstrs(NOTRANS, &L_LU_chord, &U_LU_chord, perm_c, perm_r, &B_LU, &stat, &info);
+				}
+				else
+				{
+					// solve the system
+					dgssv(&options, &A_LU, perm_c, perm_r, &L_LU, &U_LU, &B_LU, &stat, &info);
+				}
 #endif
+				if (chord_solve)
+					NR_chord_count++;
 
 				sol_LU = (double*) ((DNformat*) B_LU.Store)->nzval;
 			}
@@ -5972,15 +6184,43 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 
 		if (matrix_solver_method==MM_SUPERLU)
 		{
-			/* De-allocate storage - superLU matrix types must be destroyed at every iteration, otherwise they balloon fast (65 MB norma becomes 1.5 GB) */
+			if (chord_solve)
+			{
+				//Reused factorization drifted too far (or failed) - refactor on the next iteration
+				if ((Maxmismatch > NR_chord_mismatch_limit) || (info != 0))
+				{
+					NR_chord_release();
+				}
+				else if (jacobian_frozen && (Iteration > 0) && (Maxmismatch >= chord_last_mismatch))
+				{
+					//Frozen deltamode Jacobian stopped contracting - the network moved away from it
+					NR_chord_release();
+				}
+			}
+			else if (chord_allowed && (info == 0))
+			{
+				//Retain this factorization for chord iterations (replaces any older one)
+				NR_chord_release();
+				L_LU_chord = L_LU;
+				U_LU_chord = U_LU;
+				LU_chord_valid = true;
+				LU_chord_size = m;
+				LU_chord_type = powerflow_type;
+			}
+			else
+			{
+				/* De-allocate storage - superLU matrix types must be destroyed at every iteration, otherwise they balloon fast (65 MB norma becomes 1.5 GB) */
 #ifdef MT
-			//superLU_MT commands
-			Destroy_SuperNode_SCP(&L_LU);
-			Destroy_CompCol_NCP(&U_LU);
+				//superLU_MT commands
+				Destroy_SuperNode_SCP(&L_LU);
+				Destroy_CompCol_NCP(&U_LU);
 #else
-			//sequential superLU commands
-			Destroy_SuperNode_Matrix( &L_LU );
-			Destroy_CompCol_Matrix( &U_LU );
+				//sequential superLU commands
+				Destroy_SuperNode_Matrix( &L_LU );
+				Destroy_CompCol_Matrix( &U_LU );
+#endif
+			}
+#ifndef MT
 			StatFree ( &stat );
 #endif
 		}
@@ -5995,6 +6235,9 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 			//Defined above
 		}
 
+		//Track the update size for the next iteration's frozen Jacobian contraction check
+		chord_last_mismatch = Maxmismatch;
+
 		//Break us out if we are done or are singular		
 		if (( newiter == false ) || (info!=0))
 		{
@@ -6006,6 +6249,17 @@ int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count,
 		}
 	}	//End iteration loop
 
+	//Update solver statistics
+	NR_solution_count++;
+	NR_iteration_count += (Iteration < NR_iteration_limit) ? (Iteration + 1) : Iteration;
+	NR_solver_time += NR_wallclock() - solve_start_time;
+
+	//Keep converged normal solutions for the initial voltage predictor
+	if ((NR_voltage_predictor == true) && (powerflow_type == PF_NORMAL) && (newiter == false) && (info == 0))
+	{
+		NR_store_voltages(bus_count,bus,powerflow_values);
+	}
+
 	//Check to see how we are ending
 	if ((Iteration==NR_iteration_limit) && (newiter==true)) //Reached the limit
 	{
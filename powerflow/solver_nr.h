@@ -127,6 +127,10 @@ typedef struct {
 	Y_NR *Y_diag_fixed;					///Y_diag_fixed store the row,column and value of fixed diagonal elements of 6n*6n Y_NR matrix. No PV bus is included.
 	Y_NR *Y_diag_update;				///Y_diag_update store the row,column and value of updated diagonal elements of 6n*6n Y_NR matrix at each iteration. No PV bus is included.
 	SPARSE *Y_Amatrix;					///Y_Amatrix store all the elements of Amatrix in equation AX=B;
+	complex *V_hist_last;				///Last converged bus voltages (3 per bus) - used by the initial voltage predictor
+	complex *V_hist_prev;				///Second-to-last converged bus voltages (3 per bus) - used by the initial voltage predictor
+	TIMESTAMP V_hist_time[2];			///Timestamps of V_hist_last and V_hist_prev (0 = not populated)
+	TIMESTAMP V_pred_time;				///Timestamp the initial voltage predictor was last applied
 } NR_SOLVER_STRUCT;
 
 //Mesh-fault-related structure - passing information
@@ -142,6 +146,7 @@ typedef struct {
 //int ext_solver_solve(void *ext_array, NR_SOLVER_VARS *system_info_vars, unsigned int rowcount, unsigned int colcount);
 //void ext_solver_destroy(void *ext_array, bool new_iteration);
 
+void NR_chord_release(void);
 int64 solver_nr(unsigned int bus_count, BUSDATA *bus, unsigned int branch_count, BRANCHDATA *branch, NR_SOLVER_STRUCT *powerflow_values, NRSOLVERMODE powerflow_type , NR_MESHFAULT_IMPEDANCE *mesh_imped_vals, bool *bad_computations);
 
 #endif
@@ -89,6 +89,8 @@ eventgen::eventgen(MODULE *module)
 				GL_THROW("Unable to publish reliability event adding function");
 			if (gl_publish_function(oclass,	"interupdate_event_object", (FUNCTIONADDR)interupdate_eventgen)==NULL)
 				GL_THROW("Unable to publish reliability deltamode function");
+			if (gl_publish_function(oclass,	"nextevent_event_object", (FUNCTIONADDR)nextevent_eventgen)==NULL)
+				GL_THROW("Unable to publish reliability deltamode function");
 	}
 }
 
@@ -164,6 +166,13 @@ int eventgen::init(OBJECT *parent)
 	double temp_time_A_dbl, temp_time_B_dbl;
 	char temp_buff[128];
 
+	//If our metrics object runs several realizations, let it start them before any events are drawn
+	if ((hdr->parent != NULL) && gl_object_isa(hdr->parent,"metrics","reliability"))
+	{
+		if (((hdr->parent->flags & OF_INIT) != OF_INIT) && (OBJECTDATA(hdr->parent,metrics)->realizations > 1))
+			return 2;	//Defer until it is initialized
+	}
+
 	//Get global_minimum_timestep value and set the appropriate flag
 	//Retrieve the global value, only does so as a text string for some reason
 	gl_global_getvar("minimum_timestep",temp_buff,sizeof(temp_buff));
@@ -736,6 +745,16 @@ TIMESTAMP eventgen::presync(TIMESTAMP t0, TIMESTAMP t1)
 					*/
 				}
 
+				//Allocate the next event function reference list too
+				delta_nextevent_functions = (FUNCTIONADDR*)gl_malloc(eventgen_object_count*sizeof(FUNCTIONADDR));
+
+				//Make sure it worked
+				if (delta_nextevent_functions == NULL)
+				{
+					GL_THROW("Failed to allocate deltamode objects function array for reliability module!");
+					//Defined above
+				}
+
 				//Initialize index
 				eventgen_object_current = 0;
 			}
@@ -768,6 +787,9 @@ TIMESTAMP eventgen::presync(TIMESTAMP t0, TIMESTAMP t1)
 				*/
 			}
 
+			//Map up the function for variable timesteps - objects without one have no events to land on
+			delta_nextevent_functions[eventgen_object_current] = (FUNCTIONADDR)(gl_get_function(hdr,"nextevent_event_object"));
+
 			//Update pointer
 			eventgen_object_current++;
 
@@ -2029,6 +2051,40 @@ SIMULATIONMODE eventgen::inter_deltaupdate(unsigned int64 delta_time, unsigned l
 	return SM_EVENT;
 }
 
+//////////////////////////////////////////////////////////////////////////
+//Module-level call for variable deltamode timesteps
+EXPORT unsigned long nextevent_eventgen(OBJECT *obj, unsigned int64 next_time)
+{
+	eventgen *my = OBJECTDATA(obj,eventgen);
+	return my->deltamode_nextevent(next_time);
+}
+
+//Returns the time from the update at next_time to the next event, so a variable timestep lands on it
+unsigned long eventgen::deltamode_nextevent(unsigned int64 next_time)
+{
+	double next_time_dbl = (double)gl_globalclock + (double)next_time/(double)DT_SECOND;
+	double step_dbl;
+
+	//No event coming
+	if (next_event_time_dbl >= TSNVRDBL)
+		return DT_INFINITY;
+
+	//The event is at the next update, and the one after it is not known until it is handled
+	if (fabs(next_event_time_dbl - next_time_dbl) < 0.5/(double)DT_SECOND)
+		return 0;
+
+	//Already due, so it happens at the next update anyway
+	if (next_event_time_dbl < next_time_dbl)
+		return DT_INFINITY;
+
+	step_dbl = ceil((next_event_time_dbl - next_time_dbl)*(double)DT_SECOND);
+
+	if (step_dbl >= (double)DT_INFINITY)
+		return DT_INFINITY;
+	else
+		return (unsigned long)step_dbl;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // IMPLEMENTATION OF CORE LINKAGE
 //////////////////////////////////////////////////////////////////////////
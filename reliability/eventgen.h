@@ -14,6 +14,7 @@
 #include "metrics.h"
 
 EXPORT SIMULATIONMODE interupdate_eventgen(OBJECT *obj, unsigned int64 delta_time, unsigned long dt, unsigned int iteration_count_val);
+EXPORT unsigned long nextevent_eventgen(OBJECT *obj, unsigned int64 next_time);
 
 //Random distribution types - stolen from random.h
 //SAMPLE removed since it won't fit well with how this goes
@@ -107,6 +108,7 @@ public:
 	int add_unhandled_event(OBJECT *obj_to_fault, char *event_type, TIMESTAMP fail_time, TIMESTAMP rest_length, int implemented_fault, bool fault_state);	/**< Function to add unhandled event into the structure */
 	double *get_double(OBJECT *obj, char *name);	/**< Gets address of double - mainly for mean_repair_time */
 	SIMULATIONMODE inter_deltaupdate(unsigned int64 delta_time, unsigned long dt, unsigned int iteration_count_val);
+	unsigned long deltamode_nextevent(unsigned int64 next_time);
 public:
 	/* required implementations */
 	eventgen(MODULE *module);
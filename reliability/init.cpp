@@ -188,6 +188,41 @@ EXPORT STATUS postupdate(MODULE *module, TIMESTAMP t0, unsigned int64 dt)
 }
 
 
+//nextstep function of deltamode
+//Module-level call after each deltamode timestep when the timestep may vary
+//Events are landed on by deltamode_nextevent, so the regular timestep is not limited
+EXPORT unsigned long deltamode_nextstep(MODULE *module, TIMESTAMP t0, unsigned int64 delta_time, unsigned long dt)
+{
+	return DT_INFINITY;
+}
+
+//nextevent function of deltamode
+//Module-level call after each deltamode timestep when the timestep may vary
+//Returns the time from the update at next_time to the next event of the objects (0 if it is at that update, DT_INFINITY for none)
+EXPORT unsigned long deltamode_nextevent(MODULE *module, TIMESTAMP t0, unsigned int64 next_time)
+{
+	int curr_object_number;
+	unsigned long next_dt = DT_INFINITY;
+	unsigned long object_dt;
+
+	if (enable_subsecond_models == true)
+	{
+		for (curr_object_number=0; curr_object_number<eventgen_object_count; curr_object_number++)
+		{
+			//Objects without an event function have nothing to land on
+			if (delta_nextevent_functions[curr_object_number] == NULL)
+				continue;
+
+			object_dt = ((unsigned long (*)(OBJECT *, unsigned int64))(*delta_nextevent_functions[curr_object_number]))(delta_objects[curr_object_number],next_time);
+
+			if (object_dt < next_dt)
+				next_dt = object_dt;
+		}
+	}
+
+	return next_dt;
+}
+
 CDECL int do_kill()
 {
 	/* if global memory needs to be released, this is a good time to do it */
@@ -9,6 +9,14 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <errno.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
 
 #include "gridlabd.h"
 #include "metrics.h"
@@ -38,6 +46,9 @@ metrics::metrics(MODULE *module)
 			PT_char1024, "metrics_of_interest", PADDR(metrics_oi),
 			PT_double, "metric_interval[s]", PADDR(metric_interval_dbl),
 			PT_double, "report_interval[s]", PADDR(report_interval_dbl),
+			PT_int32, "realizations", PADDR(realizations),PT_DESCRIPTION,"Number of independent Monte Carlo realizations to run from this model load",
+			PT_int32, "realization", PADDR(realization),PT_ACCESS,PA_REFERENCE,PT_DESCRIPTION,"Index of the realization this process is running (0 is the originating process)",
+			PT_int32, "realization_workers", PADDR(realization_workers),PT_DESCRIPTION,"Maximum number of realizations run at once (0 uses the number of processors)",
 			NULL)<1) GL_THROW("unable to publish properties in %s",__FILE__);
 	}
 }
@@ -74,6 +85,18 @@ int metrics::create(void)
 	secondary_interruptions_count = false;	//By default, we don't look for the secondary interruptions flag
 
 	Extra_Data = NULL;	//Start "extra" variable as null
+
+	//Single realization by default
+	realizations = 1;
+	realization = 0;
+	realization_workers = 0;
+	batch_samples = NULL;
+	batch_sample_count = 0;
+	batch_sample_max = 0;
+	batch_token_fd[0] = batch_token_fd[1] = -1;
+	batch_result_fd = -1;
+	batch_child_fd = NULL;
+	batch_child_pid = NULL;
 	
 	return 1; /* return 1 on success, 0 on failure */
 }
@@ -104,6 +127,20 @@ int metrics::init(OBJECT *parent)
 		*/
 	}
 
+	//Start any additional realizations now - everything after this point is done by each realization separately
+	if (realizations > 1)
+	{
+		start_realizations();
+	}
+	else if (realizations < 1)
+	{
+		GL_THROW("metrics:%s must run at least one realization",hdr->name);
+		/*  TROUBLESHOOT
+		The realizations property of the metrics object is less than one.  Please specify a positive
+		number of realizations and try again.
+		*/
+	}
+
 	//It's not null, map up the init function and call it (this must exist, even if it does nothing)
 	funadd = (FUNCTIONADDR)(gl_get_function(module_metrics_obj,"init_reliability"));
 					
@@ -908,6 +945,10 @@ void metrics::write_metrics(void)
 
 	//Close the file
 	fclose(FPVAL);
+
+	//Keep the values for the realization statistics
+	if (realizations > 1)
+		store_sample();
 }
 
 //Retrieve the address of a metric
@@ -927,6 +968,706 @@ bool *metrics::get_outage_flag(OBJECT *obj, char *name)
 		return NULL;
 	return (bool*)GETADDR(obj,p);
 }
+
+//Finalize - gather the Monte Carlo realizations, if more than one was run
+int metrics::finalize(void)
+{
+	char buffer[64];
+	bool failed;
+
+	if (realizations > 1)
+	{
+		//See if this realization's simulation failed - the main loop only reaches DONE when it ends normally
+		failed = (gl_global_getvar("mainloop_state",buffer,sizeof(buffer)) != NULL) && (strcmp(buffer,"DONE") != 0);
+
+		//Make sure every realization contributes its final values, even if no report interval elapsed
+		if ((failed == false) && (batch_sample_count == 0))
+			write_metrics();
+
+		//A failed realization fails the whole run
+		if (realization == 0)
+			failed = !collect_realizations(failed);
+		else
+			return_realization(failed);
+
+		if (failed == true)
+			return 0;
+	}
+
+	return 1;
+}
+
+//Function to capture the current metric values for the realization statistics
+void metrics::store_sample(void)
+{
+	OBJECT *hdr = OBJECTHDR(this);
+	double *new_samples;
+	int index;
+
+	//Grow the sample storage, if needed
+	if (batch_sample_count >= batch_sample_max)
+	{
+		batch_sample_max = (batch_sample_max == 0) ? 16 : (2*batch_sample_max);
+
+		new_samples = (double *)gl_malloc(batch_sample_max*num_indices*sizeof(double));
+
+		if (new_samples == NULL)
+		{
+			GL_THROW("Failure to allocate realization sample memory in metrics:%s",hdr->name);
+			/*  TROUBLESHOOT
+			While storing the metric values of a realization for the Monte Carlo statistics, an error occurred
+			allocating memory.  Please try again.  If the error persists, please submit your code and a bug report
+			via the trac website.
+			*/
+		}
+
+		if (batch_samples != NULL)
+		{
+			memcpy(new_samples,batch_samples,batch_sample_count*num_indices*sizeof(double));
+			gl_free(batch_samples);
+		}
+
+		batch_samples = new_samples;
+	}
+
+	//Copy the values in
+	for (index=0; index<num_indices; index++)
+		batch_samples[batch_sample_count*num_indices+index] = *CalcIndices[index].MetricLoc;
+
+	batch_sample_count++;
+}
+
+#ifdef _WIN32
+void metrics::start_realizations(void)
+{
+	OBJECT *hdr = OBJECTHDR(this);
+
+	gl_warning("metrics:%s - multiple realizations are not supported on this platform, only one will be run",hdr->name);
+	/*  TROUBLESHOOT
+	Running several Monte Carlo realizations from one model load relies on process forking, which is not available
+	on this platform.  Only the first realization is run.  Run the model several times with different random seeds instead.
+	*/
+	realizations = 1;
+}
+
+void metrics::return_realization(bool failed)
+{
+}
+
+bool metrics::collect_realizations(bool failed)
+{
+	return !failed;
+}
+#else
+
+//Output files every realization writes - the child realizations rename them name_N.ext so they don't overwrite each other
+static struct s_realization_output {
+	const char *module;
+	const char *classname;
+	const char *property;
+	bool open_at_init;	//File is opened (or its name used) when the object initializes, so it can't be renamed afterwards
+	bool default_name;	//An empty name is replaced by a default, which would be the same in every realization
+} realization_outputs[] = {
+	{"tape",		"recorder",					"file",					false,	true},
+	{"tape",		"multi_recorder",			"file",					false,	true},
+	{"tape",		"collector",				"file",					false,	true},
+	{"tape",		"histogram",				"filename",				true,	true},
+	{"tape",		"group_recorder",			"file",					true,	false},
+	{"tape",		"violation_recorder",		"file",					true,	false},
+	{"tape",		"violation_recorder",		"summary",				false,	false},
+	{"tape",		"metrics_collector_writer",	"filename",				true,	false},
+	{"powerflow",	"voltdump",					"filename",				false,	false},
+	{"powerflow",	"currdump",					"filename",				false,	false},
+	{"powerflow",	"billdump",					"filename",				false,	false},
+	{"powerflow",	"impedance_dump",			"filename",				false,	false},
+	{"powerflow",	"fault_check",				"output_filename",		false,	false},
+	{"powerflow",	"restoration",				"output_filename",		false,	false},
+	{"market",		"auction",					"transaction_log_file",	true,	false},
+	{"market",		"auction",					"curve_log_file",		true,	false},
+	{"reliability",	"metrics",					"report_file",			false,	false},
+};
+
+//Core output files written at the end of the run
+static const char *realization_globals[] = {"dumpfile", "savefile", "kmlfile"};
+
+//Function to find the file name a realization output points to - NULL if obj doesn't have this output
+static char *realization_output_name(OBJECT *obj, struct s_realization_output *output, size_t *size)
+{
+	PROPERTY *prop;
+
+	if ((strcmp(obj->oclass->name,output->classname) != 0) || (strcmp(obj->oclass->module->name,output->module) != 0))
+		return NULL;
+
+	prop = gl_get_property(obj,(char *)output->property);
+	if (prop == NULL)
+		return NULL;
+
+	switch (prop->ptype) {
+		case PT_char32:
+			*size = 32;
+			break;
+		case PT_char256:
+			*size = 256;
+			break;
+		case PT_char1024:
+			*size = 1024;
+			break;
+		default:
+			return NULL;
+	}
+
+	return (char *)GETADDR(obj,prop);
+}
+
+//Function to give a file name the realization suffix - name_N.ext
+static void realization_filename(char *name, size_t size, int index)
+{
+	char buffer[1025];
+	char *ext = strrchr(name,'.');
+
+	if ((ext != NULL) && (strchr(ext,'/') == NULL) && (strchr(ext,'\\') == NULL))
+		snprintf(buffer,sizeof(buffer),"%.*s_%d%s",(int)(ext-name),name,index,ext);
+	else
+		snprintf(buffer,sizeof(buffer),"%s_%d",name,index);
+
+	strncpy(name,buffer,size);
+	name[size] = '\0';
+}
+
+//Function to give every output file of this realization its own name
+static void rename_realization_outputs(int index)
+{
+	OBJECT *obj;
+	GLOBALVAR *var;
+	PROPERTY *prop;
+	unsigned int entry;
+	char *name;
+	size_t size;
+
+	for (obj=gl_object_get_first(); obj!=NULL; obj=obj->next)
+	{
+		for (entry=0; entry<sizeof(realization_outputs)/sizeof(realization_outputs[0]); entry++)
+		{
+			name = realization_output_name(obj,&realization_outputs[entry],&size);
+
+			if (name == NULL)
+				continue;
+
+			if (name[0] != '\0')
+				realization_filename(name,size,index);
+			else if (realization_outputs[entry].default_name == true)	//Default would be the same everywhere - name it after the object instead
+			{
+				prop = gl_get_property(obj,"filetype");
+				snprintf(name,size+1,"%s-%d_%d.%s",obj->oclass->name,obj->id,index,((prop != NULL) && (*(char *)GETADDR(obj,prop) != '\0')) ? (char *)GETADDR(obj,prop) : "csv");
+			}
+		}
+	}
+
+	for (entry=0; entry<sizeof(realization_globals)/sizeof(realization_globals[0]); entry++)
+	{
+		var = gl_global_find((char *)realization_globals[entry]);
+
+		if ((var != NULL) && (var->prop->ptype == PT_char1024) && (*(char *)var->prop->addr != '\0'))
+			realization_filename((char *)var->prop->addr,1024,index);
+	}
+}
+
+//Function to fork the additional Monte Carlo realizations
+//Each child process continues the model initialization from here with its own copy of
+//the model state and reseeded random number generators, so events are drawn independently.
+//The number of realizations simulating at once is limited by worker slots passed through a pipe.
+void metrics::start_realizations(void)
+{
+	OBJECT *hdr = OBJECTHDR(this);
+	OBJECT *obj;
+	int index, workers, result_fd[2];
+	unsigned int entry;
+	char token = 'R';
+	char buffer[64];
+	char *name;
+	size_t size;
+	pid_t pid;
+
+	//Forking while other threads are initializing objects would leave the children with half-initialized objects
+	if ((gl_global_getvar("init_sequence",buffer,sizeof(buffer)) != NULL) && (strcmp(buffer,"PARALLEL") == 0))
+	{
+		GL_THROW("metrics:%s - multiple realizations can not be run with the PARALLEL init_sequence",hdr->name);
+		/*  TROUBLESHOOT
+		The additional Monte Carlo realizations are started while the objects are initializing.  With the PARALLEL
+		init_sequence, other objects are being initialized by other threads at the same time, which the realizations
+		can't be safely started from.  Set init_sequence to DEFERRED or CREATION, or run a single realization.
+		*/
+	}
+
+	//Anything that already opened its output file would be shared by all the realizations
+	for (obj=gl_object_get_first(); obj!=NULL; obj=obj->next)
+	{
+		if ((obj->flags & OF_INIT) != OF_INIT)
+			continue;
+
+		for (entry=0; entry<sizeof(realization_outputs)/sizeof(realization_outputs[0]); entry++)
+		{
+			if (realization_outputs[entry].open_at_init == false)
+				continue;
+
+			name = realization_output_name(obj,&realization_outputs[entry],&size);
+
+			if ((name != NULL) && ((name[0] != '\0') || (realization_outputs[entry].default_name == true)))
+			{
+				GL_THROW("metrics:%s - %s:%d opened its %s before the realizations were started",hdr->name,obj->oclass->name,obj->id,realization_outputs[entry].property);
+				/*  TROUBLESHOOT
+				Each Monte Carlo realization writes its output files under its own name (name_N.ext), but the indicated object
+				initialized and opened its output file before the metrics object started the realizations, so they would all write
+				to the same file.  Define the metrics object ahead of the indicated object in the model file, or run a single realization.
+				*/
+			}
+		}
+	}
+
+	//Determine how many may run at once
+	if (realization_workers > 0)
+		workers = realization_workers;
+	else
+		workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (workers < 1)
+		workers = 1;
+
+	batch_child_fd = (int *)gl_malloc((realizations-1)*sizeof(int));
+	batch_child_pid = (int *)gl_malloc((realizations-1)*sizeof(int));
+
+	if ((batch_child_fd == NULL) || (batch_child_pid == NULL))
+	{
+		GL_THROW("Failure to allocate realization memory in metrics:%s",hdr->name);
+		/*  TROUBLESHOOT
+		While setting up the additional Monte Carlo realizations, an error occurred allocating memory.
+		Please try again.  If the error persists, please submit your code and a bug report via the trac website.
+		*/
+	}
+
+	if (pipe(batch_token_fd) != 0)
+	{
+		GL_THROW("metrics:%s - unable to create the realization worker pipe",hdr->name);
+		/*  TROUBLESHOOT
+		The operating system refused to create the pipe used to schedule the Monte Carlo realizations.  This
+		usually means the process is out of file descriptors.  Reduce the number of realizations and try again.
+		*/
+	}
+
+	//The originating process holds one worker slot - make the rest available
+	for (index=1; (index<workers) && (index<realizations); index++)
+	{
+		if (write(batch_token_fd[1],&token,1) != 1)
+		{
+			GL_THROW("metrics:%s - unable to create the realization worker pipe",hdr->name);
+			//Defined above
+		}
+	}
+
+	//Make sure pending output isn't written again by every child
+	fflush(NULL);
+
+	for (index=1; index<realizations; index++)
+	{
+		if (pipe(result_fd) != 0)
+		{
+			GL_THROW("metrics:%s - unable to create the realization worker pipe",hdr->name);
+			//Defined above
+		}
+
+		pid = fork();
+
+		if (pid < 0)
+		{
+			GL_THROW("metrics:%s - unable to start realization %d",hdr->name,index);
+			/*  TROUBLESHOOT
+			The operating system refused to start the process for an additional Monte Carlo realization.
+			Reduce the number of realizations or free up system resources and try again.
+			*/
+		}
+		else if (pid == 0)	//Child realization - set up and carry on
+		{
+			realization = index;
+
+			//Only our own result pipe is needed
+			close(result_fd[0]);
+			while (index > 1)
+			{
+				index--;
+				close(batch_child_fd[index-1]);
+			}
+			gl_free(batch_child_fd);
+			gl_free(batch_child_pid);
+			batch_child_fd = NULL;
+			batch_child_pid = NULL;
+			batch_result_fd = result_fd[1];
+
+			//Wait for a worker slot
+			while ((read(batch_token_fd[0],&token,1) < 0) && (errno == EINTR));
+
+			//Give every object a different, but reproducible, random number stream
+			for (obj=gl_object_get_first(); obj!=NULL; obj=obj->next)
+			{
+				obj->rng_state = obj->rng_state*1103515245 + 12345 + (unsigned int)realization*2654435761u;
+			}
+
+			//Each realization gets its own output files - name_N.ext
+			rename_realization_outputs(realization);
+
+			//Messages are already reported by the originating process
+			gl_global_setvar("quiet","TRUE");
+			gl_global_setvar("warn","FALSE");
+			gl_global_setvar("verbose","FALSE");
+
+			return;
+		}
+
+		//Originating process - keep track of it
+		close(result_fd[1]);
+		batch_child_fd[index-1] = result_fd[0];
+		batch_child_pid[index-1] = (int)pid;
+	}
+
+	gl_verbose("metrics:%s - started %d additional realizations, up to %d at once",hdr->name,realizations-1,workers);
+}
+
+//Function to pass a child realization's samples back to the originating process
+void metrics::return_realization(bool failed)
+{
+	char token = 'R';
+	char *data;
+	int count;
+	size_t length, written;
+	ssize_t val;
+
+	//Free our worker slot for the next realization
+	while ((write(batch_token_fd[1],&token,1) < 0) && (errno == EINTR));
+
+	//Send the sample count (-1 if the simulation failed), then the samples
+	count = failed ? -1 : batch_sample_count;
+	val = write(batch_result_fd,&count,sizeof(int));
+
+	if ((val == sizeof(int)) && (count > 0))
+	{
+		data = (char *)batch_samples;
+		length = batch_sample_count*num_indices*sizeof(double);
+		written = 0;
+
+		while (written < length)
+		{
+			val = write(batch_result_fd,data+written,length-written);
+
+			if (val < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				break;
+			}
+
+			written += val;
+		}
+	}
+
+	close(batch_result_fd);
+	batch_result_fd = -1;
+}
+
+//Comparison function for sorting the realization samples
+static int compare_samples(const void *a, const void *b)
+{
+	double val_a = *(const double *)a;
+	double val_b = *(const double *)b;
+
+	if (val_a < val_b)
+		return -1;
+	else if (val_a > val_b)
+		return 1;
+	else
+		return 0;
+}
+
+//Percentile of sorted values - linear interpolation between the closest ranks
+static double sample_percentile(double *values, int count, double fraction)
+{
+	double position = fraction*(double)(count-1);
+	int lower = (int)position;
+
+	if (lower >= (count-1))
+		return values[count-1];
+
+	return values[lower] + (position - (double)lower)*(values[lower+1] - values[lower]);
+}
+
+//Function to gather all realizations and write their statistics to the report file
+//Returns false if any realization failed - the statistics of the rest are still written
+bool metrics::collect_realizations(bool failed)
+{
+	OBJECT *hdr = OBJECTHDR(this);
+	char token = 'R';
+	char **child_data;
+	size_t *child_length, *child_size;
+	struct pollfd *poll_list;
+	int index, indexa, open_count, poll_count, completed, child_count, status;
+	int report, report_count, value_count;
+	char *new_data;
+	double *values, *samples;
+	double mean, variance;
+	ssize_t val;
+	FILE *FPVal;
+
+	child_count = realizations-1;
+
+	child_data = (char **)gl_malloc(child_count*sizeof(char *));
+	child_length = (size_t *)gl_malloc(child_count*sizeof(size_t));
+	child_size = (size_t *)gl_malloc(child_count*sizeof(size_t));
+	poll_list = (struct pollfd *)gl_malloc(child_count*sizeof(struct pollfd));
+
+	if ((child_data == NULL) || (child_length == NULL) || (child_size == NULL) || (poll_list == NULL))
+	{
+		GL_THROW("Failure to allocate realization memory in metrics:%s",hdr->name);
+		//Defined above
+	}
+
+	for (index=0; index<child_count; index++)
+	{
+		child_data[index] = NULL;
+		child_length[index] = 0;
+		child_size[index] = 0;
+	}
+
+	//Our own realization is done - free its worker slot
+	while ((write(batch_token_fd[1],&token,1) < 0) && (errno == EINTR));
+
+	//Read everything the children send until they all close their pipes
+	open_count = child_count;
+	while (open_count > 0)
+	{
+		poll_count = 0;
+		for (index=0; index<child_count; index++)
+		{
+			if (batch_child_fd[index] >= 0)
+			{
+				poll_list[poll_count].fd = batch_child_fd[index];
+				poll_list[poll_count].events = POLLIN;
+				poll_list[poll_count].revents = 0;
+				poll_count++;
+			}
+		}
+
+		if (poll(poll_list,poll_count,-1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			GL_THROW("metrics:%s - unable to read the realization results",hdr->name);
+			/*  TROUBLESHOOT
+			While waiting for the additional Monte Carlo realizations to finish, an error occurred reading
+			their results.  Please try again.  If the error persists, please submit your code and a bug report
+			via the trac website.
+			*/
+		}
+
+		for (indexa=0; indexa<poll_count; indexa++)
+		{
+			if (poll_list[indexa].revents == 0)
+				continue;
+
+			//Find whose it is
+			for (index=0; batch_child_fd[index]!=poll_list[indexa].fd; index++);
+
+			//Make room and read
+			if (child_length[index] == child_size[index])
+			{
+				child_size[index] = (child_size[index] == 0) ? 4096 : (2*child_size[index]);
+				new_data = (char *)gl_malloc(child_size[index]);
+
+				if (new_data == NULL)
+				{
+					GL_THROW("Failure to allocate realization memory in metrics:%s",hdr->name);
+					//Defined above
+				}
+
+				if (child_data[index] != NULL)
+				{
+					memcpy(new_data,child_data[index],child_length[index]);
+					gl_free(child_data[index]);
+				}
+
+				child_data[index] = new_data;
+			}
+
+			val = read(batch_child_fd[index],child_data[index]+child_length[index],child_size[index]-child_length[index]);
+
+			if (val > 0)
+			{
+				child_length[index] += val;
+			}
+			else if ((val == 0) || (errno != EINTR))	//Done (or broken) - see what we got
+			{
+				close(batch_child_fd[index]);
+				batch_child_fd[index] = -1;
+				open_count--;
+
+				if ((child_length[index] == sizeof(int)) && (*(int *)child_data[index] < 0))
+				{
+					gl_error("metrics:%s - realization %d failed and is excluded from the statistics",hdr->name,index+1);
+					/*  TROUBLESHOOT
+					The simulation of one of the Monte Carlo realizations failed, usually because the randomly drawn
+					events led to an unsolvable system.  It is left out of the realization statistics and the run fails.
+					Look for the errors reported before this message to find out why it failed.
+					*/
+
+					child_length[index] = 0;
+				}
+				else if ((child_length[index] < sizeof(int)) || (child_length[index] != (sizeof(int) + (*(int *)child_data[index])*num_indices*sizeof(double))))
+				{
+					gl_error("metrics:%s - realization %d did not complete and is excluded from the statistics",hdr->name,index+1);
+					/*  TROUBLESHOOT
+					One of the additional Monte Carlo realizations ended without returning its metrics, usually
+					because its process was terminated.  It is left out of the realization statistics and the run
+					fails.  Please try again.  If the error persists, please submit your code and a bug report via
+					the trac website.
+					*/
+
+					child_length[index] = 0;
+
+					//It may have died holding a worker slot - replace it so the rest aren't starved
+					while ((write(batch_token_fd[1],&token,1) < 0) && (errno == EINTR));
+				}
+			}
+		}
+	}
+
+	//Reap the children - one that returned its metrics but then exited with an error failed all the same
+	for (index=0; index<child_count; index++)
+	{
+		while ((waitpid((pid_t)batch_child_pid[index],&status,0) < 0) && (errno == EINTR));
+
+		if ((child_length[index] != 0) && (!WIFEXITED(status) || (WEXITSTATUS(status) != 0)))
+		{
+			gl_error("metrics:%s - realization %d exited with status %d and is excluded from the statistics",hdr->name,index+1,WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+			/*  TROUBLESHOOT
+			One of the additional Monte Carlo realizations returned its metrics, but its process then ended with an
+			error.  It is left out of the realization statistics and the run fails.  Look for the errors reported
+			before this message to find out why it failed.
+			*/
+
+			child_length[index] = 0;
+		}
+	}
+
+	close(batch_token_fd[0]);
+	close(batch_token_fd[1]);
+
+	//Count what came back - our own realization is left out if it failed
+	if (failed == true)
+	{
+		gl_error("metrics:%s - realization 0 failed and is excluded from the statistics",hdr->name);
+		//Defined above
+
+		batch_sample_count = 0;
+		completed = 0;
+	}
+	else
+		completed = 1;
+
+	report_count = batch_sample_count;
+	for (index=0; index<child_count; index++)
+	{
+		if (child_length[index] != 0)
+		{
+			completed++;
+
+			if (*(int *)child_data[index] > report_count)
+				report_count = *(int *)child_data[index];
+		}
+	}
+
+	values = (double *)gl_malloc((completed > 0 ? completed : 1)*sizeof(double));
+
+	if (values == NULL)
+	{
+		GL_THROW("Failure to allocate realization memory in metrics:%s",hdr->name);
+		//Defined above
+	}
+
+	//Write the statistics - each report is compared across the realizations
+	FPVal = fopen(report_file,"at");
+
+	if (FPVal == NULL)
+	{
+		GL_THROW("Unable to append the realization statistics to the report file '%s' for metrics:%s",report_file,hdr->name);
+		/*  TROUBLESHOOT
+		While attempting to write the statistics of the Monte Carlo realizations, the report file could not be opened.
+		Please make sure you have write permissions at that location and try again.
+		*/
+	}
+
+	fprintf(FPVal,"\nStatistics of %d realizations\n",completed);
+	fprintf(FPVal,"Report,Realizations,Metric,Mean,Variance,Minimum,5th percentile,Median,95th percentile,Maximum\n");
+
+	for (report=0; report<report_count; report++)
+	{
+		for (indexa=0; indexa<num_indices; indexa++)
+		{
+			//Gather this metric from every realization that got this far
+			value_count = 0;
+			if (report < batch_sample_count)
+				values[value_count++] = batch_samples[report*num_indices+indexa];
+
+			for (index=0; index<child_count; index++)
+			{
+				if ((child_length[index] != 0) && (report < *(int *)child_data[index]))
+				{
+					samples = (double *)(child_data[index]+sizeof(int));
+					values[value_count++] = samples[report*num_indices+indexa];
+				}
+			}
+
+			//Mean and sample variance
+			mean = 0.0;
+			for (index=0; index<value_count; index++)
+				mean += values[index];
+			mean /= (double)value_count;
+
+			variance = 0.0;
+			if (value_count > 1)
+			{
+				for (index=0; index<value_count; index++)
+					variance += (values[index]-mean)*(values[index]-mean);
+				variance /= (double)(value_count-1);
+			}
+
+			qsort(values,value_count,sizeof(double),compare_samples);
+
+			fprintf(FPVal,"%d,%d,%s,%f,%f,%f,%f,%f,%f,%f\n",report+1,value_count,CalcIndices[indexa].MetricName.get_string(),mean,variance,values[0],sample_percentile(values,value_count,0.05),sample_percentile(values,value_count,0.5),sample_percentile(values,value_count,0.95),values[value_count-1]);
+		}
+	}
+
+	fclose(FPVal);
+
+	gl_verbose("metrics:%s - statistics of %d realizations written to %s",hdr->name,completed,report_file);
+
+	//Clean up
+	gl_free(values);
+	for (index=0; index<child_count; index++)
+	{
+		if (child_data[index] != NULL)
+			gl_free(child_data[index]);
+	}
+	gl_free(child_data);
+	gl_free(child_length);
+	gl_free(child_size);
+	gl_free(poll_list);
+	gl_free(batch_child_fd);
+	gl_free(batch_child_pid);
+	batch_child_fd = NULL;
+	batch_child_pid = NULL;
+
+	return (completed == realizations);
+}
+#endif
+
 //////////////////////////////////////////////////////////////////////////
 // IMPLEMENTATION OF CORE LINKAGE
 //////////////////////////////////////////////////////////////////////////
@@ -960,6 +1701,18 @@ EXPORT int init_metrics(OBJECT *obj, OBJECT *parent)
 	INIT_CATCHALL(metrics);
 }
 
+EXPORT int finalize_metrics(OBJECT *obj)
+{
+	try
+	{
+		if (obj!=NULL)
+			return OBJECTDATA(obj,metrics)->finalize();
+		else
+			return 0;
+	}
+	T_CATCHALL(metrics,finalize);
+}
+
 EXPORT TIMESTAMP sync_metrics(OBJECT *obj, TIMESTAMP t1, PASSCONFIG pass)
 {
 	TIMESTAMP t2 = TS_NEVER;
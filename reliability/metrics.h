@@ -46,13 +46,25 @@ private:
 	FUNCTIONADDR compute_metrics;		//Pointer to metric computation function
 
 	TIMESTAMP curr_time;	//Time tracking variable
+
+	double *batch_samples;		//Metric values captured by each write_metrics call (num_indices per sample) - multiple realizations only
+	int batch_sample_count;		//Number of samples captured in batch_samples
+	int batch_sample_max;		//Number of samples batch_samples has room for
+	int batch_token_fd[2];		//Worker slot pipe shared by all realizations - one byte per available slot
+	int batch_result_fd;		//Pipe a child realization returns its samples on
+	int *batch_child_fd;		//Result pipes of the child realizations (originating process only)
+	int *batch_child_pid;		//Process IDs of the child realizations (originating process only)
 	
 	double *get_metric(OBJECT *obj, char *name);	//Function to extract address of double value (metric)
 	bool *get_outage_flag(OBJECT *obj, char *name);	//Function to extract address of outage flag
+	void start_realizations(void);		//Function to fork the additional Monte Carlo realizations
+	void store_sample(void);			//Function to capture the current metric values for the realization statistics
+	void return_realization(bool failed);	//Function to pass a child realization's samples back to the originating process
+	bool collect_realizations(bool failed);	//Function to gather all realizations and write their statistics - false if any failed
 public:
 	static bool report_event_log;
 
-	char report_file[1024];	// the file to which the report is written
+	char1024 report_file;	// the file to which the report is written
 	bool secondary_interruptions_count;	//Flag to get secondary interruptions count - if supported.  If one "customer" supports it, they all better
 
 	// required implementations
@@ -60,11 +72,15 @@ public:
 	int create(void);
 	int init(OBJECT *parent);
 	TIMESTAMP postsync(TIMESTAMP t0, TIMESTAMP t1);
+	int finalize(void);
 	char1024 customer_group;
 	OBJECT *module_metrics_obj;
 	char1024 metrics_oi;
 	double metric_interval_dbl;
 	double report_interval_dbl;
+	int32 realizations;			//Number of independent Monte Carlo realizations run from this model load
+	int32 realization;			//Index of the realization this process is running (0 is the originating process)
+	int32 realization_workers;	//Maximum number of realizations running at once (0 = number of processors)
 	void *Extra_Data;		//Pointer to extra data array - if needed
 	void event_ended(OBJECT *event_obj,OBJECT *fault_obj,OBJECT *faulting_obj,TIMESTAMP event_start_time,TIMESTAMP event_end_time,char *fault_type,char *impl_fault,int number_customers_int);
 	void event_ended_sec(OBJECT *event_obj,OBJECT *fault_obj,OBJECT *faulting_obj,TIMESTAMP event_start_time,TIMESTAMP event_end_time,char *fault_type,char *impl_fault,int number_customers_int, int number_customers_int_secondary);
@@ -22,6 +22,7 @@ GLOBAL bool enable_subsecond_models INIT(false);	/**< normally not operating in
 GLOBAL unsigned long deltamode_timestep INIT(10000000); /* 10 ms timestep */
 GLOBAL FUNCTIONADDR *delta_functions INIT(NULL);			/* Array pointer functions for objects that need deltamode interupdate calls */
 GLOBAL OBJECT **delta_objects INIT(NULL);				/* Array pointer objects that need deltamode interupdate calls */
+GLOBAL FUNCTIONADDR *delta_nextevent_functions INIT(NULL);	/* Array pointer functions for objects with events variable deltamode timesteps land on */
 GLOBAL int eventgen_object_count INIT(0);		/* deltamode object count */
 GLOBAL int eventgen_object_current INIT(-1);		/* Index of current deltamode object */
 GLOBAL TIMESTAMP deltamode_starttime INIT(TS_NEVER);	/* Tracking variable for next desired instance of deltamode */
@@ -0,0 +1,27 @@
+# Recording check for test_house_accumulator_equivalence.glm
+#
+# Usage: python3 accumulator_check.py <accumulated csv> <locked csv>
+#
+# The recordings must have the same times and values within the round-off of
+# adding the house loads in a different order.  Exits with a non-zero code
+# naming the first difference.
+
+import sys
+
+def rows(filename):
+	return [line.strip().split(",") for line in open(filename) if not line.startswith("#")]
+
+accumulated, locked = rows(sys.argv[1]), rows(sys.argv[2])
+if len(accumulated) == 0 or len(accumulated) != len(locked):
+	print("accumulator_check: %s has %d rows and %s has %d" % (sys.argv[1],len(accumulated),sys.argv[2],len(locked)))
+	sys.exit(1)
+for a, b in zip(accumulated,locked):
+	if a[0] != b[0] or len(a) != len(b):
+		print("accumulator_check: rows at %s and %s do not match" % (a[0],b[0]))
+		sys.exit(1)
+	for x, y in zip(a[1:],b[1:]):
+		x, y = float(x), float(y)
+		if abs(x-y) > 1e-9*max(1.0,abs(x),abs(y)):
+			print("accumulator_check: %s differs at %s: %g accumulated, %g locked" % (sys.argv[1],a[0],x,y))
+			sys.exit(1)
+print("accumulator_check: %s matches %s" % (sys.argv[1],sys.argv[2]))
@@ -238,15 +238,28 @@ EVDEMAND *load_demand_profile(char *filename)
 	fclose(fp);
 	return data;
 }
+/// Get an EV demand profile, loading it the first time it is used
+/// Objects may initialize concurrently, so the list is locked while the profile is located or loaded.
 EVDEMAND *get_demand_profile(char *name)
 {
-	EVDEMAND *profile = find_demand_profile(name);
-	if (profile==NULL)
+	static unsigned int demand_profile_lock = 0;
+	EVDEMAND *profile;
+	WRITELOCK(&demand_profile_lock);
+	try {
+		profile = find_demand_profile(name);
+		if (profile==NULL)
+		{
+			profile = load_demand_profile(name);
+			if (profile!=NULL)
+				add_demand_profile(profile);
+		}
+	}
+	catch (...)
 	{
-		profile = load_demand_profile(name);
-		if (profile!=NULL)
-			add_demand_profile(profile);
+		WRITEUNLOCK(&demand_profile_lock);
+		throw;
 	}
+	WRITEUNLOCK(&demand_profile_lock);
 	return profile;
 }
 
@@ -6,8 +6,173 @@
 #include <stdio.h>
 #include <errno.h>
 #include <math.h>
+#include <string.h>
 #include "evcharger_det.h"
 
+//////////////////////////////////////////////////////////////////////////
+// NHTS data files - loaded once and shared by all the evcharger_det objects
+//////////////////////////////////////////////////////////////////////////
+static NHTSDATA *first_nhts_data = NULL;
+static unsigned int nhts_data_lock = 0;
+
+/// Find a loaded NHTS data file
+/// @returns pointer to the matching NHTSDATA structure
+static NHTSDATA *find_nhts_data(char *filename)
+{
+	NHTSDATA *item = first_nhts_data;
+	while (item!=NULL)
+	{
+		if (strcmp(filename,item->filename)==0)
+			break;
+		else
+			item = item->next;
+	}
+	return item;
+}
+
+/// Load an NHTS data file
+/// Each line after the header is one vehicle.  The fields kept are the home arrival time,
+/// home duration, miles, work arrival time and work duration (the 4th, 5th, 7th, 8th and 9th).
+/// @returns pointer to the new NHTSDATA structure, or NULL if the file could not be read
+static NHTSDATA *load_nhts_data(char *filename)
+{
+	NHTSDATA *data;
+	NHTSENTRY *entry;
+	FILE *fp;
+	char *buffer, *line, *next_line, *field, *end_ptr;
+	char temp_char_value[33];
+	double values[9];
+	long size;
+	unsigned int n_lines, n_entries;
+	int field_idx, curr_idx;
+
+	fp = fopen(filename,"rt");
+	if (fp == NULL)
+		return NULL;
+
+	//Read the whole file
+	fseek(fp,0,SEEK_END);
+	size = ftell(fp);
+	fseek(fp,0,SEEK_SET);
+	buffer = (char*)malloc(size+1);
+	if (buffer == NULL)
+	{
+		fclose(fp);
+		GL_THROW("evcharger_det: unable to allocate memory for NHTS data");
+		/*  TROUBLESHOOT
+		The memory to read the NHTS data file could not be allocated.  Please check the file and the
+		memory available and try again.
+		*/
+	}
+	size = (long)fread(buffer,1,size,fp);
+	buffer[size] = '\0';
+	fclose(fp);
+
+	//Count the vehicles
+	n_lines = 0;
+	for (line=buffer; *line!='\0'; line++)
+	{
+		if (*line == '\n')
+			n_lines++;
+	}
+
+	data = new NHTSDATA;
+	if (data == NULL)
+	{
+		free(buffer);
+		GL_THROW("evcharger_det: unable to allocate memory for NHTS data");
+		//Defined above
+	}
+	strcpy(data->filename,filename);
+	data->n_entries = n_lines;
+	data->entry = new NHTSENTRY[n_lines>0 ? n_lines : 1];
+	data->next = NULL;
+
+	//Skip the header, then parse one vehicle per line
+	line = strchr(buffer,'\n');
+	n_entries = 0;
+	while (line!=NULL && n_entries<n_lines)
+	{
+		line++;
+		if (*line == '\0')	//Nothing after the last CR
+			break;
+		next_line = strchr(line,'\n');
+		if (next_line != NULL)
+			*next_line = '\0';
+
+		entry = &data->entry[n_entries++];
+		entry->status = NE_VALID;
+		memset(values,0,sizeof(values));
+		field = line;
+		for (field_idx=0; field_idx<9; field_idx++)
+		{
+			//Copy the field up to the next comma
+			curr_idx = 0;
+			while (*field!='\0' && *field!=',' && curr_idx<31)
+				temp_char_value[curr_idx++] = *field++;
+			temp_char_value[curr_idx] = '\0';
+
+			if (*field!='\0' && *field!=',')	//32 characters or more
+			{
+				entry->status = NE_TOOLONG;
+				while (*field!='\0' && *field!=',')
+					field++;
+			}
+			values[field_idx] = strtod(temp_char_value,&end_ptr);
+
+			//The first eight fields must be followed by a comma
+			if (field_idx<8 && *field!=',')
+			{
+				entry->status = NE_INVALID;
+				break;
+			}
+			if (*field == ',')
+				field++;
+		}
+
+		entry->HomeArrive = values[3];
+		entry->HomeDuration = values[4];
+		entry->travel_distance = values[6];
+		entry->WorkArrive = values[7];
+		entry->WorkDuration = values[8];
+
+		line = next_line;
+	}
+	data->n_entries = n_entries;
+
+	free(buffer);
+	return data;
+}
+
+/// Get the NHTS data of a file, loading it the first time it is used
+/// Objects may initialize concurrently, so the list is locked while the file is located or loaded.
+/// @returns pointer to the NHTSDATA structure, or NULL if the file could not be read
+static NHTSDATA *get_nhts_data(char *filename)
+{
+	NHTSDATA *data;
+
+	WRITELOCK(&nhts_data_lock);
+	data = find_nhts_data(filename);
+	if (data==NULL)
+	{
+		try {
+			data = load_nhts_data(filename);
+		}
+		catch (...)
+		{
+			WRITEUNLOCK(&nhts_data_lock);
+			throw;
+		}
+		if (data!=NULL)
+		{
+			data->next = first_nhts_data;
+			first_nhts_data = data;
+		}
+	}
+	WRITEUNLOCK(&nhts_data_lock);
+	return data;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // evcharger_det CLASS FUNCTIONS
 //////////////////////////////////////////////////////////////////////////
@@ -120,16 +285,13 @@ int evcharger_det::init(OBJECT *parent)
 	OBJECT *hdr = OBJECTHDR(this);
 	int TempIdx;
 	int init_res;
-	int comma_count, curr_idx, curr_comma_count;
-	char temp_char;
-	char temp_char_value[33];
 	char temp_buff[128];
-	char *curr_ptr, *end_ptr;
-	double home_arrive, home_durr, temp_miles, work_arrive, work_durr, glob_min_timestep_dbl, temp_val;
+	double glob_min_timestep_dbl, temp_val;
 	double temp_hours_curr, temp_hours_curr_two, temp_hours_A, temp_hours_B, temp_hours_C, temp_hours_D;
 	double temp_sec_curr, temp_sec_curr_two, temp_sec_A, temp_sec_B, temp_sec_C, temp_sec_D;
 	double temp_amps;
-	FILE *FPTemp;
+	NHTSDATA *nhts_data;
+	NHTSENTRY *nhts_entry;
 	TIMESTAMP temp_time;
 	DATETIME temp_date;
 	
@@ -203,9 +365,6 @@ int evcharger_det::init(OBJECT *parent)
 	//Initialize enduse structure
 	init_res = residential_enduse::init(parent);
 
-	//Set end index of character array, just cause
-	temp_char_value[32] = '\0';
-
 	//See if a file has been specified
 	if (NHTSDataFile[0] != '\0')	//At least has something in it
 	{
@@ -220,11 +379,11 @@ int evcharger_det::init(OBJECT *parent)
 		}
 		else	//"Semi" valid (may be too big)
 		{
-			//Try to open if
-			FPTemp = fopen(NHTSDataFile,"rt");
+			//Find the file - it is only read the first time
+			nhts_data = get_nhts_data(NHTSDataFile);
 
 			//Make sure it worked
-			if (FPTemp == NULL)
+			if (nhts_data == NULL)
 			{
 				gl_warning("NHTS data file not found, using defaults");
 				/*  TROUBLESHOOT
@@ -232,327 +391,33 @@ int evcharger_det::init(OBJECT *parent)
 				A set of default values will be used instead.
 				*/
 			}
+			else if ((VehicleLocation > nhts_data->n_entries) || (nhts_data->entry[VehicleLocation-1].status == NE_INVALID))
+			{
+				GL_THROW("Invalid entry in NHTS file - may have exceeded file length!");
+				/*  TROUBLESHOOT
+				An invalid index value in the NHTS data file was attempted.  This could occur if an index
+				larger than the maximum number of entries was attempted.  Please ensure a valid range
+				was specified, or the NHTS-data file is correct.
+				*/
+			}
+			else if (nhts_data->entry[VehicleLocation-1].status == NE_TOOLONG)
+			{
+				GL_THROW("NHTS entry exceeded 32 characters");
+				/*  TROUBLESHOOT
+				The reading buffer for parsing the NHTS data file was exceeded.  Please check your
+				data file and try again.  If your entries are over 32 characters long, this will fail.
+				*/
+			}
 			else
 			{
-				//Determine number of commas until will be there
-				comma_count = (int)(VehicleLocation)*9;
-
-				//Parse through until comma count reached - then look for CR
-				curr_idx = 0;
-				curr_comma_count = 0;
-
-				//Get character
-				temp_char = fgetc(FPTemp);
-
-				while ((temp_char > 0) && (curr_comma_count < comma_count))
-				{
-					//See if it is a delimiter
-					if (temp_char == ',')
-						curr_comma_count++;
-
-					//Get the next one
-					temp_char = fgetc(FPTemp);
-				}
-
-				//Now continue on to the CR
-				while ((temp_char > 0) && (temp_char != '\n'))
-				{
-					//Get the next one
-					temp_char = fgetc(FPTemp);
-				}
-
-				//Make sure it is right
-				if (temp_char == '\n')
-				{
-					curr_comma_count = 0;
-
-					//Fill the buffer to the first comma
-					temp_char = fgetc(FPTemp);
-
-					//Parse - find commas
-					while (temp_char > 0)
-					{
-						//See if the current character is a comma
-						if (temp_char==',')
-						{
-							//Increment
-							curr_comma_count++;
-
-							//See if we've had enough
-							if (curr_comma_count>=3)
-							{
-								//Get us out of the while
-								break;
-							}
-						}
-
-						//Get next value
-						temp_char = getc(FPTemp);
-					}// End while
-
-					//Make sure we succeeded
-					if (curr_comma_count == 3)
-					{
-						//Get next value
-						temp_char = fgetc(FPTemp);
-
-						//While loop
-						while ((temp_char > 0) && (curr_idx < 32))
-						{
-							if (temp_char == ',')
-							{
-								//Outta the loop we go
-								break;
-							}
-							else	//Not a comma, store it
-							{
-								//Store the value
-								temp_char_value[curr_idx] = temp_char;
-
-								//Increment
-								curr_idx++;
-
-								//Check the index
-								if (curr_idx>31)
-								{
-									GL_THROW("NHTS entry exceeded 32 characters");
-									/*  TROUBLESHOOT
-									The reading buffer for parsing the NHTS data file was exceeded.  Please check your
-									data file and try again.  If your entries are over 32 characters long, this will fail.
-									*/
-								}
-							}
-
-							//Get next value
-							temp_char = fgetc(FPTemp);
-						}//End While
-
-						//Store a null at the last position - outside to catch invalids
-						temp_char_value[curr_idx]='\0';
-
-						//Put the pointer to the buffer
-						curr_ptr = temp_char_value;
-
-						//Get home arrive_time
-						home_arrive = strtod(curr_ptr,&end_ptr);
-
-						//Reset
-						curr_idx = 0;
-
-						//Get next value
-						temp_char = fgetc(FPTemp);
-
-						//Loop until comma
-						while ((temp_char > 0) && (curr_idx < 32))
-						{
-							if (temp_char == ',')
-							{
-								//Outta the loop we go
-								break;
-							}
-							else	//Not a comma, store it
-							{
-								//Store the value
-								temp_char_value[curr_idx] = temp_char;
-
-								//Increment
-								curr_idx++;
-
-								//Check the index
-								if (curr_idx>31)
-								{
-									GL_THROW("NHTS entry exceeded 32 characters");
-									//Define above
-								}
-							}
-
-							//Get next value
-							temp_char = fgetc(FPTemp);
-						}//End While
-
-						//Store a null at the last position - outside to catch invalids
-						temp_char_value[curr_idx]='\0';
-
-						//Put the pointer to the buffer
-						curr_ptr = temp_char_value;
-
-						//Get home duration_time
-						home_durr = strtod(curr_ptr,&end_ptr);
-
-						//Skip the next entry
-						temp_char = fgetc(FPTemp);
-
-						//Loop until comma
-						while (temp_char > 0)
-						{
-							if (temp_char == ',')
-							{
-								//Outta the loop we go
-								break;
-							}
-
-							//Get next value
-							temp_char = fgetc(FPTemp);
-						}//End While
-
-						//Next one is miles - keep
-						//reset
-						curr_idx = 0;
-
-						//Get next value
-						temp_char = fgetc(FPTemp);
-
-						//Loop until comma
-						while ((temp_char > 0) && (curr_idx < 32))
-						{
-							if (temp_char == ',')
-							{
-								//Outta the loop we go
-								break;
-							}
-							else	//Not a comma, store it
-							{
-								//Store the value
-								temp_char_value[curr_idx] = temp_char;
-
-								//Increment
-								curr_idx++;
-
-								//Check the index
-								if (curr_idx>31)
-								{
-									GL_THROW("NHTS entry exceeded 32 characters");
-									//Define above
-								}
-							}
-
-							//Get next value
-							temp_char = fgetc(FPTemp);
-						}//End While
-
-						//Store a null at the last position - outside to catch invalids
-						temp_char_value[curr_idx]='\0';
-
-						//Put the pointer to the buffer
-						curr_ptr = temp_char_value;
-
-						//Get miles
-						temp_miles = strtod(curr_ptr,&end_ptr);
-
-						//Reset
-						curr_idx = 0;
-
-						//Get next value
-						temp_char = fgetc(FPTemp);
-
-						//Loop until comma
-						while ((temp_char > 0) && (curr_idx < 32))
-						{
-							if (temp_char == ',')
-							{
-								//Outta the loop we go
-								break;
-							}
-							else	//Not a comma, store it
-							{
-								//Store the value
-								temp_char_value[curr_idx] = temp_char;
-
-								//Increment
-								curr_idx++;
-
-								//Check the index
-								if (curr_idx>31)
-								{
-									GL_THROW("NHTS entry exceeded 32 characters");
-									//Define above
-								}
-							}
-
-							//Get next value
-							temp_char = fgetc(FPTemp);
-						}//End While
-
-						//Store a null at the last position - outside to catch invalids
-						temp_char_value[curr_idx]='\0';
-
-						//Put the pointer to the buffer
-						curr_ptr = temp_char_value;
-
-						//Get work arrive_time
-						work_arrive = strtod(curr_ptr,&end_ptr);
-
-						//Reset
-						curr_idx = 0;
-
-						//Get next value
-						temp_char = fgetc(FPTemp);
-
-						//Loop until comma
-						while ((temp_char > 0) && (curr_idx < 32))
-						{
-							if (temp_char == ',')
-							{
-								//Outta the loop we go
-								break;
-							}
-							else	//Not a comma, store it
-							{
-								//Store the value
-								temp_char_value[curr_idx] = temp_char;
-
-								//Increment
-								curr_idx++;
-
-								//Check the index
-								if (curr_idx>31)
-								{
-									GL_THROW("NHTS entry exceeded 32 characters");
-									//Define above
-								}
-							}
-
-							//Get next value
-							temp_char = fgetc(FPTemp);
-						}//End While
-
-						//Store a null at the last position - outside to catch invalids
-						temp_char_value[curr_idx]='\0';
-
-						//Put the pointer to the buffer
-						curr_ptr = temp_char_value;
-
-						//Get work duration_time
-						work_durr = strtod(curr_ptr,&end_ptr);
-
-						//Put extracted results into structure
-						CarInformation.HomeArrive = home_arrive;
-						CarInformation.HomeDuration = home_durr * 60.0;	//In minutes, make seconds
-						CarInformation.WorkArrive = work_arrive;
-						CarInformation.WorkDuration = work_durr * 60.0;	//In minutes, make seconds
-						CarInformation.travel_distance = temp_miles;
-					}
-					else
-					{
-						GL_THROW("Invalid entry in NHTS file - may have exceeded file length!");
-						/*  TROUBLESHOOT
-						An invalid index value in the NHTS data file was attempted.  This could occur if an index
-						larger than the maximum number of entries was attempted.  Please ensure a valid range
-						was specified, or the NHTS-data file is correct.
-						*/
-					}
-				}	//End CR - valid entry
-				else
-				{
-					//Close the file handle, if necessary
-					fclose(FPTemp);
-
-					GL_THROW("Invalid entry in NHTS file - may have exceeded file length!");
-					//Defined above
-				}
-
-				//Close the file handle, if necessary
-				fclose(FPTemp);
+				nhts_entry = &nhts_data->entry[VehicleLocation-1];
+
+				//Put extracted results into structure
+				CarInformation.HomeArrive = nhts_entry->HomeArrive;
+				CarInformation.HomeDuration = nhts_entry->HomeDuration * 60.0;	//In minutes, make seconds
+				CarInformation.WorkArrive = nhts_entry->WorkArrive;
+				CarInformation.WorkDuration = nhts_entry->WorkDuration * 60.0;	//In minutes, make seconds
+				CarInformation.travel_distance = nhts_entry->travel_distance;
 			}
 		}//End Vehicle location "valid"
 	}
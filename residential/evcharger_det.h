@@ -35,6 +35,28 @@ typedef struct  {
 	TIMESTAMP next_state_change;	///< Timestamp of next transition (home->work, work->home)
 } VEHICLEDATA;
 
+typedef enum {
+		NE_INVALID=0,					///< entry is missing or does not have all the fields
+		NE_VALID=1,						///< entry is valid
+		NE_TOOLONG=2					///< entry has a field longer than 32 characters
+} NHTSENTRYSTATUS;
+
+typedef struct {
+	double HomeArrive;				///< Time when vehicle arrives at home HHMM
+	double HomeDuration;			///< Minutes a vehicle remains at home
+	double travel_distance;			///< Distance the vehicle travels on any trip from home
+	double WorkArrive;				///< Time when vehicle arrives at work HHMM
+	double WorkDuration;			///< Minutes a vehicle remains at work
+	enumeration status;				///< NHTSENTRYSTATUS of the entry
+} NHTSENTRY;
+
+typedef struct s_nhtsdata {
+	char1024 filename;				///< Path to NHTS travel data
+	unsigned int n_entries;			///< Number of vehicles in the file
+	NHTSENTRY *entry;				///< Entries, vehicle_index 1 is entry[0]
+	struct s_nhtsdata *next;
+} NHTSDATA;
+
 class evcharger_det : public residential_enduse
 {
 public:
@@ -166,7 +166,7 @@ house_e::house_e(MODULE *mod) : residential_enduse(mod)
 	if (oclass==NULL)  
 	{
 		// register the class definition
-		oclass = gl_register_class(mod,"house",sizeof(house_e),PC_PRETOPDOWN|PC_BOTTOMUP|PC_POSTTOPDOWN|PC_AUTOLOCK);
+		oclass = gl_register_class(mod,"house",sizeof(house_e),PC_PRETOPDOWN|PC_BOTTOMUP|PC_POSTTOPDOWN|PC_AUTOLOCK|PC_INITSAFE);
 		if (oclass==NULL)
 			throw "unable to register class house";
 		else
@@ -548,6 +548,7 @@ int house_e::create()
 	//Powerflow hooks
 	pHouseConn = NULL;
 	pMeterStatus = NULL;
+	pLine_I_sum = pShunt_sum = pPower_sum = NULL;
 
 	// set up implicit enduse list
 	implicit_enduse_list = NULL;
@@ -725,9 +726,11 @@ int house_e::init_climate()
 {
 	OBJECT *hdr = OBJECTHDR(this);
 
-	// link to climate data
+	// link to climate data (houses may initialize concurrently)
 	static FINDLIST *climates = NULL;
+	static unsigned int climates_lock = 0;
 	int not_found = 0;
+	WRITELOCK(&climates_lock);
 	if (climates==NULL && not_found==0) 
 	{
 		climates = gl_find_objects(FL_NEW,FT_CLASS,SAME,"climate",FT_END);
@@ -747,6 +750,7 @@ int house_e::init_climate()
 			gl_warning("house_e: %d climates found, using first one defined", climates->hit_count);
 		}
 	}
+	WRITEUNLOCK(&climates_lock);
 	if (climates!=NULL)
 	{
 		if (climates->hit_count==0)
@@ -1277,6 +1281,20 @@ int house_e::init(OBJECT *parent)
 		pMeterStatus = &default_meter_status;
 	}
 
+	// the loads of all the houses on a meter are combined once per pass instead of under the meter lock
+	pLine_I_sum = gl_accumulator_create(pLine_I,3);
+	pShunt_sum = gl_accumulator_create(pShunt,3);
+	pPower_sum = gl_accumulator_create(pPower,3);
+	if (pLine_I_sum==NULL || pShunt_sum==NULL || pPower_sum==NULL)
+	{
+		gl_error("house_e:%d unable to accumulate its load into the meter", obj->id);
+		/*  TROUBLESHOOT
+		The house could not allocate the buffers used to post its load to the parent meter.
+		Try freeing up system memory, or reducing the thread count, and try again.
+		*/
+		return 0;
+	}
+
 	//grab the start time of the simulation
 	simulation_beginning_time = gl_globalclock;
 
@@ -2458,31 +2476,11 @@ TIMESTAMP house_e::sync(TIMESTAMP t0, TIMESTAMP t1)
 /** Removes load contributions from parent object **/
 TIMESTAMP house_e::postsync(TIMESTAMP t0, TIMESTAMP t1)
 {
-	OBJECT *obj = OBJECTHDR(this);
-
-	// compute line currents and post to meter
-	if (obj->parent != NULL)
-		wlock(obj->parent);
-
-	//Post accumulations up to parent meter/node
-	//Update power
-	pPower[0] -= load_values[0][0];
-	pPower[1] -= load_values[0][1];
-	pPower[2] -= load_values[0][2];
-	
-	//Current
-	pLine_I[0] -= load_values[1][0];
-	pLine_I[1] -= load_values[1][1];
-	pLine_I[2] -= load_values[1][2];
+	//Remove accumulations from parent meter/node
+	gl_accumulator_sub(pPower_sum,load_values[0]);
+	gl_accumulator_sub(pLine_I_sum,load_values[1]);
 	//Neutral not handled in here, since it was always zero anyways
-
-	//Admittance
-	pShunt[0] -= load_values[2][0];
-	pShunt[1] -= load_values[2][1];
-	pShunt[2] -= load_values[2][2];
-
-	if (obj->parent != NULL)
-		wunlock(obj->parent);
+	gl_accumulator_sub(pShunt_sum,load_values[2]);
 
 	return TS_NEVER;
 }
@@ -2946,29 +2944,11 @@ TIMESTAMP house_e::sync_panel(TIMESTAMP t0, TIMESTAMP t1)
 
 	total_load = total.total.Mag();
 
-	// compute line currents and post to meter
-	if (obj->parent != NULL)
-		wlock(obj->parent);
-
-	//Post accumulations up to parent meter/node
-	//Update power
-	pPower[0] += load_values[0][0];
-	pPower[1] += load_values[0][1];
-	pPower[2] += load_values[0][2];
-	
-	//Current
-	pLine_I[0] += load_values[1][0];
-	pLine_I[1] += load_values[1][1];
-	pLine_I[2] += load_values[1][2];
+	//Post accumulations up to parent meter/node, they are combined once all houses are done
+	gl_accumulator_add(pPower_sum,load_values[0]);
+	gl_accumulator_add(pLine_I_sum,load_values[1]);
 	//Neutral assumed 0, since it was anyways
-
-	//Admittance
-	pShunt[0] += load_values[2][0];
-	pShunt[1] += load_values[2][1];
-	pShunt[2] += load_values[2][2];
-
-	if (obj->parent != NULL)
-		wunlock(obj->parent);
+	gl_accumulator_add(pShunt_sum,load_values[2]);
 
 	return t2;
 }
@@ -76,6 +76,9 @@ public:
 	complex *pPower;						///< pointer to power value on triplex parent
 	bool *pHouseConn;						///< Pointer to house_present variable on triplex parent
 	int *pMeterStatus;						///< Pointer to service_status variable on triplex parent
+	ACCUMULATOR *pLine_I_sum;				///< accumulates the load currents into pLine_I
+	ACCUMULATOR *pShunt_sum;				///< accumulates the load admittances into pShunt
+	ACCUMULATOR *pPower_sum;				///< accumulates the load powers into pPower
 	IMPLICITENDUSE *implicit_enduse_list;	///< implicit enduses
 	static set implicit_enduses_active;		///< implicit enduses that are to be activated
 	static enumeration implicit_enduse_source; ///< source of implicit enduses (e.g., ELCAP1990, ELCAP2010, RBSA2014)
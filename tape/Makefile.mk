@@ -1,3 +1,5 @@
+dist_pkgdata_DATA += tape/metrics_reader.py
+
 pkglib_LTLIBRARIES += tape/tape.la
 
 tape_tape_la_CPPFLAGS =
@@ -21,6 +23,8 @@ tape_tape_la_SOURCES += tape/metrics_collector.cpp
 tape_tape_la_SOURCES += tape/metrics_collector.h
 tape_tape_la_SOURCES += tape/metrics_collector_writer.cpp
 tape_tape_la_SOURCES += tape/metrics_collector_writer.h
+tape_tape_la_SOURCES += tape/metrics_columnar.cpp
+tape_tape_la_SOURCES += tape/metrics_columnar.h
 tape_tape_la_SOURCES += tape/violation_recorder.h
 tape_tape_la_SOURCES += tape/violation_recorder.cpp
 tape_tape_la_SOURCES += tape/histogram.cpp
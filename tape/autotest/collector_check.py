@@ -0,0 +1,27 @@
+# Recording check for test_collector_threaded_equivalence.glm
+#
+# Usage: python3 collector_check.py <threaded csv> <serial csv>
+#
+# The collector recordings must have the same times and aggregates within the
+# round-off of reducing the members in chunks.  Exits with a non-zero code naming
+# the first difference.
+
+import sys
+
+def rows(filename):
+	return [line.strip().split(",") for line in open(filename) if not line.startswith("#")]
+
+threaded, serial = rows(sys.argv[1]), rows(sys.argv[2])
+if len(threaded) == 0 or len(threaded) != len(serial):
+	print("collector_check: %s has %d rows and %s has %d" % (sys.argv[1],len(threaded),sys.argv[2],len(serial)))
+	sys.exit(1)
+for a, b in zip(threaded,serial):
+	if a[0] != b[0] or len(a) != len(b):
+		print("collector_check: rows at %s and %s do not match" % (a[0],b[0]))
+		sys.exit(1)
+	for column, (x, y) in enumerate(zip(a[1:],b[1:])):
+		x, y = float(x), float(y)
+		if abs(x-y) > 1e-9*max(1.0,abs(x),abs(y)):
+			print("collector_check: aggregate %d differs at %s: %.12g threaded, %.12g serial" % (column+1,a[0],x,y))
+			sys.exit(1)
+print("collector_check: %s matches %s" % (sys.argv[1],sys.argv[2]))
@@ -0,0 +1,66 @@
+# Columnar output check for test_metrics_columnar.glm
+#
+# Usage: python3 metrics_columnar_check.py <metrics_reader.py> <columnar file> <json file> <intervals>
+#
+# Reads the columnar files with metrics_reader.py and compares them with the
+# JSON files written by the reference run.  Exits with a non-zero code naming
+# the first check that failed.
+
+import importlib.util
+import json
+import math
+import subprocess
+import sys
+
+readerfile, columnarfile, jsonfile, intervals = sys.argv[1:5]
+intervals = int(intervals)
+
+spec = importlib.util.spec_from_file_location("metrics_reader",readerfile)
+metrics_reader = importlib.util.module_from_spec(spec)
+spec.loader.exec_module(metrics_reader)
+
+def check(name, condition):
+	if not condition:
+		print("metrics_columnar_check: %s failed" % name)
+		sys.exit(1)
+
+def same(a, b):
+	"""values match, allowing for the digits the JSON writer prints"""
+	if a is None or b is None:
+		return a is None and b is None
+	return a == b or abs(a-b) <= 1e-14*max(abs(a),abs(b))
+
+for prefix in ["billing_meter_", "house_", "inverter_", "substation_"]:
+	metrics = metrics_reader.MetricsFile(prefix+columnarfile)
+	expected = json.load(open(prefix+jsonfile))
+	actual = metrics.to_json()
+
+	# the last chunk is only written when the writer is finalized
+	check(prefix+" intervals", len(metrics.times()) == intervals)
+	check(prefix+" keys", sorted(actual.keys()) == sorted(expected.keys()))
+	check(prefix+" metadata", actual["Metadata"] == expected["Metadata"] and actual["StartTime"] == expected["StartTime"])
+	for key in expected:
+		if key in ("Metadata","StartTime"):
+			continue
+		check(prefix+" objects at "+key, (actual[key] is None and expected[key] in (None,{}))
+			or sorted(actual[key].keys()) == sorted(expected[key].keys()))
+		for name in (expected[key] or {}):
+			check(prefix+" values of "+name+" at "+key,
+				all(same(a,b) for a, b in zip(actual[key][name],expected[key][name])))
+
+	# the stored aggregates are those of the decoded values
+	for metric in metrics.metrics:
+		for values, (low, high, total) in zip(metrics.column(metric),metrics.aggregate(metric)):
+			values = [v for v in values if not math.isnan(v)]
+			if values:
+				check(prefix+" aggregates of "+metric, low == min(values) and high == max(values)
+					and abs(total-sum(values)) <= 1e-12*max(1,sum(abs(v) for v in values)))
+
+	# the command line prints the summary and one column
+	summary = subprocess.run([sys.executable,readerfile,prefix+columnarfile],stdout=subprocess.PIPE)
+	check(prefix+" summary", summary.returncode == 0 and ("intervals: %d" % intervals) in summary.stdout.decode())
+	if metrics.metrics and metrics.objects:
+		csv = subprocess.run([sys.executable,readerfile,prefix+columnarfile,"--csv",metrics.metrics[0]],stdout=subprocess.PIPE)
+		check(prefix+" csv", csv.returncode == 0 and len(csv.stdout.decode().splitlines()) == intervals+1)
+
+print("metrics_columnar_check: all checks passed")
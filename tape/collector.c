@@ -176,18 +176,24 @@ AGGREGATION *link_aggregates(char *aggregate_list, char *group)
 
 int read_aggregates(AGGREGATION *aggr, char *buffer, int size)
 {
-	AGGREGATION *p;
+	AGGREGATION *p=aggr;
 	int offset=0;
 	int count=0;
 	char32 fmt;
+	double value[32];
 
 	gl_global_getvar("double_format", fmt, 32);
-	for (p=aggr; p!=NULL && offset<size-33; p=p->next)
+	while (p!=NULL && offset<size-33)
 	{
-		if (offset>0) strcpy(buffer+offset++,",");
-		offset+=sprintf(buffer+offset,fmt,gl_run_aggregate(p));
-		buffer[offset]='\0';
-		count++;
+		/* aggregates over the same group are evaluated in one pass */
+		unsigned int i, n = gl_run_aggregates(p,value,sizeof(value)/sizeof(value[0]));
+		for (i=0; i<n && offset<size-33; i++, p=p->next)
+		{
+			if (offset>0) strcpy(buffer+offset++,",");
+			offset+=sprintf(buffer+offset,fmt,value[i]);
+			buffer[offset]='\0';
+			count++;
+		}
 	}
 	return count;
 }
@@ -292,4 +298,14 @@ Error:
 	return (my->interval==0 || my->interval==-1) ? TS_NEVER : my->last.ts+my->interval;
 }
 
+EXPORT int finalize_collector(OBJECT *obj)
+{
+	struct collector *my = OBJECTDATA(obj,struct collector);
+
+	/* flush the tape so on_term scripts see the whole collection */
+	if (my->status==TS_OPEN && my->ops!=NULL && my->ops->flush!=NULL)
+		my->ops->flush(my);
+	return 1;
+}
+
 /**@}*/
@@ -36,6 +36,7 @@ metrics_collector::metrics_collector(MODULE *mod){
 
         if(gl_publish_variable(oclass,
 			PT_double, "interval[s]", PADDR(interval_length_dbl), PT_DESCRIPTION, "Interval at which the metrics_collector output is stored in JSON format",
+			PT_bool, "median_estimate", PADDR(median_estimate), PT_DESCRIPTION, "Estimate the medians from running quantile markers instead of keeping the samples of each interval (default is false, exact medians)",
 
 			NULL) < 1) GL_THROW("unable to publish properties in %s",__FILE__);
 
@@ -53,17 +54,13 @@ int metrics_collector::create(){
 	memcpy(this, defaults, sizeof(metrics_collector));
 
 	// Give default values to parameters related to triplex_meter
-	real_power_array = NULL;
-	reactive_power_array = NULL;
-	voltage_mag_array = NULL;
-	voltage_average_mag_array = NULL;
-	voltage_unbalance_array = NULL;
 	last_vol_val = -1.0; // give initial value as negative one
 
 	// Interval related
 	interval_length = -1;
 	curr_index = last_index = 0;
 	interval_length_dbl=-1.0;
+	median_estimate = false;
 
 
 	return 1;
@@ -220,239 +217,38 @@ int metrics_collector::init(OBJECT *parent){
 		return 0;
 	}
 
-	// Allocate the arrays based on the parent type
+	// Create the interval statistics based on the parent type
+	bool created = false;
 	if ((strcmp(parent_string, "triplex_meter") == 0) || (strcmp(parent_string, "meter") == 0)) {
-		// Allocate real power array
-		real_power_array = (double *)gl_malloc(interval_length*sizeof(double));
-		// Check
-		if (real_power_array == NULL)
-		{
-			GL_THROW("metrics_collector %d::init(): Failed to allocated real power array",obj->id);
-			/*  TROUBLESHOOT
-			While attempting to allocate the array, an error was encountered.
-			Please try again.  If the error persists, please submit a bug report via the Trac system.
-			*/
-		}
-
-		// Allocate reactive power array
-		reactive_power_array = (double *)gl_malloc(interval_length*sizeof(double));
-		// Check
-		if (reactive_power_array == NULL)
-		{
-			GL_THROW("metrics_collector %d::init(): Failed to allocated reactive power array",obj->id);
-			/*  TROUBLESHOOT
-			While attempting to allocate the array, an error was encountered.
-			Please try again.  If the error persists, please submit a bug report via the Trac system.
-			*/
-		}
-
-		// Allocate phase 1-2 voltage array
-		voltage_mag_array = (double *)gl_malloc(interval_length*sizeof(double));
-		// Check
-		if (voltage_mag_array == NULL)
-		{
-			GL_THROW("metrics_collector %d::init(): Failed to allocated phase 1-2 voltage array",obj->id);
-			/*  TROUBLESHOOT
-			While attempting to allocate the array, an error was encountered.
-			Please try again.  If the error persists, please submit a bug report via the Trac system.
-			*/
-		}
-
-		// Allocate average voltage array
-		voltage_average_mag_array = (double *)gl_malloc(interval_length*sizeof(double));
-		// Check
-		if (voltage_average_mag_array == NULL)
-		{
-			GL_THROW("metrics_collector %d::init(): Failed to allocated average voltage array",obj->id);
-			/*  TROUBLESHOOT
-			While attempting to allocate the array, an error was encountered.
-			Please try again.  If the error persists, please submit a bug report via the Trac system.
-			*/
-		}
-
-		// Allocate voltage unbalance array
-		voltage_unbalance_array = (double *)gl_malloc(interval_length*sizeof(double));
-		// Check
-		if (voltage_unbalance_array == NULL)
-		{
-			GL_THROW("metrics_collector %d::init(): Failed to allocated voltage unbalance array",obj->id);
-			/*  TROUBLESHOOT
-			While attempting to allocate the array, an error was encountered.
-			Please try again.  If the error persists, please submit a bug report via the Trac system.
-			*/
-		}
-
-		// Initialize the array
-		for (curr_index=0; curr_index<interval_length; curr_index++)
-		{
-			real_power_array[curr_index] = 0.0;
-			reactive_power_array[curr_index] = 0.0;
-			voltage_mag_array[curr_index] = 0.0;
-			voltage_average_mag_array[curr_index] = 0.0;
-			voltage_unbalance_array[curr_index] = 0.0;
-		}
-
+		created = create_metric(&real_power, true)
+			&& create_metric(&reactive_power, true)
+			&& create_metric(&voltage_mag, false)
+			&& create_metric(&voltage_average_mag, false)
+			&& create_metric(&voltage_unbalance, false);
 	}
 	// If parent is house
 	else if (strcmp(parent_string, "house") == 0) {
-		// Allocate total_load array
-		total_load_array = (double *)gl_malloc(interval_length*sizeof(double));
-		// Check
-		if (total_load_array == NULL)
-		{
-			GL_THROW("metrics_collector %d::init(): Failed to allocated total_load array",obj->id);
-			/*  TROUBLESHOOT
-			While attempting to allocate the array, an error was encountered.
-			Please try again.  If the error persists, please submit a bug report via the Trac system.
-			*/
-		}
-
-		// Allocate hvac_load array
-		hvac_load_array = (double *)gl_malloc(interval_length*sizeof(double));
-		// Check
-		if (hvac_load_array == NULL)
-		{
-			GL_THROW("metrics_collector %d::init(): Failed to allocated hvac_load array",obj->id);
-			/*  TROUBLESHOOT
-			While attempting to allocate the array, an error was encountered.
-			Please try again.  If the error persists, please submit a bug report via the Trac system.
-			*/
-		}
-
-		// Allocate air temperature array
-		air_temperature_array = (double *)gl_malloc(interval_length*sizeof(double));
-		// Check
-		if (air_temperature_array == NULL)
-		{
-			GL_THROW("metrics_collector %d::init(): Failed to allocated air_temperature array",obj->id);
-			/*  TROUBLESHOOT
-			While attempting to allocate the array, an error was encountered.
-			Please try again.  If the error persists, please submit a bug report via the Trac system.
-			*/
-		}
-
-		// Allocate air temperature deviation from cooling setpointarray
-		air_temperature_deviation_cooling_array = (double *)gl_malloc(interval_length*sizeof(double));
-		// Check
-		if (air_temperature_deviation_cooling_array == NULL)
-		{
-			GL_THROW("metrics_collector %d::init(): Failed to allocated air_temperature_deviation_cooling_array array",obj->id);
-			/*  TROUBLESHOOT
-			While attempting to allocate the array, an error was encountered.
-			Please try again.  If the error persists, please submit a bug report via the Trac system.
-			*/
-		}
-
-		// Allocate air temperature deviation from heating setpointarray
-		air_temperature_deviation_heating_array = (double *)gl_malloc(interval_length*sizeof(double));
-		// Check
-		if (air_temperature_deviation_heating_array == NULL)
-		{
-			GL_THROW("metrics_collector %d::init(): Failed to allocated air_temperature_deviation_heating_array array",obj->id);
-			/*  TROUBLESHOOT
-			While attempting to allocate the array, an error was encountered.
-			Please try again.  If the error persists, please submit a bug report via the Trac system.
-			*/
-		}
-
-		// Initialize the array
-		for (curr_index=0; curr_index<interval_length; curr_index++)
-		{
-			total_load_array[curr_index] = 0.0;
-			hvac_load_array[curr_index] = 0.0;
-			air_temperature_array[curr_index] = 0.0;
-			air_temperature_deviation_cooling_array[curr_index] = 0.0;
-			air_temperature_deviation_heating_array[curr_index] = 0.0;
-		}
+		created = create_metric(&total_load, true)
+			&& create_metric(&hvac_load, true)
+			&& create_metric(&air_temperature, true)
+			&& create_metric(&air_temperature_deviation_cooling, false)
+			&& create_metric(&air_temperature_deviation_heating, false);
 	}
 	// If parent is waterheater
 	else if (strcmp(parent_string, "waterheater") == 0) {
-		// Allocate hvac_load array
-		actual_load_array = (double *)gl_malloc(interval_length*sizeof(double));
-		// Check
-		if (actual_load_array == NULL)
-		{
-			GL_THROW("metrics_collector %d::init(): Failed to allocated actual_load array",obj->id);
-			/*  TROUBLESHOOT
-			While attempting to allocate the array, an error was encountered.
-			Please try again.  If the error persists, please submit a bug report via the Trac system.
-			*/
-		}
+		created = create_metric(&actual_load, true);
 	}
 	// If parent is inverter
 	else if (strcmp(parent_string, "inverter") == 0) {
-		// Allocate real power array
-		real_power_array = (double *)gl_malloc(interval_length*sizeof(double));
-		// Check
-		if (real_power_array == NULL)
-		{
-			GL_THROW("metrics_collector %d::init(): Failed to allocated real power array",obj->id);
-			/*  TROUBLESHOOT
-			While attempting to allocate the array, an error was encountered.
-			Please try again.  If the error persists, please submit a bug report via the Trac system.
-			*/
-		}
-
-		// Allocate reactive power array
-		reactive_power_array = (double *)gl_malloc(interval_length*sizeof(double));
-		// Check
-		if (reactive_power_array == NULL)
-		{
-			GL_THROW("metrics_collector %d::init(): Failed to allocated reactive power array",obj->id);
-			/*  TROUBLESHOOT
-			While attempting to allocate the array, an error was encountered.
-			Please try again.  If the error persists, please submit a bug report via the Trac system.
-			*/
-		}
+		created = create_metric(&real_power, true)
+			&& create_metric(&reactive_power, true);
 	}
 	// If parent is meter
 	else if (strcmp(parent_string, "swingbus") == 0) {
-		// Allocate real power array
-		real_power_array = (double *)gl_malloc(interval_length*sizeof(double));
-		// Check
-		if (real_power_array == NULL)
-		{
-			GL_THROW("metrics_collector %d::init(): Failed to allocated real power array",obj->id);
-			/*  TROUBLESHOOT
-			While attempting to allocate the array, an error was encountered.
-			Please try again.  If the error persists, please submit a bug report via the Trac system.
-			*/
-		}
-
-		// Allocate reactive power array
-		reactive_power_array = (double *)gl_malloc(interval_length*sizeof(double));
-		// Check
-		if (reactive_power_array == NULL)
-		{
-			GL_THROW("metrics_collector %d::init(): Failed to allocated reactive power array",obj->id);
-			/*  TROUBLESHOOT
-			While attempting to allocate the array, an error was encountered.
-			Please try again.  If the error persists, please submit a bug report via the Trac system.
-			*/
-		}
-		// Allocate real power loss array
-		real_power_loss_array = (double *)gl_malloc(interval_length*sizeof(double));
-		// Check
-		if (real_power_loss_array == NULL)
-		{
-			GL_THROW("metrics_collector %d::init(): Failed to allocated real power loss array",obj->id);
-			/*  TROUBLESHOOT
-			While attempting to allocate the array, an error was encountered.
-			Please try again.  If the error persists, please submit a bug report via the Trac system.
-			*/
-		}
-
-		// Allocate reactive power loss array
-		reactive_power_loss_array = (double *)gl_malloc(interval_length*sizeof(double));
-		// Check
-		if (reactive_power_loss_array == NULL)
-		{
-			GL_THROW("metrics_collector %d::init(): Failed to allocated reactive power loss array",obj->id);
-			/*  TROUBLESHOOT
-			While attempting to allocate the array, an error was encountered.
-			Please try again.  If the error persists, please submit a bug report via the Trac system.
-			*/
-		}
+		created = create_metric(&real_power, true)
+			&& create_metric(&reactive_power, true)
+			&& create_metric(&real_power_loss, true)
+			&& create_metric(&reactive_power_loss, true);
 	}
 	// else not possible come to this step
 	else {
@@ -463,7 +259,14 @@ int metrics_collector::init(OBJECT *parent){
 		*/
 		return 0;
 	}
-
+	if (!created)
+	{
+		GL_THROW("metrics_collector %d::init(): Failed to create the interval statistics",obj->id);
+		/*  TROUBLESHOOT
+		While attempting to create the running statistics of the metrics interval, an error was encountered.
+		Please try again.  If the error persists, please submit a bug report via the Trac system.
+		*/
+	}
 
 	// Initialize tracking variables
 	curr_index = 0;
@@ -517,7 +320,7 @@ int metrics_collector::commit(TIMESTAMP t1){
 			return 0;
 		}
 		interval_write = false;
-        last_index = 0;  // TODO - we need to have array[0] = array[299], or circular queue
+        last_index = 0;  // the last value read stays as the value at index 0 of the next interval
 	}
 
 	return 1;
@@ -542,8 +345,8 @@ int metrics_collector::read_line(OBJECT *obj){
 		// Get power values
 		double realPower = *gl_get_double_by_name(obj->parent, "measured_real_power");
 		double reactivePower = *gl_get_double_by_name(obj->parent, "measured_reactive_power");
-		interpolate (real_power_array, last_index, curr_index, realPower);
-		interpolate (reactive_power_array, last_index, curr_index, reactivePower);
+		interpolate (&real_power, last_index, curr_index, realPower);
+		interpolate (&reactive_power, last_index, curr_index, reactivePower);
 
 		// Get bill value, price unit given in triplex_meter is [$/kWh]
 		price_parent = *gl_get_double_by_name(obj->parent, "price");
@@ -560,16 +363,16 @@ int metrics_collector::read_line(OBJECT *obj){
 		// compliance with C84.1; unbalance defined as max deviation from average / average, here based on 1-N and 2-N
 		double vavg = 0.5 * (v1 + v2);
 
-		interpolate (voltage_mag_array, last_index, curr_index, fabs(v12));
-		interpolate (voltage_average_mag_array, last_index, curr_index, vavg);
-		interpolate (voltage_unbalance_array, last_index, curr_index, 0.5 * fabs(v1 - v2)/vavg);
+		interpolate (&voltage_mag, last_index, curr_index, fabs(v12));
+		interpolate (&voltage_average_mag, last_index, curr_index, vavg);
+		interpolate (&voltage_unbalance, last_index, curr_index, 0.5 * fabs(v1 - v2)/vavg);
 	}
 	else if (strcmp(parent_string, "meter") == 0)
 	{
 		double realPower = *gl_get_double_by_name(obj->parent, "measured_real_power");
 		double reactivePower = *gl_get_double_by_name(obj->parent, "measured_reactive_power");
-		interpolate (real_power_array, last_index, curr_index, realPower);
-		interpolate (reactive_power_array, last_index, curr_index, reactivePower);
+		interpolate (&real_power, last_index, curr_index, realPower);
+		interpolate (&reactive_power, last_index, curr_index, reactivePower);
 
 		// Get bill value, price unit given is [$/kWh]
 		price_parent = *gl_get_double_by_name(obj->parent, "price");
@@ -601,38 +404,38 @@ int metrics_collector::read_line(OBJECT *obj){
 			last_vol_val = vll;
 		}
 
-		interpolate (voltage_mag_array, last_index, curr_index, vll);  // Vll
-		interpolate (voltage_average_mag_array, last_index, curr_index, vavg);  // Vln
-		interpolate (voltage_unbalance_array, last_index, curr_index, vdev / vll); // max deviation from Vll / average Vll
+		interpolate (&voltage_mag, last_index, curr_index, vll);  // Vll
+		interpolate (&voltage_average_mag, last_index, curr_index, vavg);  // Vln
+		interpolate (&voltage_unbalance, last_index, curr_index, vdev / vll); // max deviation from Vll / average Vll
 	} 
 	else if (strcmp(parent_string, "house") == 0)
 	{
 		// Get load values
 		double totalload = *gl_get_double_by_name(obj->parent, "total_load");
-		interpolate (total_load_array, last_index, curr_index, totalload);
+		interpolate (&total_load, last_index, curr_index, totalload);
 		double hvacload = *gl_get_double_by_name(obj->parent, "hvac_load");
-		interpolate (hvac_load_array, last_index, curr_index, hvacload);
+		interpolate (&hvac_load, last_index, curr_index, hvacload);
 		// Get air temperature values
 		double airTemperature = *gl_get_double_by_name(obj->parent, "air_temperature");
-		interpolate (air_temperature_array, last_index, curr_index, airTemperature);
+		interpolate (&air_temperature, last_index, curr_index, airTemperature);
 		// Get air temperature deviation from house cooling setpoint
 		double cooling_setpoint = *gl_get_double_by_name(obj->parent, "cooling_setpoint");
-		interpolate (air_temperature_deviation_cooling_array, last_index, curr_index, airTemperature - cooling_setpoint);
-		// Get air temperature deviation from house cooling setpoint
+		interpolate (&air_temperature_deviation_cooling, last_index, curr_index, airTemperature - cooling_setpoint);
+		// Get air temperature deviation from house heating setpoint
 		double heating_setpoint = *gl_get_double_by_name(obj->parent, "heating_setpoint");
-		interpolate (air_temperature_deviation_cooling_array, last_index, curr_index, airTemperature - heating_setpoint);
+		interpolate (&air_temperature_deviation_heating, last_index, curr_index, airTemperature - heating_setpoint);
 
 	}
 	else if (strcmp(parent_string, "waterheater") == 0) {
 		// Get load values
 		double actualload = *gl_get_double_by_name(obj->parent, "actual_load");
-		interpolate (actual_load_array, last_index, curr_index, actualload);
+		interpolate (&actual_load, last_index, curr_index, actualload);
 	}
 	else if (strcmp(parent_string, "inverter") == 0) {
 		// Get VA_Out values
 		complex VAOut = *gl_get_complex_by_name(obj->parent, "VA_Out");
-		interpolate (real_power_array, last_index, curr_index, (double)VAOut.Re());
-		interpolate (reactive_power_array, last_index, curr_index, (double)VAOut.Im());
+		interpolate (&real_power, last_index, curr_index, (double)VAOut.Re());
+		interpolate (&reactive_power, last_index, curr_index, (double)VAOut.Im());
 	}
 	else if (strcmp(parent_string, "swingbus") == 0) {
 		// Get VAfeeder values
@@ -642,8 +445,8 @@ int metrics_collector::read_line(OBJECT *obj){
 		} else {
 			VAfeeder = *gl_get_complex_by_name(obj->parent, "measured_power");
 		}
-		interpolate (real_power_array, last_index, curr_index, (double)VAfeeder.Re());
-		interpolate (reactive_power_array, last_index, curr_index, (double)VAfeeder.Im());
+		interpolate (&real_power, last_index, curr_index, (double)VAfeeder.Re());
+		interpolate (&reactive_power, last_index, curr_index, (double)VAfeeder.Im());
 		// Get feeder loss values
 		// Losses calculation
 		int index = 0;
@@ -680,8 +483,8 @@ int metrics_collector::read_line(OBJECT *obj){
 			index++;
 		}
 		// Put the loss value into the array
-		interpolate (real_power_loss_array, last_index, curr_index, (double)lossesSum.Re());
-		interpolate (reactive_power_loss_array, last_index, curr_index, (double)lossesSum.Im());
+		interpolate (&real_power_loss, last_index, curr_index, (double)lossesSum.Re());
+		interpolate (&reactive_power_loss, last_index, curr_index, (double)lossesSum.Im());
 	}
 	// else not possible come to this step
 	else {
@@ -713,243 +516,284 @@ int metrics_collector::write_line(TIMESTAMP t1, OBJECT *obj){
 	char time_str[64];
 	DATETIME dt;
 
+	// The value at the last index of the interval is final now
+	finish_interval(false);
+
 	if ((strcmp(parent_string, "triplex_meter") == 0) || (strcmp(parent_string, "meter") == 0)) {
 		// Rearranging the arrays of data, and put into the dictionary
 		// Real power data
-		metrics_Output["min_real_power"] = findMin(real_power_array, interval_length);
-		metrics_Output["max_real_power"] = findMax(real_power_array, interval_length);
-		metrics_Output["avg_real_power"] = findAverage(real_power_array, interval_length);
-		metrics_Output["median_real_power"] = findMedian(real_power_array, interval_length);
+		metrics_Output["min_real_power"] = findMin(&real_power);
+		metrics_Output["max_real_power"] = findMax(&real_power);
+		metrics_Output["avg_real_power"] = findAverage(&real_power);
+		metrics_Output["median_real_power"] = findMedian(&real_power);
 
 		// Reactive power data
-		metrics_Output["min_reactive_power"] = findMin(reactive_power_array, interval_length);
-		metrics_Output["max_reactive_power"] = findMax(reactive_power_array, interval_length);
-		metrics_Output["avg_reactive_power"] = findAverage(reactive_power_array, interval_length);
-		metrics_Output["median_reactive_power"] = findMedian(reactive_power_array, interval_length);
+		metrics_Output["min_reactive_power"] = findMin(&reactive_power);
+		metrics_Output["max_reactive_power"] = findMax(&reactive_power);
+		metrics_Output["avg_reactive_power"] = findAverage(&reactive_power);
+		metrics_Output["median_reactive_power"] = findMedian(&reactive_power);
 
 		// Energy data
-		metrics_Output["real_energy"] = findAverage(real_power_array, interval_length) * interval_write / 3600;
-		metrics_Output["reactive_energy"] = findAverage(reactive_power_array, interval_length) * interval_write / 3600;
+		metrics_Output["real_energy"] = findAverage(&real_power) * interval_write / 3600;
+		metrics_Output["reactive_energy"] = findAverage(&reactive_power) * interval_write / 3600;
 
 		// Bill - TODO?
 		metrics_Output["bill"] = metrics_Output["real_energy"].asDouble() * price_parent / 1000; // price unit given is [$/kWh]
 
 		// Phase 1 to 2 voltage data
-		metrics_Output["min_voltage"] = findMin(voltage_mag_array, interval_length);
-		metrics_Output["max_voltage"] = findMax(voltage_mag_array, interval_length);
-		metrics_Output["avg_voltage"] = findAverage(voltage_mag_array, interval_length);
+		metrics_Output["min_voltage"] = findMin(&voltage_mag);
+		metrics_Output["max_voltage"] = findMax(&voltage_mag);
+		metrics_Output["avg_voltage"] = findAverage(&voltage_mag);
 
 		// Phase 1 to 2 average voltage data
-		metrics_Output["min_voltage_average"] = findMin(voltage_average_mag_array, interval_length);
-		metrics_Output["max_voltage_average"] = findMax(voltage_average_mag_array, interval_length);
-		metrics_Output["avg_voltage_average"] = findAverage(voltage_average_mag_array, interval_length);
+		metrics_Output["min_voltage_average"] = findMin(&voltage_average_mag);
+		metrics_Output["max_voltage_average"] = findMax(&voltage_average_mag);
+		metrics_Output["avg_voltage_average"] = findAverage(&voltage_average_mag);
 
 		// Voltage unbalance data
-		metrics_Output["min_voltage_unbalance"] = findMin(voltage_unbalance_array, interval_length);
-		metrics_Output["max_voltage_unbalance"] = findMax(voltage_unbalance_array, interval_length);
-		metrics_Output["avg_voltage_unbalance"] = findAverage(voltage_unbalance_array, interval_length);
+		metrics_Output["min_voltage_unbalance"] = findMin(&voltage_unbalance);
+		metrics_Output["max_voltage_unbalance"] = findMax(&voltage_unbalance);
+		metrics_Output["avg_voltage_unbalance"] = findAverage(&voltage_unbalance);
 
-		// Voltage above/below ANSI C84 A/B Range
-		double normVol = *gl_get_double_by_name(obj->parent, "nominal_voltage");
-		double aboveRangeA = normVol* 1.05 * (std::sqrt(3));
-		double belowRangeA = normVol* 0.95 * (std::sqrt(3));
-		double aboveRangeB = normVol* 1.058 * (std::sqrt(3));
-		double belowRangeB = normVol* 0.917 * (std::sqrt(3));
 		// Voltage above Range A
-		struct vol_violation vol_Vio = findOutLimit(last_vol_val, voltage_mag_array, true, aboveRangeA, interval_length);
+		struct vol_violation vol_Vio = findOutLimit(last_vol_val, &vol_limits[0], true);
 		metrics_Output["above_RangeA_Duration"] = vol_Vio.durationViolation;
 		metrics_Output["above_RangeA_Count"] = vol_Vio.countViolation;
 		// Voltage below Range A
-		vol_Vio = findOutLimit(last_vol_val, voltage_mag_array, false, belowRangeA, interval_length);
+		vol_Vio = findOutLimit(last_vol_val, &vol_limits[1], false);
 		metrics_Output["below_RangeA_Duration"] = vol_Vio.durationViolation;
 		metrics_Output["below_RangeA_Count"] = vol_Vio.countViolation;
 		// Voltage above Range B
-		vol_Vio = findOutLimit(last_vol_val, voltage_mag_array, true, aboveRangeB, interval_length);
+		vol_Vio = findOutLimit(last_vol_val, &vol_limits[2], true);
 		metrics_Output["above_RangeB_Duration"] = vol_Vio.durationViolation;
 		metrics_Output["above_RangeB_Count"] = vol_Vio.countViolation;
 		// Voltage below Range B
-		vol_Vio = findOutLimit(last_vol_val, voltage_mag_array, false, belowRangeB, interval_length);
+		vol_Vio = findOutLimit(last_vol_val, &vol_limits[3], false);
 		metrics_Output["below_RangeB_Duration"] = vol_Vio.durationViolation;
 		metrics_Output["below_RangeB_Count"] = vol_Vio.countViolation;
 
 		// Voltage below 10% of the norminal voltage rating
-		double belowNorVol10 = normVol * 0.1;
-		vol_Vio = findOutLimit(last_vol_val, voltage_mag_array, false, belowNorVol10, interval_length);
+		vol_Vio = findOutLimit(last_vol_val, &vol_limits[4], false);
 		metrics_Output["below_10_percent_NormVol_Duration"] = vol_Vio.durationViolation;
 		metrics_Output["below_10_percent_NormVol_Count"] = vol_Vio.countViolation;
 
 		// Update the lastVol value based on this metrics interval value
-		last_vol_val = voltage_mag_array[interval_length - 1];
+		last_vol_val = voltage_mag.last;
 
 	}
 	// If parent is house
 	else if (strcmp(parent_string, "house") == 0) {
 		// Rearranging the arrays of data, and put into the dictionary
 		// total_load data
-		metrics_Output["min_house_total_load"] = findMin(total_load_array, interval_length);
-		metrics_Output["max_house_total_load"] = findMax(total_load_array, interval_length);
-		metrics_Output["avg_house_total_load"] = findAverage(total_load_array, interval_length);
-		metrics_Output["median_house_total_load"] = findMedian(total_load_array, interval_length);
+		metrics_Output["min_house_total_load"] = findMin(&total_load);
+		metrics_Output["max_house_total_load"] = findMax(&total_load);
+		metrics_Output["avg_house_total_load"] = findAverage(&total_load);
+		metrics_Output["median_house_total_load"] = findMedian(&total_load);
 
 		// hvac_load data
-		metrics_Output["min_house_hvac_load"] = findMin(hvac_load_array, interval_length);
-		metrics_Output["max_house_hvac_load"] = findMax(hvac_load_array, interval_length);
-		metrics_Output["avg_house_hvac_load"] = findAverage(hvac_load_array, interval_length);
-		metrics_Output["median_house_hvac_load"] = findMedian(hvac_load_array, interval_length);
+		metrics_Output["min_house_hvac_load"] = findMin(&hvac_load);
+		metrics_Output["max_house_hvac_load"] = findMax(&hvac_load);
+		metrics_Output["avg_house_hvac_load"] = findAverage(&hvac_load);
+		metrics_Output["median_house_hvac_load"] = findMedian(&hvac_load);
 
 		// air_temperature data
-		metrics_Output["min_house_air_temperature"] = findMin(air_temperature_array, interval_length);
-		metrics_Output["max_house_air_temperature"] = findMax(air_temperature_array, interval_length);
-		metrics_Output["avg_house_air_temperature"] = findAverage(air_temperature_array, interval_length);
-		metrics_Output["median_house_air_temperature"] = findMedian(air_temperature_array, interval_length);
-		metrics_Output["avg_house_air_temperature_deviation_cooling"] = findAverage(air_temperature_deviation_cooling_array, interval_length);
-		metrics_Output["avg_house_air_temperature_deviation_heating"] = findAverage(air_temperature_deviation_heating_array, interval_length);
+		metrics_Output["min_house_air_temperature"] = findMin(&air_temperature);
+		metrics_Output["max_house_air_temperature"] = findMax(&air_temperature);
+		metrics_Output["avg_house_air_temperature"] = findAverage(&air_temperature);
+		metrics_Output["median_house_air_temperature"] = findMedian(&air_temperature);
+		metrics_Output["avg_house_air_temperature_deviation_cooling"] = findAverage(&air_temperature_deviation_cooling);
+		metrics_Output["avg_house_air_temperature_deviation_heating"] = findAverage(&air_temperature_deviation_heating);
 
 	}
 	// If parent is waterheater
 	else if (strcmp(parent_string, "waterheater") == 0) {
 		// Rearranging the arrays of data, and put into the dictionary
 		// actual_load data
-		metrics_Output["min_waterheater_actual_load"] = findMin(actual_load_array, interval_length);
-		metrics_Output["max_waterheater_actual_load"] = findMax(actual_load_array, interval_length);
-		metrics_Output["avg_waterheater_actual_load"] = findAverage(actual_load_array, interval_length);
-		metrics_Output["median_waterheater_actual_load"] = findMedian(actual_load_array, interval_length);
+		metrics_Output["min_waterheater_actual_load"] = findMin(&actual_load);
+		metrics_Output["max_waterheater_actual_load"] = findMax(&actual_load);
+		metrics_Output["avg_waterheater_actual_load"] = findAverage(&actual_load);
+		metrics_Output["median_waterheater_actual_load"] = findMedian(&actual_load);
 
 	}
 	else if (strcmp(parent_string, "inverter") == 0) {
 		// Rearranging the arrays of data, and put into the dictionary
 		// real power data
-		metrics_Output["min_inverter_real_power"] = findMin(real_power_array, interval_length);
-		metrics_Output["max_inverter_real_power"] = findMax(real_power_array, interval_length);
-		metrics_Output["avg_inverter_real_power"] = findAverage(real_power_array, interval_length);
-		metrics_Output["median_inverter_real_power"] = findMedian(real_power_array, interval_length);
+		metrics_Output["min_inverter_real_power"] = findMin(&real_power);
+		metrics_Output["max_inverter_real_power"] = findMax(&real_power);
+		metrics_Output["avg_inverter_real_power"] = findAverage(&real_power);
+		metrics_Output["median_inverter_real_power"] = findMedian(&real_power);
 		// Reactive power data
-		metrics_Output["min_inverter_reactive_power"] = findMin(reactive_power_array, interval_length);
-		metrics_Output["max_inverter_reactive_power"] = findMax(reactive_power_array, interval_length);
-		metrics_Output["avg_inverter_reactive_power"] = findAverage(reactive_power_array, interval_length);
-		metrics_Output["median_inverter_reactive_power"] = findMedian(reactive_power_array, interval_length);
+		metrics_Output["min_inverter_reactive_power"] = findMin(&reactive_power);
+		metrics_Output["max_inverter_reactive_power"] = findMax(&reactive_power);
+		metrics_Output["avg_inverter_reactive_power"] = findAverage(&reactive_power);
+		metrics_Output["median_inverter_reactive_power"] = findMedian(&reactive_power);
 
 	}
 	else if (strcmp(parent_string, "swingbus") == 0) {
 		// Rearranging the arrays of data, and put into the dictionary
 		// real power data
-		metrics_Output["min_feeder_real_power"] = findMin(real_power_array, interval_length);
-		metrics_Output["max_feeder_real_power"] = findMax(real_power_array, interval_length);
-		metrics_Output["avg_feeder_real_power"] = findAverage(real_power_array, interval_length);
-		metrics_Output["median_feeder_real_power"] = findMedian(real_power_array, interval_length);
+		metrics_Output["min_feeder_real_power"] = findMin(&real_power);
+		metrics_Output["max_feeder_real_power"] = findMax(&real_power);
+		metrics_Output["avg_feeder_real_power"] = findAverage(&real_power);
+		metrics_Output["median_feeder_real_power"] = findMedian(&real_power);
 		// Reactive power data
-		metrics_Output["min_feeder_reactive_power"] = findMin(reactive_power_array, interval_length);
-		metrics_Output["max_feeder_reactive_power"] = findMax(reactive_power_array, interval_length);
-		metrics_Output["avg_feeder_reactive_power"] = findAverage(reactive_power_array, interval_length);
-		metrics_Output["median_feeder_reactive_power"] = findMedian(reactive_power_array, interval_length);
+		metrics_Output["min_feeder_reactive_power"] = findMin(&reactive_power);
+		metrics_Output["max_feeder_reactive_power"] = findMax(&reactive_power);
+		metrics_Output["avg_feeder_reactive_power"] = findAverage(&reactive_power);
+		metrics_Output["median_feeder_reactive_power"] = findMedian(&reactive_power);
 		// Energy data
-		metrics_Output["real_energy"] = findAverage(real_power_array, interval_length) * interval_write / 3600;
-		metrics_Output["reactive_energy"] = findAverage(reactive_power_array, interval_length) * interval_write / 3600;
+		metrics_Output["real_energy"] = findAverage(&real_power) * interval_write / 3600;
+		metrics_Output["reactive_energy"] = findAverage(&reactive_power) * interval_write / 3600;
 		// real power loss data
-		metrics_Output["min_feeder_real_power_loss"] = findMin(real_power_loss_array, interval_length);
-		metrics_Output["max_feeder_real_power_loss"] = findMax(real_power_loss_array, interval_length);
-		metrics_Output["avg_feeder_real_power_loss"] = findAverage(real_power_loss_array, interval_length);
-		metrics_Output["median_feeder_real_power_loss"] = findMedian(real_power_loss_array, interval_length);
+		metrics_Output["min_feeder_real_power_loss"] = findMin(&real_power_loss);
+		metrics_Output["max_feeder_real_power_loss"] = findMax(&real_power_loss);
+		metrics_Output["avg_feeder_real_power_loss"] = findAverage(&real_power_loss);
+		metrics_Output["median_feeder_real_power_loss"] = findMedian(&real_power_loss);
 		// Reactive power loss data
-		metrics_Output["min_feeder_reactive_power_loss"] = findMin(reactive_power_loss_array, interval_length);
-		metrics_Output["max_feeder_reactive_power_loss"] = findMax(reactive_power_loss_array, interval_length);
-		metrics_Output["avg_feeder_reactive_power_loss"] = findAverage(reactive_power_loss_array, interval_length);
-		metrics_Output["median_feeder_reactive_power_loss"] = findMedian(reactive_power_loss_array, interval_length);
+		metrics_Output["min_feeder_reactive_power_loss"] = findMin(&reactive_power_loss);
+		metrics_Output["max_feeder_reactive_power_loss"] = findMax(&reactive_power_loss);
+		metrics_Output["avg_feeder_reactive_power_loss"] = findAverage(&reactive_power_loss);
+		metrics_Output["median_feeder_reactive_power_loss"] = findMedian(&reactive_power_loss);
 	}
 
+	// Start the statistics of the next interval
+	finish_interval(true);
+
+	return 1;
+}
+
+int metrics_collector::create_metric(METRIC *metric, bool median)
+{
+	// The statistics accumulate over the interval, only the exact median needs the samples
+	metric->stats = gl_statwindow_create(0, (median && median_estimate) ? SWO_QUANTILE : SWO_NONE, 0.5);
+	metric->last = 0.0;
+	metric->samples = NULL;
+	metric->sample_count = 0;
+	if (metric->stats == NULL || metric_count >= (int)(sizeof(metric_list)/sizeof(metric_list[0])))
+		return 0;
+	if (median && !median_estimate) {
+		// at most one sample per second of the interval, plus the final value of the interval
+		metric->samples = (double *)gl_malloc((interval_length+1)*sizeof(double));
+		if (metric->samples == NULL)
+			return 0;
+	}
+	metric_list[metric_count++] = metric;
 	return 1;
 }
 
-void metrics_collector::interpolate(double array[], int idx1, int idx2, double val2)
+void metrics_collector::interpolate(METRIC *metric, int idx1, int idx2, double val2)
 {
-	array[idx2] = val2;
 	int steps = idx2 - idx1;
-	if (steps > 1) {
-		double val1 = array[idx1];
+	if (steps > 0) {
+		// The value at idx1 is final, add it and the values between idx1 and idx2
+		double val1 = metric->last;
 		double dVal = (val2 - val1) / steps;
+		add_sample(metric, val1);
 		for (int i = idx1 + 1; i < idx2; i++)
 		{
 			val1 += dVal;
-			array[i] = val1;
+			add_sample(metric, val1);
 		}
 	}
+	// The value at idx2 may still be replaced by a later read at the same index
+	metric->last = val2;
 }
 
-double metrics_collector::findMax(double array[], int length) {
-	double max = array[0];
-
-	for (int i = 1; i < length; i++) {
-		if (array[i] > max) {
-			max = array[i];
-		}
+void metrics_collector::add_sample(METRIC *metric, double value)
+{
+	if (metric == &voltage_mag) {
+		checkLimits(value, (int)gl_statwindow_get(metric->stats, SWV_COUNT));
+	}
+	gl_statwindow_add(metric->stats, value);
+	if (metric->samples != NULL && metric->sample_count <= interval_length) {
+		metric->samples[metric->sample_count++] = value;
 	}
-
-	return max;
 }
 
-double metrics_collector::findMin(double array[], int length) {
-	double min = array[0];
-
-	for (int i = 1; i < length; i++) {
-		if (array[i] < min) {
-			min = array[i];
+void metrics_collector::finish_interval(bool reset)
+{
+	for (int i = 0; i < metric_count; i++) {
+		if (reset) {
+			// The last value stays as the value at the first index of the next interval
+			gl_statwindow_reset(metric_list[i]->stats);
+			metric_list[i]->sample_count = 0;
+		} else {
+			add_sample(metric_list[i], metric_list[i]->last);
 		}
 	}
-
-	return min;
 }
 
-double metrics_collector::findAverage(double array[], int length) {
-	double avg = 0;
-
-	for (int i = 0; i < length; i++) {
-		avg += array[i];
-	}
-
-	avg = double(avg) / length;
-
-	return avg;
+double metrics_collector::findMax(METRIC *metric) {
+	return gl_statwindow_get(metric->stats, SWV_MAX);
 }
 
-double metrics_collector::findMedian(double array[], int length) {
-	double median;
-
-	std::sort(&array[0], &array[length]);
-
-	median = length % 2 ? array[length / 2] : (array[length / 2 - 1] + array[length / 2]) / 2;
-
-	return median;
+double metrics_collector::findMin(METRIC *metric) {
+	return gl_statwindow_get(metric->stats, SWV_MIN);
 }
 
-vol_violation metrics_collector::findOutLimit(double lastVol, double array[], bool checkAbove, double limitVal, int length) {
-	struct vol_violation result;
-	int count = 0;
-	double durationTime = 0.0;
-	int pastVal;
+double metrics_collector::findAverage(METRIC *metric) {
+	return gl_statwindow_get(metric->stats, SWV_MEAN);
+}
 
-	// Check the first index value
-	if (array[0] > limitVal) {
-		pastVal = 1;
+double metrics_collector::findMedian(METRIC *metric) {
+	if (metric->samples == NULL) {
+		// Estimated from the running quantile markers, exact up to 5 samples
+		return gl_statwindow_get(metric->stats, SWV_QUANTILE);
 	}
-	else if (array[0] == limitVal) {
-		pastVal = 0;
-		count++;
+
+	double *array = metric->samples;
+	int length = metric->sample_count;
+	if (length == 0) {
+		return 0.0;
 	}
-	else {
-		pastVal = -1;
+	// The samples are dropped when the interval is reset, so they can be reordered
+	std::nth_element(&array[0], &array[length / 2], &array[length]);
+	double median = array[length / 2];
+	if (length % 2 == 0) {
+		median = (*std::max_element(&array[0], &array[length / 2]) + median) / 2;
 	}
 
-	// Check length
-	if (length <= 1) {
-		result.countViolation = 0;
-		result.durationViolation = 0.0;
-		return result;
-	}
+	return median;
+}
+
+void metrics_collector::checkLimits(double value, int index) {
 
-	// Loop through the array serachinig for voltage violation time steps
-	for (int i = 1; i < length; i++) {
+	if (index == 0) {
+		// Voltage above/below ANSI C84 A/B Range
+		double normVol = *gl_get_double_by_name(OBJECTHDR(this)->parent, "nominal_voltage");
+		vol_limits[0].limitVal = normVol* 1.05 * (std::sqrt(3));
+		vol_limits[1].limitVal = normVol* 0.95 * (std::sqrt(3));
+		vol_limits[2].limitVal = normVol* 1.058 * (std::sqrt(3));
+		vol_limits[3].limitVal = normVol* 0.917 * (std::sqrt(3));
+		// Voltage below 10% of the norminal voltage rating
+		vol_limits[4].limitVal = normVol * 0.1;
+		first_vol_val = value;
+	}
+
+	for (int i = 0; i < (int)(sizeof(vol_limits)/sizeof(vol_limits[0])); i++) {
+		VOL_LIMIT *limit = &vol_limits[i];
+		double limitVal = limit->limitVal;
+		int &count = limit->violation.countViolation;
+		double &durationTime = limit->violation.durationViolation;
+		int &pastVal = limit->pastVal;
+
+		// Check the first index value
+		if (index == 0) {
+			count = 0;
+			durationTime = 0.0;
+			if (value > limitVal) {
+				pastVal = 1;
+			}
+			else if (value == limitVal) {
+				pastVal = 0;
+				count++;
+			}
+			else {
+				pastVal = -1;
+			}
+		}
 		// If the value is out of the limit
-		if (array[i] > limitVal) {
+		else if (value > limitVal) {
 			// If at last time step, the value was out of the limit also -> record duration
 			if (pastVal == 1) {
 				durationTime++;  // count the duration
@@ -966,7 +810,7 @@ vol_violation metrics_collector::findOutLimit(double lastVol, double array[], bo
 				pastVal = 1;
 			}
 		}
-		else if (array[i] == limitVal) {
+		else if (value == limitVal) {
 			// If at last time step, the value was out of the limit -> record the duration time
 			if (pastVal == 1) {
 				durationTime++;  // count the duration
@@ -1000,17 +844,32 @@ vol_violation metrics_collector::findOutLimit(double lastVol, double array[], bo
 			}
 		}
 	}
+}
+
+vol_violation metrics_collector::findOutLimit(double lastVol, VOL_LIMIT *limit, bool checkAbove) {
+	struct vol_violation result;
+	int length = (int)gl_statwindow_get(voltage_mag.stats, SWV_COUNT);
+	int count = limit->violation.countViolation;
+	double durationTime = limit->violation.durationViolation;
+	double limitVal = limit->limitVal;
+
+	// Check length
+	if (length <= 1) {
+		result.countViolation = 0;
+		result.durationViolation = 0.0;
+		return result;
+	}
 
 	// Check the voltage value at the end of last metrics collector interval
 	if (lastVol >= 0) {
-		if ((lastVol < limitVal && array[0] > limitVal) || (lastVol > limitVal && array[0] < limitVal)){
+		if ((lastVol < limitVal && first_vol_val > limitVal) || (lastVol > limitVal && first_vol_val < limitVal)){
 			count++;
 			durationTime += 0.5;
 		}
-		else if (lastVol > limitVal && array[0] > limitVal) {
+		else if (lastVol > limitVal && first_vol_val > limitVal) {
 			durationTime++;  // add the duration without count
 		}
-		else if (array[0] == limitVal && lastVol != limitVal) {
+		else if (first_vol_val == limitVal && lastVol != limitVal) {
 			durationTime++;  // count the duration
 			count++;
 		}
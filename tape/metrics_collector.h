@@ -23,6 +23,21 @@ typedef struct vol_violation {
 	int countViolation;	 //angle measurement
 } VIOLATION_RETURN;
 
+// running statistics of one measurement over the current metrics interval
+typedef struct s_metric {
+	STATWINDOW *stats;	// statistics of the samples of the interval so far
+	double last;		// value at the last index read, added once the next index is read
+	double *samples;	// samples of the interval so far, kept only for the exact median
+	int sample_count;	// number of samples kept
+} METRIC;
+
+// running state of one voltage limit check over the current metrics interval
+typedef struct s_vol_limit {
+	double limitVal;	// voltage limit
+	int pastVal;		// 1 above, 0 at, -1 below the limit at the last sample
+	VIOLATION_RETURN violation;	// limit crossings and time above the limit so far
+} VOL_LIMIT;
+
 class metrics_collector{
 public:
 	static metrics_collector *defaults;
@@ -38,6 +53,7 @@ public:
 
 public:
 	double interval_length_dbl;			//Metrics output interval length
+	bool median_estimate;				//Estimate the medians with running quantile markers instead of keeping the samples
 
 	friend class metrics_collector_writer;
 
@@ -46,12 +62,16 @@ private:
 	int read_line(OBJECT *obj);
 	int write_line(TIMESTAMP, OBJECT *obj);
 
-	void interpolate(double array[], int idx1, int idx2, double val2);
-	double findMax(double array[], int size);
-	double findMin(double array[], int size);
-	double findAverage(double array[], int size);
-	double findMedian(double array[], int size);
-	vol_violation findOutLimit(double lastVol, double array[], bool checkAbove, double limitVal, int size);
+	int create_metric(METRIC *metric, bool median);
+	void interpolate(METRIC *metric, int idx1, int idx2, double val2);
+	void add_sample(METRIC *metric, double value);
+	void finish_interval(bool reset);
+	double findMax(METRIC *metric);
+	double findMin(METRIC *metric);
+	double findAverage(METRIC *metric);
+	double findMedian(METRIC *metric);
+	void checkLimits(double value, int index);
+	vol_violation findOutLimit(double lastVol, VOL_LIMIT *limit, bool checkAbove);
 
 private:
 	FILE *rec_file;
@@ -71,37 +91,42 @@ private:
 	Json::Value metrics_Output;
 
 	// Parameters related to triplex_meter object
-	double *real_power_array;		//array storing real power measured at the triplex_meter
-	double *reactive_power_array;		//array storing reactive power measured at the triplex_meter
-	double *voltage_mag_array;		//array storing voltage12 measured at the triplex_meter
-	double *voltage_average_mag_array;		//array storing voltage12/2 measured at the triplex_meter
-	double *voltage_unbalance_array;		//array storing (voltage[0]-voltage[1])/(voltage12/2) measured at the triplex_meter
+	METRIC real_power;		//real power measured at the triplex_meter
+	METRIC reactive_power;		//reactive power measured at the triplex_meter
+	METRIC voltage_mag;		//voltage12 measured at the triplex_meter
+	METRIC voltage_average_mag;		//voltage12/2 measured at the triplex_meter
+	METRIC voltage_unbalance;		//(voltage[0]-voltage[1])/(voltage12/2) measured at the triplex_meter
 	double price_parent; 			// Price of thr triplex_meter
 	double last_vol_val;			// variable that store the voltage value from last time step, to assist in voltage violation counts analysis
+	double first_vol_val;			// voltage value at the start of the current interval
+	VOL_LIMIT vol_limits[5];		// above/below ANSI C84 range A, above/below range B, and below 10% of nominal
 
 	// Parameters related to houe object
-	double *total_load_array; 		//array storing total_load measured at the house
-	double *hvac_load_array; 		//array storing hvac_load measured at the house
-	double *air_temperature_array; 		//array storing air_temperature measured at the house
-	double *air_temperature_deviation_cooling_array;	// array storing air_temperature deviation from the cooling setpoint
-	double *air_temperature_deviation_heating_array;	// array storing air_temperature deviation from the heating setpoint
+	METRIC total_load; 		//total_load measured at the house
+	METRIC hvac_load; 		//hvac_load measured at the house
+	METRIC air_temperature; 		//air_temperature measured at the house
+	METRIC air_temperature_deviation_cooling;	// air_temperature deviation from the cooling setpoint
+	METRIC air_temperature_deviation_heating;	// air_temperature deviation from the heating setpoint
 
 	// Parameters related to waterheater object
-	double *actual_load_array; 		//array storing actual_load measured at the house
+	METRIC actual_load; 		//actual_load measured at the house
 	char waterheaterName[64];				// char array storing names of the waterheater
 
 	// Parameters related to inverter object
-	// No new arrays defined for inverter object,
-	// since real_power_array and reactive_power_array have been defined for triplex_meter already
+	// No new metrics defined for inverter object,
+	// since real_power and reactive_power have been defined for triplex_meter already
 
 	// Parameters related to Swing-bus meter object
 	FINDLIST *link_objects;
-	double *real_power_loss_array;		//array storing real power losses for the whole feeder
-	double *reactive_power_loss_array;		//array storing real power losses for the whole feeder
+	METRIC real_power_loss;		//real power losses for the whole feeder
+	METRIC reactive_power_loss;		//reactive power losses for the whole feeder
+
+	METRIC *metric_list[13];	// metrics used by the parent type
+	int metric_count;		// number of metrics used
 
-	int interval_length;	  // integer averaging length (seconds); also size of arrays
+	int interval_length;	  // integer averaging length (seconds)
 
-	int curr_index;	// Index [0..interval_length-1] for current position of averaging array
+	int curr_index;	// Index [0..interval_length-1] for current position in the interval
 	int last_index; // value of curr_index at the last read_line call; may need to interpolate
 };
 
@@ -9,6 +9,130 @@
 
 CLASS *metrics_collector_writer::oclass = NULL;
 
+// Metrics of each output file; the indices MUST match the assignments in write_line
+static METRICS_COLUMN billing_meter_columns[] = {
+	{"real_power_min", "W", "min_real_power", NULL},
+	{"real_power_max", "W", "max_real_power", NULL},
+	{"real_power_avg", "W", "avg_real_power", NULL},
+	{"real_power_median", "W", "median_real_power", NULL},
+	{"reactive_power_min", "VAR", "min_reactive_power", NULL},
+	{"reactive_power_max", "VAR", "max_reactive_power", NULL},
+	{"reactive_power_avg", "VAR", "avg_reactive_power", NULL},
+	{"reactive_power_median", "VAR", "median_reactive_power", NULL},
+	{"real_energy", "Wh", "real_energy", NULL},
+	{"reactive_energy", "VARh", "reactive_energy", NULL},
+	{"bill", "USD", "bill", NULL},
+	{"voltage_min", "V", "min_voltage_average", NULL},
+	{"voltage_max", "V", "max_voltage_average", NULL},
+	{"voltage_avg", "V", "avg_voltage_average", NULL},
+	{"voltage12_min", "V", "min_voltage", NULL},
+	{"voltage12_max", "V", "max_voltage", NULL},
+	{"voltage12_avg", "V", "avg_voltage", NULL},
+	{"voltage_unbalance_min", "V", "min_voltage_unbalance", NULL},
+	{"voltage_unbalance_max", "V", "max_voltage_unbalance", NULL},
+	{"voltage_unbalance_avg", "V", "avg_voltage_unbalance", NULL},
+	{"above_RangeA_Duration", "s", "above_RangeA_Duration", NULL},
+	{"above_RangeA_Count", "", "above_RangeA_Count", NULL},
+	{"below_RangeA_Duration", "s", "below_RangeA_Duration", NULL},
+	{"below_RangeA_Count", "", "below_RangeA_Count", NULL},
+	{"above_RangeB_Duration", "s", "above_RangeB_Duration", NULL},
+	{"above_RangeB_Count", "", "above_RangeB_Count", NULL},
+	{"below_RangeB_Duration", "s", "below_RangeB_Duration", NULL},
+	{"below_RangeB_Count", "", "below_RangeB_Count", NULL},
+	{"below_10_percent_NormVol_Duration", "s", "below_10_percent_NormVol_Duration", NULL},
+	{"below_10_percent_NormVol_Count", "", "below_10_percent_NormVol_Count", NULL},
+};
+static METRICS_COLUMN house_columns[] = {
+	{"total_load_min", "kW", "min_house_total_load", "house"},
+	{"total_load_max", "kW", "max_house_total_load", "house"},
+	{"total_load_avg", "kW", "avg_house_total_load", "house"},
+	{"total_load_median", "kW", "median_house_total_load", "house"},
+	{"hvac_load_min", "kW", "min_house_hvac_load", "house"},
+	{"hvac_load_max", "kW", "max_house_hvac_load", "house"},
+	{"hvac_load_avg", "kW", "avg_house_hvac_load", "house"},
+	{"hvac_load_median", "kW", "median_house_hvac_load", "house"},
+	{"air_temperature_min", "degF", "min_house_air_temperature", "house"},
+	{"air_temperature_max", "degF", "max_house_air_temperature", "house"},
+	{"air_temperature_avg", "degF", "avg_house_air_temperature", "house"},
+	{"air_temperature_median", "degF", "median_house_air_temperature", "house"},
+	{"air_temperature_deviation_cooling", "degF", "avg_house_air_temperature_deviation_cooling", "house"},
+	{"air_temperature_deviation_heating", "degF", "avg_house_air_temperature_deviation_heating", "house"},
+	{"waterheater_load_min", "kW", "min_waterheater_actual_load", "waterheater"},
+	{"waterheater_load_max", "kW", "max_waterheater_actual_load", "waterheater"},
+	{"waterheater_load_avg", "kW", "avg_waterheater_actual_load", "waterheater"},
+	{"waterheater_load_median", "kW", "median_waterheater_actual_load", "waterheater"},
+};
+static METRICS_COLUMN inverter_columns[] = {
+	{"real_power_min", "W", "min_inverter_real_power", NULL},
+	{"real_power_max", "W", "max_inverter_real_power", NULL},
+	{"real_power_avg", "W", "avg_inverter_real_power", NULL},
+	{"real_power_median", "W", "median_inverter_real_power", NULL},
+	{"reactive_power_min", "VAR", "min_inverter_reactive_power", NULL},
+	{"reactive_power_max", "VAR", "max_inverter_reactive_power", NULL},
+	{"reactive_power_avg", "VAR", "avg_inverter_reactive_power", NULL},
+	{"reactive_power_median", "VAR", "median_inverter_reactive_power", NULL},
+};
+static METRICS_COLUMN substation_columns[] = {
+	{"real_power_min", "W", "min_feeder_real_power", NULL},
+	{"real_power_max", "W", "max_feeder_real_power", NULL},
+	{"real_power_avg", "W", "avg_feeder_real_power", NULL},
+	{"real_power_median", "W", "median_feeder_real_power", NULL},
+	{"reactive_power_min", "VAR", "min_feeder_reactive_power", NULL},
+	{"reactive_power_max", "VAR", "max_feeder_reactive_power", NULL},
+	{"reactive_power_avg", "VAR", "avg_feeder_reactive_power", NULL},
+	{"reactive_power_median", "VAR", "median_feeder_reactive_power", NULL},
+	{"real_energy", "Wh", "real_energy", NULL},
+	{"reactive_energy", "VARh", "reactive_energy", NULL},
+	{"real_power_losses_min", "W", "min_feeder_real_power_loss", NULL},
+	{"real_power_losses_max", "W", "max_feeder_real_power_loss", NULL},
+	{"real_power_losses_avg", "W", "avg_feeder_real_power_loss", NULL},
+	{"real_power_losses_median", "W", "median_feeder_real_power_loss", NULL},
+	{"reactive_power_losses_min", "VAR", "min_feeder_reactive_power_loss", NULL},
+	{"reactive_power_losses_max", "VAR", "max_feeder_reactive_power_loss", NULL},
+	{"reactive_power_losses_avg", "VAR", "avg_feeder_reactive_power_loss", NULL},
+	{"reactive_power_losses_median", "VAR", "median_feeder_reactive_power_loss", NULL},
+};
+
+#define COLUMN_COUNT(X) ((int)(sizeof(X)/sizeof(X[0])))
+
+static struct s_metrics_group {
+	METRICS_COLUMN *columns;
+	int n_columns;
+} metrics_groups[] = {
+	{billing_meter_columns, COLUMN_COUNT(billing_meter_columns)},
+	{house_columns, COLUMN_COUNT(house_columns)},
+	{inverter_columns, COLUMN_COUNT(inverter_columns)},
+	{substation_columns, COLUMN_COUNT(substation_columns)},
+};
+
+// Output file of the metrics of a metrics_collector with the given parent type, -1 if none
+static int metrics_group(const char *parent_string)
+{
+	if ((strcmp(parent_string, "triplex_meter") == 0) || (strcmp(parent_string, "meter") == 0))
+		return 0;
+	else if ((strcmp(parent_string, "house") == 0) || (strcmp(parent_string, "waterheater") == 0))
+		return 1;
+	else if (strcmp(parent_string, "inverter") == 0)
+		return 2;
+	else if (strcmp(parent_string, "swingbus") == 0)
+		return 3;
+	else
+		return -1;
+}
+
+// JSON metadata of the metrics of an output file
+static Json::Value metrics_metadata(const METRICS_COLUMN *columns, int n_columns)
+{
+	Json::Value jsn;
+	Json::Value meta;
+	for (int idx = 0; idx < n_columns; idx++) {
+		jsn["index"] = idx;
+		jsn["units"] = columns[idx].units;
+		meta[columns[idx].name] = jsn;
+	}
+	return meta;
+}
+
 void new_metrics_collector_writer(MODULE *mod){
 	new metrics_collector_writer(mod);
 }
@@ -21,8 +145,12 @@ metrics_collector_writer::metrics_collector_writer(MODULE *mod){
 			throw "unable to register class metrics_collector_writer";
 
 		if(gl_publish_variable(oclass,
-			PT_char256,"filename",PADDR(filename),PT_DESCRIPTION,"the JSON formatted output file name",
-			PT_double, "interval[s]", PADDR(interval_length_dbl), PT_DESCRIPTION, "Interval at which the metrics_collector_writer output is stored in JSON format",
+			PT_char256,"filename",PADDR(filename),PT_DESCRIPTION,"the output file name",
+			PT_double, "interval[s]", PADDR(interval_length_dbl), PT_DESCRIPTION, "Interval at which the metrics_collector_writer output is stored",
+			PT_enumeration, "format", PADDR(format), PT_DESCRIPTION, "the output file format",
+				PT_KEYWORD, "JSON", (enumeration)FMT_JSON,
+				PT_KEYWORD, "COLUMNAR", (enumeration)FMT_COLUMNAR,
+			PT_int32, "chunk_length", PADDR(chunk_length), PT_DESCRIPTION, "number of intervals written in each chunk of the COLUMNAR output",
 			NULL) < 1) GL_THROW("unable to publish properties in %s",__FILE__);
     }
 }
@@ -34,6 +162,9 @@ int metrics_collector_writer::isa(char *classname){
 int metrics_collector_writer::create(){
 
 	firstWrite = true;
+	format = FMT_JSON;
+	chunk_length = 12;
+	memset(columnar, 0, sizeof(columnar));
 
 	return 1;
 }
@@ -76,6 +207,14 @@ int metrics_collector_writer::init(OBJECT *parent){
 		*/
 		return 0;
 	}
+	if(format == FMT_COLUMNAR && chunk_length <= 0){
+		gl_error("metrics_collector_writer::init(): invalid chunk_length of %i, must be greater than 0", chunk_length);
+		/* TROUBLESHOOT
+			The COLUMNAR output stores the metrics in chunks of intervals, so the chunk_length
+			must be a positive number of intervals.
+		*/
+		return 0;
+	}
 
 	// Find the metrics_collector objects
 	metrics_collectors = gl_find_objects(FL_NEW,FT_CLASS,SAME,"metrics_collector",FT_END); //find all metrics_collector objects
@@ -136,101 +275,15 @@ int metrics_collector_writer::init(OBJECT *parent){
 	metrics_writer_inverters["StartTime"] = time_str;
 	metrics_writer_feeder_information["StartTime"] = time_str;
 
-	// Write metadata for each file; these indices MUST match assignments below
-	Json::Value jsn;
-	Json::Value meta;
-	int idx = 0;
-	jsn["index"] = idx++; jsn["units"] = "W"; meta["real_power_min"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "W"; meta["real_power_max"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "W"; meta["real_power_avg"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "W"; meta["real_power_median"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "VAR"; meta["reactive_power_min"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "VAR"; meta["reactive_power_max"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "VAR"; meta["reactive_power_avg"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "VAR"; meta["reactive_power_median"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "Wh"; meta["real_energy"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "VARh"; meta["reactive_energy"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "USD"; meta["bill"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "V"; meta["voltage_min"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "V"; meta["voltage_max"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "V"; meta["voltage_avg"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "V"; meta["voltage12_min"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "V"; meta["voltage12_max"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "V"; meta["voltage12_avg"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "V"; meta["voltage_unbalance_min"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "V"; meta["voltage_unbalance_max"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "V"; meta["voltage_unbalance_avg"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "s"; meta["above_RangeA_Duration"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "";  meta["above_RangeA_Count"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "s"; meta["below_RangeA_Duration"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "";  meta["below_RangeA_Count"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "s"; meta["above_RangeB_Duration"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "";  meta["above_RangeB_Count"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "s"; meta["below_RangeB_Duration"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "";  meta["below_RangeB_Count"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "s"; meta["below_10_percent_NormVol_Duration"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "";  meta["below_10_percent_NormVol_Count"] = jsn;
-	metrics_writer_billing_meters["Metadata"] = meta;
-	ary_billing_meters.resize(idx);
-
-	meta.clear();
-	idx = 0;
-	jsn["index"] = idx++; jsn["units"] = "kW"; meta["total_load_min"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "kW"; meta["total_load_max"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "kW"; meta["total_load_avg"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "kW"; meta["total_load_median"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "kW"; meta["hvac_load_min"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "kW"; meta["hvac_load_max"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "kW"; meta["hvac_load_avg"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "kW"; meta["hvac_load_median"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "degF"; meta["air_temperature_min"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "degF"; meta["air_temperature_max"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "degF"; meta["air_temperature_avg"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "degF"; meta["air_temperature_median"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "degF"; meta["air_temperature_deviation_cooling"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "degF"; meta["air_temperature_deviation_heating"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "kW"; meta["waterheater_load_min"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "kW"; meta["waterheater_load_max"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "kW"; meta["waterheater_load_avg"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "kW"; meta["waterheater_load_median"] = jsn;
-	metrics_writer_houses["Metadata"] = meta;
-	ary_houses.resize(idx);
-
-	meta.clear();
-	idx = 0;
-	jsn["index"] = idx++; jsn["units"] = "W"; meta["real_power_min"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "W"; meta["real_power_max"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "W"; meta["real_power_avg"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "W"; meta["real_power_median"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "VAR"; meta["reactive_power_min"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "VAR"; meta["reactive_power_max"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "VAR"; meta["reactive_power_avg"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "VAR"; meta["reactive_power_median"] = jsn;
-	metrics_writer_inverters["Metadata"] = meta;
-	ary_inverters.resize(idx);
-
-	meta.clear();
-	idx = 0;
-	jsn["index"] = idx++; jsn["units"] = "W"; meta["real_power_min"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "W"; meta["real_power_max"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "W"; meta["real_power_avg"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "W"; meta["real_power_median"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "VAR"; meta["reactive_power_min"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "VAR"; meta["reactive_power_max"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "VAR"; meta["reactive_power_avg"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "VAR"; meta["reactive_power_median"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "Wh"; meta["real_energy"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "VARh"; meta["reactive_energy"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "W"; meta["real_power_losses_min"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "W"; meta["real_power_losses_max"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "W"; meta["real_power_losses_avg"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "W"; meta["real_power_losses_median"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "VAR"; meta["reactive_power_losses_min"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "VAR"; meta["reactive_power_losses_max"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "VAR"; meta["reactive_power_losses_avg"] = jsn;
-	jsn["index"] = idx++; jsn["units"] = "VAR"; meta["reactive_power_losses_median"] = jsn;
-	metrics_writer_feeder_information["Metadata"] = meta;
-	ary_feeders.resize(idx);
+	// Write metadata for each file
+	metrics_writer_billing_meters["Metadata"] = metrics_metadata(billing_meter_columns, COLUMN_COUNT(billing_meter_columns));
+	ary_billing_meters.resize(COLUMN_COUNT(billing_meter_columns));
+	metrics_writer_houses["Metadata"] = metrics_metadata(house_columns, COLUMN_COUNT(house_columns));
+	ary_houses.resize(COLUMN_COUNT(house_columns));
+	metrics_writer_inverters["Metadata"] = metrics_metadata(inverter_columns, COLUMN_COUNT(inverter_columns));
+	ary_inverters.resize(COLUMN_COUNT(inverter_columns));
+	metrics_writer_feeder_information["Metadata"] = metrics_metadata(substation_columns, COLUMN_COUNT(substation_columns));
+	ary_feeders.resize(COLUMN_COUNT(substation_columns));
 
 	return 1;
 }
@@ -271,6 +324,10 @@ int metrics_collector_writer::write_line(TIMESTAMP t1){
 	DATETIME dt;
 	time_t now = time(NULL);
 	int index = 0;
+
+	if (format == FMT_COLUMNAR)
+		return write_columns(t1);
+
 	// Temperary JSON Value
 
 	Json::Value metrics_Output_temp;
@@ -466,34 +523,169 @@ int metrics_collector_writer::write_line(TIMESTAMP t1){
 	metrics_writer_feeder_information[time_str] = feeder_information;
 
 	if (final_write <= t1) {
-		// Start write to file
-		Json::StyledWriter writer;
-
-		// Open file for writing
-		ofstream out_file;
-
-		// Write seperate JSON files for each object
-		// triplex_meter and primary billing meter
-		out_file.open (filename_billing_meter);
-		out_file << writer.write(metrics_writer_billing_meters) <<  endl;
-		out_file.close();
-		// house
-		out_file.open (filename_house);
-		out_file << writer.write(metrics_writer_houses) <<  endl;
-		out_file.close();
-		// inverter
-		out_file.open (filename_inverter);
-		out_file << writer.write(metrics_writer_inverters) <<  endl;
-		out_file.close();
-		// feeder information
-		out_file.open (filename_substation);
-		out_file << writer.write(metrics_writer_feeder_information) <<  endl;
-		out_file.close();
+		write_json();
+	}
+
+	return 1;
+}
+
+/**
+	Write the JSON dictionaries of all the intervals so far to the output files
+ **/
+void metrics_collector_writer::write_json(){
+	// Start write to file
+	Json::StyledWriter writer;
+
+	// Open file for writing
+	ofstream out_file;
+
+	// Write seperate JSON files for each object
+	// triplex_meter and primary billing meter
+	out_file.open (filename_billing_meter);
+	out_file << writer.write(metrics_writer_billing_meters) <<  endl;
+	out_file.close();
+	// house
+	out_file.open (filename_house);
+	out_file << writer.write(metrics_writer_houses) <<  endl;
+	out_file.close();
+	// inverter
+	out_file.open (filename_inverter);
+	out_file << writer.write(metrics_writer_inverters) <<  endl;
+	out_file.close();
+	// feeder information
+	out_file.open (filename_substation);
+	out_file << writer.write(metrics_writer_feeder_information) <<  endl;
+	out_file.close();
+}
+
+/**
+	Map each metrics_collector to a row of its columnar output file and open the files
+	@return 1 on success, 0 on error
+ **/
+int metrics_collector_writer::open_columns(){
+	vector<string> rows[4];
+	map<string,int> row_index[4];
+	char256 *filenames[4] = {&filename_billing_meter, &filename_house, &filename_inverter, &filename_substation};
+
+	int index = 0;
+	OBJECT *obj = NULL;
+	while(obj = gl_find_next(metrics_collectors,obj)){
+		if(index++ >= metrics_collectors->hit_count){
+			break;
+		}
+		metrics_collector *temp_metrics_collector = OBJECTDATA(obj,metrics_collector);
+		int group = metrics_group(temp_metrics_collector->parent_string);
+		if (group < 0)
+			continue;
+
+		// Waterheaters write into the row of their house, so the rows are keyed by parent name like the JSON objects
+		COLUMNAR_SOURCE source;
+		string key = temp_metrics_collector->metrics_Output["Parent_name"].asString();
+		map<string,int>::iterator it = row_index[group].find(key);
+		if (it == row_index[group].end()) {
+			source.row = row_index[group][key] = (int)rows[group].size();
+			rows[group].push_back(key);
+		}
+		else
+			source.row = it->second;
+		source.collector = temp_metrics_collector;
+		source.group = group;
+		for (int col = 0; col < metrics_groups[group].n_columns; col++) {
+			const char *from = metrics_groups[group].columns[col].source;
+			if (from == NULL || strcmp(from, temp_metrics_collector->parent_string) == 0)
+				source.columns.push_back(col);
+		}
+		columnar_sources.push_back(source);
 	}
 
+	for (int group = 0; group < 4; group++) {
+		columnar[group] = new metrics_columnar;
+		if (!columnar[group]->open(*filenames[group], metrics_writer_Output["StartTime"].asCString(), interval_length, chunk_length,
+				rows[group], metrics_groups[group].columns, metrics_groups[group].n_columns)) {
+			gl_error("metrics_collector_writer::open_columns(): unable to open '%s' for writing", filenames[group]->get_string());
+			/* TROUBLESHOOT
+				The columnar metrics output file could not be created.  Check that the
+				directory exists and can be written to.
+			*/
+			return 0;
+		}
+	}
 	return 1;
 }
 
+/**
+	Add the metrics of the interval to the columnar output files
+	@return 1 on success, 0 on error
+ **/
+int metrics_collector_writer::write_columns(TIMESTAMP t1){
+	if (columnar[0] == NULL && !open_columns())
+		return 0;
+
+	for (int group = 0; group < 4; group++)
+		columnar[group]->begin_interval(t1 - startTime);
+
+	// Copy the values straight from each collector instead of building the JSON dictionaries
+	for (vector<COLUMNAR_SOURCE>::iterator source = columnar_sources.begin(); source != columnar_sources.end(); source++) {
+		const Json::Value &output = source->collector->metrics_Output;
+		METRICS_COLUMN *columns = metrics_groups[source->group].columns;
+		metrics_columnar *file = columnar[source->group];
+		for (vector<int>::iterator col = source->columns.begin(); col != source->columns.end(); col++) {
+			const Json::Value &value = output[columns[*col].key];
+			file->set(source->row, *col, value.isNull() ? QNAN : value.asDouble());
+		}
+	}
+
+	int rv = 1;
+	for (int group = 0; group < 4; group++) {
+		if (!columnar[group]->end_interval())
+			rv = 0;
+	}
+
+	if (final_write <= t1 && !close_columns())
+		rv = 0;
+
+	if (rv == 0) {
+		gl_error("metrics_collector_writer::write_columns(): unable to write the columnar output");
+		/* TROUBLESHOOT
+			A chunk of the columnar metrics output could not be written.  Check that the
+			disk is not full.
+		*/
+	}
+	return rv;
+}
+
+/**
+	Write the remaining intervals of the columnar output files and close them
+	@return 1 on success, 0 on error
+ **/
+int metrics_collector_writer::close_columns(){
+	int rv = 1;
+	for (int group = 0; group < 4; group++) {
+		if (columnar[group] == NULL)
+			continue;
+		if (!columnar[group]->close())
+			rv = 0;
+		delete columnar[group];
+		columnar[group] = NULL;
+	}
+	return rv;
+}
+
+int metrics_collector_writer::finalize(OBJECT *obj){
+	// the run may stop before the last interval, so the output has not been written yet
+	if (format == FMT_JSON && last_write < final_write) {
+		write_json();
+	}
+	if (!close_columns()) {
+		gl_error("metrics_collector_writer::finalize(): unable to write the columnar output");
+		/* TROUBLESHOOT
+			The last chunk of the columnar metrics output could not be written when the
+			simulation ended.  Check that the disk is not full.
+		*/
+		return 0;
+	}
+	return 1;
+}
 
 EXPORT int create_metrics_collector_writer(OBJECT **obj, OBJECT *parent){
 	int rv = 0;
@@ -580,6 +772,21 @@ EXPORT int isa_metrics_collector_writer(OBJECT *obj, char *classname)
 	return OBJECTDATA(obj, metrics_collector_writer)->isa(classname);
 }
 
+EXPORT int finalize_metrics_collector_writer(OBJECT *obj)
+{
+	metrics_collector_writer *my = OBJECTDATA(obj, metrics_collector_writer);
+	try {
+		return my->finalize(obj);
+	}
+	catch (char *msg){
+		gl_error("finalize_metrics_collector_writer: %s", msg);
+	}
+	catch (const char *msg){
+		gl_error("finalize_metrics_collector_writer: %s", msg);
+	}
+	return 0;
+}
+
 // EOF
 
 
@@ -10,18 +10,29 @@
 
 #include "tape.h"
 #include "metrics_collector.h"
+#include "metrics_columnar.h"
 //#include <json/json.h> //jsoncpp library
 
 #include <iostream>
 #include <fstream>
 #include <cstring>
 #include <string.h>
+#include <map>
+#include <vector>
 using namespace std;
 
 EXPORT void new_metrics_collector_writer(MODULE *);
 
 #ifdef __cplusplus
 
+// metrics of one metrics_collector stored in a row of the columnar output
+typedef struct s_columnar_source {
+	metrics_collector *collector;
+	int group;			// output file (billing meters, houses, inverters or substation)
+	int row;			// row of the parent object
+	vector<int> columns;	// columns filled by this collector
+} COLUMNAR_SOURCE;
+
 class metrics_collector_writer{
 public:
 	static metrics_collector_writer *defaults;
@@ -34,9 +45,13 @@ public:
 	TIMESTAMP postsync(TIMESTAMP, TIMESTAMP);
 
 	int commit(TIMESTAMP);
+	int finalize(OBJECT *);
 
 public:
+	enum {FMT_JSON=0, FMT_COLUMNAR=1};
 	char256 filename;
+	enumeration format;				//Output file format
+	int32 chunk_length;				//Number of intervals in each chunk of the columnar output
 	double interval_length_dbl;			//Metrics output interval length
 	TIMESTAMP next_time;
 	TIMESTAMP dt;
@@ -45,6 +60,10 @@ public:
 private:
 
 	int write_line(TIMESTAMP);
+	void write_json();
+	int open_columns();
+	int write_columns(TIMESTAMP);
+	int close_columns();
 
 private:
 	Json::Value metrics_writer_Output;	// Final output dictionary
@@ -98,6 +117,9 @@ private:
 
 	bool firstWrite;
 
+	metrics_columnar *columnar[4];	// columnar output files, in the order of the JSON files
+	vector<COLUMNAR_SOURCE> columnar_sources;
+
 	TIMESTAMP perform_average_time;	//Timestamp to perform the average
 	TIMESTAMP last_update_time;		//Last time array updated
 	int curr_avg_pos_index;			//Index for current position of averaging array
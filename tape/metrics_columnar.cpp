@@ -0,0 +1,283 @@
+/*
+ * metrics_columnar.cpp
+ *
+ * Columnar output file of the metrics_collector_writer, see metrics_columnar.h
+ * for the file layout.
+ */
+
+#include "metrics_columnar.h"
+
+// little-endian encoding of the file fields
+static void put_bytes(std::vector<unsigned char> &buf, unsigned long long value, int bytes)
+{
+	for (int i = 0; i < bytes; i++) {
+		buf.push_back((unsigned char)(value >> (8*i)));
+	}
+}
+
+static void put_str(std::vector<unsigned char> &buf, const char *str)
+{
+	size_t len = strlen(str);
+	if (len > 0xffff) {
+		len = 0xffff;
+	}
+	put_bytes(buf, len, 2);
+	buf.insert(buf.end(), str, str + len);
+}
+
+static unsigned long long double_bits(double value)
+{
+	unsigned long long bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+// encode n values, each XOR'ed with the one before it
+static void put_series(std::vector<unsigned char> &buf, const double *value, int n)
+{
+	unsigned long long prev = 0;
+	for (int i = 0; i < n; i++) {
+		unsigned long long bits = double_bits(value[i]);
+		unsigned long long x = bits ^ prev;
+		prev = bits;
+		if (x == 0) {
+			buf.push_back(0); // same as the previous value
+			continue;
+		}
+		// Store the bytes between the leading and trailing zero bytes, after a byte giving their count and offset
+		int trail = 0;
+		while (((x >> (8*trail)) & 0xff) == 0) {
+			trail++;
+		}
+		int len = 8 - trail;
+		while (((x >> (8*(trail + len - 1))) & 0xff) == 0) {
+			len--;
+		}
+		buf.push_back((unsigned char)((trail << 4) | len));
+		put_bytes(buf, x >> (8*trail), len);
+	}
+}
+
+// insert the length of the block started at the given position
+static void end_block(std::vector<unsigned char> &buf, size_t start)
+{
+	size_t bytes = buf.size() - start - 4;
+	for (int i = 0; i < 4; i++) {
+		buf[start + i] = (unsigned char)(bytes >> (8*i));
+	}
+}
+
+metrics_columnar::metrics_columnar()
+{
+	fp = NULL;
+	n_rows = n_columns = chunk_length = 0;
+	fill = pending = NULL;
+	fill_time = pending_time = NULL;
+	n_fill = n_pending = 0;
+	running = busy = stopping = failed = false;
+}
+
+metrics_columnar::~metrics_columnar()
+{
+	if (running) {
+		close();
+	}
+	delete [] fill;
+	delete [] pending;
+	delete [] fill_time;
+	delete [] pending_time;
+}
+
+/** Create the file, write its header and start the background writer
+	@return 1 on success, 0 on failure
+ **/
+int metrics_columnar::open(const char *filename, const char *start_time, TIMESTAMP interval, int chunk_len,
+	const std::vector<std::string> &rows, const METRICS_COLUMN *columns, int n_cols)
+{
+	n_rows = (int)rows.size();
+	n_columns = n_cols;
+	chunk_length = chunk_len;
+
+	size_t size = (size_t)n_columns * n_rows * chunk_length;
+	fill = new double[size];
+	pending = new double[size];
+	fill_time = new TIMESTAMP[chunk_length];
+	pending_time = new TIMESTAMP[chunk_length];
+
+	fp = fopen(filename, "wb");
+	if (fp == NULL) {
+		return 0;
+	}
+
+	buffer.clear();
+	buffer.insert(buffer.end(), "GLMC", "GLMC" + 4);
+	put_bytes(buffer, METRICS_COLUMNAR_VERSION, 4);
+	put_str(buffer, start_time);
+	put_bytes(buffer, (unsigned long long)interval, 8);
+	put_bytes(buffer, n_rows, 4);
+	for (int i = 0; i < n_rows; i++) {
+		put_str(buffer, rows[i].c_str());
+	}
+	put_bytes(buffer, n_columns, 4);
+	for (int i = 0; i < n_columns; i++) {
+		put_str(buffer, columns[i].name);
+		put_str(buffer, columns[i].units);
+	}
+	if (fwrite(&buffer[0], 1, buffer.size(), fp) != buffer.size()) {
+		return 0;
+	}
+
+	pthread_mutex_init(&lock, NULL);
+	pthread_cond_init(&ready, NULL);
+	pthread_cond_init(&done, NULL);
+	if (pthread_create(&thread, NULL, write_proc, (void*)this) != 0) {
+		return 0;
+	}
+	running = true;
+	return 1;
+}
+
+/** Start the values of the next interval, all metrics are zero until set
+ **/
+void metrics_columnar::begin_interval(TIMESTAMP t)
+{
+	fill_time[n_fill] = t;
+	for (int i = 0; i < n_columns*n_rows; i++) {
+		fill[i*chunk_length + n_fill] = 0.0;
+	}
+}
+
+/** Finish the values of the interval, and hand the chunk to the writer when it is full
+	@return 1 on success, 0 if an earlier chunk could not be written
+ **/
+int metrics_columnar::end_interval()
+{
+	if (++n_fill == chunk_length) {
+		return submit();
+	}
+	return 1;
+}
+
+/** Write the remaining intervals and close the file
+	@return 1 on success, 0 if a chunk could not be written
+ **/
+int metrics_columnar::close()
+{
+	if (!running) {
+		return 0;
+	}
+	int rv = (n_fill > 0) ? submit() : 1;
+
+	pthread_mutex_lock(&lock);
+	while (busy) {
+		pthread_cond_wait(&done, &lock);
+	}
+	stopping = true;
+	pthread_cond_signal(&ready);
+	pthread_mutex_unlock(&lock);
+	pthread_join(thread, NULL);
+	running = false;
+
+	if (fclose(fp) != 0) {
+		failed = true;
+	}
+	fp = NULL;
+	return (rv && !failed) ? 1 : 0;
+}
+
+// wait for the writer to finish the previous chunk and give it the one just filled
+int metrics_columnar::submit()
+{
+	pthread_mutex_lock(&lock);
+	while (busy) {
+		pthread_cond_wait(&done, &lock);
+	}
+	if (failed) {
+		pthread_mutex_unlock(&lock);
+		return 0;
+	}
+	double *values = pending;
+	pending = fill;
+	fill = values;
+	TIMESTAMP *times = pending_time;
+	pending_time = fill_time;
+	fill_time = times;
+	n_pending = n_fill;
+	n_fill = 0;
+	busy = true;
+	pthread_cond_signal(&ready);
+	pthread_mutex_unlock(&lock);
+	return 1;
+}
+
+void *metrics_columnar::write_proc(void *arg)
+{
+	metrics_columnar *my = (metrics_columnar*)arg;
+	pthread_mutex_lock(&my->lock);
+	while (true) {
+		while (!my->busy && !my->stopping) {
+			pthread_cond_wait(&my->ready, &my->lock);
+		}
+		if (!my->busy) {
+			break;
+		}
+		pthread_mutex_unlock(&my->lock);
+		my->write_chunk();
+		pthread_mutex_lock(&my->lock);
+		my->busy = false;
+		pthread_cond_signal(&my->done);
+	}
+	pthread_mutex_unlock(&my->lock);
+	return NULL;
+}
+
+// encode and write the pending chunk, runs on the writer thread
+void metrics_columnar::write_chunk()
+{
+	std::vector<double> aggregate(3*n_pending);
+
+	buffer.clear();
+	buffer.insert(buffer.end(), "CHNK", "CHNK" + 4);
+	put_bytes(buffer, n_pending, 4);
+	for (int k = 0; k < n_pending; k++) {
+		put_bytes(buffer, (unsigned long long)pending_time[k], 8);
+	}
+
+	for (int col = 0; col < n_columns; col++) {
+		const double *column = pending + (size_t)col*n_rows*chunk_length;
+
+		size_t start = buffer.size();
+		put_bytes(buffer, 0, 4);
+		for (int row = 0; row < n_rows; row++) {
+			put_series(buffer, column + (size_t)row*chunk_length, n_pending);
+		}
+		end_block(buffer, start);
+
+		// Minimum, maximum and sum over the objects in each interval, leaving out missing values
+		for (int k = 0; k < n_pending; k++) {
+			double min = QNAN, max = QNAN, sum = 0.0;
+			for (int row = 0; row < n_rows; row++) {
+				double value = column[(size_t)row*chunk_length + k];
+				if (isnan(value)) continue;
+				if (!(value >= min)) min = value;
+				if (!(value <= max)) max = value;
+				sum += value;
+			}
+			aggregate[k] = min;
+			aggregate[n_pending + k] = max;
+			aggregate[2*n_pending + k] = sum;
+		}
+		start = buffer.size();
+		put_bytes(buffer, 0, 4);
+		for (int i = 0; i < 3; i++) {
+			put_series(buffer, &aggregate[i*n_pending], n_pending);
+		}
+		end_block(buffer, start);
+	}
+
+	if (fwrite(&buffer[0], 1, buffer.size(), fp) != buffer.size()) {
+		failed = true;
+	}
+}
+
+// EOF
@@ -0,0 +1,97 @@
+/*
+ * metrics_columnar.h
+ *
+ * Columnar output file of the metrics_collector_writer.
+ *
+ * The file holds one table of metrics per object (row) and interval, stored
+ * in chunks of intervals.  Each chunk stores every metric (column) as its own
+ * block, so a reader can decode only the metrics it needs.  Values are
+ * encoded as the XOR of the value and the previous value of the same object,
+ * with the leading and trailing zero bytes dropped, so metrics that change
+ * little from one interval to the next take one or a few bytes.  Each column
+ * block also carries the minimum, maximum and sum over the objects for each
+ * interval, so feeder-level results can be read without decoding the objects.
+ * Metrics missing from the output of a metrics_collector are stored as NaN.
+ *
+ * All integers and floats are little-endian.  The layout is
+ *
+ *	header:	"GLMC" u32:version str:start_time i64:interval
+ *			u32:rows { str:name }
+ *			u32:columns { str:name str:units }
+ *	chunk:	"CHNK" u32:intervals { i64:time }
+ *			{ u32:bytes data[rows*intervals] u32:bytes aggregate[3*intervals] } per column
+ *
+ * where str is a u16 length followed by the characters.  The encoded data
+ * are the intervals of the first row, then of the second row, and so on.
+ * The encoding restarts at each chunk so chunks are read independently.
+ *
+ * Chunks are encoded and written by a background thread while the
+ * simulation fills the next chunk.  See tape/metrics_reader.py for a reader.
+ */
+
+#ifndef _METRICS_COLUMNAR_H_
+#define _METRICS_COLUMNAR_H_
+
+#include "tape.h"
+
+#include <pthread.h>
+#include <vector>
+#include <string>
+
+#define METRICS_COLUMNAR_VERSION 1
+
+// metric stored in a column of the columnar output
+typedef struct s_metrics_column {
+	const char *name;	// name of the metric in the output metadata
+	const char *units;	// units of the metric
+	const char *key;	// name of the metric in the metrics_collector output
+	const char *source;	// parent class of the metrics_collector providing it (NULL for any)
+} METRICS_COLUMN;
+
+class metrics_columnar {
+public:
+	metrics_columnar();
+	~metrics_columnar();
+
+	int open(const char *filename, const char *start_time, TIMESTAMP interval, int chunk_length,
+		const std::vector<std::string> &rows, const METRICS_COLUMN *columns, int n_columns);
+	void begin_interval(TIMESTAMP t);
+	inline void set(int row, int column, double value) { fill[(column*n_rows + row)*chunk_length + n_fill] = value; };
+	int end_interval();
+	int close();
+
+private:
+	int submit();
+	void write_chunk();
+	static void *write_proc(void *arg);
+
+private:
+	FILE *fp;
+	int n_rows;
+	int n_columns;
+	int chunk_length;
+
+	// chunk being filled, by column, then row, then interval
+	double *fill;
+	TIMESTAMP *fill_time;
+	int n_fill;
+
+	// chunk being written by the background thread
+	double *pending;
+	TIMESTAMP *pending_time;
+	int n_pending;
+
+	std::vector<unsigned char> buffer;	// encoded column block
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t ready;	// signalled when a chunk is pending or the file is closing
+	pthread_cond_t done;	// signalled when the pending chunk has been written
+	bool running;
+	bool busy;
+	bool stopping;
+	bool failed;
+};
+
+#endif // _METRICS_COLUMNAR_H_
+
+// EOF
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+
+"""
+metrics_reader
+~~~~~~~~~~~~~~
+
+Reader of the COLUMNAR output of the metrics_collector_writer.
+
+Usage:
+    metrics_reader.py FILE                       print the objects, metrics and intervals
+    metrics_reader.py FILE --json OUT            convert to the JSON output layout
+    metrics_reader.py FILE --csv METRIC          print one metric, one column per object
+    metrics_reader.py FILE --aggregate METRIC    print the min/max/sum over the objects
+
+The --csv and --aggregate options decode only the column of the metric, and
+--aggregate uses the per-interval aggregates stored by the writer so it does
+not decode the objects at all.  See tape/metrics_columnar.h for the layout.
+"""
+
+import json
+import struct
+import sys
+
+VERSION = 1
+
+class MetricsFile:
+    """Columnar metrics file"""
+
+    def __init__(self, filename):
+        with open(filename, "rb") as f:
+            self.data = f.read()
+        self.pos = 0
+        if self._bytes(4) != b"GLMC":
+            raise ValueError("%s is not a columnar metrics file" % filename)
+        version = self._unpack("<I")
+        if version != VERSION:
+            raise ValueError("%s has unsupported version %d" % (filename, version))
+        self.start_time = self._str()
+        self.interval = self._unpack("<q")
+        self.objects = [self._str() for i in range(self._unpack("<I"))]
+        self.metrics = []
+        self.units = []
+        for i in range(self._unpack("<I")):
+            self.metrics.append(self._str())
+            self.units.append(self._str())
+        self.chunks = self._index()
+
+    def _bytes(self, n):
+        value = self.data[self.pos:self.pos + n]
+        self.pos += n
+        return value
+
+    def _unpack(self, fmt):
+        value, = struct.unpack_from(fmt, self.data, self.pos)
+        self.pos += struct.calcsize(fmt)
+        return value
+
+    def _str(self):
+        return self._bytes(self._unpack("<H")).decode()
+
+    def _index(self):
+        """Find the times and the column blocks of each chunk"""
+        chunks = []
+        while self.pos < len(self.data):
+            if self._bytes(4) != b"CHNK":
+                raise ValueError("corrupt chunk at offset %d" % (self.pos - 4))
+            n = self._unpack("<I")
+            times = list(struct.unpack_from("<%dq" % n, self.data, self.pos))
+            self.pos += 8 * n
+            columns = []
+            for col in self.metrics:
+                data = self._unpack("<I")
+                columns.append((self.pos, data))
+                self.pos += data
+                aggregate = self._unpack("<I")
+                columns[-1] += (self.pos, aggregate)
+                self.pos += aggregate
+            chunks.append((times, columns))
+        return chunks
+
+    def _decode(self, pos, length, series, n):
+        """Decode the XOR encoded series of n values"""
+        values = []
+        end = pos + length
+        for s in range(series):
+            prev = 0
+            row = []
+            for i in range(n):
+                control = self.data[pos]
+                pos += 1
+                if control:
+                    trail, size = control >> 4, control & 0x0f
+                    x = int.from_bytes(self.data[pos:pos + size], "little") << (8 * trail)
+                    pos += size
+                    prev ^= x
+                row.append(struct.unpack("<d", prev.to_bytes(8, "little"))[0])
+            values.append(row)
+        if pos != end:
+            raise ValueError("corrupt column block at offset %d" % end)
+        return values
+
+    def times(self):
+        return [t for times, columns in self.chunks for t in times]
+
+    def column(self, metric):
+        """Values of a metric as a list of intervals, each a list of object values"""
+        col = self.metrics.index(metric)
+        result = []
+        for times, columns in self.chunks:
+            pos, length = columns[col][0:2]
+            rows = self._decode(pos, length, len(self.objects), len(times))
+            result.extend(zip(*rows) if rows else [() for t in times])
+        return [list(values) for values in result]
+
+    def aggregate(self, metric):
+        """Min, max and sum over the objects of a metric as a list of intervals"""
+        col = self.metrics.index(metric)
+        result = []
+        for times, columns in self.chunks:
+            pos, length = columns[col][2:4]
+            result.extend(zip(*self._decode(pos, length, 3, len(times))))
+        return result
+
+    def to_json(self):
+        """Dictionary in the layout of the JSON output of the metrics_collector_writer"""
+        output = {"StartTime": self.start_time}
+        output["Metadata"] = dict((name, {"index": i, "units": units})
+            for i, (name, units) in enumerate(zip(self.metrics, self.units)))
+        columns = [self.column(metric) for metric in self.metrics]
+        for k, t in enumerate(self.times()):
+            # missing metrics are NaN, and a file without objects has null intervals, as in the JSON output
+            output[str(t)] = dict((name, [null(column[k][i]) for column in columns])
+                for i, name in enumerate(self.objects)) or None
+        return output
+
+def null(value):
+    return None if value != value else value
+
+def main(argv):
+    if len(argv) < 2 or argv[1] in ("-h", "--help"):
+        print(__doc__)
+        return 0
+    metrics = MetricsFile(argv[1])
+    if len(argv) == 2:
+        times = metrics.times()
+        print("start time: %s" % metrics.start_time)
+        print("interval: %d s" % metrics.interval)
+        print("intervals: %d in %d chunks" % (len(times), len(metrics.chunks)))
+        print("objects: %d" % len(metrics.objects))
+        for name, units in zip(metrics.metrics, metrics.units):
+            print("metric: %s [%s]" % (name, units))
+    elif argv[2] == "--json" and len(argv) == 4:
+        with open(argv[3], "w") as f:
+            json.dump(metrics.to_json(), f, indent=3)
+    elif argv[2] == "--csv" and len(argv) == 4:
+        print(",".join(["time"] + metrics.objects))
+        for t, values in zip(metrics.times(), metrics.column(argv[3])):
+            print(",".join([str(t)] + [repr(v) for v in values]))
+    elif argv[2] == "--aggregate" and len(argv) == 4:
+        print("time,min,max,sum")
+        for t, values in zip(metrics.times(), metrics.aggregate(argv[3])):
+            print(",".join([str(t)] + [repr(v) for v in values]))
+    else:
+        print(__doc__)
+        return 1
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
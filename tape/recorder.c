@@ -607,12 +607,39 @@ int read_properties(struct recorder *my, OBJECT *obj, PROPERTY *prop, char *buff
 	return count;
 }
 
+/* subscribe to changes of the recorded properties
+   @return non-zero only if every one of them reports its changes so it need not be polled
+ */
+static int32 subscribe_properties(OBJECT *obj, PROPERTY *prop)
+{
+	PROPERTY *p, *target;
+	int32 tracked = 1;
+	for (p=prop; p!=NULL; p=p->next)
+	{
+		/* complex parts are offset from the property they belong to */
+		target = gl_get_property(obj,p->name,NULL);
+		if (target==NULL || target->addr!=p->addr || !gl_subscribe_changes(obj,target))
+			tracked = 0;
+	}
+	return tracked;
+}
+
+static unsigned int count_changes(OBJECT *obj, PROPERTY *prop)
+{
+	PROPERTY *p;
+	unsigned int count = 0;
+	for (p=prop; p!=NULL; p=p->next)
+		count += gl_get_changes(obj,p);
+	return count;
+}
+
 EXPORT TIMESTAMP sync_recorder(OBJECT *obj, TIMESTAMP t0, PASSCONFIG pass)
 {
 	struct recorder *my = OBJECTDATA(obj,struct recorder);
 	typedef enum {NONE='\0', LT='<', EQ='=', GT='>'} COMPAREOP;
 	COMPAREOP comparison;
 	char1024 buffer = "";
+	unsigned int changes = 0;
 	
 	if (my->status==TS_DONE)
 	{
@@ -637,6 +664,8 @@ EXPORT TIMESTAMP sync_recorder(OBJECT *obj, TIMESTAMP t0, PASSCONFIG pass)
 	/* connect to property */
 	if (my->target==NULL){
 		my->target = link_properties(my, obj->parent, my->property);
+		if (my->target!=NULL)
+			my->tracked = subscribe_properties(obj->parent, my->target);
 	}
 	if (my->target==NULL)
 	{
@@ -664,6 +693,13 @@ EXPORT TIMESTAMP sync_recorder(OBJECT *obj, TIMESTAMP t0, PASSCONFIG pass)
 
 	/* update property value */
 	if ((my->target != NULL) && (my->interval == 0 || my->interval == -1)){	
+		if (my->tracked && my->interval==-1)
+		{
+			/* a change-only recorder has nothing to do until one of its targets reports a change */
+			changes = count_changes(obj->parent,my->target);
+			if (changes==my->changes && my->status==TS_OPEN && my->trigger[0]=='\0' && my->last.value[0]!='\0')
+				return TS_NEVER;
+		}
 		if(read_properties(my, obj->parent,my->target,buffer,sizeof(buffer))==0)
 		{
 			sprintf(buffer,"unable to read property '%s' of %s %d", my->property, obj->parent->oclass->name, obj->parent->id);
@@ -719,6 +755,7 @@ EXPORT TIMESTAMP sync_recorder(OBJECT *obj, TIMESTAMP t0, PASSCONFIG pass)
 
 		{
 			strncpy(my->last.value,buffer,sizeof(my->last.value));
+			my->changes = changes;
 
 			/* Deltamode-related check -- if we're ahead, don't overwrite this */
 			if (my->last.ts < t0)
@@ -729,6 +766,8 @@ EXPORT TIMESTAMP sync_recorder(OBJECT *obj, TIMESTAMP t0, PASSCONFIG pass)
 			}
 		} else if ((my->interval > 0) && (my->last.ts == t0) && (my->last.ns == 0)){
 			strncpy(my->last.value,buffer,sizeof(my->last.value));
+		} else if (my->interval==-1 && strcmp(buffer,my->last.value)==0){
+			my->changes = changes;
 		}
 	}
 Error:
@@ -748,4 +787,14 @@ Error:
 		return my->last.ts+my->interval;
 }
 
+EXPORT int finalize_recorder(OBJECT *obj)
+{
+	struct recorder *my = OBJECTDATA(obj,struct recorder);
+
+	/* flush the tape so on_term scripts see the whole recording */
+	if (my->status==TS_OPEN && my->ops!=NULL && my->ops->flush!=NULL)
+		my->ops->flush(my);
+	return 1;
+}
+
 /**@}*/
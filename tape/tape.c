@@ -155,7 +155,7 @@ TAPEFUNCS *get_ftable(char *mode){
 	ops->write = (WRITEFUNC)DLSYM(lib, "write_recorder");
 	ops->rewind = NULL;
 	ops->close = (CLOSEFUNC)DLSYM(lib, "close_recorder");
-	ops->flush = (FLUSHFUNC)DLSYM(lib, "flush_collector");
+	ops->flush = (FLUSHFUNC)DLSYM(lib, "flush_recorder");
 
 	ops = fptr->histogram = malloc(sizeof(TAPEOPS));
 	memset(ops,0,sizeof(TAPEOPS));
@@ -628,6 +628,35 @@ EXPORT SIMULATIONMODE interupdate(MODULE *module, TIMESTAMP t0, unsigned int64 d
 	return mode;
 }
 
+/* players and recorders work with any deltamode timestep */
+EXPORT unsigned long deltamode_nextstep(MODULE *module, TIMESTAMP t0, unsigned int64 delta_time, unsigned long dt)
+{
+	return DT_INFINITY;
+}
+
+/* when the deltamode timestep may vary, the time from the update at next_time to the next sample of the deltamode players
+   - 0 when a sample is at that update, because the sample after it is not read until then */
+EXPORT unsigned long deltamode_nextevent(MODULE *module, TIMESTAMP t0, unsigned int64 next_time)
+{
+	int64 step = DT_INFINITY;
+	unsigned int n;
+
+	for ( n=0 ; n<n_players ; n++ )
+	{
+		OBJECT *obj = delta_player_list[n];
+		struct player *my = (struct player *)OBJECTDATA(obj,struct player);
+		if ( my->next.ts!=TS_NEVER && my->next.ts-gl_globalclock<0x7fffffff ) /* 31 bit limit */
+		{
+			int64 sample_time = (my->next.ts-gl_globalclock)*DT_SECOND + my->next.ns;
+			if ( sample_time==(int64)next_time )
+				return 0;
+			else if ( sample_time>(int64)next_time && sample_time-(int64)next_time<step )
+				step = sample_time-(int64)next_time;
+		}
+	}
+	return (unsigned long)step;
+}
+
 EXPORT STATUS postupdate(MODULE *module, TIMESTAMP t0, unsigned int64 dt)
 {
 	unsigned int n;
@@ -179,6 +179,8 @@ struct recorder {
 	} last;
 	int32 samples;
 	PROPERTY *target;
+	int32 tracked; /* non-zero when every target property reports its changes */
+	unsigned int changes; /* change count of the targets when last.value was taken */
 };
 /** @}
 	@addtogroup collector
@@ -384,6 +384,12 @@ EXPORT void close_recorder(struct recorder *my)
 	}
 }
 
+EXPORT void flush_recorder(struct recorder *my)
+{
+	if (my->fp)
+		fflush(my->fp);
+}
+
 /*******************************************************************
  * histograms 
  */
@@ -521,4 +527,10 @@ EXPORT void close_collector(struct collector *my)
 	my->fp = 0;
 }
 
+EXPORT void flush_collector(struct collector *my)
+{
+	if (my->fp)
+		fflush(my->fp);
+}
+
 /**@}*/